@@ -1,9 +1,9 @@
 #include "clang/private/c_BasicTypes.h"
 #include "clang/private/Core/c_ActorCore.h"
 #include "clang/private/Debug/c_Assert.h"
-#include "clang/private/Directory/c_Directory.h"
+#include "clang/private/Messages/c_InlineMessage.h"
 #include "clang/private/Messages/c_MessageCreator.h"
-#include "clang/private/Threading/c_Lock.h"
+#include "clang/private/Messages/c_MessageSender.h"
 
 #include "clang/c_Actor.h"
 #include "clang/c_AllocatorManager.h"
@@ -21,24 +21,32 @@ namespace clang
 			, mSequence(0)
 			, mMessageCount(0)
 			, mMessageQueue()
-			, mNumMessageHandlers(0)
-			, mMaxMessageHandlers(32)
+			, mInlineMailbox()
+			, mHandlers(0)
+			, mNewHandlers(0)
+			, mForwardAddress(Address::Null())
 			, mState(0)
+			, mReferenced(0)
+			, mSchedule(SCHEDULE_IDLE)
 		{
 			// Actor cores shouldn't be default-constructed.
 			XLANG_FAIL();
 		}
 
-		ActorCore::ActorCore(const u32 sequence, Framework *const framework, Actor *const actor)
+		ActorCore::ActorCore(const u64 sequence, Framework *const framework, Actor *const actor)
 			: mNext(0)
 			, mParent(actor)
 			, mFramework(framework)
 			, mSequence(sequence)
 			, mMessageCount(0)
 			, mMessageQueue()
-			, mNumMessageHandlers(0)
-			, mMaxMessageHandlers(32)
-			, mState(STATE_REFERENCED)
+			, mInlineMailbox()
+			, mHandlers(0)
+			, mNewHandlers(0)
+			, mForwardAddress(Address::Null())
+			, mState(0)
+			, mReferenced(1)
+			, mSchedule(SCHEDULE_IDLE)
 		{
 			XLANG_ASSERT(GetSequence() != 0);
 			XLANG_ASSERT(mFramework != 0);
@@ -47,25 +55,27 @@ namespace clang
 		ActorCore::~ActorCore()
 		{
 			// We don't need to lock this because only one thread can access it at a time.
-			// Free all currently allocated handler objects.
-			mNumMessageHandlers = 0;
+			// Release the handler tables, which may be shared with other actors of the same type.
+			if (mNewHandlers)
+			{
+				mNewHandlers->Release();
+			}
 
+			if (mHandlers)
 			{
-				// The directory lock is used to protect the global free list.
-				Lock directoryLock(Directory::GetMutex());
-				Lock frameworkLock(mFramework->GetMutex());
-
-				// Free any left-over messages that haven't been processed.
-				// This is undesirable but can happen if the actor is killed while
-				// still processing messages.
-				while (IMessage *const message = mMessageQueue.Pop())
-				{
-					MessageCreator::Destroy(message);
-					--mMessageCount;
-				}
+				mHandlers->Release();
+			}
 
-				XLANG_ASSERT(mMessageCount == 0);
+			// Free any left-over messages that haven't been processed.
+			// This is undesirable but can happen if the actor is killed while
+			// still processing messages. The actor has been deregistered, and the
+			// directory has waited for anyone still sending to it, so no more can arrive.
+			while (IMessage *const message = GetQueuedMessage())
+			{
+				MessageCreator::Destroy(message);
 			}
+
+			XLANG_ASSERT(mMessageCount == 0);
 		}
 
 		Mutex &ActorCore::GetMutex() const
@@ -74,50 +84,126 @@ namespace clang
 			return mFramework->GetMutex();
 		}
 
-		void ActorCore::UpdateHandlers()
+		bool ActorCore::RegisterHandler(const MessageHandler_t &handler)
 		{
-			// Filter any handlers marked for deletion
-			for (u32 i=0; i<mNumMessageHandlers; ++i)
+			HandlerTable *const handlers(EditHandlers(1));
+			if (handlers == 0)
 			{
-				IMessageHandler* handler = (IMessageHandler*)&mMessageHandlers[i];
-				if (handler->IsMarked())
-				{
-					for (u32 j=i+1; j<mNumMessageHandlers; ++j)
-						mMessageHandlers[i] = mMessageHandlers[j];
-					--mNumMessageHandlers;
-				}
+				return false;
+			}
+
+			handlers->Insert(handler);
+			return true;
+		}
+
+		bool ActorCore::DeregisterHandler(const MessageHandler_t &handler)
+		{
+			// Check first, to avoid copying a shared table for a handler that isn't there.
+			if (!IsHandlerRegistered(handler))
+			{
+				return false;
+			}
+
+			HandlerTable *const handlers(EditHandlers(0));
+			if (handlers == 0)
+			{
+				return false;
+			}
+
+			return handlers->Remove(handler);
+		}
+
+		bool ActorCore::IsHandlerRegistered(const MessageHandler_t &handler) const
+		{
+			const HandlerTable *const handlers(mNewHandlers ? mNewHandlers : mHandlers);
+			return (handlers != 0 && handlers->Contains(handler));
+		}
+
+		void ActorCore::InternHandlers(HandlerTable *&typeTable)
+		{
+			// Take the handlers registered by the constructor. If the actor has already been
+			// processed, because it was sent a message during construction, they're already in use.
+			HandlerTable *const handlers(Atomic::Exchange(&mNewHandlers, static_cast<HandlerTable *>(0)));
+			if (handlers == 0)
+			{
+				return;
+			}
+
+			XLANG_ASSERT(mHandlers == 0);
+			mHandlers = HandlerTable::Intern(typeTable, handlers);
+		}
+
+		HandlerTable *ActorCore::EditHandlers(const u32 numHandlers)
+		{
+			// Tell the core to update its handler table before processing the actor.
+			DirtyHandlers();
+
+			HandlerTable *const pending(mNewHandlers);
+			const HandlerTable *const current(pending ? pending : mHandlers);
+			const u32 size(current ? current->GetSize() : 0);
+
+			if (pending && size + numHandlers <= pending->GetCapacity())
+			{
+				return pending;
 			}
 
-			if (mParent->mNewMessageHandlersNum!=0)
+			// A copy of the dispatched table is made exactly the size needed, since it's usually
+			// for a single change. Tables being built up by constructors grow geometrically instead.
+			u32 capacity(size + numHandlers);
+			if (pending || mHandlers == 0)
 			{
-				// Sorted-Insert of the new handlers
-				for (u32 i=0; i<mParent->mNewMessageHandlersNum; ++i)
+				const u32 grown(pending ? pending->GetCapacity() * 2 : 4);
+				capacity = (capacity < grown) ? grown : capacity;
+			}
+
+			HandlerTable *const handlers(HandlerTable::Copy(current, capacity));
+			if (handlers)
+			{
+				if (pending)
 				{
-					IMessageHandler* new_handler = (IMessageHandler*)&mParent->mNewMessageHandlers[i];
-					if (new_handler->IsMarked())
-						continue;
-
-					// Search for a place
-					s32 ins = 0;
-					for (; ins<(s32)mNumMessageHandlers; ++ins)
-					{
-						IMessageHandler* handler = (IMessageHandler*)&mMessageHandlers[ins];
-						if (new_handler->GetMessageTypeId() < handler->GetMessageTypeId())
-							break;
-					}
-
-					// Insert
-					// First, Move all entries up
-					//for (u32 k=ins+1; k<mNumMessageHandlers; ++k)
-					for (s32 k=mNumMessageHandlers-1; k>=ins; --k)
-						mMessageHandlers[k+1] = mMessageHandlers[k];
-					
-					// Then, Data copy the new handler at the insert position
-					mMessageHandlers[ins] = mParent->mNewMessageHandlers[i];
-					mNumMessageHandlers++;
+					pending->Release();
 				}
-				mParent->mNewMessageHandlersNum = 0;
+
+				mNewHandlers = handlers;
+			}
+
+			return handlers;
+		}
+
+		void ActorCore::UpdateHandlers()
+		{
+			HandlerTable *handlers(Atomic::Exchange(&mNewHandlers, static_cast<HandlerTable *>(0)));
+			if (handlers == 0)
+			{
+				return;
+			}
+
+			// Trim the new table so actors hold no more handler storage than they need.
+			handlers = HandlerTable::Trim(handlers);
+
+			// The old table may still be in use by other actors of the same type.
+			if (mHandlers)
+			{
+				mHandlers->Release();
 			}
+
+			mHandlers = handlers;
+		}
+
+		void ActorCore::ForwardMessage(IMessage *const message)
+		{
+			XLANG_ASSERT(IsMessageForwarded());
+			mState &= (~STATE_MESSAGE_FORWARDED);
+
+			// The handlers have all returned, so nothing refers to the message value any more.
+			// A message held in the inline mailbox is forwarded in its slot, which it keeps alive.
+			if (InlineMessage::IsInline(message))
+			{
+				InlineMessage::Detach(message);
+			}
+
+			MessageSender::Forward(mFramework, message, mForwardAddress);
+			mForwardAddress = Address::Null();
 		}
 
 		bool ActorCore::ExecuteDefaultHandler(IMessage *const message)
@@ -141,7 +227,10 @@ namespace clang
 		void ActorCore::Unreference()
 		{
 			// Schedule the actor core to make the threadpool garbage collect it.
-			mState &= ~STATE_REFERENCED;
+			// If it's already scheduled then the worker processing it notices it's unreferenced.
+			// The worker locks the mutex before destroying the actor, so it can't destroy it
+			// until we've finished scheduling it and the caller has released the lock.
+			Atomic::Store(&mReferenced, 0);
 			mFramework->Schedule(this);
 		}
 
@@ -2,8 +2,6 @@
 #include "clang/private/Core/c_ActorDestroyer.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Directory/c_ActorDirectory.h"
-#include "clang/private/Directory/c_Directory.h"
-#include "clang/private/Threading/c_Lock.h"
 
 #include "clang/c_Actor.h"
 #include "clang/c_AllocatorManager.h"
@@ -19,9 +17,8 @@ namespace clang
 			Actor *const actor(actorCore->GetParent());
 			const Address address(actor->GetAddress());
 
-			// Lock the directory to make sure no one can send the actor a message.
-			Lock lock(Directory::GetMutex());
-
+			// Messages sent to the actor until it's deregistered are queued in its core,
+			// and freed unprocessed when the core is destroyed.
 			// This seems to actually call the derived actor class destructor, as we want.
 			actor->~Actor();
 			AllocatorManager::Instance().GetAllocator()->Free(actor);
@@ -30,6 +27,7 @@ namespace clang
 			// We have to destroy the core after the actor, and not before, in case
 			// the actor does something that depends on the core in its destructor,
 			// for example if it sends a message or even creates another actor.
+			// The directory waits for any threads still sending to the actor.
 			if (!ActorDirectory::Instance().DeregisterActor(address))
 			{
 				// Failed to deregister actor core.
@@ -1,5 +1,6 @@
 #include "clang/private/Directory/c_ActorDirectory.h"
 #include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/c_Lock.h"
 
 #include "clang/c_Actor.h"
 #include "clang/c_Framework.h"
@@ -14,8 +15,29 @@ namespace clang
 	{
 		ActorDirectory ActorDirectory::smInstance;
 
+		bool ActorDirectory::Reserve(const u32 maxActors)
+		{
+			Lock lock(mMutex);
+
+			void *retiredPages(0);
+			const bool reserved(mActorPool.Reserve(maxActors, retiredPages));
+
+			// If the page table was replaced then threads that looked up actors in the old one
+			// may still be reading it.
+			if (retiredPages)
+			{
+				Synchronize();
+				ActorPool::FreeRetiredPages(retiredPages);
+			}
+
+			return reserved;
+		}
+
+
 		Address ActorDirectory::RegisterActor(Framework *const framework, Actor *const actor)
 		{
+			Lock lock(mMutex);
+
 			u32 index(0);
 			if (mActorPool.Allocate(index))
 			{
@@ -27,6 +49,7 @@ namespace clang
 
 				// Construct the actor core, initializing its sequence number.
 				// The sequence number is used to authenticate it later.
+				// Threads looking up the actor can't match it until they're given its address.
 				new (entry) ActorCore(address.GetSequence(), framework, actor);
 
 				return address;
@@ -41,6 +64,8 @@ namespace clang
 			XLANG_ASSERT(Address::IsActorAddress(address));
 			const u32 index(address.GetIndex());
 
+			Lock lock(mMutex);
+
 			// The entry in the actor pool is memory for an ActorCore object.
 			void *const entry(mActorPool.GetEntry(index));
 			if (entry)
@@ -54,10 +79,23 @@ namespace clang
 					// Zero is an invalid sequence number which isn't assigned to any actor.
 					actorCore->SetSequence(0);
 
+					// Wait for any threads that may have found the actor before we nulled it.
+					Synchronize();
+
 					// Destruct the actor core manually since it's buffer-allocated so we can't call delete.
 					actorCore->~ActorCore();
-					if (mActorPool.Free(index))
+
+					void *retiredPages(0);
+					if (mActorPool.Free(index, retiredPages))
 					{
+						// If pages were released then they've been unpublished, but threads
+						// that looked them up before that may still be reading them.
+						if (retiredPages)
+						{
+							Synchronize();
+							ActorPool::FreeRetiredPages(retiredPages);
+						}
+
 						return true;
 					}
 				}
@@ -67,6 +105,23 @@ namespace clang
 		}
 
 
+		void ActorDirectory::Synchronize()
+		{
+			// Advance the epoch so that threads pinning the directory from now on are counted
+			// separately, and are sure to see any changes made before the call.
+			Atomic::Fence();
+			const u32 epoch(Atomic::Increment(&mEpoch) - 1);
+			Atomic::Fence();
+
+			// Wait for the threads that pinned the directory in the previous epoch to unpin it.
+			// They hold it only while delivering a message, so they won't keep us for long.
+			while (Atomic::Load(&mPinCounts[epoch & 1]) != 0)
+			{
+				Atomic::Pause();
+			}
+		}
+
+
 	} // namespace detail
 } // namespace clang
 
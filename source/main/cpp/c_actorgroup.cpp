@@ -0,0 +1,83 @@
+#include "clang/c_ActorGroup.h"
+#include "clang/c_AllocatorManager.h"
+#include "clang/c_IAllocator.h"
+
+
+namespace clang
+{
+	ActorGroup::~ActorGroup()
+	{
+		if (mAddresses)
+		{
+			AllocatorManager::Instance().GetAllocator()->Free(mAddresses);
+		}
+	}
+
+	bool ActorGroup::Add(const Address &address)
+	{
+		if (Contains(address))
+		{
+			return false;
+		}
+
+		if (mSize == mCapacity)
+		{
+			// Grow the array geometrically, since groups are usually built up one address at a time.
+			const u32 capacity(mCapacity ? mCapacity * 2 : 8);
+			IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+
+			Address *const addresses(reinterpret_cast<Address *>(allocator->Allocate(capacity * (u32)sizeof(Address))));
+			if (addresses == 0)
+			{
+				return false;
+			}
+
+			for (u32 index = 0; index < mSize; ++index)
+			{
+				addresses[index] = mAddresses[index];
+			}
+
+			if (mAddresses)
+			{
+				allocator->Free(mAddresses);
+			}
+
+			mAddresses = addresses;
+			mCapacity = capacity;
+		}
+
+		mAddresses[mSize++] = address;
+
+		return true;
+	}
+
+	bool ActorGroup::Remove(const Address &address)
+	{
+		for (u32 index = 0; index < mSize; ++index)
+		{
+			if (mAddresses[index] == address)
+			{
+				// The order of the addresses doesn't matter, so fill the gap with the last one.
+				mAddresses[index] = mAddresses[--mSize];
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool ActorGroup::Contains(const Address &address) const
+	{
+		for (u32 index = 0; index < mSize; ++index)
+		{
+			if (mAddresses[index] == address)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+
+} // namespace clang
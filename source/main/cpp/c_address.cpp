@@ -1,13 +1,14 @@
 #include "clang/private/c_BasicTypes.h"
-#include "clang/private/Threading/c_Mutex.h"
 
 #include "clang/c_Address.h"
 
 
 namespace clang
 {
-	detail::Mutex Address::smMutex;
-	u32 Address::smNextValue = 1;
+	// The first value is skipped since zero is the special null value.
+	volatile u64 Address::smNextValue = 1;
+	XLANG_THREAD_LOCAL u64 Address::smNextBlockValue = 0;
+	XLANG_THREAD_LOCAL u64 Address::smEndBlockValue = 0;
 
 } // namespace clang
 
@@ -1,4 +1,9 @@
+#include "clang/private/Directory/c_ActorDirectory.h"
+#include "clang/private/Directory/c_Directory.h"
+#include "clang/private/Directory/c_ReceiverDirectory.h"
 #include "clang/private/MessageCache/c_MessageCache.h"
+#include "clang/private/MessageCache/c_PayloadCache.h"
+#include "clang/private/Threading/c_Lock.h"
 #include "clang/c_AllocatorManager.h"
 #include "clang/c_Framework.h"
 
@@ -9,7 +14,7 @@ namespace clang
 		, mFallbackMessageHandler(0)
 		, mDefaultFallbackHandler()
 	{
-		Initialize(2, 4);
+		Initialize(Parameters(2, 4));
 	}
 
 	Framework::Framework(const u32 numThreads)
@@ -17,7 +22,7 @@ namespace clang
 		, mFallbackMessageHandler(0)
 		, mDefaultFallbackHandler()
 	{
-		Initialize(numThreads, 2*numThreads);
+		Initialize(Parameters(numThreads, 2*numThreads));
 	}
 
 	Framework::Framework(const u32 numThreads, const u32 targetNumThreads)
@@ -25,7 +30,15 @@ namespace clang
 		, mFallbackMessageHandler(0)
 		, mDefaultFallbackHandler()
 	{
-		Initialize(numThreads, targetNumThreads);
+		Initialize(Parameters(numThreads, targetNumThreads));
+	}
+
+	Framework::Framework(const Parameters &params)
+		: mThreadPool()
+		, mFallbackMessageHandler(0)
+		, mDefaultFallbackHandler()
+	{
+		Initialize(params);
 	}
 
 
@@ -35,6 +48,7 @@ namespace clang
 
 		// Dereference the global free list to ensure it's destroyed.
 		detail::MessageCache::Instance().Dereference();
+		detail::PayloadCache::Instance().Dereference();
 
 		// Free the fallback handler object, if one is set.
 		if (mFallbackMessageHandler)
@@ -44,5 +58,34 @@ namespace clang
 	}
 
 
+	void Framework::Initialize(const Parameters &params)
+	{
+		// Reference the global free list to ensure it's created.
+		detail::MessageCache::Instance().Reference();
+		detail::PayloadCache::Instance().Reference();
+
+		// Make sure the shared directories can hold as many actors and receivers as asked for.
+		// If they can't grow for lack of memory they keep their previous maximums.
+		if (!detail::ActorDirectory::Instance().Reserve(params.mMaxActors))
+		{
+			XLANG_FAIL_MSG("Failed to raise the maximum number of actors");
+		}
+
+		{
+			detail::Lock lock(detail::Directory::GetMutex());
+			if (!detail::ReceiverDirectory::Instance().Reserve(params.mMaxReceivers))
+			{
+				XLANG_FAIL_MSG("Failed to raise the maximum number of receivers");
+			}
+		}
+
+		XLANG_ASSERT_MSG(params.mThreadCount > 0, "numThreads must be greater than zero");
+		mThreadPool.Start(params.mThreadCount, params.mTargetThreadCount);
+
+		// Register the default fallback handler initially.
+		SetFallbackHandler(&mDefaultFallbackHandler, &detail::DefaultFallbackHandler::Handle);
+	}
+
+
 } // namespace clang
 
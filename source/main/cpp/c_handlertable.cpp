@@ -0,0 +1,269 @@
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Handlers/c_HandlerTable.h"
+#include "clang/private/Threading/c_Lock.h"
+
+#include "clang/c_AllocatorManager.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		Mutex HandlerTable::smMutex;
+
+
+		/// Returns true if two handler objects are copies of the same handler.
+		/// The storage is zeroed before the handlers are constructed in it, so it can be compared
+		/// word by word: equal words mean the same handler class and the same handler function.
+		XLANG_FORCEINLINE static bool SameHandler(const MessageHandler_t &a, const MessageHandler_t &b)
+		{
+			return (a._vfptr_ == b._vfptr_ && a._data_[0] == b._data_[0] && a._data_[1] == b._data_[1]);
+		}
+
+
+		HandlerTable *HandlerTable::Create(const u32 capacity)
+		{
+			void *const memory = AllocatorManager::Instance().GetAllocator()->Allocate(AllocationSize(capacity));
+			if (memory == 0)
+			{
+				return 0;
+			}
+
+			// The entries are plain data, constructed as handlers are inserted.
+			HandlerTable *const table(reinterpret_cast<HandlerTable *>(memory));
+			table->mReferenceCount = 1;
+			table->mSize = 0;
+			table->mCapacity = capacity;
+			table->mTypeTable = 0;
+
+			return table;
+		}
+
+
+		HandlerTable *HandlerTable::Copy(const HandlerTable *const table, const u32 capacity)
+		{
+			const u32 size(table ? table->mSize : 0);
+			XLANG_ASSERT(capacity >= size);
+
+			HandlerTable *const copy(Create(capacity));
+			if (copy)
+			{
+				// The handler objects are only ever copied bitwise, as when they were registered.
+				for (u32 index = 0; index < size; ++index)
+				{
+					copy->mEntries[index] = table->mEntries[index];
+				}
+
+				copy->mSize = size;
+			}
+
+			return copy;
+		}
+
+
+		void HandlerTable::Release()
+		{
+			XLANG_ASSERT(Atomic::Load(&mReferenceCount) > 0);
+			if (mTypeTable == 0)
+			{
+				if (Atomic::Decrement(&mReferenceCount) == 0)
+				{
+					AllocatorManager::Instance().GetAllocator()->Free(this);
+				}
+
+				return;
+			}
+
+			// Interned tables gain references from new actors of the type, with the mutex locked.
+			// So we only need to lock it to remove what may be the last reference.
+			u32 count(Atomic::Load(&mReferenceCount));
+			while (count > 1)
+			{
+				if (Atomic::CompareExchange(&mReferenceCount, count, count - 1))
+				{
+					return;
+				}
+
+				count = Atomic::Load(&mReferenceCount);
+			}
+
+			bool unreferenced(false);
+
+			{
+				Lock lock(smMutex);
+				if (Atomic::Decrement(&mReferenceCount) == 0)
+				{
+					// Forget the table so the next actor of the type interns its own.
+					XLANG_ASSERT(*mTypeTable == this);
+					*mTypeTable = 0;
+					unreferenced = true;
+				}
+			}
+
+			if (unreferenced)
+			{
+				AllocatorManager::Instance().GetAllocator()->Free(this);
+			}
+		}
+
+
+		HandlerTable *HandlerTable::Intern(HandlerTable *&typeTable, HandlerTable *const table)
+		{
+			XLANG_ASSERT(table);
+			XLANG_ASSERT(table->mTypeTable == 0);
+
+			HandlerTable *interned(0);
+
+			{
+				Lock lock(smMutex);
+				if (typeTable && typeTable->Equals(*table))
+				{
+					typeTable->Reference();
+					interned = typeTable;
+				}
+			}
+
+			if (interned)
+			{
+				table->Release();
+				return interned;
+			}
+
+			HandlerTable *const trimmed(Trim(table));
+			if (trimmed)
+			{
+				Lock lock(smMutex);
+				if (typeTable == 0)
+				{
+					trimmed->mTypeTable = &typeTable;
+					typeTable = trimmed;
+				}
+			}
+
+			return trimmed;
+		}
+
+
+		HandlerTable *HandlerTable::Trim(HandlerTable *const table)
+		{
+			XLANG_ASSERT(table);
+			XLANG_ASSERT(table->mTypeTable == 0);
+
+			if (table->mSize == 0)
+			{
+				table->Release();
+				return 0;
+			}
+
+			if (table->mSize == table->mCapacity)
+			{
+				return table;
+			}
+
+			HandlerTable *const trimmed(Copy(table, table->mSize));
+			if (trimmed == 0)
+			{
+				return table;
+			}
+
+			table->Release();
+			return trimmed;
+		}
+
+
+		bool HandlerTable::Contains(const MessageHandler_t &handler) const
+		{
+			return (Search(handler) != 0);
+		}
+
+
+		bool HandlerTable::Equals(const HandlerTable &other) const
+		{
+			if (mSize != other.mSize)
+			{
+				return false;
+			}
+
+			for (u32 index = 0; index < mSize; ++index)
+			{
+				if (!SameHandler(mEntries[index].mHandler, other.mEntries[index].mHandler))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+
+		void HandlerTable::Insert(const MessageHandler_t &handler)
+		{
+			XLANG_ASSERT(mSize < mCapacity);
+
+			const u32 typeId(reinterpret_cast<const IMessageHandler *>(&handler)->GetMessageTypeId());
+
+			// Insert after any handlers for the same type, so they're executed in registration order.
+			u32 position(static_cast<u32>(Find(typeId) - mEntries));
+			while (position < mSize && mEntries[position].mTypeId == typeId)
+			{
+				++position;
+			}
+
+			for (u32 index = mSize; index > position; --index)
+			{
+				mEntries[index] = mEntries[index - 1];
+			}
+
+			// Cache the type id and thunk of the handler so that messages are dispatched
+			// without calling any virtual functions.
+			Entry &entry(mEntries[position]);
+			entry.mHandler = handler;
+			entry.mTypeId = typeId;
+			entry.mThunk = entry.GetHandler()->GetThunk();
+
+			++mSize;
+		}
+
+
+		bool HandlerTable::Remove(const MessageHandler_t &handler)
+		{
+			const Entry *const entry(Search(handler));
+			if (entry == 0)
+			{
+				return false;
+			}
+
+			for (u32 index = static_cast<u32>(entry - mEntries) + 1; index < mSize; ++index)
+			{
+				mEntries[index - 1] = mEntries[index];
+			}
+
+			--mSize;
+			return true;
+		}
+
+
+		const HandlerTable::Entry *HandlerTable::Search(const MessageHandler_t &handler) const
+		{
+			const u32 typeId(reinterpret_cast<const IMessageHandler *>(&handler)->GetMessageTypeId());
+
+			const Entry *entry(Find(typeId));
+			const Entry *const end(End());
+
+			while (entry != end && entry->mTypeId == typeId)
+			{
+				if (SameHandler(entry->mHandler, handler))
+				{
+					return entry;
+				}
+
+				++entry;
+			}
+
+			return 0;
+		}
+
+
+	} // namespace detail
+} // namespace clang
@@ -0,0 +1,51 @@
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Core/c_InlineMailbox.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Messages/c_InlineMessage.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		InlineMailbox::~InlineMailbox()
+		{
+			if (mSlots)
+			{
+#if XLANG_ENABLE_ASSERTS
+				// Only forwarded messages can still be in use, and they keep the slots alive.
+				for (u32 index = 0; index < NUM_SLOTS; ++index)
+				{
+					const volatile u32 *const state(reinterpret_cast<const volatile u32 *>(mSlots + index * InlineMessage::SLOT_SIZE));
+					XLANG_ASSERT(*state != InlineMessage::SLOT_USED);
+				}
+#endif // XLANG_ENABLE_ASSERTS
+
+				InlineMessage::ReleaseSlots(mSlots);
+			}
+		}
+
+
+		xbyte *InlineMailbox::AllocateSlots()
+		{
+			xbyte *const slots(InlineMessage::CreateSlots(NUM_SLOTS));
+			if (slots == 0)
+			{
+				return 0;
+			}
+
+			// Several senders can race to allocate the slots. The first to install them wins,
+			// and the others free their own and use the winner's.
+			if (!Atomic::CompareExchange(&mSlots, static_cast<xbyte *>(0), slots))
+			{
+				InlineMessage::ReleaseSlots(slots);
+				return Atomic::Load(&mSlots);
+			}
+
+			return slots;
+		}
+
+
+	} // namespace detail
+} // namespace clang
@@ -0,0 +1,109 @@
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Messages/c_InlineMessage.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_AllocatorManager.h"
+#include "clang/c_IAllocator.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		namespace
+		{
+			/// Returns the state word of a slot.
+			XLANG_FORCEINLINE volatile u32 *GetSlotState(xbyte *const slot)
+			{
+				return reinterpret_cast<volatile u32 *>(slot);
+			}
+
+			/// Returns the index of a slot within its set of slots, stored after the state word.
+			XLANG_FORCEINLINE u32 GetSlotIndex(const xbyte *const slot)
+			{
+				return *reinterpret_cast<const u32 *>(slot + sizeof(u32));
+			}
+
+			/// Returns the reference count of a set of slots, held in the cache line before the first slot.
+			XLANG_FORCEINLINE volatile u32 *GetReferenceCount(xbyte *const slots)
+			{
+				return reinterpret_cast<volatile u32 *>(slots - InlineMessage::SLOT_SIZE);
+			}
+
+			/// Returns the slot holding a message.
+			XLANG_FORCEINLINE xbyte *GetSlot(IMessage *const message)
+			{
+				return reinterpret_cast<xbyte *>(message->GetBlock()) - InlineMessage::VALUE_OFFSET;
+			}
+		}
+
+
+		xbyte *InlineMessage::CreateSlots(const u32 numSlots)
+		{
+			IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+
+			// The reference count gets a cache line to itself, so the slots stay aligned.
+			xbyte *const block(reinterpret_cast<xbyte *>(allocator->AllocateAligned((numSlots + 1) * SLOT_SIZE, SLOT_SIZE)));
+			if (block == 0)
+			{
+				return 0;
+			}
+
+			xbyte *const slots(block + SLOT_SIZE);
+			*GetReferenceCount(slots) = 1;
+
+			for (u32 index = 0; index < numSlots; ++index)
+			{
+				xbyte *const slot(slots + index * SLOT_SIZE);
+				*GetSlotState(slot) = SLOT_FREE;
+				*reinterpret_cast<u32 *>(slot + sizeof(u32)) = index;
+			}
+
+			return slots;
+		}
+
+
+		void InlineMessage::ReleaseSlots(xbyte *const slots)
+		{
+			if (Atomic::Decrement(GetReferenceCount(slots)) == 0)
+			{
+				AllocatorManager::Instance().GetAllocator()->Free(slots - SLOT_SIZE);
+			}
+		}
+
+
+		void InlineMessage::Detach(IMessage *const message)
+		{
+			XLANG_ASSERT(IsInline(message));
+
+			xbyte *const slot(GetSlot(message));
+			XLANG_ASSERT(Atomic::Load(GetSlotState(slot)) == SLOT_USED);
+
+			// The message holds a reference to the slots until it's released, wherever it ends up.
+			Atomic::Increment(GetReferenceCount(slot - GetSlotIndex(slot) * SLOT_SIZE));
+			Atomic::Store(GetSlotState(slot), static_cast<u32>(SLOT_FORWARDED));
+		}
+
+
+		bool InlineMessage::ReleaseSlot(IMessage *const message)
+		{
+			xbyte *const slot(GetSlot(message));
+
+			// Only the thread holding the message changes the state of its slot, so it needn't be
+			// exchanged atomically. Once it's free the slot can be claimed straight away by a sender.
+			if (Atomic::Load(GetSlotState(slot)) == SLOT_FORWARDED)
+			{
+				xbyte *const slots(slot - GetSlotIndex(slot) * SLOT_SIZE);
+				Atomic::Store(GetSlotState(slot), static_cast<u32>(SLOT_FREE));
+				ReleaseSlots(slots);
+				return false;
+			}
+
+			Atomic::Store(GetSlotState(slot), static_cast<u32>(SLOT_FREE));
+			return false;
+		}
+
+
+	} // namespace detail
+} // namespace clang
@@ -1,19 +1,307 @@
-namespace ncore
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Align.h"
+#include "clang/c_llfw_allocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace clang
 {
-	namespace atomic
+	namespace
+	{
+		/// Returns the index of the lowest set bit of a non-zero mask.
+		XLANG_FORCEINLINE u32 FindLowestSetBit(const u32 mask)
+		{
+			XLANG_ASSERT(mask != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<u32>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return static_cast<u32>(index);
+#else
+			u32 index(0);
+			while ((mask & (1u << index)) == 0)
+			{
+				++index;
+			}
+
+			return index;
+#endif
+		}
+	}
+
+
+	/// Header at the start of each slab, followed by the blocks.
+	/// A set bit in the masks marks a free block. The count of free blocks is reserved from before
+	/// a bit is cleared, and added to after a bit is set, so a thread that reserves a block is sure
+	/// to find a set bit.
+	struct LocklessForwardAllocator::Slab
+	{
+		/// Maximum number of masks, enough for a slab of the smallest blocks.
+		static const u32 MAX_MASKS = (SLAB_SIZE / MIN_BLOCK_SIZE) / 32;
+
+		/// Offset of the first block, leaving room for the header while keeping the blocks aligned.
+		static const u32 BLOCKS_OFFSET = 512;
+
+		u32					mBlockSize;						///< Size of the blocks in the slab.
+		u32					mNumBlocks;						///< Number of blocks in the slab.
+		u32					mNumMasks;						///< Number of masks covering the blocks.
+		volatile u32		mNumFree;						///< Number of free blocks not yet reserved by an allocating thread.
+		Slab *volatile		mNext;							///< Next older slab of the same size class.
+		volatile u32		mMasks[MAX_MASKS];				///< Masks of free blocks, one bit per block.
+
+		/// Reserves one of the free blocks, if there are any.
+		XLANG_FORCEINLINE bool Reserve()
+		{
+			u32 numFree(detail::Atomic::Load(&mNumFree));
+			while (numFree != 0)
+			{
+				if (detail::Atomic::CompareExchange(&mNumFree, numFree, numFree - 1))
+				{
+					return true;
+				}
+
+				numFree = detail::Atomic::Load(&mNumFree);
+			}
+
+			return false;
+		}
+
+		/// Allocates a previously reserved block, by clearing its bit.
+		/// Threads start searching at different masks, so they don't all contend for the first.
+		XLANG_FORCEINLINE void *Take(const u32 firstMask)
+		{
+			u32 maskIndex(firstMask % mNumMasks);
+			while (true)
+			{
+				volatile u32 *const mask(mMasks + maskIndex);
+				u32 bits(detail::Atomic::Load(mask));
+
+				while (bits != 0)
+				{
+					const u32 bitIndex(FindLowestSetBit(bits));
+					if (detail::Atomic::CompareExchange(mask, bits, bits & ~(1u << bitIndex)))
+					{
+						const u32 blockIndex(maskIndex * 32 + bitIndex);
+						return reinterpret_cast<xbyte *>(this) + BLOCKS_OFFSET + blockIndex * mBlockSize;
+					}
+
+					bits = detail::Atomic::Load(mask);
+				}
+
+				maskIndex = (maskIndex + 1 < mNumMasks) ? maskIndex + 1 : 0;
+			}
+		}
+
+		/// Frees a block, by setting its bit.
+		XLANG_FORCEINLINE void Give(void *const block)
+		{
+			const u32 offset(static_cast<u32>(reinterpret_cast<xbyte *>(block) - reinterpret_cast<xbyte *>(this)));
+			XLANG_ASSERT(offset >= BLOCKS_OFFSET);
+			XLANG_ASSERT((offset - BLOCKS_OFFSET) % mBlockSize == 0);
+
+			const u32 blockIndex((offset - BLOCKS_OFFSET) / mBlockSize);
+			const u32 bit(1u << (blockIndex % 32));
+			volatile u32 *const mask(mMasks + blockIndex / 32);
+
+			// The bit is clear, since the block is allocated, so adding it sets it without a carry.
+			XLANG_ASSERT_MSG((detail::Atomic::Load(mask) & bit) == 0, "Duplicate free of a slab block");
+			detail::Atomic::Add(mask, bit);
+			detail::Atomic::Increment(&mNumFree);
+		}
+	};
+
+
+	LocklessForwardAllocator::LocklessForwardAllocator(IAllocator *const backingAllocator, const SizeType arenaSize)
+		: mBackingAllocator(backingAllocator)
+		, mArena(0)
+		, mArenaEnd(0)
+		, mMaxSlabs(arenaSize / SLAB_SIZE)
+		, mNumSlabs(0)
+	{
+		XLANG_ASSERT(mBackingAllocator);
+
+		for (u32 index = 0; index < NUM_SIZE_CLASSES; ++index)
+		{
+			mSizeClasses[index].mHead = 0;
+			mSizeClasses[index].mCurrent = 0;
+		}
+
+		if (mMaxSlabs != 0)
+		{
+			// The slabs are aligned to their size, so the slab containing a block is found by masking its address.
+			mArena = reinterpret_cast<xbyte *>(mBackingAllocator->AllocateAligned(mMaxSlabs * SLAB_SIZE, SLAB_SIZE));
+			if (mArena)
+			{
+				mArenaEnd = mArena + mMaxSlabs * SLAB_SIZE;
+			}
+			else
+			{
+				mMaxSlabs = 0;
+			}
+		}
+	}
+
+
+	LocklessForwardAllocator::~LocklessForwardAllocator()
+	{
+		if (mArena)
+		{
+			mBackingAllocator->Free(mArena);
+		}
+	}
+
+
+	void *LocklessForwardAllocator::Allocate(const SizeType size)
+	{
+		return AllocateAligned(size, sizeof(void *));
+	}
+
+
+	void *LocklessForwardAllocator::AllocateAligned(const SizeType size, const SizeType alignment)
+	{
+		XLANG_ASSERT_MSG((alignment & (alignment - 1)) == 0, "Alignment must be a power of two");
+
+		if (size <= MAX_BLOCK_SIZE && alignment <= MAX_ALIGNMENT)
+		{
+			// Blocks are aligned to the size class spacing, and to the cache line if their size is a multiple of it.
+			const SizeType granularity(alignment > MIN_BLOCK_SIZE ? MAX_ALIGNMENT : MIN_BLOCK_SIZE);
+			const SizeType blockSize(size == 0 ? MIN_BLOCK_SIZE : (size + granularity - 1) & ~(granularity - 1));
+
+			if (blockSize <= MAX_BLOCK_SIZE)
+			{
+				if (void *const block = AllocateBlock(blockSize / MIN_BLOCK_SIZE - 1))
+				{
+					return block;
+				}
+			}
+		}
+
+		return mBackingAllocator->AllocateAligned(size, alignment);
+	}
+
+
+	void LocklessForwardAllocator::Free(void *const memory)
+	{
+		XLANG_ASSERT_MSG(memory, "Free of null pointer");
+
+		if (!IsSlabBlock(memory))
+		{
+			mBackingAllocator->Free(memory);
+			return;
+		}
+
+		const uintptr_t offset(reinterpret_cast<xbyte *>(memory) - mArena);
+		Slab *const slab(reinterpret_cast<Slab *>(mArena + (offset & ~static_cast<uintptr_t>(SLAB_SIZE - 1))));
+		slab->Give(memory);
+	}
+
+
+	u32 LocklessForwardAllocator::GetNumSlabs() const
 	{
+		return detail::Atomic::Load(&mNumSlabs);
+	}
 
-		/** Lockless forward allocator
 
-		We have to set a minimum and maximum allocation size:
-		- Minimum = 32 bytes
-		- Maximum = 32 * 32 (bits) = 1024 bytes
+	void *LocklessForwardAllocator::AllocateBlock(const u32 sizeClass)
+	{
+		XLANG_ASSERT(sizeClass < NUM_SIZE_CLASSES);
+		SizeClass &slabs(mSizeClasses[sizeClass]);
 
+		// Spread the threads over the masks of a slab using the address of their stacks,
+		// so they don't all contend for the first mask.
+		const u32 firstMask(static_cast<u32>(reinterpret_cast<uintptr_t>(&sizeClass) >> 16));
 
-		**/
+		// Usually the slab last allocated from still has free blocks.
+		Slab *const current(detail::Atomic::Load(&slabs.mCurrent));
+		if (current && current->Reserve())
+		{
+			return current->Take(firstMask);
+		}
 
+		// Otherwise look for a slab with blocks freed since. Slabs are never removed from the list,
+		// so it can be walked without locking.
+		for (Slab *slab = detail::Atomic::Load(&slabs.mHead); slab; slab = detail::Atomic::Load(&slab->mNext))
+		{
+			if (slab != current && slab->Reserve())
+			{
+				detail::Atomic::Store(&slabs.mCurrent, slab);
+				return slab->Take(firstMask);
+			}
+		}
 
+		// All the slabs are full, so carve a new one, with its first block already allocated.
+		Slab *const slab(CarveSlab(sizeClass));
+		if (slab == 0)
+		{
+			return 0;
+		}
 
+		Slab *head(detail::Atomic::Load(&slabs.mHead));
+		while (true)
+		{
+			detail::Atomic::Store(&slab->mNext, head);
+			if (detail::Atomic::CompareExchange(&slabs.mHead, head, slab))
+			{
+				break;
+			}
 
+			head = detail::Atomic::Load(&slabs.mHead);
+		}
+
+		detail::Atomic::Store(&slabs.mCurrent, slab);
+		return reinterpret_cast<xbyte *>(slab) + Slab::BLOCKS_OFFSET;
 	}
-}
\ No newline at end of file
+
+
+	LocklessForwardAllocator::Slab *LocklessForwardAllocator::CarveSlab(const u32 sizeClass)
+	{
+		// Carving is a bump of the slab count, so never takes a lock.
+		// The count is only bumped while there's room, so it can't overflow once the arena is exhausted.
+		u32 index(detail::Atomic::Load(&mNumSlabs));
+		while (true)
+		{
+			if (index >= mMaxSlabs)
+			{
+				return 0;
+			}
+
+			if (detail::Atomic::CompareExchange(&mNumSlabs, index, index + 1))
+			{
+				break;
+			}
+
+			index = detail::Atomic::Load(&mNumSlabs);
+		}
+
+		Slab *const slab(reinterpret_cast<Slab *>(mArena + index * SLAB_SIZE));
+
+		slab->mBlockSize = (sizeClass + 1) * MIN_BLOCK_SIZE;
+		slab->mNumBlocks = (SLAB_SIZE - Slab::BLOCKS_OFFSET) / slab->mBlockSize;
+		slab->mNumMasks = (slab->mNumBlocks + 31) / 32;
+		slab->mNext = 0;
+
+		// Mark all the blocks free except the first, which is returned to the caller.
+		for (u32 maskIndex = 0; maskIndex < slab->mNumMasks; ++maskIndex)
+		{
+			const u32 numBits(slab->mNumBlocks - maskIndex * 32);
+			slab->mMasks[maskIndex] = (numBits >= 32) ? 0xFFFFFFFF : ((1u << numBits) - 1);
+		}
+
+		slab->mMasks[0] &= ~1u;
+		slab->mNumFree = slab->mNumBlocks - 1;
+
+		// Publish the initialized slab before it's linked into the list.
+		detail::Atomic::Fence();
+		return slab;
+	}
+
+
+} // namespace clang
@@ -6,7 +6,103 @@ namespace clang
 	namespace detail
 	{
 		MessageCache MessageCache::smInstance;
+		XLANG_THREAD_LOCAL MessageCache::ThreadCache *MessageCache::smThreadCache = 0;
+
+
+		void MessageCache::GetPoolStats(const u32 poolIndex, PoolStats &stats)
+		{
+			XLANG_ASSERT(poolIndex < MAX_POOLS);
+
+			Lock lock(mDepotMutex);
+
+			u64 counts[MAX_STATS];
+			for (u32 stat = 0; stat < MAX_STATS; ++stat)
+			{
+				counts[stat] = mStats[poolIndex][stat];
+			}
+
+			// Thread caches can't be deregistered while we hold the lock, but are still counting.
+			for (const ThreadCache *threadCache = mThreadCaches; threadCache; threadCache = threadCache->mNext)
+			{
+				for (u32 stat = 0; stat < MAX_STATS; ++stat)
+				{
+					counts[stat] += Atomic::Load(&threadCache->mStats[poolIndex][stat]);
+				}
+			}
+
+			stats.mBlockSize = GetPoolBlockSize(poolIndex);
+			stats.mMaxBlocks = 0;
+			stats.mNumBlocks = 0;
+
+			for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+			{
+				stats.mMaxBlocks += mPools[poolIndex][alignmentClass].GetMaxBlocks();
+				stats.mNumBlocks += mPools[poolIndex][alignmentClass].GetNumBlocks();
+			}
+
+			stats.mHits = counts[STAT_HITS];
+			stats.mMisses = counts[STAT_MISSES];
+			stats.mOverflows = counts[STAT_OVERFLOWS];
+		}
+
+
+		bool MessageCache::Grow(const u32 poolIndex, const u32 alignmentClass)
+		{
+			Pool &pool(mPools[poolIndex][alignmentClass]);
+			const u32 blockSize(GetPoolBlockSize(poolIndex));
+			const u32 maxBlocks(pool.GetMaxBlocks());
+
+			// Double the size of the pool, within the limits on its size and on the memory held by the whole depot.
+			u32 newMaxBlocks(maxBlocks * 2 < MAX_DEPOT_BLOCKS ? maxBlocks * 2 : MAX_DEPOT_BLOCKS);
+
+			const u32 availableBytes(mDepotBytes < MAX_DEPOT_BYTES ? MAX_DEPOT_BYTES - mDepotBytes : 0);
+			const u32 availableBlocks(availableBytes / blockSize);
+			if (newMaxBlocks > maxBlocks + availableBlocks)
+			{
+				newMaxBlocks = maxBlocks + availableBlocks;
+			}
+
+			if (newMaxBlocks <= maxBlocks)
+			{
+				return false;
+			}
+
+			pool.SetMaxBlocks(newMaxBlocks);
+			mDepotBytes += (newMaxBlocks - maxBlocks) * blockSize;
+			return true;
+		}
+
+
+		void MessageCache::ResetDepot()
+		{
+			mDepotBytes = 0;
+
+			// The pools of each size class start out holding a magazine's worth of blocks between them,
+			// which is enough for most actors.
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				u32 maxBlocks(GetMagazineBlocks(index) / NUM_ALIGNMENT_CLASSES);
+				if (maxBlocks == 0)
+				{
+					maxBlocks = 1;
+				}
+
+				for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+				{
+					XLANG_ASSERT(mPools[index][alignmentClass].Empty());
+
+					mPools[index][alignmentClass].SetMaxBlocks(maxBlocks);
+					mDepotBytes += maxBlocks * GetPoolBlockSize(index);
+				}
+
+				for (u32 stat = 0; stat < MAX_STATS; ++stat)
+				{
+					mStats[index][stat] = 0;
+				}
+			}
+		}
+
+
 	} // namespace detail
 } // namespace clang
 
-
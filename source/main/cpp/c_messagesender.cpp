@@ -1,9 +1,11 @@
 #include "clang/private/Core/c_ActorCore.h"
 #include "clang/private/Directory/c_ActorDirectory.h"
+#include "clang/private/Directory/c_Directory.h"
 #include "clang/private/Directory/c_ReceiverDirectory.h"
 #include "clang/private/Messages/c_IMessage.h"
+#include "clang/private/Messages/c_InlineMessage.h"
+#include "clang/private/Messages/c_MessageCreator.h"
 #include "clang/private/Messages/c_MessageSender.h"
-#include "clang/private/Threading/c_Mutex.h"
 #include "clang/private/Threading/c_Lock.h"
 
 #include "clang/c_Address.h"
@@ -14,31 +16,49 @@ namespace clang
 {
 	namespace detail
 	{
+		bool MessageSender::Forward(const Framework *const framework, IMessage *const message, const Address &to)
+		{
+			// The message block is delivered as it is, so it's neither copied nor reallocated.
+			if (Deliver(framework, message, to))
+			{
+				return true;
+			}
+
+			// If the message wasn't delivered we need to delete it ourselves.
+			MessageCreator::Destroy(message);
+			return false;
+		}
+
+
 		bool MessageSender::Deliver(const Framework *const framework, IMessage *const message, const Address &address)
 		{
 			if (Address::IsActorAddress(address))
 			{
-				ActorCore *const actorCore = ActorDirectory::Instance().GetActor(address);
+				// Pin the directory so the actor can't be destroyed while we deliver to it.
+				// Looking up the actor is lock-free, so senders don't serialize on a lock.
+				ActorDirectory &directory(ActorDirectory::Instance());
+				const u32 epoch(directory.Pin());
+
+				ActorCore *const actorCore = directory.GetActor(address);
 				if (actorCore)
 				{
-					// We use a single mutex to protect access to the work queue and the actor message queues.
-					// This turns out to be faster than using separate mutexes, perhaps because of the use of
-					// expensive locks rather than lock-free primitives. Given this, our strategy is to reduce
-					// the locks in the core actor processing loop down to just one, and instead make the code
-					// within the lock as fast as possible.
-					Lock lock(framework->GetMutex());
-
-					// Push the message onto the actor's dedicated message queue.
+					// The actor's message queue is lock-free, so no lock is needed to push onto it.
 					actorCore->Push(message);
 
-					// Schedule the actor for processing and wake a worker thread to process it.
+					// Schedule the actor for processing, unless it already is, and wake a worker thread to process it.
 					framework->Schedule(actorCore);
 
+					directory.Unpin(epoch);
 					return true;
 				}
+
+				directory.Unpin(epoch);
 			}
 			else
 			{
+				// The directory lock stops the receiver being destroyed while we deliver to it.
+				Lock lock(Directory::GetMutex());
+
 				Receiver *const receiver = ReceiverDirectory::Instance().GetReceiver(address);
 				if (receiver)
 				{
@@ -58,27 +78,31 @@ namespace clang
 		{
 			if (Address::IsActorAddress(address))
 			{
-				ActorCore *const actorCore = ActorDirectory::Instance().GetActor(address);
+				// Pin the directory so the actor can't be destroyed while we deliver to it.
+				// Looking up the actor is lock-free, so senders don't serialize on a lock.
+				ActorDirectory &directory(ActorDirectory::Instance());
+				const u32 epoch(directory.Pin());
+
+				ActorCore *const actorCore = directory.GetActor(address);
 				if (actorCore)
 				{
-					// We use a single mutex to protect access to the work queue and the actor message queues.
-					// This turns out to be faster than using separate mutexes, perhaps because of the use of
-					// expensive locks rather than lock-free primitives. Given this, our strategy is to reduce
-					// the locks in the core actor processing loop down to just one, and instead make the code
-					// within the lock as fast as possible.
-					Lock lock(framework->GetMutex());
-
-					// Push the message onto the actor's dedicated message queue.
+					// The actor's message queue is lock-free, so no lock is needed to push onto it.
 					actorCore->Push(message);
 
-					// Schedule the actor for processing without waking a worker thread.
+					// Schedule the actor for processing, unless it already is, without waking a worker thread.
 					framework->TailSchedule(actorCore);
 
+					directory.Unpin(epoch);
 					return true;
 				}
+
+				directory.Unpin(epoch);
 			}
 			else
 			{
+				// The directory lock stops the receiver being destroyed while we deliver to it.
+				Lock lock(Directory::GetMutex());
+
 				Receiver *const receiver = ReceiverDirectory::Instance().GetReceiver(address);
 				if (receiver)
 				{
@@ -94,6 +118,264 @@ namespace clang
 		}
 
 
+		bool MessageSender::DeliverInline(
+			const Framework *const framework,
+			const void *const value,
+			const InlineMessageDescriptor &descriptor,
+			const u32 typeId,
+			const Address &from,
+			const Address &to,
+			const bool wake)
+		{
+			if (Address::IsActorAddress(to))
+			{
+				// Pin the directory so the actor, and its mailbox, can't be destroyed while we deliver to it.
+				ActorDirectory &directory(ActorDirectory::Instance());
+				const u32 epoch(directory.Pin());
+
+				if (ActorCore *const actorCore = directory.GetActor(to))
+				{
+					// If the actor's inline mailbox is full, spill to an ordinary message.
+					// Both kinds are pushed onto the same queue, so they arrive in the order they're sent.
+					IMessage *message(actorCore->AllocateInlineMessage(value, descriptor, typeId, from));
+					if (message == 0)
+					{
+						message = InlineMessage::Create(value, descriptor, typeId, from);
+					}
+
+					if (message)
+					{
+						actorCore->Push(message);
+						if (wake)
+						{
+							framework->Schedule(actorCore);
+						}
+						else
+						{
+							framework->TailSchedule(actorCore);
+						}
+					}
+
+					directory.Unpin(epoch);
+					return (message != 0);
+				}
+
+				directory.Unpin(epoch);
+			}
+
+			// Receivers, and addresses of actors that no longer exist, are sent ordinary messages.
+			// Undeliverable messages are passed to the fallback handler, so need to outlive this call.
+			IMessage *const message(InlineMessage::Create(value, descriptor, typeId, from));
+			if (message != 0)
+			{
+				if (wake ? Deliver(framework, message, to) : TailDeliver(framework, message, to))
+				{
+					return true;
+				}
+
+				// If the message wasn't delivered we need to delete it ourselves.
+				MessageCreator::Destroy(message);
+			}
+
+			return false;
+		}
+
+
+		u32 MessageSender::DeliverBroadcast(const Framework *const framework, IMessage *const firstMessage, const u32 stride, const Address *const addresses, const u32 count)
+		{
+			xbyte *const messages(reinterpret_cast<xbyte *>(firstMessage));
+
+			// Undelivered messages are chained together, and passed to the fallback handler
+			// once we've stopped holding up the destruction of actors and receivers.
+			IMessage *undelivered(0);
+			u32 numScheduled(0);
+			u32 numReceivers(0);
+
+			{
+				// Pin the directory once, so that none of the actors can be destroyed while we deliver to them.
+				ActorDirectory &directory(ActorDirectory::Instance());
+				const u32 epoch(directory.Pin());
+
+				for (u32 index = 0; index < count; ++index)
+				{
+					if (!Address::IsActorAddress(addresses[index]))
+					{
+						++numReceivers;
+						continue;
+					}
+
+					IMessage *const message(reinterpret_cast<IMessage *>(messages + index * stride));
+					if (ActorCore *const actorCore = directory.GetActor(addresses[index]))
+					{
+						// Schedule the actor without waking a worker thread, and wake them all at the end.
+						actorCore->Push(message);
+						numScheduled += static_cast<u32>(framework->TailSchedule(actorCore));
+					}
+					else
+					{
+						message->SetNext(undelivered);
+						undelivered = message;
+					}
+				}
+
+				directory.Unpin(epoch);
+			}
+
+			// Make a single decision about waking worker threads for the whole batch of actors.
+			if (numScheduled != 0)
+			{
+				framework->Wake(numScheduled);
+			}
+
+			if (numReceivers != 0)
+			{
+				// The directory lock stops the receivers being destroyed while we deliver to them.
+				Lock lock(Directory::GetMutex());
+
+				for (u32 index = 0; index < count; ++index)
+				{
+					if (Address::IsActorAddress(addresses[index]))
+					{
+						continue;
+					}
+
+					IMessage *const message(reinterpret_cast<IMessage *>(messages + index * stride));
+					if (Receiver *const receiver = ReceiverDirectory::Instance().GetReceiver(addresses[index]))
+					{
+						receiver->Push(message);
+					}
+					else
+					{
+						message->SetNext(undelivered);
+						undelivered = message;
+					}
+				}
+			}
+
+			u32 numDelivered(count);
+			while (undelivered)
+			{
+				IMessage *const message(undelivered);
+				undelivered = message->GetNext();
+
+				// Call the framework's fallback handler, if one was provided, then delete the message ourselves.
+				framework->ExecuteFallbackHandler(message);
+				MessageCreator::Destroy(message);
+				--numDelivered;
+			}
+
+			return numDelivered;
+		}
+
+
+		u32 MessageSender::DeliverBatch(const Framework *const framework, IMessage *const *const messages, const Address *const addresses, const u32 addressStride, const u32 count)
+		{
+			// Undelivered messages are queued in order, and passed to the fallback handler
+			// once we've stopped holding up the destruction of actors and receivers.
+			IMessage *undeliveredHead(0);
+			IMessage *undeliveredTail(0);
+			u32 numUndelivered(0);
+			u32 numScheduled(0);
+			u32 numReceivers(0);
+
+			{
+				// Pin the directory once, so that none of the actors can be destroyed while we deliver to them.
+				ActorDirectory &directory(ActorDirectory::Instance());
+				const u32 epoch(directory.Pin());
+
+				for (u32 index = 0; index < count; ++index)
+				{
+					const Address &address(addresses[index * addressStride]);
+					if (!Address::IsActorAddress(address))
+					{
+						++numReceivers;
+						continue;
+					}
+
+					IMessage *const message(messages[index]);
+					if (ActorCore *const actorCore = directory.GetActor(address))
+					{
+						// Schedule the actor without waking a worker thread, and wake them all at the end.
+						// Messages pushed to the same actor are queued in the order they're pushed.
+						actorCore->Push(message);
+						numScheduled += static_cast<u32>(framework->TailSchedule(actorCore));
+					}
+					else
+					{
+						message->SetNext(0);
+						if (undeliveredTail)
+						{
+							undeliveredTail->SetNext(message);
+						}
+						else
+						{
+							undeliveredHead = message;
+						}
+
+						undeliveredTail = message;
+						++numUndelivered;
+					}
+				}
+
+				directory.Unpin(epoch);
+			}
+
+			// Make a single decision about waking worker threads for the whole batch of actors.
+			if (numScheduled != 0)
+			{
+				framework->Wake(numScheduled);
+			}
+
+			if (numReceivers != 0)
+			{
+				// The directory lock stops the receivers being destroyed while we deliver to them.
+				Lock lock(Directory::GetMutex());
+
+				for (u32 index = 0; index < count; ++index)
+				{
+					const Address &address(addresses[index * addressStride]);
+					if (Address::IsActorAddress(address))
+					{
+						continue;
+					}
+
+					IMessage *const message(messages[index]);
+					if (Receiver *const receiver = ReceiverDirectory::Instance().GetReceiver(address))
+					{
+						receiver->Push(message);
+					}
+					else
+					{
+						message->SetNext(0);
+						if (undeliveredTail)
+						{
+							undeliveredTail->SetNext(message);
+						}
+						else
+						{
+							undeliveredHead = message;
+						}
+
+						undeliveredTail = message;
+						++numUndelivered;
+					}
+				}
+			}
+
+			while (undeliveredHead)
+			{
+				IMessage *const message(undeliveredHead);
+				undeliveredHead = message->GetNext();
+
+				// Call the framework's fallback handler, if one was provided, then delete the message ourselves.
+				framework->ExecuteFallbackHandler(message);
+				MessageCreator::Destroy(message);
+			}
+
+			return count - numUndelivered;
+		}
+
+
 	} // namespace detail
 } // namespace clang
 
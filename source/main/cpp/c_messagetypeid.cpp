@@ -0,0 +1,49 @@
+#include "clang/private/Messages/c_MessageTypeId.h"
+#include "clang/private/Threading/c_Lock.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+#if XLANG_ENABLE_ASSERTS
+
+		Mutex MessageTypeIdRegistry::smMutex;
+		u32 MessageTypeIdRegistry::smIds[MessageTypeIdRegistry::MAX_TYPES];
+		const void *MessageTypeIdRegistry::smTypes[MessageTypeIdRegistry::MAX_TYPES];
+
+
+		bool MessageTypeIdRegistry::Register(const u32 id, const void *const type)
+		{
+			XLANG_ASSERT(type);
+
+			Lock lock(smMutex);
+
+			// Open addressing with linear probing, starting from the entry picked by the id.
+			// Generated ids are hashes, so their low bits are spread evenly.
+			u32 index(id & (MAX_TYPES - 1));
+			for (u32 count = 0; count < MAX_TYPES; ++count)
+			{
+				if (smTypes[index] == 0)
+				{
+					smIds[index] = id;
+					smTypes[index] = type;
+					return true;
+				}
+
+				if (smIds[index] == id)
+				{
+					return (smTypes[index] == type);
+				}
+
+				index = (index + 1) & (MAX_TYPES - 1);
+			}
+
+			// The table is full, so the type can't be checked.
+			return true;
+		}
+
+#endif // XLANG_ENABLE_ASSERTS
+
+	} // namespace detail
+} // namespace clang
@@ -0,0 +1,10 @@
+#include "clang/private/MessageCache/c_PayloadCache.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		PayloadCache PayloadCache::smInstance;
+	} // namespace detail
+} // namespace clang
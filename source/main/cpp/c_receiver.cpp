@@ -2,6 +2,7 @@
 #include "clang/private/Directory/c_Directory.h"
 #include "clang/private/Directory/c_ReceiverDirectory.h"
 #include "clang/private/MessageCache/c_MessageCache.h"
+#include "clang/private/MessageCache/c_PayloadCache.h"
 #include "clang/private/Messages/c_MessageCreator.h"
 #include "clang/private/Threading/c_Lock.h"
 
@@ -22,6 +23,7 @@ namespace clang
 	{
 		// Reference the global free list to ensure it's created.
 		detail::MessageCache::Instance().Reference();
+		detail::PayloadCache::Instance().Reference();
 
 		{
 			detail::Lock lock(detail::Directory::GetMutex());
@@ -52,6 +54,7 @@ namespace clang
 
 		// Dereference the global free list to ensure it's destroyed.
 		detail::MessageCache::Instance().Dereference();
+		detail::PayloadCache::Instance().Dereference();
 	}
 
 	void Receiver::Push(detail::IMessage *const message)
@@ -81,8 +84,7 @@ namespace clang
 		}
 
 		// Free the message, whether it was handled or not.
-		// The directory lock is used to protect the global free list.
-		detail::Lock lock(detail::Directory::GetMutex());
+		// The message cache is thread-safe so we don't need to lock it ourselves.
 		detail::MessageCreator::Destroy(message);
 	}
 
@@ -3,6 +3,9 @@
 
 #include "clang/c_Receiver.h"
 
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void	operator delete(void* mem, void* )							{ }
 
 namespace clang
 {
@@ -10,6 +13,17 @@ namespace clang
 	{
 		ReceiverDirectory ReceiverDirectory::smInstance;
 
+		bool ReceiverDirectory::Reserve(const u32 maxReceivers)
+		{
+			// Nobody reads the pool without locking, so a replaced page table can be freed right away.
+			void *retiredPages(0);
+			const bool reserved(mReceiverPool.Reserve(maxReceivers, retiredPages));
+			ReceiverPool::FreeRetiredPages(retiredPages);
+
+			return reserved;
+		}
+
+
 		Address ReceiverDirectory::RegisterReceiver(Receiver *const receiver)
 		{
 			u32 index(0);
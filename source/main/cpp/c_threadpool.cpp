@@ -10,18 +10,49 @@ namespace clang
 {
 	namespace detail
 	{
+		XLANG_THREAD_LOCAL ThreadPool::Worker *ThreadPool::smCurrentWorker = 0;
+
+
 		ThreadPool::ThreadPool() 
 			: mNumThreads(0)
 			, mTargetThreads(0)
-			, mWorkQueue()
-			, mWorkQueueMonitor()
+			, mMutex()
+			, mInjectionMutex()
+			, mInjectionQueue()
+			, mNumInjected(0)
+			, mWorkerMonitor()
+			, mNumSleeping(0)
+			, mNumSpinning(0)
+			, mIdleSpinCount(XLANG_DEFAULT_IDLE_SPIN_COUNT)
+			, mNumWorkers(0)
 			, mManagerMonitor()
-			, mNumMessagesProcessed(0)
-			, mNumThreadsPulsed(0)
-			, mNumThreadsWoken(0)
+			, mMessageQuantum(XLANG_DEFAULT_MESSAGE_QUANTUM)
+			, mSharedCounters()
+			, mCounterBase()
 			, mWorkerThreads()
 			, mManagerThread()
 		{
+			for (u32 index = 0; index < XLANG_MAX_THREADS_PER_FRAMEWORK; ++index)
+			{
+				mWorkers[index] = 0;
+			}
+		}
+
+
+		ThreadPool::~ThreadPool()
+		{
+			// The worker threads have all been joined by Stop, so nothing can still be stealing.
+			for (u32 index = 0; index < mNumWorkers; ++index)
+			{
+				Worker *const worker(mWorkers[index]);
+				XLANG_ASSERT(worker->mActive == false);
+
+				worker->~Worker();
+				AllocatorManager::Instance().GetAllocator()->Free(worker);
+				mWorkers[index] = 0;
+			}
+
+			mNumWorkers = 0;
 		}
 
 
@@ -69,8 +100,9 @@ namespace clang
 
 			// Wake the worker threads so they terminate.
 			{
-				Lock lock(mWorkQueueMonitor.GetMutex());
-				mWorkQueueMonitor.PulseAll();
+				Lock lock(mWorkerMonitor.GetMutex());
+				Atomic::Store(&mNumSleeping, 0);
+				mWorkerMonitor.PulseAll();
 			}
 
 			// Wait for the manager thread to terminate.
@@ -115,45 +147,75 @@ namespace clang
 			// so in this static wrapper function we call the non-static method
 			// on the instance, which is provided as context.
 
-			ThreadPool *const threadPool(reinterpret_cast<ThreadPool *>(context));
-			threadPool->WorkerThreadProc();
+			// The context is the worker, which knows its owning pool.
+			Worker *const worker(reinterpret_cast<Worker *>(context));
+			worker->mThreadPool->WorkerThreadProc(worker);
 		}
 
 
-		void ThreadPool::WorkerThreadProc()
+		void ThreadPool::WorkerThreadProc(Worker *const worker)
 		{
-			// This whole function is inside a lock-unlock pair. But the workers actually spend
-			// most of their time outside the lock - either doing the processing of an item or
-			// waiting for more work.
-			Lock lock(mWorkQueueMonitor.GetMutex());
+			// Remember the worker so that actors scheduled by this thread go onto its queue.
+			smCurrentWorker = worker;
+
+			// Messages allocated and freed by this thread are cached in the worker, without locking.
+			MessageCache::Instance().RegisterThreadCache(&worker->mMessageCache);
 
 			while (true)
 			{
-				// Check the work queue for work.
-				while (ActorCore *const actorCore = mWorkQueue.Pop())
+				// Process actors from our own queue, the injection queue, or other workers' queues.
+				// No lock is held while looking for work, and actors are processed without locking their queues.
+				while (ActorCore *const actorCore = FindWork(worker))
+				{
+					ProcessActorCore(worker, actorCore);
+				}
+
+				// Poll for a while before sleeping, since waking a sleeping thread is expensive.
+				if (Spin(worker))
 				{
-					ProcessActorCore(lock, actorCore);
+					continue;
 				}
 
 				// We test this condition without locking the manager lock to reduce locking overheads.
 				if (mNumThreads <= mTargetThreads)
 				{
-					// Wait for work to arrive or to be told to exit.
-					// This releases the lock on the monitor and then re-acquires it when woken.
-					mWorkQueueMonitor.Wait(lock);
-					++mNumThreadsWoken;
+					Lock lock(mWorkerMonitor.GetMutex());
+
+					// Announce that we're about to sleep before looking for work one last time.
+					// Threads that push work after we look will see the count and pulse us.
+					Atomic::Increment(&mNumSleeping);
+
+					// Check the thread count again now we hold the lock, in case we were told
+					// to stop after the check above and the pulse came before we could wait.
+					if (!HasWork() && mNumThreads <= mTargetThreads)
+					{
+						// Wait for work to arrive or to be told to exit.
+						// This releases the lock on the monitor and then re-acquires it when woken.
+						// The thread that pulses us takes us off the sleeping count.
+						mWorkerMonitor.Wait(lock);
+						IncrementCounter(worker, COUNTER_THREADS_WOKEN);
+					}
+					else
+					{
+						Atomic::Decrement(&mNumSleeping);
+					}
 				}
 				else
 				{
 					// Terminate this thread if there are more threads than we want.
+					// Our queue is empty, and only we push to it, so no actors are stranded in it.
 					Lock managerLock(mManagerMonitor.GetMutex());
 					if (mNumThreads > mTargetThreads)
 					{
 						--mNumThreads;
+						worker->mActive = false;
 						break;
 					}
 				}
 			}
+
+			MessageCache::Instance().DeregisterThreadCache();
+			smCurrentWorker = 0;
 		}
 
 
@@ -174,12 +236,22 @@ namespace clang
 					// Start new threads while there are less than the target number.
 					while (mNumThreads < mTargetThreads)
 					{
+						Worker *const worker(AcquireWorker());
+						if (worker == 0)
+						{
+							break;
+						}
+
+						// Count the thread before starting it. A new thread can decide to terminate
+						// straight away, and if it weren't counted yet it would decrement the count on
+						// behalf of another thread, which might then sleep through a request to stop.
+						++mNumThreads;
+
 						lock.Unlock();
 
-						mWorkerThreads.CreateThread(StaticWorkerThreadEntryPoint, this);
+						mWorkerThreads.CreateThread(StaticWorkerThreadEntryPoint, worker);
 
 						lock.Relock();
-						++mNumThreads;
 					}
 
 					// The manager terminates when the target thread count is set to zero.
@@ -201,6 +273,43 @@ namespace clang
 		}
 
 
+		ThreadPool::Worker *ThreadPool::AcquireWorker()
+		{
+			// Reuse a worker left behind by a thread that has terminated.
+			const u32 numWorkers(mNumWorkers);
+			for (u32 index = 0; index < numWorkers; ++index)
+			{
+				Worker *const worker(mWorkers[index]);
+				if (!worker->mActive)
+				{
+					worker->mActive = true;
+					return worker;
+				}
+			}
+
+			if (numWorkers == XLANG_MAX_THREADS_PER_FRAMEWORK)
+			{
+				return 0;
+			}
+
+			// Workers are aligned to cache lines so that the queues of different workers don't share them.
+			void *const memory = AllocatorManager::Instance().GetAllocator()->AllocateAligned(sizeof(Worker), XLANG_CACHELINE_SIZE);
+			if (memory == 0)
+			{
+				return 0;
+			}
+
+			Worker *const worker = new (memory) Worker(this, numWorkers);
+			worker->mActive = true;
+
+			// Publish the worker before the new count, so thieves that see the count can see the worker.
+			Atomic::Store(&mWorkers[numWorkers], worker);
+			Atomic::Store(&mNumWorkers, numWorkers + 1);
+
+			return worker;
+		}
+
+
 	} // namespace detail
 } // namespace clang
 
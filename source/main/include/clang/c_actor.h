@@ -6,6 +6,7 @@
 #endif
 
 #include "clang/private/c_basictypes.h"
+#include "clang/private/c_move.h"
 #include "clang/private/Containers/c_intrusivelist.h"
 #include "clang/private/Core/c_actorcore.h"
 #include "clang/private/Core/c_actorcreator.h"
@@ -15,11 +16,12 @@
 #include "clang/private/Handlers/c_idefaulthandler.h"
 #include "clang/private/Handlers/c_messagehandler.h"
 #include "clang/private/Handlers/c_imessagehandler.h"
-#include "clang/private/Handlers/c_messagehandlercast.h"
 #include "clang/private/Messages/c_messagesender.h"
 #include "clang/private/Messages/c_messagetraits.h"
+#include "clang/private/Threading/c_atomic.h"
 #include "clang/private/Threading/c_lock.h"
 
+#include "clang/c_actorgroup.h"
 #include "clang/c_address.h"
 #include "clang/c_allocatormanager.h"
 #include "clang/c_defines.h"
@@ -56,8 +58,8 @@ namespace clang
 	is destructed. See \ref ActorRef for more information on actor garbage collection.
 
 	The maximum number of actors that can be created in an application is limited
-	by the \ref XLANG_MAX_ACTORS define, which defines the number of unique
-	actor addresses.
+	by the \ref Framework::Parameters::mMaxActors "maximum" passed to the Framework,
+	which defaults to the \ref XLANG_MAX_ACTORS define.
 
 	*/
 	class Actor
@@ -642,6 +644,191 @@ namespace clang
 		template <class ValueType>
 		inline bool TailSend(const ValueType &value, const Address &address) const;
 
+		/**
+		\brief Sends a message to every entity (actor or receiver) in the given group.
+
+		The value is copied only once, and the copy is shared by the messages received by the
+		members of the group, so it's much cheaper than calling \ref Send for each member.
+		The recipients are all scheduled before any worker threads are woken to process them.
+
+		\code
+		class Publisher : public clang::Actor
+		{
+		public:
+
+			Publisher()
+			{
+				RegisterHandler(this, &Publisher::Subscribe);
+				RegisterHandler(this, &Publisher::Publish);
+			}
+
+		private:
+
+			inline void Subscribe(const SubscribeMessage &message, const clang::Address from)
+			{
+				mSubscribers.Add(from);
+			}
+
+			inline void Publish(const Update &message, const clang::Address from)
+			{
+				Broadcast(message, mSubscribers);
+			}
+
+			clang::ActorGroup mSubscribers;
+		};
+		\endcode
+
+		\tparam ValueType The message type (any copyable class or Plain Old Datatype).
+		\param value The message value.
+		\param group The addresses of the target entities.
+		\return The number of members of the group to which the message was delivered.
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline u32 Broadcast(const ValueType &value, const ActorGroup &group) const;
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		/**
+		\brief Sends a message, moving the value into the message rather than copying it.
+
+		Chosen instead of \ref Send for temporaries and values passed with std::move, so
+		that message values owning memory, such as strings and vectors, aren't deep-copied.
+
+		\code
+		std::vector<int> values(1000, 0);
+		Send(std::move(values), from);
+		\endcode
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline typename detail::EnableIfMovable<ValueType, bool>::Type Send(ValueType &&value, const Address &address) const;
+
+		/**
+		\brief Sends a message without waking a worker thread, moving the value into the message.
+
+		\see TailSend
+		*/
+		template <class ValueType>
+		inline typename detail::EnableIfMovable<ValueType, bool>::Type TailSend(ValueType &&value, const Address &address) const;
+
+		/**
+		\brief Sends a message whose value is constructed in place from the given arguments.
+
+		The value is constructed directly inside the message, using the constructor of the
+		value type that accepts the arguments, so it's neither copied nor moved.
+
+		\code
+		Emplace<std::string>(from, 16, 'x');
+		\endcode
+
+		\tparam ValueType The message type, which must be specified explicitly.
+		\param address The address of the entity to which the message is sent.
+		\param args The arguments passed to the constructor of the message value.
+		\return True, if the message was delivered to the target entity, otherwise false.
+
+		\see Send
+		*/
+		template <class ValueType, class... ArgTypes>
+		inline bool Emplace(const Address &address, ArgTypes &&... args) const;
+
+		/**
+		\brief Sends a message whose value is constructed in place, without waking a worker thread.
+
+		\see Emplace
+		\see TailSend
+		*/
+		template <class ValueType, class... ArgTypes>
+		inline bool TailEmplace(const Address &address, ArgTypes &&... args) const;
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+		/**
+		\brief Forwards the message being handled to the entity at the given address.
+
+		This method can only be called from within a message handler. Rather than sending
+		a copy of the message, the message itself is passed on to its new recipient once the
+		handlers executed for it have returned, so it isn't copied or reallocated. The message
+		keeps its original sender, so the recipient sees the message as coming from the entity
+		that sent it to this actor.
+
+		\code
+		class Router : public clang::Actor
+		{
+		public:
+
+			struct Parameters
+			{
+				clang::Address mWorker;
+			};
+
+			Router(const Parameters &params) : mWorker(params.mWorker)
+			{
+				RegisterHandler(this, &Router::Route);
+			}
+
+		private:
+
+			inline void Route(const Request &message, const clang::Address from)
+			{
+				// The worker receives the request from the original sender, and replies to it directly.
+				Forward(mWorker);
+			}
+
+			clang::Address mWorker;
+		};
+		\endcode
+
+		\param address The address of the entity to which the message is forwarded.
+		\return True, if the message will be forwarded; false if not called from within a message handler.
+
+		\note The message is delivered after the handler returns, so whether it reaches its target
+		isn't known by the handler. Undelivered messages are passed to the framework's fallback handler.
+		If a handler forwards the same message more than once, it's only forwarded to the last address.
+
+		\see Send
+		*/
+		inline bool Forward(const Address &address);
+
+		/**
+		\brief Enables the actor's inline mailbox, so that small messages sent to it aren't allocated.
+
+		Small messages with trivially copyable values, such as integers and handles, can be
+		held in a ring of \ref XLANG_INLINE_MAILBOX_SLOTS slots owned by the actor, instead of
+		being allocated from the message cache. The ring costs a cache line per slot for the
+		lifetime of the actor, so it's disabled by default, and worth enabling only for actors
+		that are sent a steady stream of small messages.
+
+		\code
+		class Counter : public clang::Actor
+		{
+		public:
+
+			Counter() : mCount(0)
+			{
+				EnableInlineMailbox();
+				RegisterHandler(this, &Counter::Count);
+			}
+
+		private:
+
+			inline void Count(const int &message, const clang::Address from)
+			{
+				mCount += message;
+			}
+
+			int mCount;
+		};
+		\endcode
+
+		\note The ring is allocated when the first small message is sent after the call.
+		Messages are delivered in the order they were sent, whether held inline or not.
+		Has no effect if \ref XLANG_INLINE_MAILBOX_SLOTS is defined as zero.
+		*/
+		inline void EnableInlineMailbox();
+
 	private:
 		Actor(const Actor &other);
 		Actor &operator=(const Actor &other);
@@ -663,12 +850,8 @@ namespace clang
 
 		Address						mAddress;					///< Unique address of this actor.
 		detail::ActorCore*			mCore;						///< Pointer to the core implementation of the actor.
-		u32							mReferenceCount;			///< Counts how many ActorRef instances reference this actor.
+		volatile u32				mReferenceCount;			///< Counts how many ActorRef instances reference this actor.
 		detail::MessageHandler_t	mDefaultMessageHandler;		///< Handler executed for unhandled messages.
-		
-		u32							mNewMessageHandlersNum;
-		u32							mNewMessageHandlersMax;
-		detail::MessageHandler_t	mNewMessageHandlers[32];
 	};
 
 	const int SizeOfMessageHandler = sizeof(detail::MessageHandler_t);
@@ -677,8 +860,6 @@ namespace clang
 		: mAddress(Address::Null())
 		, mCore(0)
 		, mReferenceCount(0)
-		, mNewMessageHandlersNum(0)
-		, mNewMessageHandlersMax(32)
 	{
 		// Pick up the pointer to the referenced actor core object registered prior to construction.
 		// This is a hacky workaround for not being able to pass the core pointer as an Actor
@@ -707,10 +888,8 @@ namespace clang
 
 	XLANG_FORCEINLINE u32 Actor::GetNumQueuedMessages() const
 	{
-		// We lock the core mutex to protect access to the message count.
-		// Messages may be received during the execution of a handler, 
-		// changing the count.
-		detail::Lock lock(mCore->GetMutex());
+		// The count is read atomically since messages may be received
+		// during the execution of a handler, changing the count.
 		return mCore->GetNumQueuedMessages();
 	}
 
@@ -719,104 +898,40 @@ namespace clang
 	{
 		typedef detail::MessageHandler<ActorType, ValueType> MessageHandlerType;
 
-		void *const memory = (void *)&mNewMessageHandlers[mNewMessageHandlersNum];
-
-		// Allocate memory for a message handler object.
-		//void *const memory = AllocatorManager::Instance().GetAllocator()->Allocate(sizeof(MessageHandlerType));
-		//if (memory == 0)
-		//{
-		//	return false;
-		//}
-
 		// Construct a handler object to remember the function pointer and message value type.
-		MessageHandlerType *const messageHandler = new (memory) MessageHandlerType(handler);
-		XLANG_ASSERT(messageHandler);
-
-		// Increase the NewMessageHandlers count to indicate that we have added
-		// a new handler
-		mNewMessageHandlersNum++;
-
-		// Tell the core to update its handler list before processing the actor.
-		mCore->DirtyHandlers();
+		// The core copies it into its handler table, which is shared with other actors of the
+		// same type if their constructors register the same handlers.
+		detail::MessageHandler_t messageHandler;
+		new (&messageHandler) MessageHandlerType(handler);
 
-		return true;
+		return mCore->RegisterHandler(messageHandler);
 	}
 
 
 	template <class ActorType, class ValueType>
-	inline bool Actor::DeregisterHandler(ActorType *const actor, void (ActorType::*handler)(const ValueType &message, const Address from))
+	inline bool Actor::DeregisterHandler(ActorType *const /*actor*/, void (ActorType::*handler)(const ValueType &message, const Address from))
 	{
-		// If the message value type has a valid (non-zero) type name defined for it,
-		// then we use explicit type names to match messages to handlers.
-		// The default value of zero indicates that no type name has been defined,
-		// in which case we rely on compiler-generated RTTI to identify message types.
 		typedef detail::MessageHandler<ActorType, ValueType> MessageHandlerType;
-		typedef detail::MessageHandlerCast<ActorType, detail::MessageTraits<ValueType>::HAS_TYPE_NAME> HandlerCaster;
 
-		// Remove the handler from the main handler list, if it's there.
-		if (mCore->DeregisterHandler<ActorType, ValueType>(actor, handler))
-		{
-			return true;
-		}
+		// Construct a copy of the handler object, which compares equal to the registered one.
+		// The handler is removed from a private copy of the actor's handler table, so a handler
+		// can safely deregister itself or other handlers for the message being processed.
+		detail::MessageHandler_t messageHandler;
+		new (&messageHandler) MessageHandlerType(handler);
 
-		// The handler wasn't in the registered list, maybe it's in the new handlers list.
-		// That can happen if the handler was only just registered prior to this in the same function.
-		// It's a bit weird to register a handler and then immediately deregister it, but legal.
-		for (u32 i=0; i<mNewMessageHandlersNum; ++i)
-		{
-			detail::IMessageHandler* messageHandler = (detail::IMessageHandler*)&mNewMessageHandlers[i];
-			// Try to convert this handler, of unknown type, to the target type.
-			const MessageHandlerType *const typedHandler = HandlerCaster:: template CastHandler<ValueType>(messageHandler);
-			if (typedHandler)
-			{
-				// Don't count the handler if it's already marked for deregistration.
-				if (typedHandler->GetHandlerFunction() == handler && !typedHandler->IsMarked())
-				{
-					// Mark the handler for deregistration.
-					messageHandler->Mark();
-
-					// We don't need to tell the actor to update its handlers since the new handler list is non-empty.
-					XLANG_ASSERT(mCore->AreHandlersDirty());
-
-					return true;
-				}
-			}
-		}
-		return false;
+		return mCore->DeregisterHandler(messageHandler);
 	}
 
 
 	template <class ActorType, class ValueType>
-	inline bool Actor::IsHandlerRegistered(ActorType *const actor, void (ActorType::*handler)(const ValueType &message, const Address from))
+	inline bool Actor::IsHandlerRegistered(ActorType *const /*actor*/, void (ActorType::*handler)(const ValueType &message, const Address from))
 	{
-		// If the message value type has a valid (non-zero) type name defined for it,
-		// then we use explicit type names to match messages to handlers.
-		// The default value of zero indicates that no type name has been defined,
-		// in which case we rely on compiler-generated RTTI to identify message types.
 		typedef detail::MessageHandler<ActorType, ValueType> MessageHandlerType;
-		typedef detail::MessageHandlerCast<ActorType, detail::MessageTraits<ValueType>::HAS_TYPE_NAME> HandlerCaster;
 
-		// Search the currently registered handlers first.
-		if (mCore->IsHandlerRegistered<ActorType, ValueType>(actor, handler))
-		{
-			return true;
-		}
+		detail::MessageHandler_t messageHandler;
+		new (&messageHandler) MessageHandlerType(handler);
 
-		for (u32 i=0; i<mNewMessageHandlersNum; ++i)
-		{
-			detail::IMessageHandler* messageHandler = (detail::IMessageHandler*)&mNewMessageHandlers[i];
-			// Try to convert this handler, of unknown type, to the target type.
-			const MessageHandlerType *const typedHandler = HandlerCaster:: template CastHandler<ValueType>(messageHandler);
-			if (typedHandler)
-			{
-				// Don't count the handler if it's already marked for deregistration.
-				if (typedHandler->GetHandlerFunction() == handler && !typedHandler->IsMarked())
-				{
-					return true;
-				}
-			}
-		}
-		return false;
+		return mCore->IsHandlerRegistered(messageHandler);
 	}
 
 
@@ -893,6 +1008,78 @@ namespace clang
 	}
 
 
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 Actor::Broadcast(const ValueType &value, const ActorGroup &group) const
+	{
+		return detail::MessageSender::Broadcast(
+			mCore->GetFramework(),
+			value,
+			mAddress,
+			group.GetAddresses(),
+			group.GetSize());
+	}
+
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+	template <class ValueType>
+	XLANG_FORCEINLINE typename detail::EnableIfMovable<ValueType, bool>::Type Actor::Send(ValueType &&value, const Address &address) const
+	{
+		return detail::MessageSender::Emplace<ValueType>(
+			mCore->GetFramework(),
+			mAddress,
+			address,
+			detail::Move(value));
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE typename detail::EnableIfMovable<ValueType, bool>::Type Actor::TailSend(ValueType &&value, const Address &address) const
+	{
+		return detail::MessageSender::TailEmplace<ValueType>(
+			mCore->GetFramework(),
+			mAddress,
+			address,
+			detail::Move(value));
+	}
+
+
+	template <class ValueType, class... ArgTypes>
+	XLANG_FORCEINLINE bool Actor::Emplace(const Address &address, ArgTypes &&... args) const
+	{
+		return detail::MessageSender::Emplace<ValueType>(
+			mCore->GetFramework(),
+			mAddress,
+			address,
+			detail::Forward<ArgTypes>(args)...);
+	}
+
+
+	template <class ValueType, class... ArgTypes>
+	XLANG_FORCEINLINE bool Actor::TailEmplace(const Address &address, ArgTypes &&... args) const
+	{
+		return detail::MessageSender::TailEmplace<ValueType>(
+			mCore->GetFramework(),
+			mAddress,
+			address,
+			detail::Forward<ArgTypes>(args)...);
+	}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+	XLANG_FORCEINLINE bool Actor::Forward(const Address &address)
+	{
+		return mCore->SetForwardAddress(address);
+	}
+
+
+	XLANG_FORCEINLINE void Actor::EnableInlineMailbox()
+	{
+		mCore->EnableInlineMailbox();
+	}
+
+
 	XLANG_FORCEINLINE detail::ActorCore &Actor::Core()
 	{
 		return *mCore;
@@ -907,25 +1094,24 @@ namespace clang
 
 	XLANG_FORCEINLINE void Actor::Reference()
 	{
-		detail::Lock lock(mCore->GetMutex());
-		++mReferenceCount;
+		// Actors are only referenced on creation or by copying an existing reference,
+		// so the actor can't be destroyed while we increment the count.
+		detail::Atomic::Increment(&mReferenceCount);
 	}
 
 
 	XLANG_FORCEINLINE void Actor::Dereference()
 	{
-		// We lock the reference count partly to ensure threadsafe access
-		// to the actual count and partly to make sure the actor isn't destroyed
-		// while we're still accessing it, in the case where we decrement the count to zero.
-		detail::Lock lock(mCore->GetMutex());
-
-		XLANG_ASSERT(mReferenceCount > 0);
-		if (--mReferenceCount == 0)
+		XLANG_ASSERT(detail::Atomic::Load(&mReferenceCount) > 0);
+		if (detail::Atomic::Decrement(&mReferenceCount) == 0)
 		{
 			// The framework eventually destroys actors that become unreferenced.
 			// However we have to tell the framework that the actor is dead.
 			// We call this method to wake a single worker thread.
 			// On finding that the actor is unreferenced, the worker thread will destroy it.
+			// We only lock here, on the last dereference, to make sure the actor isn't
+			// destroyed while we're still accessing it.
+			detail::Lock lock(mCore->GetMutex());
 			mCore->Unreference();
 		}
 	}
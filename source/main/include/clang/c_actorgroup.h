@@ -0,0 +1,115 @@
+#ifndef __XLANG_ACTORGROUP_H
+#define __XLANG_ACTORGROUP_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+
+#include "clang/c_Address.h"
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	/**
+	\brief A set of addresses to which messages can be broadcast.
+
+	An ActorGroup holds the addresses of a group of entities (actors or receivers),
+	such as the subscribers to a topic. A value can be sent to every member of the group
+	at once with \ref Framework::Broadcast or \ref Actor::Broadcast, which copy the value
+	only once and share it between the messages received by the members.
+
+	\code
+	clang::ActorGroup subscribers;
+	subscribers.Add(actorOne.GetAddress());
+	subscribers.Add(actorTwo.GetAddress());
+
+	framework.Broadcast(update, receiver.GetAddress(), subscribers);
+	\endcode
+
+	\note ActorGroup objects aren't thread-safe, so a group shouldn't be changed while
+	it's being used by another thread. The order of the addresses in a group isn't defined.
+	*/
+	class ActorGroup
+	{
+	public:
+
+		/// Constructs an empty group.
+		inline ActorGroup();
+
+		/// Destructor.
+		~ActorGroup();
+
+		/// Adds an address to the group.
+		/// \return False if the address is already a member of the group, or if out of memory.
+		bool Add(const Address &address);
+
+		/// Removes an address from the group.
+		/// \return False if the address isn't a member of the group.
+		bool Remove(const Address &address);
+
+		/// Returns true if the address is a member of the group.
+		bool Contains(const Address &address) const;
+
+		/// Removes all the addresses from the group.
+		inline void Clear();
+
+		/// Returns the number of addresses in the group.
+		inline u32 GetSize() const;
+
+		/// Returns the address at the given index within the group.
+		inline const Address &GetAddress(const u32 index) const;
+
+		/// Returns the addresses in the group, as a contiguous array.
+		inline const Address *GetAddresses() const;
+
+	private:
+
+		ActorGroup(const ActorGroup &other);
+		ActorGroup &operator=(const ActorGroup &other);
+
+		Address		*mAddresses;				///< Array of member addresses, allocated with the user allocator.
+		u32			mSize;						///< Number of addresses in the group.
+		u32			mCapacity;					///< Number of addresses the array has room for.
+	};
+
+
+	XLANG_FORCEINLINE ActorGroup::ActorGroup()
+		: mAddresses(0)
+		, mSize(0)
+		, mCapacity(0)
+	{
+	}
+
+
+	XLANG_FORCEINLINE void ActorGroup::Clear()
+	{
+		mSize = 0;
+	}
+
+
+	XLANG_FORCEINLINE u32 ActorGroup::GetSize() const
+	{
+		return mSize;
+	}
+
+
+	XLANG_FORCEINLINE const Address &ActorGroup::GetAddress(const u32 index) const
+	{
+		XLANG_ASSERT(index < mSize);
+		return mAddresses[index];
+	}
+
+
+	XLANG_FORCEINLINE const Address *ActorGroup::GetAddresses() const
+	{
+		return mAddresses;
+	}
+
+
+} // namespace clang
+
+
+#endif // __XLANG_ACTORGROUP_H
@@ -5,6 +5,7 @@
 #pragma once 
 #endif
 
+#include "clang/private/c_Move.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Messages/c_MessageSender.h"
 
@@ -235,6 +236,33 @@ namespace clang
 		template <class ValueType>
 		inline bool Push(const ValueType &value, const Address &from);
 
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		/**
+		\brief Pushes a message into the referenced actor, moving the value into the message.
+
+		Chosen instead of \ref Push for temporaries and values passed with std::move.
+
+		\see Push
+		*/
+		template <class ValueType>
+		inline typename detail::EnableIfMovable<ValueType, bool>::Type Push(ValueType &&value, const Address &from);
+
+		/**
+		\brief Pushes a message whose value is constructed in place from the given arguments.
+
+		\tparam ValueType The message type, which must be specified explicitly.
+		\param from The address of the sending entity.
+		\param args The arguments passed to the constructor of the message value.
+		\return True, if the actor accepted the message.
+
+		\see Push
+		*/
+		template <class ValueType, class... ArgTypes>
+		inline bool Emplace(const Address &from, ArgTypes &&... args);
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
 		/**
 		\brief Gets the number of messages queued at this actor, awaiting processing.
 
@@ -285,10 +313,17 @@ namespace clang
 
 	XLANG_FORCEINLINE ActorRef &ActorRef::operator=(const ActorRef &other)
 	{
-		Dereference();
+		// Reference the new actor before dereferencing the old one, so that assigning
+		// a reference to itself can't drop the count to zero.
+		Actor *const previous(mActor);
 		mActor = other.mActor;
 		Reference();
 
+		if (previous)
+		{
+			previous->Dereference();
+		}
+
 		return *this;
 	}
 
@@ -347,6 +382,32 @@ namespace clang
 	}
 
 
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+	template <class ValueType>
+	XLANG_FORCEINLINE typename detail::EnableIfMovable<ValueType, bool>::Type ActorRef::Push(ValueType &&value, const Address &from)
+	{
+		return detail::MessageSender::Emplace<ValueType>(
+			&mActor->GetFramework(),
+			from,
+			mActor->GetAddress(),
+			detail::Move(value));
+	}
+
+
+	template <class ValueType, class... ArgTypes>
+	XLANG_FORCEINLINE bool ActorRef::Emplace(const Address &from, ArgTypes &&... args)
+	{
+		return detail::MessageSender::Emplace<ValueType>(
+			&mActor->GetFramework(),
+			from,
+			mActor->GetAddress(),
+			detail::Forward<ArgTypes>(args)...);
+	}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
 	XLANG_FORCEINLINE u32 ActorRef::GetNumQueuedMessages() const
 	{
 		return mActor->GetNumQueuedMessages();
@@ -6,8 +6,7 @@
 #endif
 
 #include "clang/private/c_BasicTypes.h"
-#include "clang/private/Threading/c_Mutex.h"
-#include "clang/private/Threading/c_Lock.h"
+#include "clang/private/Threading/c_Atomic.h"
 
 #include "clang/c_Defines.h"
 
@@ -16,6 +15,7 @@ namespace clang
 	namespace detail
 	{
 		class ActorDirectory;
+		class IMessage;
 		class ReceiverDirectory;
 	}
 
@@ -46,14 +46,15 @@ namespace clang
 	unless the actor publicly exposes their addresses.
 
 	\note The maximum numbers of actor and receiver addresses in clang are limited
-	by the \ref XLANG_MAX_ACTORS and \ref XLANG_MAX_RECEIVERS defines, which can
-	both be overridden in user projects via project-level definitions.
+	by the maxima passed to the Framework in its \ref Framework::Parameters, which
+	default to the \ref XLANG_MAX_ACTORS and \ref XLANG_MAX_RECEIVERS defines.
 	*/
 	class Address
 	{
 	public:
 
 		friend class detail::ActorDirectory;
+		friend class detail::IMessage;
 		friend class detail::ReceiverDirectory;
 
 		/**
@@ -148,7 +149,10 @@ namespace clang
 		}
 
 		/**
-		\brief Gets the unique value of the address as an unsigned integer.
+		\brief Gets the value of the address as an unsigned integer, for display.
+
+		\note Addresses are unique 64-bit values. This returns the low 32 bits of the value,
+		which may be shared with other addresses in programs that create billions of entities.
 
 		\code
 		class Actor : public clang::Actor
@@ -163,7 +167,7 @@ namespace clang
 		*/
 		XLANG_FORCEINLINE u32 AsInteger() const
 		{
-			return mSequence;
+			return static_cast<u32>(mSequence);
 		}
 
 		/**
@@ -220,43 +224,47 @@ namespace clang
 
 		static const u32 RECEIVER_FLAG = (1UL << 31);
 
-		static detail::Mutex smMutex;       ///< Mutex that protects access to the static 'next value' member.
-		static u32 smNextValue;        ///< Static member that remembers the next unique address value.
+		/// Number of sequence numbers claimed by a thread at once.
+		static const u32 SEQUENCE_BLOCK_SIZE = 64;
+
+		static volatile u64 smNextValue;                        ///< Start of the next block of unique address values.
+		static XLANG_THREAD_LOCAL u64 smNextBlockValue;         ///< Next unclaimed value in the calling thread's block.
+		static XLANG_THREAD_LOCAL u64 smEndBlockValue;          ///< End of the calling thread's block of values.
 
 		/// \brief Returns the next unique address in sequence.
-		inline static u32 GetNextSequenceNumber()
+		/// Each thread claims blocks of sequence numbers with a single atomic add, and hands them
+		/// out without synchronization. Sequence numbers are 64-bit so they never wrap around,
+		/// and an old address can never match a new entity registered at the same index.
+		inline static u64 GetNextSequenceNumber()
 		{
-			detail::Lock lock(smMutex);
-
-			// Skip the special null value.
-			if (smNextValue)
+			if (smNextBlockValue == smEndBlockValue)
 			{
-				return smNextValue++;
+				smEndBlockValue = detail::Atomic::Add(&smNextValue, SEQUENCE_BLOCK_SIZE);
+				smNextBlockValue = smEndBlockValue - SEQUENCE_BLOCK_SIZE;
 			}
 
-			smNextValue = 2;
-			return 1;
+			return smNextBlockValue++;
 		}
 
 		XLANG_FORCEINLINE static Address MakeActorAddress(const u32 index)
 		{
-			const u32 sequence(GetNextSequenceNumber());
+			const u64 sequence(GetNextSequenceNumber());
 			return Address(sequence, index);
 		}
 
 		XLANG_FORCEINLINE static Address MakeReceiverAddress(const u32 index)
 		{
-			const u32 sequence(GetNextSequenceNumber());
+			const u64 sequence(GetNextSequenceNumber());
 			return Address(sequence, index | Address::RECEIVER_FLAG);
 		}
 
 		/// Constructor that accepts a specific value for the address.
 		/// \param value The value for the newly constructed address.
-		XLANG_FORCEINLINE Address(const u32 sequence, const u32 index) : mSequence(sequence), mIndex(index)
+		XLANG_FORCEINLINE Address(const u64 sequence, const u32 index) : mSequence(sequence), mIndex(index)
 		{
 		}
 
-		XLANG_FORCEINLINE u32 GetSequence() const
+		XLANG_FORCEINLINE u64 GetSequence() const
 		{
 			return mSequence;
 		}
@@ -266,7 +274,7 @@ namespace clang
 			return (mIndex & (~RECEIVER_FLAG));
 		}
 
-		u32 mSequence;                 ///< Unique sequence number.
+		u64 mSequence;                 ///< Unique sequence number.
 		u32 mIndex;                    ///< Pool index at which the addressed entity is registered.
 	};
 
@@ -366,7 +366,8 @@ namespace clang
 		// We assume underlying allocations are always MIN_ALIGNMENT aligned, so padding is at most (alignment-MIN_ALIGNMENT) bytes.
 		const u32 preambleSize(numPreFields * sizeof(u32));
 		const u32 postambleSize(numPostFields * sizeof(u32));
-		const u32 internalSize(preambleSize + ((size + (alignment - 1)) & ~(alignment - 1)) + postambleSize);
+		const u32 paddingSize(alignment > MIN_ALIGNMENT ? alignment - MIN_ALIGNMENT : 0);
+		const u32 internalSize(preambleSize + paddingSize + ((size + (alignment - 1)) & ~(alignment - 1)) + postambleSize);
 
 		u32 *const block = reinterpret_cast<u32 *>(new unsigned char[internalSize]);
 		XLANG_ASSERT_MSG(XLANG_ALIGNED(block, MIN_ALIGNMENT), "Global new is assumed to always align to MIN_ALIGNMENT boundaries");
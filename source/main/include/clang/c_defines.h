@@ -120,6 +120,70 @@ be easily overridden just by defining the defines yourself globally in your buil
 #endif // XLANG_FORCEINLINE
 
 
+#ifndef XLANG_THREAD_LOCAL
+	#ifdef _MSC_VER
+		#define XLANG_THREAD_LOCAL __declspec(thread)
+	#elif defined(__GNUC__)
+		#define XLANG_THREAD_LOCAL __thread
+	#else
+		/**
+		\brief Storage class keyword for variables with one instance per thread.
+
+		Used internally by the scheduler so that a worker thread can find its own work queue
+		without a lookup. Defaults to __declspec(thread) for Visual C++ and __thread for gcc.
+
+		The definition of \ref XLANG_THREAD_LOCAL can be overridden by defining it globally
+		in the build (in the makefile using -D, or in the project preprocessor settings
+		in Visual Studio).
+		*/
+		#define XLANG_THREAD_LOCAL thread_local
+	#endif
+#endif // XLANG_THREAD_LOCAL
+
+
+#ifndef XLANG_ENABLE_MOVE_SEMANTICS
+	#if (defined(__cplusplus) && __cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1800)
+		#define XLANG_ENABLE_MOVE_SEMANTICS 1
+	#else
+		/**
+		\brief Enables the message sending overloads that move or construct message values in place.
+
+		When enabled, \ref clang::Actor::Send "Send" and its variants accept rvalues, which are moved
+		into the message rather than copied, and the Emplace variants construct message values
+		directly inside the message from their constructor arguments. Both need rvalue references and
+		variadic templates, so are enabled by default when compiling as C++11 or later.
+
+		The value of \ref XLANG_ENABLE_MOVE_SEMANTICS can be overridden by defining it globally in the
+		build (in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+		*/
+		#define XLANG_ENABLE_MOVE_SEMANTICS 0
+	#endif
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+#ifndef XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+	#if (defined(__cplusplus) && __cplusplus >= 201103L) || (defined(_MSC_VER) && _MSC_VER >= 1900)
+		#define XLANG_ENABLE_CONSTEXPR_TYPE_IDS 1
+	#else
+		/**
+		\brief Enables message type ids computed at compile time.
+
+		Each message carries the id of its value type, which actors compare with the ids of
+		their registered handlers to dispatch it. When enabled, the id of an unregistered message
+		type is a hash of its name computed by the compiler, so ids are constants that are the same
+		in every run of the same build. Otherwise ids are handed out in order of first use at run time.
+		Ids set explicitly with \ref XLANG_REGISTER_MESSAGE_ID are constants either way.
+
+		Needs constexpr functions, so is enabled by default when compiling as C++11 or later.
+
+		The value of \ref XLANG_ENABLE_CONSTEXPR_TYPE_IDS can be overridden by defining it globally in the
+		build (in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+		*/
+		#define XLANG_ENABLE_CONSTEXPR_TYPE_IDS 0
+	#endif
+#endif // XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+
+
 #ifndef XLANG_ENABLE_DEFAULTALLOCATOR_CHECKS
 	// Support XLANG_ENABLE_SIMPLEALLOCATOR_CHECKS as a legacy synonym.
 	#if defined(XLANG_ENABLE_SIMPLEALLOCATOR_CHECKS)
@@ -148,37 +212,18 @@ be easily overridden just by defining the defines yourself globally in your buil
 
 #ifndef XLANG_ENABLE_MESSAGE_REGISTRATION_CHECKS
 	/**
-	\brief Enables run-time reporting of unregistered message types, which is off by default.
-
-	Message types can be registered using the \ref XLANG_REGISTER_MESSAGE macro, which notifies
-	clang of the unique name of a message type. Registering the message types sent within an
-	application causes clang's internal type ID system to be used to identity messages when they
-	arrive at an actor, instead of the built-in C++ typeid system.
-
-	This has two useful effects: Firstly, it avoids calling the slow C++ dynamic_cast
-	operator, and instead performs a simple check on the unique name associated with each message type
-	(a fast pointer comparison). Secondly, it allows the C++ compiler's built-in Run-Time Type
-	Information (RTTI) system to be disabled, which avoids storing compiler-generated type IDs in
-	classes.
+	\brief Enables run-time reporting of unregistered message types.
 
-	However this efficiency comes with a catch: once we start registering message types, we
-	have to remember to consistently always register *every* message type used by the application.
-	If any of the message types are omitted, then errors may ensue (usually caught by asserts,
-	in debug builds).
+	Message types can be registered using the \ref XLANG_REGISTER_MESSAGE_ID and \ref XLANG_REGISTER_MESSAGE
+	macros, which give a message type an explicit id. Unregistered message types are given ids generated
+	from their names, so every message type has a non-zero id and messages are matched to handlers by
+	comparing ids, without calling dynamic_cast or relying on the C++ Run-Time Type Information (RTTI)
+	system, which can be disabled.
 
-	To make this easier, define \ref XLANG_ENABLE_MESSAGE_REGISTRATION_CHECKS as 1 in your local
-	build (ideally globally with a compiler option). This enables run-time error reports that
-	helpfully detect message types that haven't been registered.
+	Registering message types is therefore optional, and unregistered types aren't an error, so this
+	define has no effect. It's kept so that builds which define it still compile.
 
-	Of course, you should only enable this checking if you are actually intending to register your
-	message types! If you don't care about the overheads of RTTI and dynamic_cast, then it's perfectly
-	fine (and a lot simpler) to just not register *any* message types at all -- and leave this define
-	disabled -- and then everything will work as normal.
-
-	\note Note that unregistered message types are reported by asserts, so are only active if assert
-	code is also enabled via \ref XLANG_ENABLE_ASSERTS.
-
-	\see <a href="http://www.theron-library.com/index.php?t=page&p=RegisteringMessages">Registering messages</a>
+	\see XLANG_REGISTER_MESSAGE_ID
 	*/
 	#define XLANG_ENABLE_MESSAGE_REGISTRATION_CHECKS 1
 #endif // XLANG_ENABLE_MESSAGE_REGISTRATION_CHECKS
@@ -218,6 +263,29 @@ be easily overridden just by defining the defines yourself globally in your buil
 #endif // XLANG_ENABLE_UNHANDLED_MESSAGE_CHECKS
 
 
+#ifndef XLANG_USE_LINUX_THREADS
+	#if defined(__linux__)
+		#define XLANG_USE_LINUX_THREADS 1
+	#else
+		/**
+		\brief Selects the native Linux threading backend.
+
+		When defined as 1, clang's internal Thread, Mutex, Lock and Monitor classes are
+		implemented directly on POSIX threads and Linux futexes, instead of on the Win32
+		threading API. The futex-based Mutex spins briefly before sleeping in the kernel,
+		and only issues a wake system call when another thread is actually waiting.
+
+		Defaults to 1 when building for Linux, and to 0 otherwise.
+
+		The value of \ref XLANG_USE_LINUX_THREADS can be overridden by defining it
+		globally in the build (in the makefile using -D, or in the project preprocessor
+		settings in Visual Studio).
+		*/
+		#define XLANG_USE_LINUX_THREADS 0
+	#endif // defined(__linux__)
+#endif // XLANG_USE_LINUX_THREADS
+
+
 #ifndef XLANG_MAX_THREADS_PER_FRAMEWORK
 	/**
 	\brief Hard limit on the maximum number of worker threads software is allowed to enable.
@@ -237,13 +305,69 @@ be easily overridden just by defining the defines yourself globally in your buil
 #endif // XLANG_MAX_THREADS_PER_FRAMEWORK
 
 
+#ifndef XLANG_CACHELINE_SIZE
+	/**
+	\brief Size in bytes of a processor cache line.
+
+	Data written frequently by different threads, such as the per-worker scheduling queues,
+	is padded and aligned to this size so that writes by one thread don't invalidate the
+	cache lines read by another (false sharing).
+
+	Defaults to 64, which is correct for current x86, x64 and most ARM processors.
+
+	The value of \ref XLANG_CACHELINE_SIZE can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_CACHELINE_SIZE 64
+#endif // XLANG_CACHELINE_SIZE
+
+
+#ifndef XLANG_DEFAULT_MESSAGE_QUANTUM
+	/**
+	\brief Default maximum number of messages an actor processes each time it's scheduled.
+
+	A worker thread that picks up an actor processes up to this many of its queued messages
+	before moving on to other work, so that the scheduling costs are shared by the whole batch.
+	Larger values improve the throughput of busy actors, while smaller values let other actors
+	run sooner. The quantum can be changed at runtime with \ref clang::Framework::SetMessageQuantum
+	"Framework::SetMessageQuantum".
+
+	Defaults to 32.
+
+	The value of \ref XLANG_DEFAULT_MESSAGE_QUANTUM can be overridden by defining it globally in the
+	build (in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_DEFAULT_MESSAGE_QUANTUM 32
+#endif // XLANG_DEFAULT_MESSAGE_QUANTUM
+
+
+#ifndef XLANG_DEFAULT_IDLE_SPIN_COUNT
+	/**
+	\brief Default maximum number of times an idle worker thread polls for work before sleeping.
+
+	A worker thread that runs out of work spins for a while, polling the work queues with a
+	processor pause between polls, before going to sleep. Work that arrives during the spin is
+	picked up without the cost of waking a sleeping thread in the kernel. Each worker adapts the
+	length of its spin between a small minimum and this maximum, spinning for longer when spinning
+	finds work and for less time when it doesn't. The maximum can be changed at runtime with
+	\ref clang::Framework::SetIdleSpinCount "Framework::SetIdleSpinCount", and zero disables spinning.
+
+	Defaults to 1024.
+
+	The value of \ref XLANG_DEFAULT_IDLE_SPIN_COUNT can be overridden by defining it globally in the
+	build (in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_DEFAULT_IDLE_SPIN_COUNT 1024
+#endif // XLANG_DEFAULT_IDLE_SPIN_COUNT
+
+
 #ifndef XLANG_MAX_ACTORS
 	/**
-	\brief Limits the maximum number of actors that can be created at once within clang.
+	\brief Default maximum number of actors that can be created at once within clang.
 
-	If you want to create a very large number of simultaneous actors then you'll need to
-	change the value of this define. Note that doing so may lead to higher fixed memory
-	overheads, so should be avoided unless really necessary.
+	The maximum can be raised at runtime with \ref clang::Framework::Parameters::mMaxActors
+	when constructing a Framework. Memory for actors and the tables that index them is only
+	allocated as actors are created, so a large maximum has little fixed memory overhead.
 
 	Defaults to 8192.
 
@@ -256,11 +380,11 @@ be easily overridden just by defining the defines yourself globally in your buil
 
 #ifndef XLANG_MAX_RECEIVERS
 	/**
-	\brief Limits the maximum number of receivers that can be created at once within clang.
+	\brief Default maximum number of receivers that can be created at once within clang.
 
-	If you want to create a very large number of simultaneous receivers then you'll need to
-	change the value of this define. Note that doing so may lead to higher fixed memory
-	overheads, so should be avoided unless really necessary.
+	The maximum can be raised at runtime with \ref clang::Framework::Parameters::mMaxReceivers
+	when constructing a Framework. Memory for receivers and the tables that index them is only
+	allocated as receivers are created, so a large maximum has little fixed memory overhead.
 
 	Defaults to 256.
 
@@ -271,5 +395,102 @@ be easily overridden just by defining the defines yourself globally in your buil
 #endif // XLANG_MAX_RECEIVERS
 
 
+#ifndef XLANG_INLINE_MAILBOX_SLOTS
+	/**
+	\brief Number of small messages each actor can hold inline, without allocating them.
+
+	Small messages with trivially copyable values, such as integers, handles and small
+	structs, sent to actors that call Actor::EnableInlineMailbox, are copied into a ring of
+	fixed-size slots owned by the receiving actor, instead of being allocated from the message cache. Messages that don't fit, or that arrive while
+	all the slots are in use, are allocated as usual. Either way messages are queued in the
+	order they were sent, so the ring is invisible except in the allocations it saves.
+
+	Each slot takes a cache line, held until the actor is destroyed, so the ring is disabled
+	by default and only allocated for actors that enable it and are then sent small messages.
+	Defining the value as zero disables the ring for all actors.
+
+	Defaults to 16.
+
+	The value of \ref XLANG_INLINE_MAILBOX_SLOTS can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_INLINE_MAILBOX_SLOTS 16
+#endif // XLANG_INLINE_MAILBOX_SLOTS
+
+
+#ifndef XLANG_MESSAGE_CACHE_MAX_BLOCK_SIZE
+	/**
+	\brief Size in bytes of the largest message memory block cached for reuse.
+
+	Freed message memory blocks are cached in pools of geometrically spaced size classes,
+	four per doubling of size, so that they can be reused by later messages of similar size
+	without calling the allocator. Blocks larger than this size are always allocated from,
+	and freed to, the allocator. Must be a power of two, and at least 64.
+
+	Defaults to 32768.
+
+	The value of \ref XLANG_MESSAGE_CACHE_MAX_BLOCK_SIZE can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_MESSAGE_CACHE_MAX_BLOCK_SIZE 32768
+#endif // XLANG_MESSAGE_CACHE_MAX_BLOCK_SIZE
+
+
+#ifndef XLANG_MESSAGE_CACHE_MAX_BYTES
+	/**
+	\brief Limits the memory that the shared message cache can hold, in bytes.
+
+	The number of freed message memory blocks cached for each size class grows whenever
+	freed blocks overflow it, so that bursts of messages are eventually served entirely
+	from the cache. The total size of the blocks that the shared cache can hold, across all
+	size classes, is capped at this value. Blocks cached by individual worker threads are
+	limited separately, and aren't counted.
+
+	Defaults to 4MB.
+
+	The value of \ref XLANG_MESSAGE_CACHE_MAX_BYTES can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_MESSAGE_CACHE_MAX_BYTES (4 * 1024 * 1024)
+#endif // XLANG_MESSAGE_CACHE_MAX_BYTES
+
+
+#ifndef XLANG_DIRECTORY_SPARE_PAGES
+	/**
+	\brief Number of unused pages of actors or receivers that the directories keep for reuse.
+
+	Actors and receivers are registered in pages of 64 entries. Pages left unused when
+	actors or receivers are destroyed are kept, up to this number, so that creating and
+	destroying actors around a page boundary doesn't repeatedly allocate and free pages.
+	Further unused pages are released to the allocator, as are all the kept pages once
+	no actors or receivers remain.
+
+	Defaults to 4.
+
+	The value of \ref XLANG_DIRECTORY_SPARE_PAGES can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_DIRECTORY_SPARE_PAGES 4
+#endif // XLANG_DIRECTORY_SPARE_PAGES
+
+
+#ifndef XLANG_DIRECTORY_PREFER_LOW_INDICES
+	/**
+	\brief Enables allocation of actors and receivers at the lowest free directory index.
+
+	By default newly registered actors and receivers are allocated in the page last
+	allocated from, while it has room, which is fastest. When this define is non-zero
+	they're instead allocated at the lowest free index, keeping the used part of the
+	directories dense and leaving unused pages at the top, where they're released first.
+
+	Defaults to 0 (disabled).
+
+	The value of \ref XLANG_DIRECTORY_PREFER_LOW_INDICES can be overridden by defining it globally in the build
+	(in the makefile using -D, or in the project preprocessor settings in Visual Studio).
+	*/
+	#define XLANG_DIRECTORY_PREFER_LOW_INDICES 0
+#endif // XLANG_DIRECTORY_PREFER_LOW_INDICES
+
+
 #endif // XLANG_DEFINES_H
 
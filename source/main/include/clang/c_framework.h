@@ -6,6 +6,7 @@
 #endif
 
 #include "clang/c_Actor.h"
+#include "clang/c_ActorGroup.h"
 #include "clang/c_ActorRef.h"
 #include "clang/c_Address.h"
 #include "clang/c_AllocatorManager.h"
@@ -13,6 +14,7 @@
 #include "clang/c_Receiver.h"
 
 #include "clang/private/c_BasicTypes.h"
+#include "clang/private/c_Move.h"
 #include "clang/private/Core/c_ActorConstructor.h"
 #include "clang/private/Core/c_ActorCore.h"
 #include "clang/private/Core/c_ActorCreator.h"
@@ -21,6 +23,7 @@
 #include "clang/private/Handlers/c_DefaultFallbackHandler.h"
 #include "clang/private/Handlers/c_FallbackHandler.h"
 #include "clang/private/Handlers/c_IFallbackHandler.h"
+#include "clang/private/MessageCache/c_PayloadCache.h"
 #include "clang/private/Messages/c_IMessage.h"
 #include "clang/private/Messages/c_MessageSender.h"
 #include "clang/private/Threading/c_Mutex.h"
@@ -60,9 +63,10 @@ namespace clang
 	The worker threads are created and synchronized using underlying threading
 	objects. Different implementations of these threading objects are possible,
 	allowing clang to be used in environments with different threading primitives.
-	Currently, implementations based on Win32 threads and Boost threads are
-	provided. Users can use the \ref XLANG_USE_BOOST_THREADS define to enable
-	or disable the use of Boost threads.
+	Currently, implementations based on Win32 threads and on native Linux threads
+	(POSIX threads with futex-based mutexes and monitors) are provided. Users can use
+	the \ref XLANG_USE_LINUX_THREADS define to select the Linux implementation, which
+	is enabled by default in Linux builds.
 
 	It's possible to create more than one Framework in an application. Actors created
 	within each Framework are executed only by the worker threads in the threadpool
@@ -70,9 +74,14 @@ namespace clang
 	to particular actors. See the \ref Framework::Framework "constructor" for more
 	information.
 
-	The maximum number of actors that can be created in an application is limited
-	by the \ref XLANG_MAX_ACTORS define, which defines the number of unique
-	actor addresses. This limit is per-application, rather than per-framework.
+	The maximum number of actors that can exist at once in an application is limited
+	by the \ref Parameters::mMaxActors "maximum" passed to the Framework constructor,
+	which defaults to the value of the \ref XLANG_MAX_ACTORS define. This limit is
+	per-application, rather than per-framework: it's the largest maximum passed to any
+	Framework. Memory for actors is only allocated as they're created, so a large
+	maximum costs little while few actors exist.
+	If the limit can't be raised for lack of memory, the previous limit is kept, and
+	in builds with \ref XLANG_ENABLE_ASSERTS the constructor asserts.
 
 	\note An important point about Framework objects is that they must always
 	outlive the actors created within them. See the destructor documentation
@@ -90,6 +99,38 @@ namespace clang
 		friend class detail::ActorCore;
 		friend class detail::MessageSender;
 
+		/**
+		\brief Parameters structure that can be passed to the Framework constructor.
+
+		\code
+		// Create a framework with 8 worker threads, able to hold ten million actors at once.
+		clang::Framework::Parameters params(8, 16);
+		params.mMaxActors = 10000000;
+
+		clang::Framework framework(params);
+		\endcode
+		*/
+		struct Parameters
+		{
+			/// Constructor.
+			inline explicit Parameters(
+				const u32 threadCount = 2,
+				const u32 targetThreadCount = 4,
+				const u32 maxActors = XLANG_MAX_ACTORS,
+				const u32 maxReceivers = XLANG_MAX_RECEIVERS)
+				: mThreadCount(threadCount)
+				, mTargetThreadCount(targetThreadCount)
+				, mMaxActors(maxActors)
+				, mMaxReceivers(maxReceivers)
+			{
+			}
+
+			u32 mThreadCount;           ///< Number of worker threads to create initially.
+			u32 mTargetThreadCount;     ///< Number of worker threads the threadpool aims for.
+			u32 mMaxActors;             ///< Maximum number of actors that can exist at once, in all frameworks.
+			u32 mMaxReceivers;          ///< Maximum number of receivers that can exist at once.
+		};
+
 		/**
 		\brief Enumerated type that lists event counters available for querying.
 
@@ -104,7 +145,9 @@ namespace clang
 		counted: only those where the arrived message could be processed immediately if a sleeping
 		thread could be woken. Messages that arrive at actors which are already scheduled for processing
 		for earlier messages can't be processed immediately anyway, since messages are processed one at a
-		time (serially) within each actor.
+		time (serially) within each actor. Nor are arrivals counted while a worker thread is spinning
+		while polling for work, since the spinning thread picks up the message without being woken.
+		See \ref SetIdleSpinCount.
 
 		The effect of pulsing the pool is to wake a single worker thread, if one or more sleeping threads
 		are available. If all worker threads are already awake, then the pulse has no effect. The
@@ -127,6 +170,22 @@ namespace clang
 		Finally, the \ref COUNTER_MESSAGES_PROCESSED counter counts the number of messages that
 		were processed by all threads in the threadpool. This gives a rough indication of workload.
 
+		Each time a worker thread picks up an actor it processes a batch of up to \ref GetMessageQuantum
+		"the message quantum" of its queued messages. The \ref COUNTER_MESSAGE_BATCHES counter counts
+		those batches, and \ref COUNTER_AVERAGE_BATCH_SIZE reports the average number of messages in
+		each, rounded down. Averages close to one mean that actors are rarely sent messages faster
+		than they process them, in which case the quantum has little effect.
+
+		Worker threads that run out of work take actors from the queues of other worker threads,
+		counted by \ref COUNTER_ACTORS_STOLEN, and spin for a while before going to sleep. The
+		\ref COUNTER_SPINS_SUCCEEDED counter counts the number of times a spinning thread found
+		work, and so avoided having to be woken again. See \ref SetIdleSpinCount.
+
+		The counters are 64-bit. Each worker thread keeps its own counts, on cache lines of its own,
+		so counting doesn't involve any locks or contended memory. Reading a counter sums the
+		counts of all the threads, so it can be done at any time, from any thread, without slowing
+		down message processing.
+
 		\note All the counters are local to each Framework instance, and count events in
 		the queried Framework only.
 
@@ -137,6 +196,10 @@ namespace clang
 			COUNTER_MESSAGES_PROCESSED = 0,     ///< Number of arrived actor messages processed by the framework.
 			COUNTER_THREADS_PULSED,             ///< Number of times the framework pulsed its threadpool to wake a thread.
 			COUNTER_THREADS_WOKEN,              ///< Number of threads actually woken by pulse events.
+			COUNTER_MESSAGE_BATCHES,            ///< Number of batches of messages processed by actors in the framework.
+			COUNTER_AVERAGE_BATCH_SIZE,         ///< Average number of messages processed in each batch.
+			COUNTER_ACTORS_STOLEN,              ///< Number of actors taken by idle threads from the queues of other threads.
+			COUNTER_SPINS_SUCCEEDED,            ///< Number of times a spinning idle thread found work without sleeping.
 			MAX_COUNTERS                        ///< Number of counters available for querying.
 		};
 
@@ -176,6 +239,19 @@ namespace clang
 		explicit Framework(const u32 numThreads);
 		explicit Framework(const u32 numThreads, const u32 targetNumThreads);
 
+		/**
+		\brief Constructor.
+
+		Constructs a framework with the given \ref Parameters.
+
+		The actor and receiver directories are shared by all frameworks, so the maxima of
+		actors and receivers are raised to those given, if they're lower. They're never
+		lowered. The directories allocate their page tables in segments as actors and
+		receivers are created, and release them as they're destroyed, so the maxima only
+		limit how far they can grow.
+		*/
+		explicit Framework(const Parameters &params);
+
 		/**
 		\brief Destructor.
 
@@ -208,8 +284,8 @@ namespace clang
 		\endcode
 
 		The maximum number of actors that can be created in an application (across all
-		frameworks) is limited by the \ref XLANG_MAX_ACTORS define, whose default value
-		is defined in \ref Defines.h.
+		frameworks) is limited by the largest \ref Parameters::mMaxActors passed to any
+		framework, which defaults to the \ref XLANG_MAX_ACTORS define.
 
 		\note It is important that the framework in which an actor is created
 		must always outlive it. It is the caller's responsibility to not allow
@@ -254,8 +330,8 @@ namespace clang
 		\endcode
 
 		The maximum number of actors that can be created in an application (across all
-		frameworks) is limited by the \ref XLANG_MAX_ACTORS define, whose default value
-		is defined in \ref Defines.h.
+		frameworks) is limited by the largest \ref Parameters::mMaxActors passed to any
+		framework, which defaults to the \ref XLANG_MAX_ACTORS define.
 
 		\tparam ActorType The actor class to be instantiated.
 		\param params An instance of the Parameters type exposed by the ActorType class.
@@ -315,6 +391,123 @@ namespace clang
 		template <class ValueType>
 		inline bool Send(const ValueType &value, const Address &from, const Address &to) const;
 
+		/**
+		\brief Sends a message to every entity (actor or receiver) in the given group.
+
+		The value is copied only once, and the copy is shared by the messages received by
+		the members of the group, which are all scheduled before any worker threads are woken.
+		This is much cheaper than sending the value to each member in turn with \ref Send.
+
+		\code
+		clang::ActorGroup subscribers;
+		subscribers.Add(actorOne.GetAddress());
+		subscribers.Add(actorTwo.GetAddress());
+
+		framework.Broadcast(update, receiver.GetAddress(), subscribers);
+		\endcode
+
+		\tparam ValueType The message type.
+		\param value The message value.
+		\param from The address of the sending entity (typically a receiver).
+		\param group The addresses of the target entities.
+		\return The number of members of the group to which the message was delivered.
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline u32 Broadcast(const ValueType &value, const Address &from, const ActorGroup &group) const;
+
+		/**
+		\brief Sends each of an array of values as a message to the entity at the given address.
+
+		Sending many values with a single call is much cheaper than sending them one at a time
+		with \ref Send. The messages are allocated together, and the target actor is scheduled
+		once, with worker threads woken only after all of the messages have been queued.
+
+		\code
+		WorkItem items[1000];
+		FillWorkItems(items, 1000);
+
+		framework.SendBatch(items, 1000, receiver.GetAddress(), worker.GetAddress());
+		\endcode
+
+		The messages arrive in the order of the values in the array, as if they had been
+		sent one at a time in that order.
+
+		\tparam ValueType The message type.
+		\param values The array of message values.
+		\param count The number of values in the array.
+		\param from The address of the sending entity (typically a receiver).
+		\param to The address of the target entity (an actor or a receiver).
+		\return The number of messages delivered, which is less than the count if the target
+		doesn't exist or if out of memory.
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline u32 SendBatch(const ValueType *const values, const u32 count, const Address &from, const Address &to) const;
+
+		/**
+		\brief Sends each of an array of values as a message to the entity at the corresponding address.
+
+		Like the single-destination \ref SendBatch, but the value at each index in the array
+		is sent to the address at the same index in the array of addresses. Worker threads are
+		woken once for the whole batch, however many different actors receive messages.
+		Messages sent to the same address arrive in the order of the values in the array.
+
+		\code
+		for (clang::u32 index = 0; index < 1000; ++index)
+		{
+			targets[index] = workers[index % numWorkers].GetAddress();
+		}
+
+		framework.SendBatch(items, 1000, receiver.GetAddress(), targets);
+		\endcode
+
+		\tparam ValueType The message type.
+		\param values The array of message values.
+		\param count The number of values, and of addresses.
+		\param from The address of the sending entity (typically a receiver).
+		\param to The array of addresses of the target entities, one per value.
+		\return The number of messages delivered.
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline u32 SendBatch(const ValueType *const values, const u32 count, const Address &from, const Address *const to) const;
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		/**
+		\brief Sends a message, moving the value into the message rather than copying it.
+
+		Chosen instead of \ref Send for temporaries and values passed with std::move.
+
+		\see Send
+		*/
+		template <class ValueType>
+		inline typename detail::EnableIfMovable<ValueType, bool>::Type Send(ValueType &&value, const Address &from, const Address &to) const;
+
+		/**
+		\brief Sends a message whose value is constructed in place from the given arguments.
+
+		\code
+		framework.Emplace<std::string>(receiver.GetAddress(), actor.GetAddress(), "Hello");
+		\endcode
+
+		\tparam ValueType The message type, which must be specified explicitly.
+		\param from The address of the sending entity (typically a receiver).
+		\param to The address of the target entity (an actor or a receiver).
+		\param args The arguments passed to the constructor of the message value.
+		\return True, if the message was delivered to an entity, otherwise false.
+
+		\see Send
+		*/
+		template <class ValueType, class... ArgTypes>
+		inline bool Emplace(const Address &from, const Address &to, ArgTypes &&... args) const;
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
 		/**
 		\brief Specifies a maximum limit on the number of worker threads enabled in this framework.
 
@@ -446,6 +639,66 @@ namespace clang
 		*/
 		inline u32 GetPeakThreads() const;
 
+		/**
+		\brief Sets the maximum number of messages an actor processes each time it's scheduled.
+
+		When a worker thread picks up an actor with queued messages, it processes up to this
+		many of them in one batch before moving on to other actors. The costs of scheduling the
+		actor and of validating its message handlers are paid once per batch rather than once
+		per message, which improves the throughput of busy actors. Smaller values share the
+		worker threads more evenly between actors, reducing the latency of other actors when
+		some actors are flooded with messages.
+
+		A batch ends early if a message handler registers or deregisters any of the actor's
+		handlers, so handler changes take effect from the next message just as they would
+		without batching.
+
+		The default quantum is set by \ref XLANG_DEFAULT_MESSAGE_QUANTUM.
+
+		\param count A positive integer. Zero is treated as one, which processes one message per activation.
+
+		\see GetMessageQuantum
+		\see COUNTER_AVERAGE_BATCH_SIZE
+		*/
+		inline void SetMessageQuantum(const u32 count);
+
+		/**
+		\brief Returns the maximum number of messages an actor processes each time it's scheduled.
+
+		\see SetMessageQuantum
+		*/
+		inline u32 GetMessageQuantum() const;
+
+		/**
+		\brief Sets the maximum number of times an idle worker thread polls for work before sleeping.
+
+		A worker thread that runs out of work doesn't go to sleep straight away. Instead it spins
+		for a while, polling for new work with a processor pause instruction between polls. Work
+		that arrives while a worker is spinning is picked up without the cost of waking a
+		sleeping thread, and while any worker is spinning, threads that send messages don't
+		wake sleeping threads at all. This greatly reduces latency and kernel overheads for
+		request/response traffic, where work tends to arrive shortly after a thread runs out.
+
+		Each worker adapts the length of its spin to the traffic, spinning for longer while
+		spinning finds work and for less time when it doesn't, up to the maximum set here.
+		Higher values suit latency-sensitive applications with dedicated processor cores, while
+		lower values waste less processor time in applications that share the cores with other
+		work. Setting the count to zero disables spinning, so idle threads sleep straight away.
+
+		The default count is set by \ref XLANG_DEFAULT_IDLE_SPIN_COUNT.
+
+		\see GetIdleSpinCount
+		\see COUNTER_THREADS_PULSED
+		*/
+		inline void SetIdleSpinCount(const u32 count);
+
+		/**
+		\brief Returns the maximum number of times an idle worker thread polls for work before sleeping.
+
+		\see SetIdleSpinCount
+		*/
+		inline u32 GetIdleSpinCount() const;
+
 		/**
 		\brief Resets the \ref Counter "internal event counters" that track reported events for threadpool management.
 
@@ -464,10 +717,12 @@ namespace clang
 
 		\param counter One of several values of an \ref Counter "enumerated type" identifying the available counters.
 
+		\note The counters are read without locking, so events occurring during the call may or may not be counted.
+
 		\see ResetCounters
 		\see <a href="http://www.theron-library.com/index.php?t=page&p=MeasuringThreadUtilization">Measuring thread utilization</a>
 		*/
-		inline u32 GetCounterValue(const Counter counter) const;
+		inline u64 GetCounterValue(const Counter counter) const;
 
 		/**
 		\brief Sets the fallback message handler executed for unhandled messages.
@@ -575,16 +830,24 @@ namespace clang
 		Framework &operator=(const Framework &other);
 
 		/// Initializes a Framework object on construction.
-		inline void Initialize(const u32 numThreads, const u32 targetNumThreads);
+		void Initialize(const Parameters &params);
 
-		/// Gets a reference to the core message processing mutex.
+		/// Gets a reference to the mutex that protects the reference state of actors.
 		inline detail::Mutex &GetMutex() const;
 
 		/// Schedules an actor for processing by the framework's threadpool.
+		/// Does nothing if the actor is already scheduled or being processed.
+		/// When called from one of the framework's worker threads the actor is queued
+		/// locally to that worker, otherwise it's queued on the shared injection queue.
 		inline void Schedule(detail::ActorCore *const actor) const;
 
 		/// Schedules an actor for processing by the framework's threadpool, without waking a worker thread.
-		inline void TailSchedule(detail::ActorCore *const actor) const;
+		/// Like \ref Schedule, the actor is queued locally when called from a worker thread.
+		/// \return True if the actor was queued, or false if it was already scheduled.
+		inline bool TailSchedule(detail::ActorCore *const actor) const;
+
+		/// Wakes worker threads to process the given number of actors scheduled with \ref TailSchedule.
+		inline void Wake(const u32 count) const;
 
 		/// Executes the fallback message handler for a message which was unhandled by an actor.
 		inline bool ExecuteFallbackHandler(const detail::IMessage *const message) const;
@@ -598,18 +861,6 @@ namespace clang
 	};
 
 
-	XLANG_FORCEINLINE void Framework::Initialize(const u32 numThreads, const u32 targetNumThreads)
-	{
-		// Reference the global free list to ensure it's created.
-		detail::MessageCache::Instance().Reference();
-
-		XLANG_ASSERT_MSG(numThreads > 0, "numThreads must be greater than zero");
-		mThreadPool.Start(numThreads, targetNumThreads);
-
-		// Register the default fallback handler initially.
-		SetFallbackHandler(&mDefaultFallbackHandler, &detail::DefaultFallbackHandler::Handle);
-	}
-
 	template <class ActorType>
 	inline ActorRef Framework::CreateActor()
 	{
@@ -640,6 +891,42 @@ namespace clang
 		return detail::MessageSender::Send(this,value,from,to);
 	}
 
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 Framework::Broadcast(const ValueType &value, const Address &from, const ActorGroup &group) const
+	{
+		return detail::MessageSender::Broadcast(this, value, from, group.GetAddresses(), group.GetSize());
+	}
+
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 Framework::SendBatch(const ValueType *const values, const u32 count, const Address &from, const Address &to) const
+	{
+		// A zero address stride sends every value to the same address.
+		return detail::MessageSender::SendBatch(this, values, count, from, &to, 0);
+	}
+
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 Framework::SendBatch(const ValueType *const values, const u32 count, const Address &from, const Address *const to) const
+	{
+		return detail::MessageSender::SendBatch(this, values, count, from, to, 1);
+	}
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+	template <class ValueType>
+	XLANG_FORCEINLINE typename detail::EnableIfMovable<ValueType, bool>::Type Framework::Send(ValueType &&value, const Address &from, const Address &to) const
+	{
+		return detail::MessageSender::Emplace<ValueType>(this, from, to, detail::Move(value));
+	}
+
+
+	template <class ValueType, class... ArgTypes>
+	XLANG_FORCEINLINE bool Framework::Emplace(const Address &from, const Address &to, ArgTypes &&... args) const
+	{
+		return detail::MessageSender::Emplace<ValueType>(this, from, to, detail::Forward<ArgTypes>(args)...);
+	}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
 
 	template <class ObjectType>
 	inline bool Framework::SetFallbackHandler(ObjectType *const handlerObject, void (ObjectType::*handler)(const Address from))
@@ -735,33 +1022,88 @@ namespace clang
 	}
 
 
+	XLANG_FORCEINLINE void Framework::SetMessageQuantum(const u32 count)
+	{
+		mThreadPool.SetMessageQuantum(count);
+	}
+
+
+	XLANG_FORCEINLINE u32 Framework::GetMessageQuantum() const
+	{
+		return mThreadPool.GetMessageQuantum();
+	}
+
+
+	XLANG_FORCEINLINE void Framework::SetIdleSpinCount(const u32 count)
+	{
+		mThreadPool.SetIdleSpinCount(count);
+	}
+
+
+	XLANG_FORCEINLINE u32 Framework::GetIdleSpinCount() const
+	{
+		return mThreadPool.GetIdleSpinCount();
+	}
+
+
 	XLANG_FORCEINLINE void Framework::ResetCounters() const
 	{
 		mThreadPool.ResetCounters();
 	}
 
 
-	XLANG_FORCEINLINE u32 Framework::GetCounterValue(const Counter counter) const
+	XLANG_FORCEINLINE u64 Framework::GetCounterValue(const Counter counter) const
 	{
-		u32 count(0);
+		typedef detail::ThreadPool ThreadPool;
+
+		u64 count(0);
 
 		switch (counter)
 		{
 		case COUNTER_MESSAGES_PROCESSED:
 			{
-				count = mThreadPool.GetNumMessagesProcessed();
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_MESSAGES_PROCESSED);
 				break;
 			}
 
 		case COUNTER_THREADS_PULSED:
 			{
-				count = mThreadPool.GetNumThreadsPulsed();
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_THREADS_PULSED);
 				break;
 			}
 
 		case COUNTER_THREADS_WOKEN:
 			{
-				count = mThreadPool.GetNumThreadsWoken();
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_THREADS_WOKEN);
+				break;
+			}
+
+		case COUNTER_MESSAGE_BATCHES:
+			{
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_MESSAGE_BATCHES);
+				break;
+			}
+
+		case COUNTER_AVERAGE_BATCH_SIZE:
+			{
+				const u64 numBatches(mThreadPool.GetCounterValue(ThreadPool::COUNTER_MESSAGE_BATCHES));
+				if (numBatches)
+				{
+					count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_MESSAGES_PROCESSED) / numBatches;
+				}
+
+				break;
+			}
+
+		case COUNTER_ACTORS_STOLEN:
+			{
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_ACTORS_STOLEN);
+				break;
+			}
+
+		case COUNTER_SPINS_SUCCEEDED:
+			{
+				count = mThreadPool.GetCounterValue(ThreadPool::COUNTER_SPINS_SUCCEEDED);
 				break;
 			}
 
@@ -784,9 +1126,15 @@ namespace clang
 	}
 
 
-	XLANG_FORCEINLINE void Framework::TailSchedule(detail::ActorCore *const actor) const
+	XLANG_FORCEINLINE bool Framework::TailSchedule(detail::ActorCore *const actor) const
+	{
+		return mThreadPool.TailPush(actor);
+	}
+
+
+	XLANG_FORCEINLINE void Framework::Wake(const u32 count) const
 	{
-		mThreadPool.TailPush(actor);
+		mThreadPool.Wake(count);
 	}
 
 
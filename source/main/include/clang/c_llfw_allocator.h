@@ -0,0 +1,149 @@
+#ifndef __XLANG_LLFW_ALLOCATOR_H
+#define __XLANG_LLFW_ALLOCATOR_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+/**
+\file c_llfw_allocator.h
+A lock-free allocator for the small blocks allocated by clang.
+*/
+
+#include "clang/private/c_BasicTypes.h"
+
+#include "clang/c_Defines.h"
+#include "clang/c_IAllocator.h"
+
+namespace clang
+{
+	/**
+	\brief A lock-free allocator for small blocks, such as messages and actor cores.
+
+	The LocklessForwardAllocator serves blocks of 32 to 1024 bytes from slabs, which it carves
+	forward from a single arena allocated up front. Block sizes are rounded up to one of 32 size
+	classes, each a multiple of 32 bytes. Each slab holds blocks of a single size class, and tracks
+	which of them are free in an array of 32-bit masks. Blocks are allocated and freed by atomically
+	clearing and setting their bits, so allocation never takes a lock, and a block can be freed by
+	any thread, not just the one that allocated it.
+
+	Slabs are never returned to the arena, but their blocks are reused by later allocations of the
+	same size class. Larger blocks, blocks needing more than cache line alignment, and blocks
+	allocated once the arena is exhausted, are allocated from a backing allocator instead.
+
+	\code
+	clang::DefaultAllocator backingAllocator;
+	clang::LocklessForwardAllocator allocator(&backingAllocator, 64 * 1024 * 1024);
+	clang::AllocatorManager::Instance().SetAllocator(&allocator);
+	\endcode
+
+	\note The arena is allocated when the allocator is constructed, and freed when it's destroyed,
+	at which point any blocks still allocated from it become invalid.
+	\see AllocatorManager
+	*/
+	class LocklessForwardAllocator : public IAllocator
+	{
+	public:
+
+		/// Size of the smallest size class, and the spacing of the size classes.
+		static const SizeType MIN_BLOCK_SIZE = 32;
+
+		/// Size of the largest size class. Larger blocks are allocated from the backing allocator.
+		static const SizeType MAX_BLOCK_SIZE = 1024;
+
+		/// Number of size classes.
+		static const u32 NUM_SIZE_CLASSES = MAX_BLOCK_SIZE / MIN_BLOCK_SIZE;
+
+		/// Size and alignment of the slabs carved from the arena.
+		static const SizeType SLAB_SIZE = 65536;
+
+		/// Largest alignment of the blocks allocated from slabs.
+		static const SizeType MAX_ALIGNMENT = XLANG_CACHELINE_SIZE;
+
+		/**
+		\brief Constructor.
+		\param backingAllocator Allocator from which the arena, and blocks not served from slabs, are allocated.
+		\param arenaSize Size of the arena in bytes, which is rounded down to a multiple of the slab size.
+		*/
+		LocklessForwardAllocator(IAllocator *const backingAllocator, const SizeType arenaSize);
+
+		/**
+		\brief Virtual destructor. Frees the arena.
+		*/
+		virtual ~LocklessForwardAllocator();
+
+		/**
+		\brief Allocates a block of contiguous memory, aligned to at least the size of a pointer.
+		\param size The size of the memory block to allocate, in bytes.
+		\return A pointer to the allocated memory, or null if out of memory.
+		*/
+		virtual void *Allocate(const SizeType size);
+
+		/**
+		\brief Allocates a block of contiguous memory aligned to a given byte-multiple boundary.
+		\param size The size of the memory block to allocate, in bytes.
+		\param alignment The alignment of the memory to allocate, in bytes, which must be a power of two.
+		\return A pointer to the allocated memory, or null if out of memory.
+		*/
+		virtual void *AllocateAligned(const SizeType size, const SizeType alignment);
+
+		/**
+		\brief Frees a previously allocated block of contiguous memory.
+		Blocks can be freed by any thread, regardless of which thread allocated them.
+		\param memory Pointer to the memory to be deallocated.
+		*/
+		virtual void Free(void *const memory);
+
+		/**
+		\brief Gets the number of slabs carved from the arena so far.
+		*/
+		u32 GetNumSlabs() const;
+
+		/**
+		\brief Returns true if the given block was allocated from a slab, rather than from the backing allocator.
+		*/
+		inline bool IsSlabBlock(const void *const memory) const;
+
+	private:
+
+		struct Slab;
+
+		/// Slabs of a single size class, padded to a cache line to avoid false sharing.
+		struct SizeClass
+		{
+			Slab *volatile		mHead;						///< Most recently carved slab, heading a list of all the slabs.
+			Slab *volatile		mCurrent;					///< Slab from which blocks were last allocated.
+			xbyte				mPadding[XLANG_CACHELINE_SIZE - 2 * sizeof(Slab *)];
+		};
+
+		LocklessForwardAllocator(const LocklessForwardAllocator &other);
+		LocklessForwardAllocator &operator=(const LocklessForwardAllocator &other);
+
+		/// Allocates a block of the given size class from a slab.
+		/// \return Null if the arena is exhausted.
+		void *AllocateBlock(const u32 sizeClass);
+
+		/// Carves a new slab of the given size class from the arena, with its first block allocated.
+		/// \return Null if the arena is exhausted.
+		Slab *CarveSlab(const u32 sizeClass);
+
+		SizeClass			mSizeClasses[NUM_SIZE_CLASSES];	///< Slabs of each size class.
+		IAllocator			*mBackingAllocator;				///< Allocator of the arena, and of blocks not served from slabs.
+		xbyte				*mArena;						///< Start of the arena, aligned to the slab size.
+		xbyte				*mArenaEnd;						///< End of the arena.
+		u32					mMaxSlabs;						///< Number of slabs that fit in the arena.
+		volatile u32		mNumSlabs;						///< Number of slabs carved from the arena so far.
+	};
+
+
+	XLANG_FORCEINLINE bool LocklessForwardAllocator::IsSlabBlock(const void *const memory) const
+	{
+		const xbyte *const block(reinterpret_cast<const xbyte *>(memory));
+		return (block >= mArena && block < mArenaEnd);
+	}
+
+
+} // namespace clang
+
+
+#endif // __XLANG_LLFW_ALLOCATOR_H
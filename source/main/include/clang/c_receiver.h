@@ -12,7 +12,7 @@
 #include "clang/private/Handlers/c_IReceiverHandler.h"
 #include "clang/private/Handlers/c_ReceiverHandlerCast.h"
 #include "clang/private/Messages/c_IMessage.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 #include "clang/private/Threading/c_Lock.h"
 #include "clang/private/Threading/c_Monitor.h"
 
@@ -69,8 +69,8 @@ namespace clang
 	the messages they handle have arrived, and the associated handlers have been executed.
 
 	The maximum number of receivers that can be created in an application is limited
-	by the \ref XLANG_MAX_RECEIVERS define, which defines the number of unique
-	receiver addresses.
+	by the \ref Framework::Parameters::mMaxReceivers "maximum" passed to the Framework,
+	which defaults to the \ref XLANG_MAX_RECEIVERS define.
 
 	\see <a href="http://www.theron-library.com/index.php?t=page&p=Receiver">Using a Receiver</a>
 	\see <a href="http://www.theron-library.com/index.php?t=page&p=TerminatingTheFramework">Terminating the Framework</a>
@@ -322,10 +322,8 @@ namespace clang
 		ClassType *const owner,
 		void (ClassType::*handler)(const ValueType &message, const Address from))
 	{
-		// If the message value type has a valid (non-zero) type name defined for it,
-		// then we use explicit type names to match messages to handlers.
-		// The default value of zero will indicates that no type name has been defined,
-		// in which case we rely on automatically stored RTTI to identify message types.
+		// The handler remembers the id of the message value type, explicit or generated,
+		// which is matched against the type ids carried by arriving messages.
 		typedef detail::ReceiverHandler<ClassType, ValueType> MessageHandlerType;
 
 		// Allocate memory for a message handler object.
@@ -356,12 +354,9 @@ namespace clang
 		ClassType *const /*owner*/,
 		void (ClassType::*handler)(const ValueType &message, const Address from))
 	{
-		// If the message value type has a valid (non-zero) type name defined for it,
-		// then we use explicit type IDs to match messages to handlers.
-		// The default value of zero will indicate that no type name has been defined,
-		// in which case we rely on automatically stored RTTI to identify message types.
+		// Handlers are matched by the id of their message value type, explicit or generated.
 		typedef detail::ReceiverHandler<ClassType, ValueType> MessageHandlerType;
-		typedef detail::ReceiverHandlerCast<ClassType, detail::MessageTraits<ValueType>::HAS_TYPE_NAME> HandlerCaster;
+		typedef detail::ReceiverHandlerCast<ClassType> HandlerCaster;
 
 		{
 			detail::Lock lock(mMonitor.GetMutex());
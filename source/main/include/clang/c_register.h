@@ -6,24 +6,24 @@
 #endif
 
 #include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
-#define XLANG_NO_REGISTER_MESSAGE
-#ifndef XLANG_NO_REGISTER_MESSAGE
+#include "clang/c_Defines.h"
+
+#ifndef XLANG_REGISTER_MESSAGE_ID
 
 /**
-\brief Message type registration macro.
+\brief Message type registration macro, with an explicit id.
 
-Registers message types for use within clang.
+Registers a message type with an explicit, unique, non-zero id.
 
-Registration of message types is optional in clang. Registering the message
-types used in an application causes clang to use hand-rolled Runtime Type
-Information (RTTI) explicity stored with each message type, instead of the
-built-in C++ RTTI. Doing so allows the built-in C++ RTTI to be turned off,
-resulting in a memory storage saving in all types, not just message types.
-This saving can be important in embedded and realtime applications such as
-games, where for example a Vector class may need to be stored as just three
-floats, with no additional runtime type information added silently by the
-compiler.
+Every message carries the id of its type, which is compared with the ids of the
+handlers registered by the receiving actor. Unregistered message types are given
+ids generated from their names by the compiler, which are the same in every run
+of the same build, but can differ between builds made with different compilers.
+Registering a message type with an explicit id makes its id the same in every build,
+so it can be persisted, or used to identify messages exchanged with processes built
+separately.
 
 An important limitation of the message type registration macro is that it
 can only be used from within the global namespace. Furthermore the full
@@ -39,39 +39,67 @@ namespace MyNamespace
 
 }
 
-XLANG_REGISTER_MESSAGE(MyNamespace::MyMessage);
+XLANG_REGISTER_MESSAGE_ID(MyNamespace::MyMessage, 0x1001);
 \endcode
 
 (Unfortunately this means that it isn't generally possible to register messages
 immediately after their declaration, as we'd often prefer).
 
-\note If message types are registered, then \em all message types
-must be registered, throughout the whole application, otherwise runtime
-errors will occur. Therefore it is simpler and less error prone to not
-register any message types at all. Only bother with message registration
-if you specifically need to turn the built-in C++ RTTI system off.
+\note Ids must be unique across all of the message types used by the application,
+including the ids generated for unregistered types, which are 32-bit hashes.
+Small explicit ids are therefore unlikely to clash with generated ones. Two types
+with the same id can't be told apart, so messages of one would be delivered to
+handlers of the other as the wrong type, corrupting memory. Although unlikely, two
+generated ids can also clash. Debug builds (with \ref XLANG_ENABLE_ASSERTS) assert
+when a message or handler is first created for a type whose id is already used by
+another type; registering one of the types with an explicit id resolves the clash.
 
-\see <a href="http://www.theron-library.com/index.php?t=page&p=RegisteringMessages">Registering messages</a>
+\see XLANG_REGISTER_MESSAGE
 */
-#define XLANG_REGISTER_MESSAGE(MessageType)											\
+#define XLANG_REGISTER_MESSAGE_ID(MessageType, MessageId)						\
 namespace clang																		\
 {																					\
 	namespace detail																\
 	{																				\
-		template <typename T>														\
+		template <class ValueType>													\
 		struct MessageTraits;														\
 		template <>																	\
 		struct MessageTraits<MessageType>											\
 		{																			\
-			static const bool HAS_TYPE_NAME = true;									\
-			static const char *const TYPE_NAME;										\
+			static const bool HAS_TYPE_ID = true;									\
+			static const u32 TYPE_ID = MessageId;									\
 		};																			\
-																					\
-		const char *const MessageTraits<MessageType>::TYPE_NAME = #MessageType;		\
 	}																				\
 }
 
+#endif // XLANG_REGISTER_MESSAGE_ID
+
+
+#if XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+#ifndef XLANG_REGISTER_MESSAGE
+
+/**
+\brief Message type registration macro.
+
+Registers a message type with an id generated at compile time from the name
+passed to the macro, rather than from the name spelled by the compiler. The id
+is therefore the same in every build that registers the type with the same name,
+whichever compiler is used.
+
+\code
+XLANG_REGISTER_MESSAGE(MyNamespace::MyMessage);
+\endcode
+
+\note Needs \ref XLANG_ENABLE_CONSTEXPR_TYPE_IDS. The limitations of
+\ref XLANG_REGISTER_MESSAGE_ID apply.
+
+\see XLANG_REGISTER_MESSAGE_ID
+*/
+#define XLANG_REGISTER_MESSAGE(MessageType)											\
+	XLANG_REGISTER_MESSAGE_ID(MessageType, clang::detail::HashTypeName(#MessageType))
+
 #endif // XLANG_REGISTER_MESSAGE
+#endif // XLANG_ENABLE_CONSTEXPR_TYPE_IDS
 
 
 #endif // XLANG_REGISTER_H
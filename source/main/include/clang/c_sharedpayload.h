@@ -0,0 +1,329 @@
+#ifndef __XLANG_SHAREDPAYLOAD_H
+#define __XLANG_SHAREDPAYLOAD_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/c_Move.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/MessageCache/c_PayloadCache.h"
+#include "clang/private/Messages/c_MessageAlignment.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Header of the memory block holding a shared payload, which is followed by the payload value.
+		struct PayloadHeader
+		{
+			volatile u32	mReferenceCount;		///< Number of SharedPayload handles referencing the payload.
+			u32				mBlockSize;				///< Size of the memory block holding the payload.
+		};
+	} // namespace detail
+
+
+	/**
+	\brief Reference-counted handle to an immutable payload shared by many messages.
+
+	Messages are copied when they're sent, so every recipient of a message receives its own
+	copy of the message value. For large message values, such as buffers of several kilobytes,
+	that's expensive, and more so when the same value is sent to many actors.
+
+	A SharedPayload holds a single copy of a value in a block allocated from a pool of
+	size-classed blocks. Copying a SharedPayload only copies a pointer and atomically
+	increments the reference count of the payload, so sending one as a message value, or
+	as a member of one, costs about as much as sending a pointer. The payload is destroyed,
+	and its block returned to the pool, when the last handle referencing it is destroyed.
+
+	\code
+	struct Frame
+	{
+		clang::u8 mData[65536];
+	};
+
+	clang::SharedPayload<Frame> frame(clang::SharedPayload<Frame>::Create());
+	FillFrame(frame.EditValue());
+
+	// Each subscriber receives a handle to the same frame.
+	for (clang::u32 index = 0; index < numSubscribers; ++index)
+	{
+		framework.Send(frame, receiver.GetAddress(), subscribers[index]);
+	}
+	\endcode
+
+	\tparam ValueType The payload type. The alignment of payloads is the alignment
+	of the type when sent as a message, set with \ref XLANG_ALIGN_MESSAGE.
+
+	\note Shared payloads are immutable, since they're read concurrently by the actors
+	that receive them. The payload can only be edited while it's referenced by a single handle,
+	typically just after it's created.
+	*/
+	template <class ValueType>
+	class SharedPayload
+	{
+	public:
+
+		/// Constructs a null handle that doesn't reference a payload.
+		inline SharedPayload();
+
+		/// Constructs a handle to a new payload holding a copy of the given value.
+		/// \note The handle is null if the payload can't be allocated.
+		inline explicit SharedPayload(const ValueType &value);
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		/// Creates a payload whose value is constructed in place from the given arguments.
+		/// \note The handle is null if the payload can't be allocated.
+		template <class... ArgTypes>
+		inline static SharedPayload Create(ArgTypes &&... args);
+
+#else
+
+		/// Creates a payload holding a default-constructed value.
+		/// \note The handle is null if the payload can't be allocated.
+		inline static SharedPayload Create();
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+		/// Copy constructor. References the same payload as the other handle.
+		inline SharedPayload(const SharedPayload &other);
+
+		/// Assignment operator. References the same payload as the other handle.
+		inline SharedPayload &operator=(const SharedPayload &other);
+
+		/// Destructor. Destroys the payload if this is the last handle referencing it.
+		inline ~SharedPayload();
+
+		/// Returns true if the handle doesn't reference a payload.
+		inline bool IsNull() const;
+
+		/// Returns the number of handles referencing the payload.
+		inline u32 GetReferenceCount() const;
+
+		/// Gets the payload value.
+		inline const ValueType &Value() const;
+
+		/// Gets the payload value for editing.
+		/// \note Must only be called while this is the only handle referencing the payload.
+		inline ValueType &EditValue();
+
+		/// Accesses the members of the payload value.
+		inline const ValueType *operator->() const;
+
+		/// Gets the payload value.
+		inline const ValueType &operator*() const;
+
+	private:
+
+		/// Returns the offset of the payload value from the start of its block.
+		inline static u32 GetValueOffset();
+
+		/// Allocates a block for a payload, with its reference count set, but without a value.
+		inline static detail::PayloadHeader *Allocate();
+
+		/// Releases the referenced payload, if any, destroying it on last release.
+		inline void Release();
+
+		/// Gets a pointer to the payload value.
+		inline ValueType *GetValuePointer() const;
+
+		detail::PayloadHeader *mHeader;				///< Header of the referenced payload, or null.
+	};
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE SharedPayload<ValueType>::SharedPayload() : mHeader(0)
+	{
+	}
+
+
+	template <class ValueType>
+	inline SharedPayload<ValueType>::SharedPayload(const ValueType &value) : mHeader(Allocate())
+	{
+		if (mHeader)
+		{
+			new (GetValuePointer()) ValueType(value);
+		}
+	}
+
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+	template <class ValueType>
+	template <class... ArgTypes>
+	inline SharedPayload<ValueType> SharedPayload<ValueType>::Create(ArgTypes &&... args)
+	{
+		SharedPayload payload;
+		payload.mHeader = Allocate();
+
+		if (payload.mHeader)
+		{
+			new (payload.GetValuePointer()) ValueType(detail::Forward<ArgTypes>(args)...);
+		}
+
+		return payload;
+	}
+
+#else
+
+	template <class ValueType>
+	inline SharedPayload<ValueType> SharedPayload<ValueType>::Create()
+	{
+		SharedPayload payload;
+		payload.mHeader = Allocate();
+
+		if (payload.mHeader)
+		{
+			new (payload.GetValuePointer()) ValueType();
+		}
+
+		return payload;
+	}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE SharedPayload<ValueType>::SharedPayload(const SharedPayload &other) : mHeader(other.mHeader)
+	{
+		if (mHeader)
+		{
+			detail::Atomic::Increment(&mHeader->mReferenceCount);
+		}
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE SharedPayload<ValueType> &SharedPayload<ValueType>::operator=(const SharedPayload &other)
+	{
+		// Reference the new payload before releasing the old one, in case they're the same.
+		detail::PayloadHeader *const header(other.mHeader);
+		if (header)
+		{
+			detail::Atomic::Increment(&header->mReferenceCount);
+		}
+
+		Release();
+		mHeader = header;
+
+		return *this;
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE SharedPayload<ValueType>::~SharedPayload()
+	{
+		Release();
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE bool SharedPayload<ValueType>::IsNull() const
+	{
+		return (mHeader == 0);
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 SharedPayload<ValueType>::GetReferenceCount() const
+	{
+		return mHeader ? detail::Atomic::Load(&mHeader->mReferenceCount) : 0;
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE const ValueType &SharedPayload<ValueType>::Value() const
+	{
+		XLANG_ASSERT(mHeader);
+		return *GetValuePointer();
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE ValueType &SharedPayload<ValueType>::EditValue()
+	{
+		XLANG_ASSERT(mHeader);
+		XLANG_ASSERT_MSG(GetReferenceCount() == 1, "Shared payloads can't be edited");
+		return *GetValuePointer();
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE const ValueType *SharedPayload<ValueType>::operator->() const
+	{
+		XLANG_ASSERT(mHeader);
+		return GetValuePointer();
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE const ValueType &SharedPayload<ValueType>::operator*() const
+	{
+		XLANG_ASSERT(mHeader);
+		return *GetValuePointer();
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE u32 SharedPayload<ValueType>::GetValueOffset()
+	{
+		// The value follows the header, at the alignment of the value type.
+		const u32 alignment(detail::MessageAlignment<ValueType>::ALIGNMENT);
+		return ((u32)sizeof(detail::PayloadHeader) + (alignment - 1)) & ~(alignment - 1);
+	}
+
+
+	template <class ValueType>
+	inline detail::PayloadHeader *SharedPayload<ValueType>::Allocate()
+	{
+		const u32 alignment(detail::MessageAlignment<ValueType>::ALIGNMENT);
+		const u32 blockSize(detail::PayloadCache::GetBlockSize(GetValueOffset() + (u32)sizeof(ValueType)));
+
+		void *const block(detail::PayloadCache::Instance().Allocate(blockSize, alignment));
+		if (block == 0)
+		{
+			return 0;
+		}
+
+		detail::PayloadHeader *const header(reinterpret_cast<detail::PayloadHeader *>(block));
+		header->mReferenceCount = 1;
+		header->mBlockSize = blockSize;
+
+		return header;
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE void SharedPayload<ValueType>::Release()
+	{
+		detail::PayloadHeader *const header(mHeader);
+		mHeader = 0;
+
+		// The last handle to be released destroys the payload. The payload is immutable,
+		// so no other thread can be accessing it once the count has dropped to zero.
+		if (header && detail::Atomic::Decrement(&header->mReferenceCount) == 0)
+		{
+			ValueType *const value(reinterpret_cast<ValueType *>(reinterpret_cast<xbyte *>(header) + GetValueOffset()));
+			value->~ValueType();
+
+			detail::PayloadCache::Instance().Free(header, header->mBlockSize);
+		}
+	}
+
+
+	template <class ValueType>
+	XLANG_FORCEINLINE ValueType *SharedPayload<ValueType>::GetValuePointer() const
+	{
+		return reinterpret_cast<ValueType *>(reinterpret_cast<xbyte *>(mHeader) + GetValueOffset());
+	}
+
+
+} // namespace clang
+
+
+#endif // __XLANG_SHAREDPAYLOAD_H
@@ -0,0 +1,141 @@
+#ifndef __XLANG_PRIVATE_CONTAINERS_INTRUSIVEMPSCQUEUE_H
+#define __XLANG_PRIVATE_CONTAINERS_INTRUSIVEMPSCQUEUE_H
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Class template describing a lock-free multi-producer, single-consumer queue.
+		/// Any number of threads can push items concurrently, but only one thread at a time may pop them.
+		/// Producers push onto a shared stack with a single atomic exchange, so pushing is wait-free.
+		/// The consumer takes the whole stack when its own list runs dry and reverses it, so items
+		/// are popped in the order in which they were pushed.
+		/// \note The item type is the node type and is expected to expose SetNext and GetNext methods,
+		/// which must access the link atomically since it's written and read by different threads.
+		template <class ItemType>
+		class IntrusiveMpscQueue
+		{
+		public:
+
+			/// Constructor
+			inline IntrusiveMpscQueue();
+
+			/// Destructor
+			inline ~IntrusiveMpscQueue();
+
+			/// Returns true if the queue contains no items.
+			/// \note Must be called by the consumer. Items pushed concurrently may or may not be seen.
+			inline bool Empty() const;
+
+			/// Pushes an item onto the queue.
+			/// \note Can be called by any thread.
+			inline void Push(ItemType *const item);
+
+			/// Removes and returns the item at the front of the queue.
+			/// \note Must be called by the consumer.
+			inline ItemType *Pop();
+
+		private:
+
+			IntrusiveMpscQueue(const IntrusiveMpscQueue &other);
+			IntrusiveMpscQueue &operator=(const IntrusiveMpscQueue &other);
+
+			/// Returns the placeholder link of an item that is being pushed.
+			/// Producers publish an item before linking it to the item pushed before it.
+			inline static ItemType *Pending();
+
+			ItemType *volatile mPushed;		///< Stack of items pushed by producers, most recent first.
+			ItemType *mFront;				///< Items taken by the consumer, in push order.
+		};
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE IntrusiveMpscQueue<ItemType>::IntrusiveMpscQueue()
+			: mPushed(0)
+			, mFront(0)
+		{
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE IntrusiveMpscQueue<ItemType>::~IntrusiveMpscQueue()
+		{
+			// If the queue hasn't been emptied by the caller we'll leak the nodes.
+			XLANG_ASSERT(mPushed == 0);
+			XLANG_ASSERT(mFront == 0);
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE bool IntrusiveMpscQueue<ItemType>::Empty() const
+		{
+			return (mFront == 0 && Atomic::Load(&mPushed) == 0);
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE void IntrusiveMpscQueue<ItemType>::Push(ItemType *const item)
+		{
+			XLANG_ASSERT(item);
+
+			// The exchange publishes the item, so mark its link as pending until we've set it.
+			item->SetNext(Pending());
+			ItemType *const previous(Atomic::Exchange(&mPushed, item));
+			item->SetNext(previous);
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE ItemType *IntrusiveMpscQueue<ItemType>::Pop()
+		{
+			if (mFront == 0)
+			{
+				// Take everything pushed so far and reverse it into push order.
+				ItemType *item(Atomic::Exchange(&mPushed, static_cast<ItemType *>(0)));
+				while (item)
+				{
+					// Wait for the producer, if it hasn't linked the item yet.
+					// It's between two consecutive instructions so this is very rarely needed.
+					ItemType *next(item->GetNext());
+					while (next == Pending())
+					{
+						Atomic::Pause();
+						next = item->GetNext();
+					}
+
+					item->SetNext(mFront);
+					mFront = item;
+					item = next;
+				}
+			}
+
+			ItemType *const item(mFront);
+			if (item)
+			{
+				mFront = item->GetNext();
+			}
+
+			return item;
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE ItemType *IntrusiveMpscQueue<ItemType>::Pending()
+		{
+			// An odd address can never be a real item.
+			return reinterpret_cast<ItemType *>(static_cast<uintptr_t>(1));
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_CONTAINERS_INTRUSIVEMPSCQUEUE_H
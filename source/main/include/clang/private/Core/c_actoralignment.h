@@ -12,8 +12,8 @@ namespace clang
 		/// clang about any specialized alignment requirements of those classes.
 		/// clang uses the alignment value defined for each actor type to request memory
 		/// with the correct alignment from the general allocator registered with the
-		/// \ref AllocatorManager. The default alignment is four bytes, implying that
-		/// instances of the actor class should be allocated starting at 4-byte boundaries.
+		/// \ref AllocatorManager. The default alignment is eight bytes, implying that
+		/// instances of the actor class should be allocated starting at 8-byte boundaries.
 		/// \note Note that although clang will request memory allocated with the correct
 		/// alignment, whether or not the allocator respects the alignment request is up
 		/// to the allocator implementation. The default allocator, DefaultAllocator,
@@ -26,8 +26,8 @@ namespace clang
 		struct ActorAlignment
 		{
 			/// \brief Describes the memory alignment requirement of the actor type, in bytes.
-			/// The default alignment is four bytes.
-			static const u32 ALIGNMENT = 4;
+			/// The default alignment is eight bytes, the minimum accepted by DefaultAllocator.
+			static const u32 ALIGNMENT = 8;
 		};
 
 
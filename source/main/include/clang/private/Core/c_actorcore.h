@@ -3,13 +3,13 @@
 
 #include "clang/private/c_BasicTypes.h"
 #include "clang/private/Containers/c_IntrusiveList.h"
-#include "clang/private/Containers/c_IntrusiveQueue.h"
+#include "clang/private/Containers/c_IntrusiveMpscQueue.h"
+#include "clang/private/Core/c_InlineMailbox.h"
 #include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Handlers/c_HandlerTable.h"
 #include "clang/private/Handlers/c_MessageHandler.h"
-#include "clang/private/Handlers/c_IMessageHandler.h"
-#include "clang/private/Handlers/c_MessageHandlerCast.h"
 #include "clang/private/Messages/c_IMessage.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Threading/c_Atomic.h"
 
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
@@ -36,7 +36,7 @@ namespace clang
 
 			/// Constructor.
 			/// \note Actor cores can't be constructed directly in user code.
-			ActorCore(const u32 sequence, Framework *const framework, Actor *const actor);
+			ActorCore(const u64 sequence, Framework *const framework, Actor *const actor);
 
 			/// Destructor.
 			~ActorCore();
@@ -48,12 +48,15 @@ namespace clang
 			XLANG_FORCEINLINE ActorCore *GetNext() const			{ return mNext; }
 
 			/// Sets the sequence number of the actor.
-			XLANG_FORCEINLINE void SetSequence(const u32 sequence)	{ mSequence = sequence; }
+			XLANG_FORCEINLINE void SetSequence(const u64 sequence)	{ Atomic::Store(&mSequence, sequence); }
 
 			/// Gets the sequence number of the actor.
-			XLANG_FORCEINLINE u32 GetSequence() const				{ return mSequence; }
+			/// \note The sequence number is read by threads looking up the actor without locking.
+			XLANG_FORCEINLINE u64 GetSequence() const				{ return Atomic::Load(&mSequence); }
 
 			/// Pushes a message into the actor.
+			/// \note This is lock-free and can be called by any thread, concurrently with the
+			/// worker thread processing the actor.
 			XLANG_FORCEINLINE void Push(IMessage *const message)
 			{
 				XLANG_ASSERT(message);
@@ -61,9 +64,23 @@ namespace clang
 				// Push the message onto the internal queue to await delivery.
 				// The point of this is to maintain correct message delivery order within the actor.
 				// The queue stores pointers to the IMessage interfaces for polymorphism.
-				// We reuse the work queue lock to protect the per-actor message queues.
+				// The count is incremented first so it never drops below the number of queued messages.
+				Atomic::Increment(&mMessageCount);
 				mMessageQueue.Push(message);
-				++mMessageCount;
+			}
+
+			/// Constructs a small message in a slot of the actor's inline mailbox, ready to be pushed.
+			/// \return Null if no slot is free, in which case the message has to be allocated instead.
+			/// \note This is lock-free and can be called by any thread.
+			XLANG_FORCEINLINE IMessage *AllocateInlineMessage(const void *const value, const InlineMessageDescriptor &descriptor, const u32 typeId, const Address &from)
+			{
+				return mInlineMailbox.Allocate(value, descriptor, typeId, from);
+			}
+
+			/// Enables the actor's inline mailbox, so that small messages sent to it are held inline.
+			XLANG_FORCEINLINE void EnableInlineMailbox()
+			{
+				mInlineMailbox.Enable();
 			}
 
 			/// Returns a pointer to the actor that contains this core.
@@ -74,44 +91,44 @@ namespace clang
 			/// \return A pointer to the framework to which the actor belongs.
 			XLANG_FORCEINLINE Framework *GetFramework() const		{ XLANG_ASSERT(mFramework); return mFramework; }
 
-			/// Gets a reference to the mutex that protects the actor.
+			/// Gets a reference to the mutex that protects the actor's reference state.
+			/// \note It's only locked when the actor becomes unreferenced, and by the thread destroying it.
 			Mutex &GetMutex() const;
 
 			/// Returns true if the actor is marked as referenced by at least one ActorRef.
-			XLANG_FORCEINLINE bool IsReferenced() const				{ return ((mState & STATE_REFERENCED) != 0); }
+			XLANG_FORCEINLINE bool IsReferenced() const				{ return (Atomic::Load(&mReferenced) != 0); }
 
 			/// Marks the actor as unreferenced and so ready for garbage collection.
+			/// \note Must be called with the mutex returned by GetMutex locked.
 			void Unreference();
 
 			/// Returns true if the actor is being processed, or is scheduled for processing.
-			XLANG_FORCEINLINE bool IsScheduled() const				{ return ((mState & STATE_BUSY) != 0); }
-
-			/// Marks the actor as either being processed, or scheduled for processing.
-			XLANG_FORCEINLINE void Schedule()						{ mState |= STATE_BUSY; }
-
-			/// Marks the actor as neither being processed nor scheduled for processing.
-			XLANG_FORCEINLINE void Unschedule()						{ mState &= STATE_BUSY; }
+			XLANG_FORCEINLINE bool IsScheduled() const				{ return (Atomic::Load(&mSchedule) != SCHEDULE_IDLE); }
 
-			/// Returns true if the actor is marked as in need of processing.
-			XLANG_FORCEINLINE bool IsDirty() const					{ return ((mState & STATE_DIRTY) != 0); }
+			/// Notifies the actor that it needs processing, for example because it was sent a message.
+			/// \return True if the actor was idle, in which case the caller has to push it onto a work queue.
+			/// Otherwise the thread processing the actor sees the notification and processes it again.
+			XLANG_FORCEINLINE bool Schedule()						{ return (Atomic::Exchange(&mSchedule, SCHEDULE_NOTIFIED) == SCHEDULE_IDLE); }
 
-			/// Marks the actor as in need of processing, causing it to be scheduled.
-			XLANG_FORCEINLINE void Dirty()							{ mState |= STATE_DIRTY; }
-
-			/// Marks the actor as not in need of processing.
-			XLANG_FORCEINLINE void Clean()							{ mState &= ~STATE_DIRTY; }
-
-			/// Marks the actor as being processed but not yet in need of further processing.
-			XLANG_FORCEINLINE void CleanAndSchedule()
+			/// Consumes any notifications, before the actor's message queue is read.
+			/// \note Must be called by the thread processing the actor.
+			XLANG_FORCEINLINE void BeginProcessing()
 			{
-				u32 state(mState);
-				state &= ~STATE_DIRTY;
-				state |= STATE_BUSY;
-				mState = state;
+				// Skip the write if there's nothing to consume. A notification arriving
+				// just after the check is seen by Unschedule instead.
+				if (Atomic::Load(&mSchedule) == SCHEDULE_NOTIFIED)
+				{
+					Atomic::Exchange(&mSchedule, SCHEDULE_RUNNING);
+				}
 			}
 
-			/// Marks the actor as neither being processed nor in need of processing.
-			XLANG_FORCEINLINE void CleanAndUnschedule()				{ mState &= ~(STATE_DIRTY | STATE_BUSY); }
+			/// Marks the actor as neither being processed nor scheduled for processing,
+			/// unless it was notified since processing began.
+			/// \return False if the actor was notified, in which case it's still scheduled
+			/// and the caller has to process it again.
+			/// \note Must be called by the thread processing the actor. If it succeeds, the
+			/// caller must not access the actor again, since another thread may now process it.
+			XLANG_FORCEINLINE bool Unschedule()						{ return Atomic::CompareExchange(&mSchedule, SCHEDULE_RUNNING, SCHEDULE_IDLE); }
 
 			/// Returns true if the actor has been notified that its handlers need updating.
 			XLANG_FORCEINLINE bool AreHandlersDirty() const			{ return ((mState & STATE_HANDLERS_DIRTY) != 0); }
@@ -119,48 +136,87 @@ namespace clang
 			/// Marks that the actor's handler list has changed since it was last processed.
 			XLANG_FORCEINLINE void DirtyHandlers()					{ mState |= STATE_HANDLERS_DIRTY; }
 
-			/// Deregisters a previously registered handler.
-			template <class ActorType, class ValueType>
-			inline bool			DeregisterHandler(ActorType *const actor, void (ActorType::*handler)(const ValueType &message, const Address from));
+			/// Registers a handler, taking effect the next time the actor is processed.
+			/// \return False if out of memory.
+			bool				RegisterHandler(const MessageHandler_t &handler);
 
-			/// Checks whether the given message handler is registered.
-			template <class ActorType, class ValueType>
-			inline bool			IsHandlerRegistered(ActorType *const actor, void (ActorType::*handler)(const ValueType &message, const Address from));
+			/// Deregisters a previously registered handler, taking effect the next time the actor is processed.
+			/// \return False if the handler isn't registered, or if out of memory.
+			bool				DeregisterHandler(const MessageHandler_t &handler);
 
-			/// Removes any handlers marked for removal and adds any scheduled for adding.
+			/// Checks whether the given message handler is registered, including any pending changes.
+			bool				IsHandlerRegistered(const MessageHandler_t &handler) const;
+
+			/// Shares the handlers registered by the actor's constructor with other actors of the same type.
+			/// \param typeTable Refers to the table interned for the actor type, if any.
+			/// \note Must be called by the thread creating the actor once the constructor has returned.
+			void				InternHandlers(HandlerTable *&typeTable);
+
+			/// Applies any handler changes made since the actor was last processed.
 			inline void			ValidateHandlers();
 
 			/// Gets the number of messages queued at this actor, awaiting processing.
 			inline u32			GetNumQueuedMessages() const;
 
 			/// Checks whether the actor has any queued messages awaiting processing.
+			/// \note Must be called by the thread processing the actor.
 			inline bool			HasQueuedMessage() const;
 
 			/// Gets the first message from the message queue, if any.
+			/// \note Must be called by the thread processing the actor.
 			inline IMessage*	GetQueuedMessage();
 
 			/// Presents the actor with one of its queued messages, if any,
 			/// and calls the associated handler.
 			inline void			ProcessMessage(IMessage *const message);
 
+			/// Requests that the message being processed is forwarded to the given address once
+			/// its handlers have returned, rather than destroyed.
+			/// \return False if the actor isn't processing a message.
+			/// \note Must be called by the thread processing the actor, from within a handler.
+			inline bool			SetForwardAddress(const Address &address);
+
+			/// Returns true if a handler forwarded the message that was just processed.
+			/// \note Must be called by the thread processing the actor.
+			XLANG_FORCEINLINE bool IsMessageForwarded() const		{ return ((mState & STATE_MESSAGE_FORWARDED) != 0); }
+
+			/// Delivers the message that was just processed to the address it was forwarded to.
+			/// The message block is delivered intact, keeping its original sender, and is destroyed
+			/// by its new recipient, or here if it can't be delivered. Messages held in the actor's
+			/// inline mailbox keep their slots alive, so can outlive the actor.
+			/// \note Must be called by the thread processing the actor.
+			void				ForwardMessage(IMessage *const message);
+
 		private:
 
 			/// Flags describing the execution state of an actor.
 			enum
 			{ 
-				STATE_BUSY = (1 << 0),								///< Being processed (in the work queue or being executed).
-				STATE_DIRTY = (1 << 1),								///< In need of more processing after current execution.
-				STATE_HANDLERS_DIRTY = (1 << 2),					///< One or more message handlers added or removed since last run.
-				STATE_REFERENCED = (1 << 3),						///< Actor is referenced by one or more ActorRefs so can't be garbage collected.
+				STATE_HANDLERS_DIRTY = (1 << 0),					///< One or more message handlers added or removed since last run.
+				STATE_PROCESSING_MESSAGE = (1 << 1),				///< A message is being presented to the actor's handlers.
+				STATE_MESSAGE_FORWARDED = (1 << 2),					///< The message being processed was forwarded by a handler.
 				STATE_FORCESIZEINT = 0xFFFFFFFF						///< Ensures the enum is an integer.
 			};
 
-			typedef IntrusiveQueue<IMessage> MessageQueue;
+			/// Scheduling states of an actor. Senders only ever move the state to notified, and
+			/// only the thread processing the actor moves it back to running or idle.
+			enum
+			{
+				SCHEDULE_IDLE = 0,									///< Neither scheduled nor being processed.
+				SCHEDULE_RUNNING = 1,								///< In a work queue or being processed.
+				SCHEDULE_NOTIFIED = 2								///< As running, but notified again since processing began.
+			};
+
+			typedef IntrusiveMpscQueue<IMessage> MessageQueue;
 
 							ActorCore(const ActorCore &other);
 							ActorCore &operator=(const ActorCore &other);
 
-			/// Updates the core's registered handler list with any changes from the actor.
+			/// Returns a private table, with room for the given number of additional handlers,
+			/// to which handler changes are made until the actor is next processed.
+			HandlerTable	*EditHandlers(const u32 numHandlers);
+
+			/// Replaces the dispatched handler table with the table of pending changes.
 			void			UpdateHandlers();
 
 			/// Executes the core's default handler, if any, for an unhandled message.
@@ -172,109 +228,42 @@ namespace clang
 			ActorCore					*mNext;						///< Pointer to the next actor in a queue of actors.
 			Actor						*mParent;					///< Address of the actor instance containing this core.
 			Framework					*mFramework;				///< The framework instance that owns this actor.
-			u32							mSequence;					///< Sequence number of the actor (half of its unique address).
-			u32							mMessageCount;				///< Number of messages in the message queue.
-			MessageQueue				mMessageQueue;				///< Queue of messages awaiting processing.
-			u32							mNumMessageHandlers;
-			u32							mMaxMessageHandlers;
-			detail::MessageHandler_t	mMessageHandlers[32];
-			u32							mState;						///< Execution state (idle, busy, dirty).
+			volatile u64				mSequence;					///< Sequence number of the actor (half of its unique address).
+			volatile u32				mMessageCount;				///< Number of messages in the message queue.
+			MessageQueue				mMessageQueue;				///< Lock-free queue of messages awaiting processing.
+			InlineMailbox				mInlineMailbox;				///< Slots holding small messages sent to the actor, in place of allocations.
+			HandlerTable				*mHandlers;					///< Handlers used for dispatch, possibly shared with other actors.
+			HandlerTable *volatile		mNewHandlers;				///< Private copy of the handlers with pending changes, if any.
+			Address						mForwardAddress;			///< Address to which the message being processed is forwarded.
+			u32							mState;						///< Handler state flags, accessed only by the thread processing the actor.
+			volatile u32				mReferenced;				///< Non-zero until the last ActorRef referencing the actor is destroyed.
+			volatile u32				mSchedule;					///< Scheduling state (idle, running, notified).
 		};
 
 
-		template <class ActorType, class ValueType>
-		inline bool ActorCore::DeregisterHandler(ActorType *const /*actor*/, void (ActorType::*handler)(const ValueType &message, const Address from))
-		{
-			// If the message value type has a valid (non-zero) type name defined for it,
-			// then we use explicit type names to match messages to handlers.
-			// The default value of zero indicates that no type name has been defined,
-			// in which case we rely on compiler-generated RTTI to identify message types.
-			typedef MessageHandler<ActorType, ValueType> MessageHandlerType;
-			typedef MessageHandlerCast<ActorType, MessageTraits<ValueType>::HAS_TYPE_NAME> HandlerCaster;
-
-			// We don't need to lock this because only one thread can access it at a time.
-			// Find the handler in the registered handler list.
-			for (u32 i=0; i<mNumMessageHandlers; ++i)
-			{
-				IMessageHandler* messageHandler = (IMessageHandler*)&mMessageHandlers[i];
-				// Try to convert this handler, of unknown type, to the target type.
-				const MessageHandlerType *const typedHandler = HandlerCaster:: template CastHandler<ValueType>(messageHandler);
-				if (typedHandler)
-				{
-					// Don't count the handler if it's already marked for deregistration.
-					if (typedHandler->GetHandlerFunction() == handler && !typedHandler->IsMarked())
-					{
-						// Mark the handler for deregistration.
-						// We defer the actual deregistration and deletion until
-						// after all active message handlers have been executed, because
-						// message handlers themselves can deregister handlers.
-						messageHandler->Mark();
-
-						// Mark the handlers as dirty so we update them before the next processing.
-						DirtyHandlers();
-
-						return true;
-					}
-				}
-			}
-			return false;
-		}
-
-
-		template <class ActorType, class ValueType>
-		inline bool ActorCore::IsHandlerRegistered(ActorType *const /*actor*/, void (ActorType::*handler)(const ValueType &message, const Address from))
-		{
-			// If the message value type has a valid (non-zero) type name defined for it,
-			// then we use explicit type names to match messages to handlers.
-			// The default value of zero indicates that no type name has been defined,
-			// in which case we rely on compiler-generated RTTI to identify message types.
-			typedef MessageHandler<ActorType, ValueType> MessageHandlerType;
-			typedef MessageHandlerCast<ActorType, MessageTraits<ValueType>::HAS_TYPE_NAME> HandlerCaster;
-
-			// We don't need to lock this because only one thread can access it at a time.
-			// Find the handler in the registered handler list.
-			for (u32 i=0; i<mNumMessageHandlers; ++i)
-			{
-				IMessageHandler* messageHandler = (IMessageHandler*)&mMessageHandlers[i];
-				// Try to convert this handler, of unknown type, to the target type.
-				const MessageHandlerType *const typedHandler = HandlerCaster:: template CastHandler<ValueType>(messageHandler);
-				if (typedHandler)
-				{
-					// Don't count the handler if it's already marked for deregistration.
-					if (typedHandler->GetHandlerFunction() == handler && !typedHandler->IsMarked())
-					{
-						return true;
-					}
-				}
-			}
-			return false;
-
-		}
-
-
 		XLANG_FORCEINLINE u32 ActorCore::GetNumQueuedMessages() const
 		{
-			return mMessageCount;
+			return Atomic::Load(&mMessageCount);
 		}
 
 
 		XLANG_FORCEINLINE bool ActorCore::HasQueuedMessage() const
 		{
-			return (mMessageCount > 0);
+			// The queue itself is checked rather than the count, since a message is
+			// counted slightly before it's pushed.
+			return !mMessageQueue.Empty();
 		}
 
 
 		XLANG_FORCEINLINE IMessage *ActorCore::GetQueuedMessage()
 		{
-			// This exploits the fact that bools are either 0 or 1 to avoid a branch.
 			IMessage *const message(mMessageQueue.Pop());
-			const bool gotMessage(message != 0);
-			const u32 messageDecrement(static_cast<u32>(gotMessage));
-
-			XLANG_ASSERT(messageDecrement <= 1);
-			XLANG_ASSERT(mMessageCount >= messageDecrement);
+			if (message)
+			{
+				XLANG_ASSERT(Atomic::Load(&mMessageCount) > 0);
+				Atomic::Decrement(&mMessageCount);
+			}
 
-			mMessageCount -= messageDecrement;
 			return message;
 		}
 
@@ -293,33 +282,51 @@ namespace clang
 		{
 			XLANG_ASSERT(message);
 
-			// Give each registered handler a chance to handle this message.
-			bool handled(false);
+			// Use the message type id as the key into the dispatch index.
+			const u32 typeId(message->TypeId());
 
-			// Use the message type name as the key
-			int const msg_typeid = message->TypeId();
+			// Execute each registered handler for this message type, in the order they were registered.
+			// Handlers changed by the handlers themselves are changed in a private copy of the table,
+			// so the table we're iterating stays valid until the actor is next processed.
+			// Handlers can forward the message while it's being processed.
+			mState |= STATE_PROCESSING_MESSAGE;
 
-			// @TODO: Binary search!
-			// Currently a linear search
-			for (u32 i=0; i<mNumMessageHandlers; ++i)
+			bool handled(false);
+			if (const HandlerTable *const handlers = mHandlers)
 			{
-				IMessageHandler* handler = (IMessageHandler*)&mMessageHandlers[i];
-				if (handler->GetMessageTypeId() == msg_typeid)
+				const HandlerTable::Entry *entry(handlers->Find(typeId));
+				const HandlerTable::Entry *const end(handlers->End());
+
+				while (entry != end && entry->mTypeId == typeId)
 				{
-					handled = handler->Handle(mParent, message);
-					XLANG_ASSERT(handled);
+					entry->mThunk(entry->GetHandler(), mParent, message);
+					handled = true;
+					++entry;
 				}
 			}
 
-			if (handled)
-				return;
-
 			// If no registered handler handled the message, execute the default handler instead.
-			if (ExecuteDefaultHandler(message))
-				return;
-
 			// Finally if the actor has no default handler then run the framework's fallback handler.
-			ExecuteFallbackHandler(message);
+			if (!handled && !ExecuteDefaultHandler(message))
+			{
+				ExecuteFallbackHandler(message);
+			}
+
+			mState &= (~STATE_PROCESSING_MESSAGE);
+		}
+
+
+		XLANG_FORCEINLINE bool ActorCore::SetForwardAddress(const Address &address)
+		{
+			if ((mState & STATE_PROCESSING_MESSAGE) == 0)
+			{
+				return false;
+			}
+
+			// If the message is forwarded more than once, the last address wins.
+			mForwardAddress = address;
+			mState |= STATE_MESSAGE_FORWARDED;
+			return true;
 		}
 
 
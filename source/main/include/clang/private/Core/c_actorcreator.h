@@ -6,7 +6,7 @@
 #include "clang/private/Core/c_ActorCore.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Directory/c_ActorDirectory.h"
-#include "clang/private/Directory/c_Directory.h"
+#include "clang/private/Handlers/c_HandlerTable.h"
 #include "clang/private/Threading/c_Lock.h"
 #include "clang/private/Threading/c_Mutex.h"
 
@@ -61,6 +61,22 @@ namespace clang
 		};
 
 
+		/// Remembers the handlers registered by the constructors of actors of a given type,
+		/// so they can be shared by later actors of the same type.
+		/// \note Only accessed by HandlerTable, which forgets the table when it's freed.
+		template <class ActorType>
+		class ActorHandlers
+		{
+		public:
+
+			static HandlerTable *smTable;           ///< Shared table of handlers, or null if none yet.
+		};
+
+
+		template <class ActorType>
+		HandlerTable *ActorHandlers<ActorType>::smTable = 0;
+
+
 		XLANG_FORCEINLINE void ActorCreator::SetAddress(const Address &address)
 		{
 			smAddress = address;
@@ -106,7 +122,7 @@ namespace clang
 				bool registered(false);
 
 				{
-					Lock lock(Directory::GetMutex());
+					// The directory locks itself for registration.
 					ActorDirectory &directory(ActorDirectory::Instance());
 
 					// Register and construct the actor core, passing it the framework and referencing actor.
@@ -138,6 +154,9 @@ namespace clang
 						// memory buffer. The derived actor class constructor may itself send messages or
 						// construct other actors.
 						actor = constructor(actorMemory);
+
+						// Share the handlers registered by the constructor with other actors of the same type.
+						actorCore->InternHandlers(ActorHandlers<ActorType>::smTable);
 					}
 
 					return actor;
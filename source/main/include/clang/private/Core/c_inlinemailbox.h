@@ -0,0 +1,113 @@
+#ifndef __XLANG_PRIVATE_CORE_INLINEMAILBOX_H
+#define __XLANG_PRIVATE_CORE_INLINEMAILBOX_H
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Messages/c_IMessage.h"
+#include "clang/private/Messages/c_InlineMessage.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Address.h"
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Ring of message slots owned by an actor, in which small messages sent to the actor are
+		/// held instead of being allocated from the message cache.
+		/// Messages held in slots are queued in the actor's message queue like any other, so the order
+		/// of arrival is kept across inline and ordinary messages. Slots are claimed in turn by senders,
+		/// and freed when their messages are destroyed, which is usually in the same order.
+		/// Senders that find the next slot in use, or that lose a race for it, spill to ordinary messages.
+		/// \note The mailbox is disabled until enabled by the owning actor, and the slots are only
+		/// allocated when the first small message is sent to it after that.
+		class InlineMailbox
+		{
+		public:
+
+			/// Number of slots in the ring. When the ring is disabled no messages are held inline,
+			/// so the mailbox is never used, but is kept valid.
+			static const u32 NUM_SLOTS = XLANG_INLINE_MAILBOX_SLOTS ? XLANG_INLINE_MAILBOX_SLOTS : 1;
+
+			/// Default constructor.
+			inline InlineMailbox();
+
+			/// Destructor. Frees the slots, which must all be free.
+			~InlineMailbox();
+
+			/// Copies a value into the next slot, and constructs a message for it.
+			/// \return Null if the next slot is still in use, or if out of memory, in which
+			/// case the message has to be allocated as an ordinary message instead.
+			/// \note This is lock-free and can be called by any thread.
+			inline IMessage *Allocate(const void *const value, const InlineMessageDescriptor &descriptor, const u32 typeId, const Address &from);
+
+			/// Enables the mailbox, so that later small messages are held in its slots.
+			/// Until enabled, Allocate always returns null and no slots are allocated.
+			inline void Enable();
+
+		private:
+
+			InlineMailbox(const InlineMailbox &other);
+			InlineMailbox &operator=(const InlineMailbox &other);
+
+			/// Allocates and installs the slots, unless another thread beats us to it.
+			/// \return The installed slots, or null if out of memory.
+			xbyte *AllocateSlots();
+
+			xbyte *volatile		mSlots;				///< Array of slots, each a cache line, or null until first used.
+			volatile u32		mNextSlot;			///< Counter of claimed slots, indicating the next slot to claim.
+			volatile u32		mEnabled;			///< Non-zero once the owning actor has enabled the mailbox.
+		};
+
+
+		XLANG_FORCEINLINE InlineMailbox::InlineMailbox()
+			: mSlots(0)
+			, mNextSlot(0)
+			, mEnabled(0)
+		{
+		}
+
+
+		XLANG_FORCEINLINE IMessage *InlineMailbox::Allocate(const void *const value, const InlineMessageDescriptor &descriptor, const u32 typeId, const Address &from)
+		{
+			if (Atomic::Load(&mEnabled) == 0)
+			{
+				return 0;
+			}
+
+			xbyte *slots(Atomic::Load(&mSlots));
+			if (slots == 0 && (slots = AllocateSlots()) == 0)
+			{
+				return 0;
+			}
+
+			// Senders claim the slots in turn. If the next slot is still in use the ring is full,
+			// and rather than search for a free slot we spill to an ordinary message. The next
+			// slot is the oldest, so it's the first to be freed when the actor processes its messages.
+			const u32 claim(Atomic::Load(&mNextSlot));
+			xbyte *const slot(slots + (claim % NUM_SLOTS) * InlineMessage::SLOT_SIZE);
+
+			if (!Atomic::CompareExchange(reinterpret_cast<volatile u32 *>(slot), static_cast<u32>(InlineMessage::SLOT_FREE), static_cast<u32>(InlineMessage::SLOT_USED)))
+			{
+				return 0;
+			}
+
+			// Another sender may already have moved on, if the slot was freed and claimed again meanwhile.
+			Atomic::CompareExchange(&mNextSlot, claim, claim + 1);
+
+			return InlineMessage::InitializeSlot(slot, value, descriptor, typeId, from);
+		}
+
+
+		XLANG_FORCEINLINE void InlineMailbox::Enable()
+		{
+			Atomic::Store(&mEnabled, static_cast<u32>(1));
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_CORE_INLINEMAILBOX_H
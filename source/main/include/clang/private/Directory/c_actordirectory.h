@@ -5,6 +5,8 @@
 #include "clang/private/Core/c_ActorCore.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/PagedPool/c_PagedPool.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Mutex.h"
 
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
@@ -19,6 +21,10 @@ namespace clang
 	{
 		/// A directory mapping unique addresses to actors.
 		/// The directory is also a pool in which actor cores are allocated.
+		/// Actors are looked up without locking. Threads looking up actors pin the directory while
+		/// they use the actors they find, and deregistration waits for the lookups that might have
+		/// found the actor before destroying it, or freeing the page it was allocated in.
+		/// Registration and deregistration are serialized by a lock private to the directory.
 		class ActorDirectory
 		{
 		public:
@@ -32,26 +38,50 @@ namespace clang
 			/// Returns the number of actors currently registered.
 			inline u32 Count() const;
 
+			/// Raises the maximum number of actors that can be registered at once to at least the given number.
+			/// Memory for the actors is only allocated as they're registered.
+			/// \return False if the maximum couldn't be raised, for lack of memory.
+			/// \note Must not be called while the calling thread has the directory pinned.
+			bool Reserve(const u32 maxActors);
+
 			/// Registers an actor and returns its unique address.
 			Address RegisterActor(Framework *const framework, Actor *const actor);
 
-			/// Deregisters the actor at the given address.
+			/// Deregisters and destroys the actor core at the given address.
+			/// Waits for any threads that have the directory pinned, and might be using the actor.
 			/// \note The address can be the address of a currently registered actor.
+			/// \note Must not be called while the calling thread has the directory pinned.
 			bool DeregisterActor(const Address &address);
 
+			/// Pins the directory, so that actors looked up by the calling thread can't be
+			/// destroyed until it's unpinned again.
+			/// \return A token to be passed to the matching call to \ref Unpin.
+			inline u32 Pin();
+
+			/// Unpins the directory, after a previous call to \ref Pin.
+			inline void Unpin(const u32 epoch);
+
 			/// Gets a pointer to the actor core at the given address.
 			/// \note The address can be the address of a currently registered actor.
+			/// \note This is lock-free. The returned actor core is only guaranteed to remain valid while
+			/// the calling thread has the directory pinned, or holds a reference to the actor.
 			inline ActorCore *GetActor(const Address &address) const;
 
 		private:
-			typedef PagedPool<ActorCore, XLANG_MAX_ACTORS> ActorPool;
+			typedef PagedPool<ActorCore> ActorPool;
 
 			ActorDirectory(const ActorDirectory &other);
 			ActorDirectory &operator=(const ActorDirectory &other);
 
+			/// Waits until all threads that pinned the directory before the call have unpinned it.
+			void Synchronize();
+
 			static ActorDirectory smInstance;       ///< Single, static instance of the class.
 
+			Mutex mMutex;                           ///< Serializes registration and deregistration.
 			ActorPool mActorPool;                   ///< Pool of system-allocated actor cores.
+			volatile u32 mEpoch;                    ///< Advanced by each deregistration to separate earlier pins from later ones.
+			volatile u32 mPinCounts[2];             ///< Number of threads pinning the directory, for even and odd epochs.
 		};
 
 
@@ -60,8 +90,16 @@ namespace clang
 			return smInstance;
 		}
 
-		XLANG_FORCEINLINE ActorDirectory::ActorDirectory() : mActorPool()
+		XLANG_FORCEINLINE ActorDirectory::ActorDirectory()
+			: mMutex()
+			, mActorPool(XLANG_MAX_ACTORS)
+			, mEpoch(0)
 		{
+			mPinCounts[0] = 0;
+			mPinCounts[1] = 0;
+
+			mActorPool.SetMaxSparePages(XLANG_DIRECTORY_SPARE_PAGES);
+			mActorPool.SetPreferLowIndices(XLANG_DIRECTORY_PREFER_LOW_INDICES != 0);
 		}
 
 		XLANG_FORCEINLINE u32 ActorDirectory::Count() const
@@ -69,17 +107,46 @@ namespace clang
 			return mActorPool.Count();
 		}
 
+		XLANG_FORCEINLINE u32 ActorDirectory::Pin()
+		{
+			while (true)
+			{
+				// Count ourselves against the current epoch.
+				const u32 epoch(Atomic::Load(&mEpoch));
+				Atomic::Increment(&mPinCounts[epoch & 1]);
+
+				// If the epoch advanced before we were counted then a deregistering thread may
+				// have missed us, and gone on to destroy an actor we could still find. Try again.
+				if (Atomic::Load(&mEpoch) == epoch)
+				{
+					return epoch;
+				}
+
+				Atomic::Decrement(&mPinCounts[epoch & 1]);
+			}
+		}
+
+
+		XLANG_FORCEINLINE void ActorDirectory::Unpin(const u32 epoch)
+		{
+			XLANG_ASSERT(Atomic::Load(&mPinCounts[epoch & 1]) > 0);
+			Atomic::Decrement(&mPinCounts[epoch & 1]);
+		}
+
+
 		XLANG_FORCEINLINE ActorCore *ActorDirectory::GetActor(const Address &address) const
 		{
 			XLANG_ASSERT(Address::IsActorAddress(address));
 			const u32 index(address.GetIndex());
 
 			// The entry in the actor pool is memory for an ActorCore object.
+			// The page is read without locking so it may be null if the address is stale.
 			void *const entry(mActorPool.GetEntry(index));
 			if (entry)
 			{
 				// Reject the actor core if its sequence number doesn't match.
-				// This guards against new actor cores constructed at the same indices as old ones.
+				// This guards against new actor cores constructed at the same indices as old ones,
+				// and against actor cores that have been deregistered.
 				ActorCore *const actorCore(reinterpret_cast<ActorCore *>(entry));
 				if (actorCore->GetSequence() == address.GetSequence())
 				{
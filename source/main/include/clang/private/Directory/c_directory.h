@@ -8,7 +8,8 @@ namespace clang
 {
 	namespace detail
 	{
-		/// Provides thread synchronization for the actor pool and receiver registry.
+		/// Provides thread synchronization for the receiver registry.
+		/// \note The actor directory is lock-free for lookups and has its own lock for registration.
 		class Directory
 		{
 		public:
@@ -30,6 +30,10 @@ namespace clang
 			/// Returns the number of receivers currently registered.
 			inline u32 Count() const;
 
+			/// Raises the maximum number of receivers that can be registered at once to at least the given number.
+			/// \return False if the maximum couldn't be raised, for lack of memory.
+			bool Reserve(const u32 maxReceivers);
+
 			/// Registers a receiver and returns its unique address.
 			Address RegisterReceiver(Receiver *const receiver);
 
@@ -43,7 +47,7 @@ namespace clang
 
 		private:
 
-			typedef PagedPool<Receiver *, XLANG_MAX_RECEIVERS> ReceiverPool;
+			typedef PagedPool<Receiver *> ReceiverPool;
 
 			ReceiverDirectory(const ReceiverDirectory &other);
 			ReceiverDirectory &operator=(const ReceiverDirectory &other);
@@ -60,8 +64,10 @@ namespace clang
 		}
 
 
-		XLANG_FORCEINLINE ReceiverDirectory::ReceiverDirectory() : mReceiverPool()
+		XLANG_FORCEINLINE ReceiverDirectory::ReceiverDirectory() : mReceiverPool(XLANG_MAX_RECEIVERS)
 		{
+			mReceiverPool.SetMaxSparePages(XLANG_DIRECTORY_SPARE_PAGES);
+			mReceiverPool.SetPreferLowIndices(XLANG_DIRECTORY_PREFER_LOW_INDICES != 0);
 		}
 
 
@@ -0,0 +1,162 @@
+#ifndef __XLANG_PRIVATE_HANDLERS_HANDLERTABLE_H
+#define __XLANG_PRIVATE_HANDLERS_HANDLERTABLE_H
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Handlers/c_IMessageHandler.h"
+#include "clang/private/Handlers/c_MessageHandler.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Mutex.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Reference-counted table of the message handlers registered by an actor.
+		/// The handlers are kept sorted by message type id, so the handlers for a message are found
+		/// with a binary search, and handlers for the same type stay in the order they were registered.
+		///
+		/// Tables are allocated with exactly the room they need. Actors of the same type whose
+		/// constructors register the same handlers share a single interned table, so tables are never
+		/// modified once they're in use for dispatch: changes are made to a private copy, which replaces
+		/// the table the next time the actor is processed.
+		class HandlerTable
+		{
+		public:
+
+			/// Entry in the table, holding a registered handler and its cached dispatch information.
+			struct Entry
+			{
+				/// Returns the registered handler.
+				XLANG_FORCEINLINE const IMessageHandler *GetHandler() const
+				{
+					return reinterpret_cast<const IMessageHandler *>(&mHandler);
+				}
+
+				u32							mTypeId;			///< Type id of the messages accepted by the handler.
+				IMessageHandler::Thunk		mThunk;				///< Executes the handler for a message of that type.
+				MessageHandler_t			mHandler;			///< The registered handler object.
+			};
+
+			/// Allocates an empty table with room for the given number of handlers.
+			/// \return A pointer to the table, with a reference count of one, or null if out of memory.
+			static HandlerTable *Create(const u32 capacity);
+
+			/// Allocates a copy of a table with room for the given number of handlers.
+			/// \param table The table to copy, which may be null for an empty table.
+			/// \return A pointer to the copy, with a reference count of one, or null if out of memory.
+			static HandlerTable *Copy(const HandlerTable *const table, const u32 capacity);
+
+			/// Adds a reference to the table.
+			XLANG_FORCEINLINE void Reference()
+			{
+				Atomic::Increment(&mReferenceCount);
+			}
+
+			/// Removes a reference from the table, freeing it when the last reference is removed.
+			/// \note Tables shared by actors on different threads are released concurrently.
+			void Release();
+
+			/// Shares a table of handlers with other actors of the same type.
+			/// \param typeTable Refers to the table interned for the actor type, if any. The interned
+			/// table is forgotten again when it's freed, so it doesn't outlive the actors using it.
+			/// \param table A private table, which is released if the interned table is used instead.
+			/// \return The interned table, with a reference added, if it holds the same handlers.
+			/// Otherwise the given table trimmed to size, which becomes the interned table if there is none.
+			static HandlerTable *Intern(HandlerTable *&typeTable, HandlerTable *const table);
+
+			/// Returns a table holding the same handlers with no spare room, releasing the given table.
+			/// \return Null if the table is empty, or the given table if it's already the right size
+			/// or if the copy can't be allocated.
+			static HandlerTable *Trim(HandlerTable *const table);
+
+			/// Returns the number of handlers in the table.
+			XLANG_FORCEINLINE u32 GetSize() const					{ return mSize; }
+
+			/// Returns the number of handlers the table has room for.
+			XLANG_FORCEINLINE u32 GetCapacity() const				{ return mCapacity; }
+
+			/// Returns a pointer to the first entry in the table.
+			XLANG_FORCEINLINE const Entry *Begin() const			{ return mEntries; }
+
+			/// Returns a pointer past the last entry in the table.
+			XLANG_FORCEINLINE const Entry *End() const				{ return mEntries + mSize; }
+
+			/// Returns the first entry whose type id isn't less than the given one.
+			inline const Entry *Find(const u32 typeId) const;
+
+			/// Returns true if the table contains the given handler.
+			bool Contains(const MessageHandler_t &handler) const;
+
+			/// Returns true if the table holds the same handlers, in the same order, as another.
+			bool Equals(const HandlerTable &other) const;
+
+			/// Adds a handler after any others registered for the same message type.
+			/// \note The table must be private to the caller and have room for the handler.
+			void Insert(const MessageHandler_t &handler);
+
+			/// Removes the first occurrence of the given handler.
+			/// \return False if the table doesn't contain the handler.
+			/// \note The table must be private to the caller.
+			bool Remove(const MessageHandler_t &handler);
+
+		private:
+
+			HandlerTable();
+			HandlerTable(const HandlerTable &other);
+			HandlerTable &operator=(const HandlerTable &other);
+
+			/// Returns the number of bytes allocated for a table with room for the given number of handlers.
+			inline static u32 AllocationSize(const u32 capacity);
+
+			/// Returns the first entry holding the given handler, or null if there is none.
+			const Entry *Search(const MessageHandler_t &handler) const;
+
+			static Mutex		smMutex;					///< Synchronizes interning with freeing of interned tables.
+
+			volatile u32		mReferenceCount;			///< Number of actors using the table.
+			u32					mSize;						///< Number of handlers in the table.
+			u32					mCapacity;					///< Number of handlers the table has room for.
+			HandlerTable		**mTypeTable;				///< Refers to the table if it's interned for an actor type.
+			Entry				mEntries[1];				///< Entries, allocated with the table to hold its capacity.
+		};
+
+
+		XLANG_FORCEINLINE u32 HandlerTable::AllocationSize(const u32 capacity)
+		{
+			XLANG_ASSERT(capacity > 0);
+			return static_cast<u32>(sizeof(HandlerTable) + (capacity - 1) * sizeof(Entry));
+		}
+
+
+		XLANG_FORCEINLINE const HandlerTable::Entry *HandlerTable::Find(const u32 typeId) const
+		{
+			// Branchless binary search: the conditional compiles to a conditional move, and the
+			// number of iterations depends only on the number of handlers.
+			const Entry *entry(mEntries);
+			u32 count(mSize);
+
+			while (count > 1)
+			{
+				const u32 half(count / 2);
+				entry = (entry[half].mTypeId < typeId) ? entry + half : entry;
+				count -= half;
+			}
+
+			// Step past the remaining entry if it's also less than the one we want.
+			if (count != 0)
+			{
+				entry += (entry->mTypeId < typeId);
+			}
+
+			return entry;
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_HANDLERS_HANDLERTABLE_H
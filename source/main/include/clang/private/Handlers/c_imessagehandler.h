@@ -16,8 +16,11 @@ namespace clang
 		class IMessageHandler
 		{
 		public:
+			/// Function that executes a handler for a message already known to be of the type it accepts.
+			/// Calling it directly avoids the virtual calls and type check of \ref Handle.
+			typedef void (*Thunk)(const IMessageHandler *const handler, Actor *const actor, const IMessage *const message);
 			/// Default constructor.
-			XLANG_FORCEINLINE IMessageHandler() : mMarked(0)
+			XLANG_FORCEINLINE IMessageHandler()
 			{
 			}
 
@@ -26,36 +29,21 @@ namespace clang
 			{
 			}
 
-			/// Marks the handler (eg. for deletion).    
-			inline void Mark();
-
-			/// Returns true if the handler is marked (eg. for deletion).    
-			inline bool IsMarked() const;
-
-			/// Returns the unique name of the message type handled by this handler.
-			virtual int GetMessageTypeId() const = 0;
+			/// Returns the unique id of the message type handled by this handler.
+			virtual u32 GetMessageTypeId() const = 0;
 
 			/// Handles the given message, if it's of the type accepted by the handler.
 			/// \return True, if the handler handled the message.
 			virtual bool Handle(Actor *const actor, const IMessage *const message) const = 0;
 
+			/// Returns the thunk that executes this handler for messages of the type it accepts.
+			virtual Thunk GetThunk() const = 0;
+
 		private:
 			IMessageHandler(const IMessageHandler &other);
 			IMessageHandler &operator=(const IMessageHandler &other);
-
-			u64 mMarked;           ///< Flag used to mark the handler for deletion.
 		};
 
-		XLANG_FORCEINLINE void IMessageHandler::Mark()
-		{
-			mMarked |= 1;
-		}
-
-		XLANG_FORCEINLINE bool IMessageHandler::IsMarked() const
-		{
-			return (mMarked & 1) == 1;
-		}
-
 
 	} // namespace detail
 } // namespace clang
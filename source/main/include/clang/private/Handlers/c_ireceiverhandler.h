@@ -31,8 +31,8 @@ namespace clang
 			/// Gets the pointer to the next message handler in a list of handlers.
 			inline IReceiverHandler *GetNext() const;
 
-			/// Returns the unique name of the message type handled by this handler.
-			virtual int GetMessageTypeId() const = 0;
+			/// Returns the unique id of the message type handled by this handler.
+			virtual u32 GetMessageTypeId() const = 0;
 
 			/// Handles the given message, if it's of the type accepted by the handler.
 			/// \return True, if the handler handled the message.
@@ -11,7 +11,7 @@
 #include "clang/private/Messages/c_IMessage.h"
 #include "clang/private/Messages/c_Message.h"
 #include "clang/private/Messages/c_MessageCast.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
@@ -22,7 +22,11 @@ namespace clang
 
 	namespace detail
 	{
-		struct MessageHandler_t { MessageHandler_t() : _vfptr_(0), _marked_(0), _data_(0) {} void* _vfptr_; u64 _marked_; u64 _data_; };
+		/// Raw storage for a placement-constructed message handler.
+		/// A pointer to member function is one word with Visual C++ but two words with the
+		/// Itanium C++ ABI used by gcc and clang, so room is reserved for the larger of the two.
+		/// The storage is zeroed so that copies of the same handler compare equal word by word.
+		struct MessageHandler_t { MessageHandler_t() : _vfptr_(0) { _data_[0] = 0; _data_[1] = 0; } void* _vfptr_; u64 _data_[2]; };
 
 		/// Instantiable class template that remembers a message handler function and
 		/// the type of message it accepts. It is responsible for checking whether
@@ -31,9 +35,8 @@ namespace clang
 		///
 		/// Incoming messages are cast at runtime to the type of message handled by the
 		/// stored handler, and the handler is executed only if the cast succeeds (returns
-		/// a non-zero pointer). The dynamic cast operation is specialized to use either
-		/// C++ dynamic_cast or a hand-rolled runtime type information (RTTI) system
-		/// that avoids introducing the type information into types other than messages.
+		/// a non-zero pointer). The cast compares the type id carried by the message with
+		/// the id of the handled type, so no C++ runtime type information (RTTI) is needed.
 		/// 
 		/// \tparam ActorType The type of actor whose message handlers are considered.
 		/// \tparam ValueType The type of message handled by this message handler.
@@ -49,6 +52,7 @@ namespace clang
 			/// Constructor.
 			inline explicit MessageHandler(HandlerFunction function) : mHandlerFunction(function)
 			{
+				MessageTypeIdCheck<ValueType>::Check();
 			}
 
 			/// Virtual destructor.
@@ -62,10 +66,10 @@ namespace clang
 				return mHandlerFunction;
 			}
 
-			/// Returns the unique name of the message type handled by this handler.
-			inline virtual int GetMessageTypeId() const
+			/// Returns the unique id of the message type handled by this handler.
+			inline virtual u32 GetMessageTypeId() const
 			{
-				return type2int<ValueType>::value();
+				return MessageTypeId<ValueType>::Value();
 			}
 
 			/// Handles the given message, if it's of the type accepted by the handler.
@@ -74,14 +78,12 @@ namespace clang
 			/// The message will be automatically destroyed when all handlers have seen it.
 			inline virtual bool Handle(Actor *const actor, const IMessage *const message) const
 			{
-				typedef MessageCast<MessageTraits<ValueType>::HAS_TYPE_NAME> MessageCaster;
-
 				XLANG_ASSERT(actor);
 				XLANG_ASSERT(mHandlerFunction);
 				XLANG_ASSERT(message);
 
 				// Try to convert the message, of unknown type, to message of the assumed type.
-				const Message<ValueType> *const typedMessage = MessageCaster:: template CastMessage<ValueType>(message);
+				const Message<ValueType> *const typedMessage = MessageCast::CastMessage<ValueType>(message);
 				if (typedMessage)
 				{
 					// Call the handler, passing it the message value and from address.
@@ -93,6 +95,28 @@ namespace clang
 				return false;
 			}
 
+			/// Returns the thunk that executes this handler for messages of the type it accepts.
+			inline virtual Thunk GetThunk() const
+			{
+				return &Invoke;
+			}
+
+			/// Executes the given handler for a message already known to be of the type it accepts.
+			inline static void Invoke(const IMessageHandler *const handler, Actor *const actor, const IMessage *const message)
+			{
+				XLANG_ASSERT(handler);
+				XLANG_ASSERT(actor);
+				XLANG_ASSERT(message);
+				XLANG_ASSERT(message->TypeId() == MessageTypeId<ValueType>::Value());
+
+				// The caller has matched the type id of the message so we can hard-convert it.
+				const MessageHandler *const typedHandler = static_cast<const MessageHandler *>(handler);
+				const Message<ValueType> *const typedMessage = reinterpret_cast<const Message<ValueType> *>(message);
+				ActorType *const typedActor = static_cast<ActorType *>(actor);
+
+				(typedActor->*typedHandler->mHandlerFunction)(typedMessage->Value(), typedMessage->From());
+			}
+
 			XCORE_CLASS_PLACEMENT_NEW_DELETE
 		private:
 			MessageHandler() : mHandlerFunction(NULL) {}
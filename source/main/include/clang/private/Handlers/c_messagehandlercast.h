@@ -4,7 +4,7 @@
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Handlers/c_IMessageHandler.h"
 #include "clang/private/Handlers/c_MessageHandler.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Defines.h"
 
@@ -17,26 +17,15 @@ namespace clang
 
 		/// \brief Dynamic cast utility for message handler pointers.
 		/// A cast utility that can be used to dynamically cast a message handler of unknown type
-		/// to a message handler of a known type at runtime, using stored runtime type information.
+		/// to a message handler of a known type at runtime, using the type id of the handled message.
 		/// If the unknown message handler is of the target type then the cast succeeds and a pointer
 		/// to the typecast message handler is returned, otherwise a null pointer is returned.
 		///
-		/// This utility roughly mimics the functionality of dynamic_cast, but includes
-		/// two alternate implementations: one that uses dynamic_cast directly and another
-		/// that rolls its own runtime type information only for message handler classes. The
-		/// advantage of the second implementation is that the storage overhead of the extra
-		/// runtime type information is not imposed on \em all classes, as with the C++ RTTI.
-		/// If the second implementation is used consistently then dynamic_cast is not
-		/// called at all, using a partial template specialization trick, and the C++ RTTI
-		/// functionality can be turned off (usually by means of a compiler option).
-		///
-		/// \note Partial template specialization is used here as a device to avoid
-		/// introducing a hardcoded dependency on C++ RTTI. The dependency can be avoided
-		/// by defining non-zero type names for all message types used in the application.
+		/// Every message type has a non-zero id, whether explicit or generated,
+		/// so the cast never needs dynamic_cast or the C++ RTTI.
 		///
 		/// \tparam ActorType The actor class for which the handler is registered.
-		/// \tparam HAS_TYPE_NAME A flag indicating whether the message type has a name.
-		template <class ActorType, bool HAS_TYPE_NAME>
+		template <class ActorType>
 		class MessageHandlerCast
 		{
 		public:
@@ -51,11 +40,11 @@ namespace clang
 			{
 				XLANG_ASSERT(handler);
 
-				// If explicit type names are used then they must be defined for all message types.
-				XLANG_ASSERT_MSG(handler->GetMessageTypeId()>=0, "Missing type name for message type");
+				// Every message type has a non-zero id, whether explicit or generated.
+				XLANG_ASSERT_MSG(handler->GetMessageTypeId() != 0, "Missing type id for message type");
 
-				// Compare the handlers using type names.
-				if (handler->GetMessageTypeId() != type2int<ValueType>::value())
+				// Compare the handlers using type ids.
+				if (handler->GetMessageTypeId() != MessageTypeId<ValueType>::Value())
 				{
 					return 0;
 				}
@@ -11,7 +11,7 @@
 #include "clang/private/Messages/c_IMessage.h"
 #include "clang/private/Messages/c_Message.h"
 #include "clang/private/Messages/c_MessageCast.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
@@ -28,9 +28,8 @@ namespace clang
 		///
 		/// Incoming messages are cast at runtime to the type of message handled by the
 		/// stored handler, and the handler is executed only if the cast succeeds (returns
-		/// a non-zero pointer). The dynamic cast operation is specialized to use either
-		/// C++ dynamic_cast or a hand-rolled runtime type information (RTTI) system
-		/// that avoids introducing the type information into types other than messages.
+		/// a non-zero pointer). The cast compares the type id carried by the message with
+		/// the id of the handled type, so no C++ runtime type information (RTTI) is needed.
 		/// 
 		/// \tparam ObjectType The class on which the handler function is a method.
 		/// \tparam ValueType The type of message handled by the message handler.
@@ -48,6 +47,7 @@ namespace clang
 				: mObject(object)
 				, mHandlerFunction(function)
 			{
+				MessageTypeIdCheck<ValueType>::Check();
 			}
 
 			/// Virtual destructor.
@@ -61,10 +61,10 @@ namespace clang
 				return mHandlerFunction;
 			}
 
-			/// Returns the unique name of the message type handled by this handler.
-			inline virtual int GetMessageTypeId() const
+			/// Returns the unique id of the message type handled by this handler.
+			inline virtual u32 GetMessageTypeId() const
 			{
-				return type2int<ValueType>::value();
+				return MessageTypeId<ValueType>::Value();
 			}
 
 			/// Handles the given message, if it's of the type accepted by the handler.
@@ -73,14 +73,12 @@ namespace clang
 			/// The message will be automatically destroyed when all handlers have seen it.
 			inline virtual bool Handle(const IMessage *const message) const
 			{
-				typedef MessageCast<MessageTraits<ValueType>::HAS_TYPE_NAME> MessageCaster;
-
 				XLANG_ASSERT(mObject);
 				XLANG_ASSERT(mHandlerFunction);
 				XLANG_ASSERT(message);
 
 				// Try to convert the message, of unknown type, to message of the assumed type.
-				const Message<ValueType> *const typedMessage = MessageCaster:: template CastMessage<ValueType>(message);
+				const Message<ValueType> *const typedMessage = MessageCast::CastMessage<ValueType>(message);
 				if (typedMessage)
 				{
 					// Call the handler, passing it the message value and from address.
@@ -4,7 +4,7 @@
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Handlers/c_IReceiverHandler.h"
 #include "clang/private/Handlers/c_ReceiverHandler.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Defines.h"
 
@@ -16,7 +16,16 @@ namespace clang
 
 
 		/// \brief Dynamic cast utility for message handler pointers.
-		template <class ObjectType, bool HAS_TYPE_NAME>
+		/// A cast utility that can be used to dynamically cast a message handler of unknown type
+		/// to a message handler of a known type at runtime, using the type id of the handled message.
+		/// If the unknown message handler is of the target type then the cast succeeds and a pointer
+		/// to the typecast message handler is returned, otherwise a null pointer is returned.
+		///
+		/// Every message type has a non-zero id, whether explicit or generated,
+		/// so the cast never needs dynamic_cast or the C++ RTTI.
+		///
+		/// \tparam ObjectType The class on which the handler function is a method.
+		template <class ObjectType>
 		class ReceiverHandlerCast
 		{
 		public:
@@ -27,11 +36,11 @@ namespace clang
 			{
 				XLANG_ASSERT(handler);
 
-				// If explicit type names are used then they must be defined for all message types.
-				XLANG_ASSERT_MSG(handler->GetMessageTypeId()>=0, "Missing type name for message type");
+				// Every message type has a non-zero id, whether explicit or generated.
+				XLANG_ASSERT_MSG(handler->GetMessageTypeId() != 0, "Missing type id for message type");
 
-				// Compare the handlers using type names.
-				if (handler->GetMessageTypeId() != type2int<ValueType>::value())
+				// Compare the handlers using type ids.
+				if (handler->GetMessageTypeId() != MessageTypeId<ValueType>::Value())
 				{
 					return 0;
 				}
@@ -42,31 +51,6 @@ namespace clang
 			}
 		};
 
-#ifndef XLANG_NO_DYNAMIC_CAST
-		// Specialization of the ReceiverHandlerCast for the case where the message type has no type name.
-		// This specialization uses C++ built-in RTTI instead of explicitly stored type names.
-		template <class ObjectType>
-		class ReceiverHandlerCast<ObjectType, false>
-		{
-		public:
-
-			/// Attempts to convert the given message handler, of unknown message type, to a handler of the given type.
-			/// \note Returns a null pointer if the unknown handler is of the wrong type.
-			template <class ValueType>
-			XLANG_FORCEINLINE static const ReceiverHandler<ObjectType, ValueType> *CastHandler(const IReceiverHandler *const handler)
-			{
-				XLANG_ASSERT(handler);
-
-				// Explicit type names must be defined for all message types or none at all.
-				XLANG_ASSERT_MSG(handler->GetMessageTypeId()>=0, "Type names specified for only some message types!");
-
-				// Try to convert the given message handler to this type.
-				typedef ReceiverHandler<ObjectType, ValueType> HandlerType;
-				return dynamic_cast<const HandlerType *>(handler);
-			}
-		};
-#endif
-
 	} // namespace detail
 } // namespace clang
 
@@ -8,22 +8,102 @@
 #include "clang/private/c_BasicTypes.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/MessageCache/c_Pool.h"
+#include "clang/private/Threading/c_Atomic.h"
 #include "clang/private/Threading/c_Lock.h"
 #include "clang/private/Threading/c_Mutex.h"
 
 #include "clang/c_AllocatorManager.h"
 #include "clang/c_Defines.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 
 namespace clang
 {
 	namespace detail
 	{
-		// A global cache of free message memory blocks of different sizes.
+		/// Computes the base two logarithm of a power of two at compile time.
+		template <u32 VALUE>
+		struct MessageCacheLog2
+		{
+			static const u32 RESULT = 1 + MessageCacheLog2<VALUE / 2>::RESULT;
+		};
+
+		template <>
+		struct MessageCacheLog2<1>
+		{
+			static const u32 RESULT = 0;
+		};
+
+
+		/// A global cache of free message memory blocks of different sizes and alignments.
+		/// Block sizes are rounded up to geometrically spaced size classes, four per doubling of
+		/// size, and alignments to alignment classes, powers of two up to the cache line size.
+		/// Each combination of size class and alignment class has its own pool of free blocks,
+		/// so a block of any supported alignment is fetched by popping the head of a pool.
+		/// Threads that register a thread cache allocate and free blocks through per-thread
+		/// magazines of cached blocks, one per size class, without locking. Magazines that run
+		/// empty or overflow exchange batches of blocks with a shared depot, which is protected
+		/// by its own lock. Other threads allocate and free blocks directly from the depot.
+		/// Each pool of the depot starts small and grows whenever freed blocks overflow it, up to
+		/// a ceiling on the memory held by the whole depot.
 		class MessageCache
 		{
 		public:
-			static const u32 MessageAlignment = sizeof(void*);
+
+			/// Size in bytes of the largest block that can be cached.
+			static const u32 MAX_BLOCK_SIZE = XLANG_MESSAGE_CACHE_MAX_BLOCK_SIZE;
+
+			/// Maximum total size in bytes of the blocks that the depot can hold.
+			static const u32 MAX_DEPOT_BYTES = XLANG_MESSAGE_CACHE_MAX_BYTES;
+
+			/// Number of size classes per doubling of the block size.
+			static const u32 CLASSES_PER_DOUBLING = 4;
+
+			/// Number of memory block pools maintained, one per size class.
+			/// The smallest four size classes are 8, 16, 24 and 32 bytes, and each following
+			/// group of four is twice the size of the previous group, up to the maximum block size.
+			static const u32 MAX_POOLS = CLASSES_PER_DOUBLING * (MessageCacheLog2<MAX_BLOCK_SIZE>::RESULT - 4);
+
+			/// Smallest alignment of cached blocks, which is the alignment of the first alignment class.
+			static const u32 MIN_ALIGNMENT = 8;
+
+			/// Number of alignment classes, each twice the alignment of the last, up to the cache line size.
+			/// Blocks needing more alignment are allocated at their own alignment, and cached by the alignment they happen to have.
+			static const u32 NUM_ALIGNMENT_CLASSES = MessageCacheLog2<XLANG_CACHELINE_SIZE>::RESULT - MessageCacheLog2<MIN_ALIGNMENT>::RESULT + 1;
+
+			/// Counted events, per size class.
+			enum Stat
+			{
+				STAT_HITS = 0,								///< Allocations served from the cache.
+				STAT_MISSES,								///< Allocations that fell through to the allocator.
+				STAT_OVERFLOWS,								///< Frees that fell through to the allocator, because the depot was full.
+				MAX_STATS
+			};
+
+			/// Snapshot of the state and event counts of a single size class.
+			struct PoolStats
+			{
+				u32			mBlockSize;					///< Size in bytes of the blocks of the size class.
+				u32			mMaxBlocks;					///< Maximum number of blocks the depot currently holds for the size class, of all alignments.
+				u32			mNumBlocks;					///< Number of blocks currently held by the depot, of all alignments.
+				u64			mHits;						///< Allocations served from the cache.
+				u64			mMisses;					///< Allocations that fell through to the allocator.
+				u64			mOverflows;					///< Frees that fell through to the allocator.
+			};
+
+			/// Magazines of free blocks owned by a single thread, one per size class and alignment class.
+			struct ThreadCache
+			{
+				/// Default constructor.
+				inline ThreadCache();
+
+				Pool			mMagazines[MAX_POOLS][NUM_ALIGNMENT_CLASSES];	///< Blocks cached by the thread, indexed by pool and alignment class.
+				volatile u64	mStats[MAX_POOLS][MAX_STATS];		///< Event counts, written only by the owning thread.
+				ThreadCache		*mNext;								///< Next registered thread cache, protected by the depot lock.
+			};
 
 			/// Gets a reference to the single global instance.
 			inline static MessageCache &Instance();
@@ -38,36 +118,127 @@ namespace clang
 			inline void Reference();
 
 			/// Dereferences the singleton instance.
-			/// Any cached memory blocks are freed on last dereference.
+			/// Any cached memory blocks are freed on last dereference, and the pools and event counts reset.
+			/// \note Threads with registered thread caches must have deregistered them first.
 			inline void Dereference();
 
+			/// Registers a thread cache for the calling thread to use for all its allocations.
+			/// \note The cache must be empty, and remain valid until it's deregistered.
+			inline void RegisterThreadCache(ThreadCache *const threadCache);
+
+			/// Deregisters the calling thread's thread cache, returning its blocks to the depot.
+			inline void DeregisterThreadCache();
+
 			/// Allocates a memory block of the given size.
+			/// \note Can be called by any thread, without locking.
 			inline void *Allocate(const u32 size, const u32 alignment);
 
+			/// Allocates a number of memory blocks of the same size at once.
+			/// Threads without a thread cache lock the depot only once for the whole batch.
+			/// \return The number of blocks allocated, which is less than requested if out of memory.
+			/// \note Can be called by any thread.
+			inline u32 AllocateBatch(const u32 size, const u32 alignment, void **const blocks, const u32 count);
+
 			/// Frees a previously allocated memory block.
+			/// \note Can be called by any thread, without locking.
 			inline void Free(void *const block, const u32 size);
 
-		private:
+			/// Gets the state and event counts of a size class, summed over the depot and all registered thread caches.
+			/// \note Can be called by any thread.
+			void GetPoolStats(const u32 poolIndex, PoolStats &stats);
 
-			/// Hashes a block size to a pool index.
+			/// Hashes a block size to the index of the pool holding blocks of its size class.
+			/// \return MAX_POOLS or more if the size is too big to cache.
 			inline static u32 MapBlockSizeToPool(const u32 size);
 
+			/// Gets the size in bytes of the blocks held by a pool.
+			inline static u32 GetPoolBlockSize(const u32 poolIndex);
+
+			/// Maps a requested alignment to the smallest alignment class that satisfies it.
+			/// \return NUM_ALIGNMENT_CLASSES or more if the alignment is too big to cache.
+			inline static u32 MapAlignmentToClass(const u32 alignment);
+
+			/// Gets the highest alignment class whose alignment a block's address satisfies.
+			/// Blocks are cached by the alignment of their address, which is at least the alignment they were allocated with.
+			inline static u32 GetBlockAlignmentClass(const void *const block);
+
+			/// Pops a block from the first non-empty pool, of a size class, with at least the given alignment class.
+			/// \return Zero if the pools are all empty.
+			inline static void *FetchFromPools(Pool *const pools, const u32 alignmentClass);
+
+		private:
+
+			/// Largest number of blocks a magazine holds.
+			static const u32 MAX_MAGAZINE_BLOCKS = Pool::DEFAULT_MAX_BLOCKS;
+
+			/// Smallest number of blocks a magazine holds.
+			static const u32 MIN_MAGAZINE_BLOCKS = 2;
+
+			/// Size in bytes of the blocks a magazine holds, so magazines of large blocks hold fewer.
+			static const u32 MAGAZINE_BYTES = 16384;
+
+			/// Largest number of blocks the depot holds of any one size class.
+			static const u32 MAX_DEPOT_BLOCKS = 4096;
+
 			MessageCache(const MessageCache &other);
 			MessageCache &operator=(const MessageCache &other);
 
-			/// Number of memory block pools maintained.
-			/// Each pool holds memory blocks of a specific size.
-			/// The number of pools dictates the maximum block size that can be cached.
-			static const u32 MAX_POOLS = 32;
+			/// Gets the number of blocks each magazine of a pool holds, and the initial number held by the depot.
+			inline static u32 GetMagazineBlocks(const u32 poolIndex);
 
-			static MessageCache smInstance;			///< Single, static instance of the class.
+			/// Counts events in a word written only by a single thread.
+			inline static void IncrementStat(volatile u64 *const word, const u32 value = 1);
 
-			Mutex		mReferenceCountMutex;		///< Synchronizes access to the reference count.
-			u32			mReferenceCount;			///< Tracks how many clients exist.
-			Pool		mPools[MAX_POOLS];			///< Pools of memory blocks of different sizes.
+			/// Returns the index of the highest set bit of a non-zero value.
+			inline static u32 FindHighestSetBit(const u32 value);
+
+			/// Moves a batch of blocks, if there are any, from the depot into empty magazines.
+			/// The blocks come from the first pool of the depot, with at least the given alignment class, that isn't empty.
+			inline void Refill(Pool *const magazines, const u32 poolIndex, const u32 alignmentClass);
+
+			/// Moves a batch of blocks from a full magazine into the depot,
+			/// freeing any that the depot has no room for.
+			inline void Spill(Pool &magazine, const u32 poolIndex, const u32 alignmentClass, const u32 count);
+
+			/// Adds a block to a pool of the depot, growing the pool if it's full.
+			/// \return False if the depot has no room for the block.
+			/// \note The caller must hold the depot lock.
+			inline bool AddToDepot(void *const block, const u32 poolIndex, const u32 alignmentClass);
+
+			/// Grows a full pool of the depot, within the limit on the memory held by the depot.
+			/// \return False if the pool can't grow.
+			/// \note The caller must hold the depot lock.
+			bool Grow(const u32 poolIndex, const u32 alignmentClass);
+
+			/// Resets the pools of the depot to their initial sizes, and clears the event counts.
+			/// \note The caller must hold the depot lock, and the pools must be empty.
+			void ResetDepot();
+
+			static MessageCache smInstance;			///< Single, static instance of the class.
+			static XLANG_THREAD_LOCAL ThreadCache *smThreadCache;	///< Thread cache of the calling thread, if any.
+
+			Mutex			mReferenceCountMutex;		///< Synchronizes access to the reference count.
+			u32				mReferenceCount;			///< Tracks how many clients exist.
+			Mutex			mDepotMutex;				///< Protects the depot.
+			Pool			mPools[MAX_POOLS][NUM_ALIGNMENT_CLASSES];	///< Depot of memory blocks of different sizes and alignments, shared by all threads.
+			u64				mStats[MAX_POOLS][MAX_STATS];	///< Event counts of the depot, and of deregistered thread caches.
+			u32				mDepotBytes;				///< Total size of the blocks the pools of the depot can hold.
+			ThreadCache		*mThreadCaches;				///< List of registered thread caches.
 		};
 
 
+		XLANG_FORCEINLINE MessageCache::ThreadCache::ThreadCache() : mNext(0)
+		{
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				for (u32 stat = 0; stat < MAX_STATS; ++stat)
+				{
+					mStats[index][stat] = 0;
+				}
+			}
+		}
+
+
 		XLANG_FORCEINLINE MessageCache &MessageCache::Instance()
 		{
 			return smInstance;
@@ -77,7 +248,11 @@ namespace clang
 		XLANG_FORCEINLINE MessageCache::MessageCache()
 			: mReferenceCountMutex()
 			, mReferenceCount(0)
+			, mDepotMutex()
+			, mDepotBytes(0)
+			, mThreadCaches(0)
 		{
+			ResetDepot();
 		}
 
 
@@ -88,7 +263,10 @@ namespace clang
 			// or a receiver) wasn't destructed prior to the application ending.
 			for (u32 index = 0; index < MAX_POOLS; ++index)
 			{
-				XLANG_ASSERT(mPools[index].Empty());
+				for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+				{
+					XLANG_ASSERT(mPools[index][alignmentClass].Empty());
+				}
 			}
 		}
 
@@ -99,9 +277,13 @@ namespace clang
 			if (mReferenceCount++ == 0)
 			{
 				// Check that the pools were all left empty from the last use, if any.
+				Lock depotLock(mDepotMutex);
 				for (u32 index = 0; index < MAX_POOLS; ++index)
 				{
-					XLANG_ASSERT(mPools[index].Empty());
+					for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+					{
+						XLANG_ASSERT(mPools[index][alignmentClass].Empty());
+					}
 				}
 			}
 		}
@@ -113,9 +295,87 @@ namespace clang
 			if (--mReferenceCount == 0)
 			{
 				// Free any remaining blocks in the pools.
+				Lock depotLock(mDepotMutex);
+				XLANG_ASSERT(mThreadCaches == 0);
+
 				for (u32 index = 0; index < MAX_POOLS; ++index)
 				{
-					mPools[index].Clear();
+					for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+					{
+						mPools[index][alignmentClass].Clear();
+					}
+				}
+
+				ResetDepot();
+			}
+		}
+
+
+		XLANG_FORCEINLINE void MessageCache::RegisterThreadCache(ThreadCache *const threadCache)
+		{
+			XLANG_ASSERT(threadCache);
+			XLANG_ASSERT(smThreadCache == 0);
+
+			// Magazines of large blocks hold fewer of them, to bound the memory held by each thread.
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+				{
+					XLANG_ASSERT(threadCache->mMagazines[index][alignmentClass].Empty());
+					threadCache->mMagazines[index][alignmentClass].SetMaxBlocks(GetMagazineBlocks(index));
+				}
+
+				for (u32 stat = 0; stat < MAX_STATS; ++stat)
+				{
+					threadCache->mStats[index][stat] = 0;
+				}
+			}
+
+			{
+				Lock lock(mDepotMutex);
+				threadCache->mNext = mThreadCaches;
+				mThreadCaches = threadCache;
+			}
+
+			smThreadCache = threadCache;
+		}
+
+
+		XLANG_FORCEINLINE void MessageCache::DeregisterThreadCache()
+		{
+			ThreadCache *const threadCache(smThreadCache);
+			XLANG_ASSERT(threadCache);
+
+			smThreadCache = 0;
+
+			// Return all the cached blocks to the depot, so they can be freed with it.
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+				{
+					Pool &magazine(threadCache->mMagazines[index][alignmentClass]);
+					Spill(magazine, index, alignmentClass, magazine.GetNumBlocks());
+				}
+			}
+
+			// Unlink the thread cache, keeping its event counts in the depot's.
+			Lock lock(mDepotMutex);
+
+			ThreadCache **link(&mThreadCaches);
+			while (*link != threadCache)
+			{
+				XLANG_ASSERT(*link);
+				link = &(*link)->mNext;
+			}
+
+			*link = threadCache->mNext;
+			threadCache->mNext = 0;
+
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				for (u32 stat = 0; stat < MAX_STATS; ++stat)
+				{
+					mStats[index][stat] += threadCache->mStats[index][stat];
 				}
 			}
 		}
@@ -134,12 +394,47 @@ namespace clang
 			// We can't cache blocks bigger than a certain maximum size.
 			if (poolIndex < MAX_POOLS)
 			{
-				// Search the pool for a block of the right alignment.
-				Pool &pool(mPools[poolIndex]);
-				if (void *const block = pool.FetchAligned(alignment))
+				// Blocks needing more than cache line alignment are never found in the cache.
+				const u32 alignmentClass(MapAlignmentToClass(alignment));
+				if (alignmentClass < NUM_ALIGNMENT_CLASSES)
 				{
-					return block;
+					if (ThreadCache *const threadCache = smThreadCache)
+					{
+						// Pop a block from the thread's own magazines, refilling them from the depot if they're empty.
+						Pool *const magazines(threadCache->mMagazines[poolIndex]);
+						void *block(FetchFromPools(magazines, alignmentClass));
+
+						if (block == 0)
+						{
+							Refill(magazines, poolIndex, alignmentClass);
+							block = FetchFromPools(magazines, alignmentClass);
+						}
+
+						IncrementStat(&threadCache->mStats[poolIndex][block ? STAT_HITS : STAT_MISSES]);
+
+						if (block)
+						{
+							return block;
+						}
+					}
+					else
+					{
+						// Pop a block from the depot.
+						Lock lock(mDepotMutex);
+						void *const block(FetchFromPools(mPools[poolIndex], alignmentClass));
+						++mStats[poolIndex][block ? STAT_HITS : STAT_MISSES];
+
+						if (block)
+						{
+							return block;
+						}
+					}
 				}
+
+				// Allocate a block of the full size of the size class, so it can be reused for any size in the class,
+				// aligned to at least the smallest alignment class.
+				const u32 blockAlignment(alignment < MIN_ALIGNMENT ? MIN_ALIGNMENT : alignment);
+				return AllocatorManager::Instance().GetAllocator()->AllocateAligned(GetPoolBlockSize(poolIndex), blockAlignment);
 			}
 
 			// We didn't find a cached block so we need to allocate a new one from the user allocator.
@@ -147,6 +442,84 @@ namespace clang
 		}
 
 
+		XLANG_FORCEINLINE u32 MessageCache::AllocateBatch(const u32 size, const u32 alignment, void **const blocks, const u32 count)
+		{
+			XLANG_ASSERT(size);
+			XLANG_ASSERT(alignment);
+			XLANG_ASSERT((alignment & (alignment - 1)) == 0);
+			XLANG_ASSERT(blocks);
+
+			const u32 poolIndex(MapBlockSizeToPool(size));
+			const u32 alignmentClass(MapAlignmentToClass(alignment));
+			u32 allocated(0);
+
+			// Blocks needing more than cache line alignment are never found in the cache.
+			if (poolIndex < MAX_POOLS && alignmentClass < NUM_ALIGNMENT_CLASSES)
+			{
+				if (ThreadCache *const threadCache = smThreadCache)
+				{
+					// Take blocks from the thread's own magazines, refilling them from the depot until it runs dry.
+					Pool *const magazines(threadCache->mMagazines[poolIndex]);
+					while (allocated < count)
+					{
+						void *block(FetchFromPools(magazines, alignmentClass));
+						if (block == 0)
+						{
+							Refill(magazines, poolIndex, alignmentClass);
+							block = FetchFromPools(magazines, alignmentClass);
+
+							if (block == 0)
+							{
+								break;
+							}
+						}
+
+						blocks[allocated++] = block;
+					}
+
+					IncrementStat(&threadCache->mStats[poolIndex][STAT_HITS], allocated);
+					IncrementStat(&threadCache->mStats[poolIndex][STAT_MISSES], count - allocated);
+				}
+				else
+				{
+					// Take as many blocks as the depot has, under a single lock.
+					Lock lock(mDepotMutex);
+					while (allocated < count)
+					{
+						void *const block(FetchFromPools(mPools[poolIndex], alignmentClass));
+						if (block == 0)
+						{
+							break;
+						}
+
+						blocks[allocated++] = block;
+					}
+
+					mStats[poolIndex][STAT_HITS] += allocated;
+					mStats[poolIndex][STAT_MISSES] += count - allocated;
+				}
+			}
+
+			// Allocate the rest from the user allocator, at the full size of the size class if it's cached.
+			const u32 blockSize(poolIndex < MAX_POOLS ? GetPoolBlockSize(poolIndex) : size);
+			const u32 blockAlignment(poolIndex < MAX_POOLS && alignment < MIN_ALIGNMENT ? MIN_ALIGNMENT : alignment);
+
+			IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+			while (allocated < count)
+			{
+				void *const block(allocator->AllocateAligned(blockSize, blockAlignment));
+				if (block == 0)
+				{
+					break;
+				}
+
+				blocks[allocated++] = block;
+			}
+
+			return allocated;
+		}
+
+
 		XLANG_FORCEINLINE void MessageCache::Free(void *const block, const u32 size)
 		{
 			XLANG_ASSERT(block);
@@ -158,8 +531,24 @@ namespace clang
 			// We can't cache blocks bigger than a certain maximum size.
 			if (poolIndex < MAX_POOLS)
 			{
-				// Add the block to the pool, if there is space left in the pool.
-				if (mPools[poolIndex].Add(block))
+				const u32 alignmentClass(GetBlockAlignmentClass(block));
+
+				if (ThreadCache *const threadCache = smThreadCache)
+				{
+					// Add the block to the thread's own magazine, making room if it's full.
+					Pool &magazine(threadCache->mMagazines[poolIndex][alignmentClass]);
+					if (!magazine.Add(block))
+					{
+						Spill(magazine, poolIndex, alignmentClass, (magazine.GetMaxBlocks() + 1) / 2);
+						magazine.Add(block);
+					}
+
+					return;
+				}
+
+				// Add the block to the depot, if there is space left in the pool.
+				Lock lock(mDepotMutex);
+				if (AddToDepot(block, poolIndex, alignmentClass))
 				{
 					return;
 				}
@@ -172,15 +561,188 @@ namespace clang
 
 		XLANG_FORCEINLINE u32 MessageCache::MapBlockSizeToPool(const u32 size)
 		{
-			// We assume that all allocations are non-zero multiples of four bytes!
-			XLANG_ASSERT((size & 3) == 0);
+			XLANG_ASSERT(size > 0);
+
+			// The smallest four size classes are spaced eight bytes apart.
+			if (size <= 32)
+			{
+				return (size + 7) / 8 - 1;
+			}
+
+			// Otherwise the two bits below the highest set bit of the largest offset within
+			// the size class select one of the four size classes of its doubling.
+			const u32 offset(size - 1);
+			const u32 log2(FindHighestSetBit(offset));
+			return CLASSES_PER_DOUBLING * (log2 - 4) + (offset >> (log2 - 2)) - 4;
+		}
+
+
+		XLANG_FORCEINLINE u32 MessageCache::GetPoolBlockSize(const u32 poolIndex)
+		{
+			const u32 group(poolIndex / CLASSES_PER_DOUBLING);
+			const u32 step(poolIndex % CLASSES_PER_DOUBLING);
+
+			if (group == 0)
+			{
+				return (step + 1) * 8;
+			}
 
-			// Because all allocation sizes are multiples of four, we divide by four.
-			const u32 index((size + (MessageAlignment - 1)) / MessageAlignment);
+			return (step + 5) << (group + 2);
+		}
+
+
+		XLANG_FORCEINLINE u32 MessageCache::MapAlignmentToClass(const u32 alignment)
+		{
+			if (alignment <= MIN_ALIGNMENT)
+			{
+				return 0;
+			}
+
+			return FindHighestSetBit(alignment) - MessageCacheLog2<MIN_ALIGNMENT>::RESULT;
+		}
+
+
+		XLANG_FORCEINLINE u32 MessageCache::GetMagazineBlocks(const u32 poolIndex)
+		{
+			const u32 numBlocks(MAGAZINE_BYTES / GetPoolBlockSize(poolIndex));
+
+			if (numBlocks < MIN_MAGAZINE_BLOCKS)
+			{
+				return MIN_MAGAZINE_BLOCKS;
+			}
+
+			return (numBlocks < MAX_MAGAZINE_BLOCKS) ? numBlocks : MAX_MAGAZINE_BLOCKS;
+		}
+
+
+		XLANG_FORCEINLINE void MessageCache::IncrementStat(volatile u64 *const word, const u32 value)
+		{
+			// Only one thread writes each count, so a plain add is safe.
+			// The atomic load and store just stop readers seeing torn 64-bit values.
+			Atomic::Store(word, Atomic::Load(word) + value);
+		}
+
+
+		XLANG_FORCEINLINE u32 MessageCache::FindHighestSetBit(const u32 value)
+		{
+			XLANG_ASSERT(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+			return 31 - static_cast<u32>(__builtin_clz(value));
+#elif defined(_MSC_VER)
+			unsigned long index;
+			_BitScanReverse(&index, value);
+			return static_cast<u32>(index);
+#else
+			u32 index(31);
+			while ((value & (1u << index)) == 0)
+			{
+				--index;
+			}
+
+			return index;
+#endif
+		}
+
+
+		XLANG_FORCEINLINE u32 MessageCache::GetBlockAlignmentClass(const void *const block)
+		{
+			const uintptr_t address(reinterpret_cast<uintptr_t>(block));
+			XLANG_ASSERT((address & (MIN_ALIGNMENT - 1)) == 0);
+
+			u32 alignmentClass(NUM_ALIGNMENT_CLASSES - 1);
+			while ((address & ((MIN_ALIGNMENT << alignmentClass) - 1)) != 0)
+			{
+				--alignmentClass;
+			}
+
+			return alignmentClass;
+		}
+
+
+		XLANG_FORCEINLINE void *MessageCache::FetchFromPools(Pool *const pools, const u32 alignmentClass)
+		{
+			// Blocks of higher alignment classes satisfy lower ones too.
+			for (u32 index = alignmentClass; index < NUM_ALIGNMENT_CLASSES; ++index)
+			{
+				if (void *const block = pools[index].Fetch())
+				{
+					return block;
+				}
+			}
+
+			return 0;
+		}
+
+
+		XLANG_FORCEINLINE void MessageCache::Refill(Pool *const magazines, const u32 poolIndex, const u32 alignmentClass)
+		{
+			Lock lock(mDepotMutex);
+
+			for (u32 index = alignmentClass; index < NUM_ALIGNMENT_CLASSES; ++index)
+			{
+				Pool &pool(mPools[poolIndex][index]);
+				if (pool.Empty())
+				{
+					continue;
+				}
+
+				// Fill half the magazine, leaving room for blocks freed by the thread.
+				Pool &magazine(magazines[index]);
+				const u32 batchSize((magazine.GetMaxBlocks() + 1) / 2);
+
+				for (u32 count = 0; count < batchSize; ++count)
+				{
+					void *const block(pool.Fetch());
+					if (block == 0)
+					{
+						break;
+					}
+
+					magazine.Add(block);
+				}
+
+				return;
+			}
+		}
+
+
+		XLANG_FORCEINLINE void MessageCache::Spill(Pool &magazine, const u32 poolIndex, const u32 alignmentClass, const u32 count)
+		{
+			Lock lock(mDepotMutex);
+
+			for (u32 index = 0; index < count; ++index)
+			{
+				void *const block(magazine.Fetch());
+				if (block == 0)
+				{
+					break;
+				}
+
+				if (!AddToDepot(block, poolIndex, alignmentClass))
+				{
+					AllocatorManager::Instance().GetAllocator()->Free(block);
+				}
+			}
+		}
+
+
+		XLANG_FORCEINLINE bool MessageCache::AddToDepot(void *const block, const u32 poolIndex, const u32 alignmentClass)
+		{
+			Pool &pool(mPools[poolIndex][alignmentClass]);
+			if (pool.Add(block))
+			{
+				return true;
+			}
+
+			// An overflowing pool is too small for the bursts of messages of its size, so grow it.
+			if (Grow(poolIndex, alignmentClass) && pool.Add(block))
+			{
+				return true;
+			}
 
-			// Because the minimum size is four bytes, we subtract one.
-			XLANG_ASSERT(index > 0);
-			return index - 1;
+			++mStats[poolIndex][STAT_OVERFLOWS];
+			return false;
 		}
 
 
@@ -0,0 +1,244 @@
+#ifndef __XLANG_PRIVATE_MESSAGECACHE_PAYLOADCACHE_H
+#define __XLANG_PRIVATE_MESSAGECACHE_PAYLOADCACHE_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/MessageCache/c_MessageCache.h"
+#include "clang/private/MessageCache/c_Pool.h"
+#include "clang/private/Threading/c_Lock.h"
+#include "clang/private/Threading/c_Mutex.h"
+
+#include "clang/c_AllocatorManager.h"
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// A global cache of free shared payload memory blocks.
+		/// Payloads are typically much bigger than the message blocks cached by the MessageCache,
+		/// so their sizes are rounded up to powers of two. Like the MessageCache, each combination of
+		/// size class and alignment class has its own pool of free blocks, so a block of any supported
+		/// alignment is fetched by popping the head of a pool.
+		/// Payloads are allocated and freed far less often than messages, so the pools are simply
+		/// protected by a lock.
+		class PayloadCache
+		{
+		public:
+
+			/// Size in bytes of the smallest size class, as a power of two.
+			static const u32 MIN_BLOCK_SIZE_LOG2 = 6;
+
+			/// Number of size classes, each with a memory block pool per alignment class.
+			/// The number of size classes dictates the maximum block size that can be cached (256KB).
+			static const u32 MAX_POOLS = 13;
+
+			/// Number of alignment classes, shared with the MessageCache.
+			static const u32 NUM_ALIGNMENT_CLASSES = MessageCache::NUM_ALIGNMENT_CLASSES;
+
+			/// Largest number of blocks cached of any one size class, over all its alignment classes.
+			static const u32 MAX_BLOCKS = Pool::DEFAULT_MAX_BLOCKS;
+
+			/// Gets a reference to the single global instance.
+			inline static PayloadCache &Instance();
+
+			/// Default constructor.
+			inline PayloadCache();
+
+			/// Destructor.
+			inline ~PayloadCache();
+
+			/// References the singleton instance.
+			inline void Reference();
+
+			/// Dereferences the singleton instance.
+			/// Any cached memory blocks are freed on last dereference.
+			inline void Dereference();
+
+			/// Returns the size of the memory block allocated to hold a payload of the given size.
+			/// \note Blocks of cacheable sizes are rounded up to the size of their size class.
+			inline static u32 GetBlockSize(const u32 size);
+
+			/// Allocates a memory block of the given size, as returned by GetBlockSize.
+			/// \note Can be called by any thread.
+			inline void *Allocate(const u32 blockSize, const u32 alignment);
+
+			/// Frees a previously allocated memory block.
+			/// \note Can be called by any thread, including after the cache is last dereferenced.
+			inline void Free(void *const block, const u32 blockSize);
+
+		private:
+
+			/// Maps a block size to the index of the pool holding blocks of its size class.
+			inline static u32 MapBlockSizeToPool(const u32 blockSize);
+
+			PayloadCache(const PayloadCache &other);
+			PayloadCache &operator=(const PayloadCache &other);
+
+			static PayloadCache smInstance;			///< Single, static instance of the class.
+
+			Mutex		mMutex;						///< Protects the reference count and the pools.
+			u32			mReferenceCount;			///< Tracks how many clients exist.
+			Pool		mPools[MAX_POOLS][NUM_ALIGNMENT_CLASSES];	///< Memory blocks of different sizes and alignments.
+		};
+
+
+		XLANG_FORCEINLINE PayloadCache &PayloadCache::Instance()
+		{
+			return smInstance;
+		}
+
+
+		XLANG_FORCEINLINE PayloadCache::PayloadCache()
+			: mMutex()
+			, mReferenceCount(0)
+		{
+		}
+
+
+		inline PayloadCache::~PayloadCache()
+		{
+			// Check that the pools were all emptied when the cache became unreferenced.
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+				{
+					XLANG_ASSERT(mPools[index][alignmentClass].Empty());
+				}
+			}
+		}
+
+
+		XLANG_FORCEINLINE void PayloadCache::Reference()
+		{
+			Lock lock(mMutex);
+			++mReferenceCount;
+		}
+
+
+		XLANG_FORCEINLINE void PayloadCache::Dereference()
+		{
+			Lock lock(mMutex);
+			XLANG_ASSERT(mReferenceCount > 0);
+			if (--mReferenceCount == 0)
+			{
+				// Free any remaining blocks in the pools.
+				// Payloads still held by the application are freed directly when they're released.
+				for (u32 index = 0; index < MAX_POOLS; ++index)
+				{
+					for (u32 alignmentClass = 0; alignmentClass < NUM_ALIGNMENT_CLASSES; ++alignmentClass)
+					{
+						mPools[index][alignmentClass].Clear();
+					}
+				}
+			}
+		}
+
+
+		XLANG_FORCEINLINE u32 PayloadCache::GetBlockSize(const u32 size)
+		{
+			u32 blockSize(1 << MIN_BLOCK_SIZE_LOG2);
+			for (u32 index = 0; index < MAX_POOLS; ++index)
+			{
+				if (size <= blockSize)
+				{
+					return blockSize;
+				}
+
+				blockSize <<= 1;
+			}
+
+			// Blocks too big to cache are only rounded up to a multiple of eight bytes.
+			return (size + 7) & ~7;
+		}
+
+
+		XLANG_FORCEINLINE void *PayloadCache::Allocate(const u32 blockSize, const u32 alignment)
+		{
+			XLANG_ASSERT(blockSize);
+			XLANG_ASSERT(alignment);
+			XLANG_ASSERT((alignment & (alignment - 1)) == 0);
+
+			const u32 poolIndex(MapBlockSizeToPool(blockSize));
+			if (poolIndex < MAX_POOLS)
+			{
+				// Blocks needing more than cache line alignment are never found in the cache.
+				const u32 alignmentClass(MessageCache::MapAlignmentToClass(alignment));
+				if (alignmentClass < NUM_ALIGNMENT_CLASSES)
+				{
+					Lock lock(mMutex);
+					if (void *const block = MessageCache::FetchFromPools(mPools[poolIndex], alignmentClass))
+					{
+						return block;
+					}
+				}
+
+				// Cached blocks are aligned to at least the smallest alignment class.
+				const u32 blockAlignment(alignment < MessageCache::MIN_ALIGNMENT ? MessageCache::MIN_ALIGNMENT : alignment);
+				return AllocatorManager::Instance().GetAllocator()->AllocateAligned(blockSize, blockAlignment);
+			}
+
+			// We can't cache blocks this big, so we allocate a new one from the user allocator.
+			return AllocatorManager::Instance().GetAllocator()->AllocateAligned(blockSize, alignment);
+		}
+
+
+		XLANG_FORCEINLINE void PayloadCache::Free(void *const block, const u32 blockSize)
+		{
+			XLANG_ASSERT(block);
+			XLANG_ASSERT(blockSize);
+
+			const u32 poolIndex(MapBlockSizeToPool(blockSize));
+			if (poolIndex < MAX_POOLS)
+			{
+				// Blocks are cached by the alignment of their address, so they satisfy any request they're fetched for.
+				const u32 alignmentClass(MessageCache::GetBlockAlignmentClass(block));
+
+				// Blocks are only cached while the cache is referenced, so they're freed with it.
+				Lock lock(mMutex);
+				if (mReferenceCount != 0)
+				{
+					// Limit the blocks held of each size class, whatever their alignment.
+					u32 numBlocks(0);
+					for (u32 index = 0; index < NUM_ALIGNMENT_CLASSES; ++index)
+					{
+						numBlocks += mPools[poolIndex][index].GetNumBlocks();
+					}
+
+					if (numBlocks < MAX_BLOCKS && mPools[poolIndex][alignmentClass].Add(block))
+					{
+						return;
+					}
+				}
+			}
+
+			// Can't cache this block; return it to the user allocator.
+			AllocatorManager::Instance().GetAllocator()->Free(block);
+		}
+
+
+		XLANG_FORCEINLINE u32 PayloadCache::MapBlockSizeToPool(const u32 blockSize)
+		{
+			u32 poolIndex(0);
+			u32 classSize(1 << MIN_BLOCK_SIZE_LOG2);
+
+			while (poolIndex < MAX_POOLS && classSize != blockSize)
+			{
+				classSize <<= 1;
+				++poolIndex;
+			}
+
+			return poolIndex;
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_MESSAGECACHE_PAYLOADCACHE_H
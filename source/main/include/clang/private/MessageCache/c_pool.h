@@ -23,9 +23,22 @@ namespace clang
 		{
 		public:
 
+			/// Default maximum number of memory blocks stored in a pool.
+			static const u32 DEFAULT_MAX_BLOCKS = 16;
+
 			/// Constructor.
 			inline Pool();
 
+			/// Gets the number of memory blocks currently in the pool.
+			inline u32 GetNumBlocks() const;
+
+			/// Gets the maximum number of memory blocks the pool can hold.
+			inline u32 GetMaxBlocks() const;
+
+			/// Sets the maximum number of memory blocks the pool can hold.
+			/// \note Blocks already in the pool are kept, even if there are more of them than the new maximum.
+			inline void SetMaxBlocks(const u32 maxBlocks);
+
 			/// Returns true if the pool contains no memory blocks.
 			inline bool Empty() const;
 
@@ -35,10 +48,6 @@ namespace clang
 			/// Adds a memory block to the pool.
 			inline bool Add(void *memory);
 
-			/// Retreives a memory block from the pool with the given alignment.
-			/// \return Zero if no suitable blocks in pool.
-			inline void *FetchAligned(const u32 alignment);
-
 			/// Retreives a memory block from the pool with any alignment.
 			/// \return Zero if no blocks in pool.
 			inline void *Fetch();
@@ -56,17 +65,36 @@ namespace clang
 				Node *mNext;                        ///< Pointer to next node in a list.
 			};
 
-			static const u32 MAX_BLOCKS = 16;  ///< Maximum number of memory blocks stored per pool.
-
 			Node mHead;                             ///< Dummy node at head of a linked list of nodes in the pool.
 			u32 mBlockCount;                   ///< Number of blocks currently cached in the pool.
+			u32 mMaxBlocks;                    ///< Maximum number of memory blocks stored in the pool.
 		};
 
 
 		XLANG_FORCEINLINE Pool::Pool() 
 			: mHead()
 			, mBlockCount(0)
+			, mMaxBlocks(DEFAULT_MAX_BLOCKS)
+		{
+		}
+
+
+		XLANG_FORCEINLINE u32 Pool::GetNumBlocks() const
+		{
+			return mBlockCount;
+		}
+
+
+		XLANG_FORCEINLINE u32 Pool::GetMaxBlocks() const
+		{
+			return mMaxBlocks;
+		}
+
+
+		XLANG_FORCEINLINE void Pool::SetMaxBlocks(const u32 maxBlocks)
 		{
+			XLANG_ASSERT(maxBlocks > 0);
+			mMaxBlocks = maxBlocks;
 		}
 
 
@@ -101,7 +129,7 @@ namespace clang
 			Node *const node(reinterpret_cast<Node *>(memory));
 
 			// Below maximum block count limit?
-			if (mBlockCount < MAX_BLOCKS)
+			if (mBlockCount < mMaxBlocks)
 			{
 				node->mNext = mHead.mNext;
 				mHead.mNext = node;
@@ -113,36 +141,6 @@ namespace clang
 		}
 
 
-		XLANG_FORCEINLINE void *Pool::FetchAligned(const u32 alignment)
-		{
-			Node *previous(&mHead);
-			const u32 alignmentMask(alignment - 1);
-
-			// Search the block list.
-			Node *node(mHead.mNext);
-			while (node)
-			{
-				// Prefetch.
-				Node *const next(node->mNext);
-
-				// This is XLANG_ALIGNED with the alignment mask calculated outside the loop.
-				if ((reinterpret_cast<uintptr_t>(node) & alignmentMask) == 0)
-				{
-					// Remove from list and return as block.
-					previous->mNext = next;
-					--mBlockCount;
-					return reinterpret_cast<void *>(node);
-				}
-
-				previous = node;
-				node = next;
-			}
-
-			// Zero result indicates no correctly aligned block available.
-			return 0;
-		}
-
-
 		XLANG_FORCEINLINE void *Pool::Fetch()
 		{
 			// Grab first block in the list if the list isn't empty.
@@ -0,0 +1,142 @@
+#ifndef __XLANG_PRIVATE_MESSAGES_BROADCASTMESSAGE_H
+#define __XLANG_PRIVATE_MESSAGES_BROADCASTMESSAGE_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/MessageCache/c_MessageCache.h"
+#include "clang/private/Messages/c_Message.h"
+#include "clang/private/Messages/c_MessageDescriptor.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Message sent to one of many recipients of a broadcast, sharing its value with the others.
+		/// All the messages of a broadcast are allocated in a single memory block, laid out as a single
+		/// copy of the value, followed by the number of messages and the number still unreleased,
+		/// followed by the messages. Each message is preceded by a pointer to the shared value, where
+		/// a Message of the same value type has its value, so it reads the value through its descriptor
+		/// and is handled exactly like a Message of the same value type.
+		template <class ValueType>
+		class BroadcastMessage : public Message<ValueType>
+		{
+		public:
+
+			typedef Message<ValueType> BaseType;
+			typedef BroadcastMessage<ValueType> ThisType;
+
+			/// Returns the offset from the start of the block to the counts of messages.
+			XLANG_FORCEINLINE static u32 GetCountOffset()
+			{
+				return BaseType::GetValueSize();
+			}
+
+			/// Returns the spacing in bytes of the messages within the block.
+			XLANG_FORCEINLINE static u32 GetMessageStride()
+			{
+				const u32 alignment(BaseType::GetAlignment());
+				return ((u32)(sizeof(void *) + sizeof(ThisType)) + (alignment - 1)) & ~(alignment - 1);
+			}
+
+			/// Returns the memory block size required to initialize a broadcast to the given number of recipients.
+			XLANG_FORCEINLINE static u32 GetSize(const u32 count)
+			{
+				return GetFirstMessageOffset() - (u32)sizeof(void *) + count * GetMessageStride();
+			}
+
+			/// Initializes the messages of a broadcast to the given number of recipients in the provided
+			/// memory block, with a single copy of the value. The block is allocated by the caller, and
+			/// freed by the last of the messages to be released.
+			/// \return The first message, which is followed by the others at intervals of GetMessageStride.
+			XLANG_FORCEINLINE static ThisType *Initialize(void *const block, const u32 count, const ValueType &value, const Address &from)
+			{
+				XLANG_ASSERT(block);
+				XLANG_ASSERT(count > 0);
+
+				// The value is first, and is copied only once.
+				void *const pValue = new (block) ValueType(value);
+
+				u32 *const counts(reinterpret_cast<u32 *>(reinterpret_cast<xbyte *>(block) + GetCountOffset()));
+				counts[0] = count;
+				counts[1] = count;
+
+				xbyte *const first(reinterpret_cast<xbyte *>(block) + GetFirstMessageOffset());
+				for (u32 index = 0; index < count; ++index)
+				{
+					xbyte *const message(first + index * GetMessageStride());
+					*reinterpret_cast<void **>(message - sizeof(void *)) = pValue;
+					new (message) ThisType(from);
+				}
+
+				return reinterpret_cast<ThisType *>(first);
+			}
+
+			XCORE_CLASS_PLACEMENT_NEW_DELETE
+		private:
+
+			/// Returns the offset from the start of the block to the first message.
+			XLANG_FORCEINLINE static u32 GetFirstMessageOffset()
+			{
+				const u32 alignment(BaseType::GetAlignment());
+				const u32 countsSize((2 * (u32)sizeof(u32) + (alignment - 1)) & ~(alignment - 1));
+				return GetCountOffset() + countsSize + (u32)sizeof(void *);
+			}
+
+			/// Releases a message of a broadcast. The last message to be released destructs the
+			/// shared value and frees the block itself, since only it knows the size of the block.
+			/// \return False, since the block is never freed by the caller.
+			inline static bool ReleaseShared(IMessage *const message)
+			{
+				xbyte *const block(reinterpret_cast<xbyte *>(message->GetBlock()));
+				u32 *const counts(reinterpret_cast<u32 *>(block + GetCountOffset()));
+
+				// Recipients release their messages concurrently, in any order.
+				if (Atomic::Decrement(reinterpret_cast<volatile u32 *>(counts + 1)) != 0)
+				{
+					return false;
+				}
+
+				if (!HasTrivialDestructor<ValueType>::VALUE)
+				{
+					reinterpret_cast<ValueType *>(block)->~ValueType();
+				}
+
+				MessageCache::Instance().Free(block, GetSize(counts[0]));
+				return false;
+			}
+
+			/// Private constructor.
+			XLANG_FORCEINLINE explicit BroadcastMessage(const Address &from)
+				: BaseType(from, &smDescriptor)
+			{
+			}
+
+			BroadcastMessage(const BroadcastMessage &other);
+			BroadcastMessage &operator=(const BroadcastMessage &other);
+
+			static const MessageDescriptor smDescriptor;		///< Descriptor shared by all broadcast messages of this type.
+		};
+
+
+		// Broadcast messages don't know the size of their block, and free it themselves.
+		template <class ValueType>
+		const MessageDescriptor BroadcastMessage<ValueType>::smDescriptor =
+		{
+			&BroadcastMessage<ValueType>::ReleaseShared,
+			Message<ValueType>::VALUE_SIZE,
+			0
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_MESSAGES_BROADCASTMESSAGE_H
@@ -6,6 +6,9 @@
 #endif
 
 #include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Messages/c_MessageDescriptor.h"
+#include "clang/private/Threading/c_Atomic.h"
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
 
@@ -13,109 +16,117 @@ namespace clang
 {
 	namespace detail
 	{
-		class type2intgeneric
-		{
-		protected:
-			static const ncore::s32 next()
-			{
-				static ncore::s32 id = 1;
-				return id++;
-			}
-		};
-
-		template <typename T>
-		struct type2int : public type2intgeneric
-		{
-			static const ncore::s32 value() 
-			{
-				static const ncore::s32 id = next();
-				return id;
-			}
-		};
-
-		/// Interface describing the generic API of the message class template.
+		/// Header of a message, describing the generic API of the message class template.
+		/// Messages are laid out in their memory blocks immediately after their values.
 		class IMessage
 		{
 		public:
 
 			/// Sets the pointer to the next message in a queue of messages.
+			/// \note The link is accessed atomically because actor mailboxes are written
+			/// by sending threads while the receiving worker thread reads them.
 			XLANG_FORCEINLINE void SetNext(IMessage *const next)
 			{
-				mNext = next;
+				Atomic::Store(&mNext, next);
 			}
 
 			/// Gets the pointer to the next message in a queue of messages.
 			XLANG_FORCEINLINE IMessage *GetNext() const
 			{
-				return mNext;
+				return Atomic::Load(&mNext);
 			}
 
 			/// Gets the address from which the message was sent.
 			XLANG_FORCEINLINE Address From() const
 			{
-				return mFrom;
+				return Address(mFromSequence, mFromIndex);
 			}
 
 			/// Returns the memory block in which this message was allocated.
+			/// The message value is at the start of the block.
 			XLANG_FORCEINLINE void *GetBlock() const
 			{
-				XLANG_ASSERT(mBlock);
-				return mBlock;
+				return const_cast<void *>(GetMessageData());
 			}
 
 			/// Returns the size in bytes of the memory block in which this message was allocated.
+			/// \note Messages sharing their value, and their block, with other messages don't know its size.
 			XLANG_FORCEINLINE u32 GetBlockSize() const
 			{
-				XLANG_ASSERT(mBlockSize);
-				return mBlockSize;
+				XLANG_ASSERT(mDescriptor->mBlockSize);
+				return mDescriptor->mBlockSize;
 			}
 
 			/// Returns the message value as blind data.
 			XLANG_FORCEINLINE const void *GetMessageData() const
 			{
-				XLANG_ASSERT(mBlock);
-				return mBlock;
+				const xbyte *const header(reinterpret_cast<const xbyte *>(this));
+
+				// Messages that share their value are preceded by a pointer to it instead of by the value itself.
+				if (mDescriptor->mBlockSize == 0)
+				{
+					return *reinterpret_cast<const void *const *>(header - sizeof(void *));
+				}
+
+				return header - mDescriptor->mValueSize;
+			}
+
+			/// Returns the id of the message type.
+			/// This uniquely identifies the type of the message value.
+			XLANG_FORCEINLINE u32 TypeId() const
+			{
+				return mTypeId;
 			}
 
 			/// Returns the size in bytes of the message data.
-			virtual u32 GetMessageValueSize() const = 0;
+			XLANG_FORCEINLINE u32 GetMessageValueSize() const
+			{
+				return mDescriptor->mValueSize;
+			}
 
-			/// Returns the name of the message type.
-			/// This uniquely identifies the type of the message value.
-			/// \note Unless explicitly specified to avoid C++ RTTI, message names are null.
-			virtual int TypeId() const = 0;
+			/// Returns the static descriptor of the message.
+			XLANG_FORCEINLINE const MessageDescriptor &GetDescriptor() const
+			{
+				return *mDescriptor;
+			}
 
 			/// Allows the message instance to destruct its constructed value object before being freed.
-			virtual void Release() = 0;
+			/// \return True if the memory block containing the message can be freed, or false if
+			/// it's shared with other messages that are still in use.
+			/// \note Values with trivial destructors are released without an indirect call.
+			XLANG_FORCEINLINE bool Release()
+			{
+				const MessageDescriptor::ReleaseFunction release(mDescriptor->mRelease);
+				return (release == 0 || release(this));
+			}
 
 		protected:
 
 			/// Constructs an IMessage.
 			/// \param from The address from which the message was sent.
-			/// \param block The memory block containing the message.
-			/// \param blockSize The size of the memory block containing the message.
-			/// \param typeName String identifier uniquely identifying the type of the message value.
-			XLANG_FORCEINLINE IMessage(const Address &from, void *const block, const u32 blockSize) 
+			/// \param typeId Id uniquely identifying the type of the message value.
+			/// \param descriptor The static descriptor of the message.
+			XLANG_FORCEINLINE IMessage(const Address &from, const u32 typeId, const MessageDescriptor *const descriptor)
 				: mNext(0)
-				, mFrom(from)
-				, mBlock(block)
-				, mBlockSize(blockSize)
-			{
-			}
-
-			/// Virtual destructor.
-			XLANG_FORCEINLINE virtual ~IMessage()
+				, mFromSequence(from.mSequence)
+				, mFromIndex(from.mIndex)
+				, mTypeId(typeId)
+				, mDescriptor(descriptor)
 			{
+				XLANG_ASSERT(descriptor);
 			}
 
 		private:
 							IMessage(const IMessage &other);
 							IMessage &operator=(const IMessage &other);
 
-			IMessage		*mNext;			///< Pointer to the next message in a message queue.
-			const Address	mFrom;			///< The address from which the message was sent.
-			void *const		mBlock;			///< Pointer to the memory block containing the message.
-			const u32		mBlockSize;		///< Total size of the message memory block in bytes.
+			// The from address is stored as its fields, so that the type id fills the space otherwise
+			// left as padding at the end of the address. The whole header is 32 bytes on 64-bit platforms.
+			IMessage *volatile				mNext;				///< Pointer to the next message in a message queue.
+			const u64						mFromSequence;		///< Sequence number of the address from which the message was sent.
+			const u32						mFromIndex;			///< Index of the address from which the message was sent.
+			const u32						mTypeId;			///< Id of the type of the message value, stored to avoid a virtual call.
+			const MessageDescriptor *const	mDescriptor;		///< Static descriptor of the message, in place of a table of virtual functions.
 		};
 
 
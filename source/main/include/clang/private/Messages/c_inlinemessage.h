@@ -0,0 +1,200 @@
+#ifndef __XLANG_PRIVATE_MESSAGES_INLINEMESSAGE_H
+#define __XLANG_PRIVATE_MESSAGES_INLINEMESSAGE_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "cbase/c_allocator.h"
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/MessageCache/c_MessageCache.h"
+#include "clang/private/Messages/c_IMessage.h"
+#include "clang/private/Messages/c_Message.h"
+#include "clang/private/Messages/c_MessageAlignment.h"
+#include "clang/private/Messages/c_MessageDescriptor.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Descriptor of a message held in a slot of an actor's inline mailbox.
+		/// Extends the descriptor of the message with what's needed to allocate an ordinary
+		/// message of the same value type instead, when there's no free slot.
+		struct InlineMessageDescriptor
+		{
+			MessageDescriptor			mDescriptor;			///< Descriptor of the message in its slot. Must be first.
+			const MessageDescriptor		*mHeapDescriptor;		///< Descriptor of an ordinary message of the same value type.
+			u32							mCopySize;				///< Size in bytes of the value, which is copied as raw bytes.
+			u32							mHeapAlignment;			///< Alignment of the memory block of an ordinary message.
+		};
+
+
+		/// Message whose trivially copyable value is copied as raw bytes, either into a slot of an
+		/// actor's inline mailbox or into a block allocated from the message cache.
+		/// Each slot is a cache line holding a state word, the index of the slot, the value and the
+		/// message header. Within the slot the message follows its value, just like an ordinary message,
+		/// so it's handled exactly like a Message of the same value type.
+		/// The slots of a mailbox are allocated together, after a cache line holding a reference count.
+		/// The mailbox holds one reference, and each forwarded message another, so that messages
+		/// forwarded elsewhere can outlive the actor that received them without being copied.
+		class InlineMessage : public IMessage
+		{
+		public:
+
+			/// Size and alignment of a mailbox slot.
+			static const u32 SLOT_SIZE = XLANG_CACHELINE_SIZE;
+
+			/// Offset of the value within a slot, after the state word and the index.
+			static const u32 VALUE_OFFSET = 8;
+
+			/// Largest value, including padding, that fits in a slot alongside the message header.
+			static const u32 MAX_VALUE_SIZE = SLOT_SIZE - VALUE_OFFSET - (u32)sizeof(IMessage);
+
+			/// States of a mailbox slot, held in its state word.
+			enum
+			{
+				SLOT_FREE = 0,										///< Available to senders.
+				SLOT_USED = 1,										///< Holds a message that hasn't been destroyed yet.
+				SLOT_FORWARDED = 2									///< As used, but the message holds a reference to the slots.
+			};
+
+			/// Allocates the given number of free slots, with a single reference held by the caller.
+			/// \return A pointer to the first slot, or null if out of memory.
+			static xbyte *CreateSlots(const u32 numSlots);
+
+			/// Releases a reference to a set of slots, freeing them if it's the last.
+			static void ReleaseSlots(xbyte *const slots);
+
+			/// Copies a value into a mailbox slot, claimed by the caller, and constructs a message after it.
+			XLANG_FORCEINLINE static IMessage *InitializeSlot(
+				void *const slot,
+				const void *const value,
+				const InlineMessageDescriptor &descriptor,
+				const u32 typeId,
+				const Address &from)
+			{
+				XLANG_ASSERT(slot);
+				XLANG_ASSERT(Atomic::Load(reinterpret_cast<volatile u32 *>(slot)) == SLOT_USED);
+
+				xbyte *const pValue(reinterpret_cast<xbyte *>(slot) + VALUE_OFFSET);
+				CopyValue(pValue, value, descriptor.mCopySize);
+
+				return new (pValue + descriptor.mDescriptor.mValueSize) InlineMessage(from, typeId, &descriptor.mDescriptor);
+			}
+
+			/// Allocates an ordinary message from the message cache, and copies a value into it.
+			/// Used for messages that can't be held in a slot.
+			/// \return Null if out of memory.
+			XLANG_FORCEINLINE static IMessage *Create(
+				const void *const value,
+				const InlineMessageDescriptor &descriptor,
+				const u32 typeId,
+				const Address &from)
+			{
+				const MessageDescriptor *const heapDescriptor(descriptor.mHeapDescriptor);
+
+				void *const block = MessageCache::Instance().Allocate(heapDescriptor->mBlockSize, descriptor.mHeapAlignment);
+				if (block == 0)
+				{
+					return 0;
+				}
+
+				xbyte *const pValue(reinterpret_cast<xbyte *>(block));
+				CopyValue(pValue, value, descriptor.mCopySize);
+
+				return new (pValue + heapDescriptor->mValueSize) InlineMessage(from, typeId, heapDescriptor);
+			}
+
+			/// Returns true if the message is held in a mailbox slot.
+			XLANG_FORCEINLINE static bool IsInline(const IMessage *const message)
+			{
+				return (message->GetDescriptor().mRelease == &ReleaseSlot);
+			}
+
+			/// Lets a message held in a mailbox slot outlive the mailbox, so it can be forwarded.
+			/// \note Must be called by the thread holding the message.
+			static void Detach(IMessage *const message);
+
+			/// Frees the mailbox slot holding a message, once the message has been handled.
+			/// The value is trivially destructible, so there's nothing to destruct.
+			/// \return False, since the slot is never freed to the message cache.
+			static bool ReleaseSlot(IMessage *const message);
+
+			XCORE_CLASS_PLACEMENT_NEW_DELETE
+		private:
+
+			/// Private constructor.
+			XLANG_FORCEINLINE InlineMessage(const Address &from, const u32 typeId, const MessageDescriptor *const descriptor)
+				: IMessage(from, typeId, descriptor)
+			{
+			}
+
+			InlineMessage(const InlineMessage &other);
+			InlineMessage &operator=(const InlineMessage &other);
+
+			/// Copies a value as raw bytes. Values are small, so a simple loop is fastest.
+			XLANG_FORCEINLINE static void CopyValue(xbyte *const destination, const void *const source, const u32 size)
+			{
+				const xbyte *const bytes(reinterpret_cast<const xbyte *>(source));
+				for (u32 index = 0; index < size; ++index)
+				{
+					destination[index] = bytes[index];
+				}
+			}
+		};
+
+
+		/// Traits template indicating whether messages of a value type can be held in a slot of an
+		/// actor's inline mailbox, and providing their descriptor.
+		/// Values qualify if they're trivially copyable and destructible, small enough to fit in a slot,
+		/// and need no more alignment than the slot provides.
+		template <class ValueType>
+		struct InlineMessageTraits
+		{
+			/// Size of the value, padded so that the message following it is aligned.
+			static const u32 VALUE_SIZE = ((u32)sizeof(ValueType) + 7) & ~7u;
+
+			/// Indicates whether messages of the value type are held inline.
+			static const bool IS_INLINE =
+				XLANG_INLINE_MAILBOX_SLOTS != 0 &&
+				HasTrivialCopy<ValueType>::VALUE &&
+				HasTrivialDestructor<ValueType>::VALUE &&
+				MessageAlignment<ValueType>::ALIGNMENT <= InlineMessage::VALUE_OFFSET &&
+				VALUE_SIZE <= InlineMessage::MAX_VALUE_SIZE;
+
+			static const InlineMessageDescriptor smDescriptor;		///< Descriptor shared by all inline messages of this type.
+		};
+
+
+		template <class ValueType>
+		const u32 InlineMessageTraits<ValueType>::VALUE_SIZE;
+
+		template <class ValueType>
+		const bool InlineMessageTraits<ValueType>::IS_INLINE;
+
+		// Messages that spill out of the mailbox are ordinary messages, so refer to the ordinary descriptor,
+		// which lets them take the fast path in Message::Value.
+		template <class ValueType>
+		const InlineMessageDescriptor InlineMessageTraits<ValueType>::smDescriptor =
+		{
+			{
+				&InlineMessage::ReleaseSlot,
+				InlineMessageTraits<ValueType>::VALUE_SIZE,
+				InlineMessage::SLOT_SIZE
+			},
+			&Message<ValueType>::smDescriptor,
+			(u32)sizeof(ValueType),
+			Message<ValueType>::ALIGNMENT
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_MESSAGES_INLINEMESSAGE_H
@@ -8,9 +8,11 @@
 #include "cbase/c_allocator.h"
 
 #include "clang/private/c_BasicTypes.h"
+#include "clang/private/c_Move.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Messages/c_IMessage.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageDescriptor.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 #include "clang/private/Messages/c_MessageAlignment.h"
 
 #include "clang/c_AllocatorManager.h"
@@ -20,6 +22,8 @@ namespace clang
 {
 	namespace detail
 	{
+		template <class ValueType>
+		struct InlineMessageTraits;
 
 		/// Message class, used for sending data between actors.
 		template <class ValueType>
@@ -29,29 +33,26 @@ namespace clang
 
 			typedef Message<ValueType> ThisType;
 
-			/// Virtual destructor.
-			XLANG_FORCEINLINE virtual ~Message()
-			{
-			}
+			/// Alignment of the value, and of the memory block containing the message.
+			static const u32 ALIGNMENT = MessageAlignment<ValueType>::ALIGNMENT;
+
+			/// Size of the value, padded so that the message following it is aligned.
+			/// Empty structs passed as values have a size of one byte, which is rounded up like any other.
+			static const u32 VALUE_SIZE = ((u32)sizeof(ValueType) + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
+
+			/// Size of the message, padded to the alignment. Messages add nothing to their header.
+			static const u32 MESSAGE_SIZE = ((u32)sizeof(IMessage) + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
 
 			/// Returns the memory block size required to initialize a message of this type.
 			XLANG_FORCEINLINE static u32 GetMessageSize()
 			{
-				const u32 alignment(GetAlignment());
-				return ((u32)sizeof(ThisType) + (alignment - 1)) & ~(alignment - 1);
+				return MESSAGE_SIZE;
 			}
 
 			/// Returns the memory block size required to initialize a message of this type.
 			XLANG_FORCEINLINE static u32 GetValueSize() 
 			{
-				const u32 alignment(GetAlignment());
-
-				// Empty structs passed as values have a size of one byte, which we don't like.
-				// We expect every allocation to be a multiple of 8 bytes, so we round up.
-				u32 valueSize(sizeof(ValueType));
-				valueSize += (u32)(valueSize == 0);
-				valueSize = (valueSize + (alignment - 1)) & ~(alignment - 1);
-				return valueSize;
+				return VALUE_SIZE;
 			}
 
 			/// Returns the memory block size required to initialize a message of this type.
@@ -67,7 +68,7 @@ namespace clang
 			/// Returns the memory block alignment required to initialize a message of this type.
 			XLANG_FORCEINLINE static u32 GetAlignment()
 			{
-				return MessageAlignment<ValueType>::ALIGNMENT;
+				return ALIGNMENT;
 			}
 
 			/// Initializes a message of this type in the provided memory block.
@@ -83,52 +84,100 @@ namespace clang
 
 				// Allocate the message object immediately after the value, passing it the value's address.
 				void *const pObject(reinterpret_cast<void *>((xbyte*)pValue + GetValueSize()));
-				return new (pObject) ThisType(pValue, from);
+				return new (pObject) ThisType(from);
 			}
 
-			/// Returns the name of the message type.
-			/// This uniquely identifies the type of the message value.
-			virtual int TypeId() const
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Initializes a message of this type in the provided memory block, constructing its
+			/// value in place from the given constructor arguments.
+			/// The block is allocated and freed by the caller.
+			/// \note Passing a moved value as the only argument moves it into the message.
+			template <class... ArgTypes>
+			XLANG_FORCEINLINE static ThisType *Emplace(void *const block, const Address &from, ArgTypes &&... args)
 			{
-				return type2int<ValueType>::value();
+				XLANG_ASSERT(block);
+
+				// Construct the value directly in the block, rather than copying one built elsewhere.
+				ValueType *const pValue = new (block) ValueType(Forward<ArgTypes>(args)...);
+
+				// Allocate the message object immediately after the value, passing it the value's address.
+				void *const pObject(reinterpret_cast<void *>((xbyte*)pValue + GetValueSize()));
+				return new (pObject) ThisType(from);
 			}
 
-			/// Allows the message instance to destruct its constructed value object before being freed.
-			virtual void Release()
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Destructs the value of a message of this type before it's freed.
+			/// Only called for value types with non-trivial destructors.
+			inline static bool ReleaseValue(IMessage *const message)
 			{
-				// The referenced block owned by this message is blind data, but we know it holds
+				// The block owned by this message is blind data, but we know it holds
 				// an instance of the value type, that needs to be explicitly destructed.
 				// We have to call the destructor manually because we constructed the object in-place.
-				Value().~ValueType();
-			}
-
-			/// Returns the size in bytes of the message value.
-			virtual u32 GetMessageValueSize() const
-			{
-				// Calculate the size of the message value itself. There's no padding between the
-				// message value block and the Message object that follows it.
-				return GetBlockSize() - GetMessageSize();
+				static_cast<ThisType *>(message)->Value().~ValueType();
+				return true;
 			}
 
 			/// Gets the value carried by the message.
 			XLANG_FORCEINLINE const ValueType &Value() const
 			{
-				// The value is stored at the start of the memory block.
-				return *reinterpret_cast<const ValueType *>(GetBlock());
+				// Messages of exactly this type are laid out immediately after their values.
+				// Otherwise the value is shared, and the message is preceded by a pointer to it.
+				if (&GetDescriptor() == &smDescriptor)
+				{
+					return *reinterpret_cast<const ValueType *>(reinterpret_cast<const xbyte *>(this) - VALUE_SIZE);
+				}
+
+				return *reinterpret_cast<const ValueType *>(GetMessageData());
 			}
 
 			XCORE_CLASS_PLACEMENT_NEW_DELETE
+		protected:
+
+			/// Constructor for derived message classes that share their value with other messages.
+			XLANG_FORCEINLINE Message(const Address &from, const MessageDescriptor *const descriptor)
+				: IMessage(from, MessageTypeId<ValueType>::Value(), descriptor)
+			{
+				MessageTypeIdCheck<ValueType>::Check();
+			}
+
 		private:
 
+			// Messages copied out of inline mailbox slots are given the descriptor of this type.
+			friend struct InlineMessageTraits<ValueType>;
+
 			/// Private constructor.
-			XLANG_FORCEINLINE Message(void *const block, const Address &from)
-				: IMessage(from, block, ThisType::GetSize())
+			XLANG_FORCEINLINE explicit Message(const Address &from)
+				: IMessage(from, MessageTypeId<ValueType>::Value(), &smDescriptor)
 			{
-				XLANG_ASSERT(block);
+				MessageTypeIdCheck<ValueType>::Check();
 			}
 
 			Message(const Message &other);
 			Message &operator=(const Message &other);
+
+			static const MessageDescriptor smDescriptor;		///< Descriptor shared by all messages of this type.
+		};
+
+
+		template <class ValueType>
+		const u32 Message<ValueType>::ALIGNMENT;
+
+		template <class ValueType>
+		const u32 Message<ValueType>::VALUE_SIZE;
+
+		template <class ValueType>
+		const u32 Message<ValueType>::MESSAGE_SIZE;
+
+		// The descriptor is a constant expression, so it's initialized before any code runs.
+		// Values with trivial destructors need no release function, which saves an indirect call.
+		template <class ValueType>
+		const MessageDescriptor Message<ValueType>::smDescriptor =
+		{
+			HasTrivialDestructor<ValueType>::VALUE ? 0 : &Message<ValueType>::ReleaseValue,
+			Message<ValueType>::VALUE_SIZE,
+			Message<ValueType>::VALUE_SIZE + Message<ValueType>::MESSAGE_SIZE
 		};
 
 
@@ -8,7 +8,7 @@
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Messages/c_IMessage.h"
 #include "clang/private/Messages/c_Message.h"
-#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Defines.h"
 
@@ -19,25 +19,13 @@ namespace clang
 	{
 		/// \brief Dynamic cast utility for message pointers.
 		/// A cast utility that can be used to dynamically cast a message of unknown type
-		/// to a message of a known type at runtime, using stored runtime type information.
+		/// to a message of a known type at runtime, using the type id stored in the message.
 		/// If the unknown message is of the target type then the cast succeeds and a pointer
 		/// to the typecast message is returned, otherwise a null pointer is returned.
 		///
-		/// This utility roughly mimics the functionality of dynamic_cast, but includes
-		/// two alternate implementations: one that uses dynamic_cast directly and another
-		/// that rolls its own runtime type information only for message classes. The
-		/// advantage of the second implementation is that the storage overhead of the extra
-		/// runtime type information is not imposed on \em all classes, as with the C++ RTTI.
-		/// If the second implementation is used consistently then dynamic_cast is not
-		/// called at all, using a partial template specialization trick, and the C++ RTTI
-		/// functionality can be turned off (usually by means of a compiler option).
-		///
-		/// \note Partial template specialization is used here as a device to avoid
-		/// introducing a hardcoded dependency on C++ RTTI. The dependency can be avoided
-		/// by defining non-zero type IDs for all message types used in the application.
-		///
-		/// \tparam HAS_TYPE_ID A flag indicating whether the message type has a name.
-		template <bool HAS_TYPE_ID>
+		/// This utility roughly mimics the functionality of dynamic_cast, but every message
+		/// type has a non-zero id, whether explicit or generated, so it never
+		/// needs the C++ RTTI, which can be turned off (usually by means of a compiler option).
 		class MessageCast
 		{
 		public:
@@ -52,11 +40,11 @@ namespace clang
 			{
 				XLANG_ASSERT(message);
 
-				// If explicit type names are used then they must be defined for all message types.
-				XLANG_ASSERT_MSG(message->TypeId()>=0, "Message type has null type name");
+				// Every message type has a non-zero id, whether explicit or generated.
+				XLANG_ASSERT_MSG(message->TypeId() != 0, "Message type has null type id");
 
-				// Check the type of the message using the type name it carries, which was set on creation.
-				if (message->TypeId() == type2int<ValueType>::value())
+				// Check the type of the message using the type id it carries, which was set on creation.
+				if (message->TypeId() == MessageTypeId<ValueType>::Value())
 				{
 					// Hard-convert the given message to the indicated type.
 					return reinterpret_cast<const Message<ValueType> *>(message);
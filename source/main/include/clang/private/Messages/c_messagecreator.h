@@ -7,6 +7,7 @@
 
 #include "clang/private/c_basictypes.h"
 #include "clang/private/MessageCache/c_messagecache.h"
+#include "clang/private/Messages/c_broadcastmessage.h"
 #include "clang/private/Messages/c_imessage.h"
 #include "clang/private/Messages/c_message.h"
 
@@ -22,10 +23,33 @@ namespace clang
 		{
 		public:
 
+			/// Maximum number of messages created by a single call to \ref CreateBatch.
+			static const u32 MAX_BATCH_SIZE = 64;
+
 			/// Allocates and constructs a message with the given value and from address.
 			template <class ValueType>
 			inline static Message<ValueType> *Create(const ValueType &value, const Address &from);
 
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Allocates a message and constructs its value in place from the given constructor arguments.
+			template <class ValueType, class... ArgTypes>
+			inline static Message<ValueType> *Emplace(const Address &from, ArgTypes &&... args);
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Allocates and constructs the messages of a broadcast to the given number of recipients,
+			/// sharing a single copy of the given value.
+			/// \return The first message, which is followed by the others at intervals of the message stride.
+			template <class ValueType>
+			inline static BroadcastMessage<ValueType> *CreateBroadcast(const ValueType &value, const Address &from, const u32 count);
+
+			/// Allocates and constructs a message for each of an array of values, allocating
+			/// all of their blocks from the message cache at once.
+			/// \return The number of messages created, which is less than requested if out of memory.
+			template <class ValueType>
+			inline static u32 CreateBatch(const ValueType *const values, const u32 count, const Address &from, IMessage **const messages);
+
 			/// Destructs and frees a message of unknown type referenced by an interface pointer.
 			inline static void Destroy(IMessage *const message);
 		};
@@ -41,8 +65,8 @@ namespace clang
 			const u32 blockAlignment(MessageType::GetAlignment());
 
 			// Allocate a message. It'll be deleted by the actor after it's been handled.
-			// We allocate a block from the global free list for caching of common allocations.
-			// The free list is thread-safe so we don't need to lock it ourselves.
+			// We allocate a block from the global message cache for caching of common allocations.
+			// The cache is thread-safe so we don't need to lock it ourselves.
 			void *const block = MessageCache::Instance().Allocate(blockSize, blockAlignment);
 			if (block)
 			{
@@ -53,13 +77,81 @@ namespace clang
 		}
 
 
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		template <class ValueType, class... ArgTypes>
+		XLANG_FORCEINLINE Message<ValueType> *MessageCreator::Emplace(const Address &from, ArgTypes &&... args)
+		{
+			typedef Message<ValueType> MessageType;
+
+			const u32 blockSize(MessageType::GetSize());
+			const u32 blockAlignment(MessageType::GetAlignment());
+
+			// Allocate the block as for a copied value, but construct the value straight into it.
+			void *const block = MessageCache::Instance().Allocate(blockSize, blockAlignment);
+			if (block)
+			{
+				return MessageType::Emplace(block, from, Forward<ArgTypes>(args)...);
+			}
+
+			return 0;
+		}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+		template <class ValueType>
+		XLANG_FORCEINLINE BroadcastMessage<ValueType> *MessageCreator::CreateBroadcast(const ValueType &value, const Address &from, const u32 count)
+		{
+			typedef BroadcastMessage<ValueType> MessageType;
+
+			const u32 blockSize(MessageType::GetSize(count));
+			const u32 blockAlignment(MessageType::GetAlignment());
+
+			// The block is freed when the last of the messages in it is destroyed.
+			void *const block = MessageCache::Instance().Allocate(blockSize, blockAlignment);
+			if (block)
+			{
+				return MessageType::Initialize(block, count, value, from);
+			}
+
+			return 0;
+		}
+
+
+		template <class ValueType>
+		XLANG_FORCEINLINE u32 MessageCreator::CreateBatch(const ValueType *const values, const u32 count, const Address &from, IMessage **const messages)
+		{
+			typedef Message<ValueType> MessageType;
+
+			XLANG_ASSERT(count <= MAX_BATCH_SIZE);
+
+			const u32 blockSize(MessageType::GetSize());
+			const u32 blockAlignment(MessageType::GetAlignment());
+
+			// Allocate all the blocks in one go, so the cache isn't locked once per message.
+			void *blocks[MAX_BATCH_SIZE];
+			const u32 numBlocks(MessageCache::Instance().AllocateBatch(blockSize, blockAlignment, blocks, count));
+
+			for (u32 index = 0; index < numBlocks; ++index)
+			{
+				messages[index] = MessageType::Initialize(blocks[index], values[index], from);
+			}
+
+			return numBlocks;
+		}
+
+
 		XLANG_FORCEINLINE void MessageCreator::Destroy(IMessage *const message)
 		{
 			// Call release on the message to give it chance to destruct its value type.
-			message->Release();
-
-			// Return the block to the global free list.
-			MessageCache::Instance().Free(message->GetBlock(), message->GetBlockSize());
+			// Values with trivial destructors are released without calling anything.
+			// Messages sharing a block with other messages free it themselves once they're all released.
+			if (message->Release())
+			{
+				// Return the block to the global message cache.
+				MessageCache::Instance().Free(message->GetBlock(), message->GetBlockSize());
+			}
 		}
 
 
@@ -0,0 +1,66 @@
+#ifndef __XLANG_PRIVATE_MESSAGES_MESSAGEDESCRIPTOR_H
+#define __XLANG_PRIVATE_MESSAGES_MESSAGEDESCRIPTOR_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE 
+#pragma once 
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		class IMessage;
+
+		/// Static description of a kind of message, shared by all the messages of that kind.
+		/// Messages refer to their descriptor instead of carrying a table of virtual functions,
+		/// which keeps them small, and keeps the destruction of values with trivial destructors
+		/// free of indirect calls.
+		struct MessageDescriptor
+		{
+			/// Function that destructs the value of a message before it's freed.
+			/// \return True if the memory block containing the message can be freed, or false if
+			/// it's shared with other messages that are still in use.
+			typedef bool (*ReleaseFunction)(IMessage *const message);
+
+			ReleaseFunction		mRelease;				///< Releases a message, or null if there's nothing to do.
+			u32					mValueSize;				///< Size in bytes of the message value, including padding.
+			u32					mBlockSize;				///< Size in bytes of the block containing the message, or zero if the value is shared.
+		};
+
+
+		/// Traits template indicating whether a type has a trivial destructor, which needn't be called.
+		/// Uses the type trait intrinsic supported by Visual C++, gcc and clang. Other compilers
+		/// assume a non-trivial destructor, which is always safe.
+		template <class ValueType>
+		struct HasTrivialDestructor
+		{
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+			static const bool VALUE = __has_trivial_destructor(ValueType);
+#else
+			static const bool VALUE = false;
+#endif
+		};
+
+
+		/// Traits template indicating whether a type has a trivial copy constructor, so can be copied
+		/// as raw bytes. Other compilers assume a non-trivial copy constructor, which is always safe.
+		template <class ValueType>
+		struct HasTrivialCopy
+		{
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+			static const bool VALUE = __has_trivial_copy(ValueType);
+#else
+			static const bool VALUE = false;
+#endif
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_MESSAGES_MESSAGEDESCRIPTOR_H
@@ -5,10 +5,10 @@
 #pragma once 
 #endif
 
-#include "clang/private/Directory/c_Directory.h"
 #include "clang/private/Messages/c_IMessage.h"
+#include "clang/private/Messages/c_InlineMessage.h"
 #include "clang/private/Messages/c_MessageCreator.h"
-#include "clang/private/Threading/c_Lock.h"
+#include "clang/private/Messages/c_MessageTypeId.h"
 
 #include "clang/c_Address.h"
 #include "clang/c_Defines.h"
@@ -37,6 +37,44 @@ namespace clang
 			template <class ValueType>
 			inline static bool TailSend(const Framework *const framework, const ValueType &value, const Address &from, const Address &to);
 
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Sends a message whose value is constructed in place from the given constructor arguments.
+			template <class ValueType, class... ArgTypes>
+			inline static bool Emplace(const Framework *const framework, const Address &from, const Address &to, ArgTypes &&... args);
+
+			/// Sends a message whose value is constructed in place from the given constructor arguments,
+			/// without waking a worker thread to process it.
+			template <class ValueType, class... ArgTypes>
+			inline static bool TailEmplace(const Framework *const framework, const Address &from, const Address &to, ArgTypes &&... args);
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+			/// Sends the given value as a message from an address in the given framework to each
+			/// of the given addresses, sharing a single copy of the value between the messages.
+			/// \return The number of addresses to which the message was delivered.
+			template <class ValueType>
+			inline static u32 Broadcast(const Framework *const framework, const ValueType &value, const Address &from, const Address *const addresses, const u32 count);
+
+			/// Sends each of an array of values as a message from an address in the given framework.
+			/// Value i is sent to the address at index i * addressStride, so an address stride of zero
+			/// sends all of the values to the first address. Messages sent to the same address arrive
+			/// in the order of the values.
+			/// \return The number of messages delivered.
+			template <class ValueType>
+			inline static u32 SendBatch(
+				const Framework *const framework,
+				const ValueType *const values,
+				const u32 count,
+				const Address &from,
+				const Address *const addresses,
+				const u32 addressStride);
+
+			/// Delivers an existing message to some other address, keeping its original sender.
+			/// The message is destroyed if it can't be delivered.
+			/// This is a non-inlined called function to avoid code bloat.
+			static bool Forward(const Framework *const framework, IMessage *const message, const Address &to);
+
 		private:
 
 			/// Delivers the given message to the given address.
@@ -46,16 +84,45 @@ namespace clang
 			/// Delivers the given message to the given address, without waking a worker thread to process it.
 			/// This is a non-inlined called function to avoid code bloat.
 			static bool TailDeliver(const Framework *const framework, IMessage *const message, const Address &address);
+
+			/// Delivers a small value to the given address, holding the message in a slot of the receiving
+			/// actor's inline mailbox if one is free, rather than allocating it. Otherwise the message is
+			/// allocated and delivered as usual.
+			/// \param wake Whether to wake a worker thread to process the actor.
+			/// This is a non-inlined called function to avoid code bloat.
+			static bool DeliverInline(
+				const Framework *const framework,
+				const void *const value,
+				const InlineMessageDescriptor &descriptor,
+				const u32 typeId,
+				const Address &from,
+				const Address &to,
+				const bool wake);
+
+			/// Delivers each of a series of messages, spaced at the given stride, to the corresponding address.
+			/// Actors are scheduled in batches, waking worker threads once per framework.
+			/// This is a non-inlined called function to avoid code bloat.
+			static u32 DeliverBroadcast(const Framework *const framework, IMessage *const firstMessage, const u32 stride, const Address *const addresses, const u32 count);
+
+			/// Delivers each of an array of messages to the address at the corresponding multiple of the
+			/// address stride, in order. Actors are scheduled in batches, waking worker threads once per framework.
+			/// This is a non-inlined called function to avoid code bloat.
+			static u32 DeliverBatch(const Framework *const framework, IMessage *const *const messages, const Address *const addresses, const u32 addressStride, const u32 count);
 		};
 
 
 		template <class ValueType>
 		XLANG_FORCEINLINE bool MessageSender::Send(const Framework *const framework, const ValueType &value, const Address &from, const Address &to)
 		{
-			// The directory lock is used to protect the global free list.
-			Lock lock(Directory::GetMutex());
+			// Small trivially copyable values are copied into the receiving actor's inline mailbox, if it has room.
+			// This call is non-inlined to reduce code bloat.
+			if (InlineMessageTraits<ValueType>::IS_INLINE)
+			{
+				return DeliverInline(framework, &value, InlineMessageTraits<ValueType>::smDescriptor, MessageTypeId<ValueType>::Value(), from, to, true);
+			}
 
 			// Allocate a message. It'll be deleted by the target after it's been handled.
+			// The message cache is thread-safe so we don't need to lock it ourselves.
 			IMessage *const message = MessageCreator::Create(value, from);
 			if (message != 0)
 			{
@@ -76,10 +143,13 @@ namespace clang
 		template <class ValueType>
 		XLANG_FORCEINLINE bool MessageSender::TailSend(const Framework *const framework, const ValueType &value, const Address &from, const Address &to)
 		{
-			// The directory lock is used to protect the global free list.
-			Lock lock(Directory::GetMutex());
+			if (InlineMessageTraits<ValueType>::IS_INLINE)
+			{
+				return DeliverInline(framework, &value, InlineMessageTraits<ValueType>::smDescriptor, MessageTypeId<ValueType>::Value(), from, to, false);
+			}
 
 			// Allocate a message. It'll be deleted by the target after it's been handled.
+			// The message cache is thread-safe so we don't need to lock it ourselves.
 			IMessage *const message = MessageCreator::Create(value, from);
 			if (message != 0)
 			{
@@ -98,6 +168,123 @@ namespace clang
 		}
 
 
+		template <class ValueType>
+		XLANG_FORCEINLINE u32 MessageSender::Broadcast(const Framework *const framework, const ValueType &value, const Address &from, const Address *const addresses, const u32 count)
+		{
+			if (count == 0)
+			{
+				return 0;
+			}
+
+			// Allocate a message for each recipient in a single block, with a single copy of the value.
+			// The block is freed once every recipient has destroyed its message.
+			IMessage *const message = MessageCreator::CreateBroadcast(value, from, count);
+			if (message == 0)
+			{
+				return 0;
+			}
+
+			// This call is non-inlined to reduce code bloat.
+			// Messages that can't be delivered are destroyed there.
+			return DeliverBroadcast(framework, message, BroadcastMessage<ValueType>::GetMessageStride(), addresses, count);
+		}
+
+
+		template <class ValueType>
+		inline u32 MessageSender::SendBatch(
+			const Framework *const framework,
+			const ValueType *const values,
+			const u32 count,
+			const Address &from,
+			const Address *const addresses,
+			const u32 addressStride)
+		{
+			IMessage *messages[MessageCreator::MAX_BATCH_SIZE];
+			u32 numDelivered(0);
+
+			// Send the values in chunks, each allocated and delivered as a whole.
+			// The chunks are delivered in order, so the order of arrival is that of the values.
+			for (u32 offset = 0; offset < count; offset += MessageCreator::MAX_BATCH_SIZE)
+			{
+				const u32 remaining(count - offset);
+				const u32 chunkSize(remaining < MessageCreator::MAX_BATCH_SIZE ? remaining : MessageCreator::MAX_BATCH_SIZE);
+
+				const u32 numCreated(MessageCreator::CreateBatch(values + offset, chunkSize, from, messages));
+				if (numCreated != 0)
+				{
+					// This call is non-inlined to reduce code bloat.
+					numDelivered += DeliverBatch(framework, messages, addresses + offset * addressStride, addressStride, numCreated);
+				}
+
+				// Stop if we ran out of memory, rather than skip some of the values.
+				if (numCreated < chunkSize)
+				{
+					break;
+				}
+			}
+
+			return numDelivered;
+		}
+
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		template <class ValueType, class... ArgTypes>
+		XLANG_FORCEINLINE bool MessageSender::Emplace(const Framework *const framework, const Address &from, const Address &to, ArgTypes &&... args)
+		{
+			// Trivially copyable values are as cheap to copy as to construct in place,
+			// so small ones are constructed here and copied into the inline mailbox.
+			if (InlineMessageTraits<ValueType>::IS_INLINE)
+			{
+				const ValueType value(detail::Forward<ArgTypes>(args)...);
+				return DeliverInline(framework, &value, InlineMessageTraits<ValueType>::smDescriptor, MessageTypeId<ValueType>::Value(), from, to, true);
+			}
+
+			// The value is constructed directly in the message block, so it's never copied.
+			IMessage *const message = MessageCreator::Emplace<ValueType>(from, detail::Forward<ArgTypes>(args)...);
+			if (message != 0)
+			{
+				if (Deliver(framework, message, to))
+				{
+					return true;
+				}
+
+				// If the message wasn't delivered we need to delete it ourselves.
+				MessageCreator::Destroy(message);
+			}
+
+			return false;
+		}
+
+
+		template <class ValueType, class... ArgTypes>
+		XLANG_FORCEINLINE bool MessageSender::TailEmplace(const Framework *const framework, const Address &from, const Address &to, ArgTypes &&... args)
+		{
+			if (InlineMessageTraits<ValueType>::IS_INLINE)
+			{
+				const ValueType value(detail::Forward<ArgTypes>(args)...);
+				return DeliverInline(framework, &value, InlineMessageTraits<ValueType>::smDescriptor, MessageTypeId<ValueType>::Value(), from, to, false);
+			}
+
+			IMessage *const message = MessageCreator::Emplace<ValueType>(from, detail::Forward<ArgTypes>(args)...);
+			if (message != 0)
+			{
+				// This 'tail' call doesn't wake a worker thread to process the message.
+				if (TailDeliver(framework, message, to))
+				{
+					return true;
+				}
+
+				// If the message wasn't delivered we need to delete it ourselves.
+				MessageCreator::Destroy(message);
+			}
+
+			return false;
+		}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
 	} // namespace detail
 } // namespace clang
 
@@ -5,6 +5,8 @@
 #pragma once 
 #endif
 
+#include "clang/private/c_BasicTypes.h"
+
 namespace clang
 {
 	namespace detail
@@ -12,64 +14,40 @@ namespace clang
 		/// \brief Traits template that stores meta-information about message types.
 		///
 		/// The MessageTraits template can be specialized for individual message types
-		/// in order to label the types with their string names.
-		/// By storing the name of the message type in every sent message, clang is
+		/// in order to label the types with explicit type ids.
+		/// By storing the id of the message type in every sent message, clang is
 		/// able to match the type with the types expected by message handlers
 		/// registered in the receiving actor.
 		///
-		/// The default implementation defines a null pointer (no name) for all types.
-		/// The null pointer is a reserved value and implies that the type has no explicit name.
-		/// Types with null names are matched by means of dynamic_cast, which
-		/// relies on RTTI (Runtime Type Information - the automatic storing of a
-		/// type identifier in every class). By default clang uses RTTI exclusively.
-		///
-		/// The availability of RTTI is a compilation option, usually on by default
-		/// and disabled by means of an optional compiler flag. It introduces a small
-		/// size overhead into every class due to the need to store a hidden identifier to
-		/// identify the class's type. Note that this overhead is applied to all classes
-		/// and not just messages within clang. The overhead is not normally a problem,
-		/// however in applications with tightly constrained memory requirements (such as
-		/// embedded environments and games consoles) it is undesirable.
+		/// The default implementation defines no explicit id for any type. Such types
+		/// are identified by the id generated for them by \ref MessageTypeId, which
+		/// is a compile-time hash of the type name when \ref XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+		/// is enabled. Generated ids are the same in every run of the same build, but
+		/// depend on how the compiler spells the type name, so may differ between compilers.
 		///
-		/// The dependency on RTTI can be avoided by specifying non-null names
-		/// for all message types used in the application. Users can define
-		/// specializations of the traits template for their own message types, with
-		/// non-zero name pointers. Doing so causes the type names stored with every
-		/// sent message to be populated with the registered names of the types.
-		/// If names are provided for all message types then the names are used for type
-		/// matching, instead of the built-in C++ RTTI. This then allows RTTI to be disabled
-		/// in the application build.
+		/// Explicit ids are the same in every build, so are needed for message types
+		/// whose ids are persisted or shared with processes built separately.
+		/// Users can define specializations of the traits template for their own message
+		/// types with non-zero ids, or use the \ref XLANG_REGISTER_MESSAGE and
+		/// \ref XLANG_REGISTER_MESSAGE_ID macros as a shorthand.
 		///
-		/// The \ref XLANG_REGISTER_MESSAGE macro can be used as a shorthand mechanism
-		/// for registering automatically-generated names with message types.
-		///
-		/// \note If type names are used, then unique names must be specified for \em all
-		/// message types. Failure to specify a valid, unique name for one or more message
-		/// types will result in undefined behavior (usually caught by asserts). Although
-		/// type names must be unique and non-null, their values are arbitrary.
+		/// \note Type ids must be unique. Zero is reserved, and is never a valid id.
 		///
 		/// \tparam ValueType The message type for which the traits are defined.
 		/// \see XLANG_REGISTER_MESSAGE
 		template <class ValueType>
 		struct MessageTraits
 		{
-			/// \brief Indicates whether the message type has an explicit name.
-			/// Message types for which have valid type names are identified
-			/// using their names rather than with built-in C++ Runtime Type Information
-			static const bool HAS_TYPE_NAME = false;
+			/// \brief Indicates whether the message type has an explicit id.
+			static const bool HAS_TYPE_ID = false;
 
-			/// \brief The unique name of the type.
-			static const char *const TYPE_NAME;
+			/// \brief The unique id of the type, or zero if it has no explicit id.
+			static const u32 TYPE_ID = 0;
 		};
 
 
-		template <class ValueType>
-		const char *const MessageTraits<ValueType>::TYPE_NAME = 0;
-
-
 	} // namespace detail
 } // namespace clang
 
 
 #endif // __XLANG_PRIVATE_MESSAGES_MESSAGETRAITS_H
-
@@ -0,0 +1,191 @@
+#ifndef __XLANG_PRIVATE_MESSAGES_MESSAGETYPEID_H
+#define __XLANG_PRIVATE_MESSAGES_MESSAGETYPEID_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Messages/c_MessageTraits.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Mutex.h"
+
+#include "clang/c_Defines.h"
+
+namespace clang
+{
+	namespace detail
+	{
+#if XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+
+		/// Hashes a single character into a 32-bit FNV-1a hash.
+		XLANG_FORCEINLINE constexpr u32 HashTypeNameCharacter(const u32 hash, const char character)
+		{
+			return (hash ^ static_cast<u8>(character)) * 16777619u;
+		}
+
+		/// Hashes the rest of a null-terminated name into a 32-bit FNV-1a hash, at compile time.
+		/// Four characters are hashed per call to keep the recursion shallow for long template names.
+		XLANG_FORCEINLINE constexpr u32 HashTypeName(const char *const name, const u32 hash)
+		{
+			return (name[0] == 0) ? hash :
+				(name[1] == 0) ? HashTypeNameCharacter(hash, name[0]) :
+				(name[2] == 0) ? HashTypeNameCharacter(HashTypeNameCharacter(hash, name[0]), name[1]) :
+				(name[3] == 0) ? HashTypeNameCharacter(HashTypeNameCharacter(HashTypeNameCharacter(hash, name[0]), name[1]), name[2]) :
+				HashTypeName(name + 4, HashTypeNameCharacter(HashTypeNameCharacter(HashTypeNameCharacter(HashTypeNameCharacter(hash, name[0]), name[1]), name[2]), name[3]));
+		}
+
+		/// Returns a hash as a type id. Zero is reserved to mean no id, so the unlikely hash of zero is moved.
+		XLANG_FORCEINLINE constexpr u32 NonZeroTypeId(const u32 hash)
+		{
+			return (hash != 0) ? hash : 1;
+		}
+
+		/// Hashes a null-terminated type name into a non-zero type id, at compile time.
+		XLANG_FORCEINLINE constexpr u32 HashTypeName(const char *const name)
+		{
+			return NonZeroTypeId(HashTypeName(name, 2166136261u));
+		}
+
+		/// Returns the id generated for a type, as the hash of a function signature that names it.
+		template <class ValueType>
+		XLANG_FORCEINLINE constexpr u32 GenerateTypeId()
+		{
+#ifdef _MSC_VER
+			return HashTypeName(__FUNCSIG__);
+#else
+			return HashTypeName(__PRETTY_FUNCTION__);
+#endif
+		}
+
+		/// \brief Provides the unique id of a message type.
+		/// The id is the explicit id of the type, if it has one, or else the hash of its name.
+		/// Either way it's a compile-time constant, so comparing ids is a plain integer compare.
+		/// \tparam ValueType The message type.
+		template <class ValueType>
+		struct MessageTypeId
+		{
+			/// The id of the message type.
+			static constexpr u32 VALUE = MessageTraits<ValueType>::HAS_TYPE_ID ?
+				MessageTraits<ValueType>::TYPE_ID :
+				GenerateTypeId<ValueType>();
+
+			/// Returns the id of the message type.
+			XLANG_FORCEINLINE static constexpr u32 Value()
+			{
+				return VALUE;
+			}
+		};
+
+		template <class ValueType>
+		constexpr u32 MessageTypeId<ValueType>::VALUE;
+
+#else
+
+		/// Hands out ids, in order of first use, to message types without explicit ids.
+		class MessageTypeIdCounter
+		{
+		protected:
+
+			/// Returns the next unused id.
+			inline static u32 Next()
+			{
+				// Counted down from the top, so generated ids don't clash with small explicit ids.
+				static u32 id = 0xFFFFFFFF;
+				return id--;
+			}
+		};
+
+		/// \brief Provides the unique id of a message type.
+		/// The id is the explicit id of the type, if it has one, or else an id handed out
+		/// on first use, which can differ between runs.
+		/// \tparam ValueType The message type.
+		template <class ValueType>
+		struct MessageTypeId : public MessageTypeIdCounter
+		{
+			/// Returns the id of the message type.
+			XLANG_FORCEINLINE static u32 Value()
+			{
+				if (MessageTraits<ValueType>::HAS_TYPE_ID)
+				{
+					return MessageTraits<ValueType>::TYPE_ID;
+				}
+
+				static const u32 id = Next();
+				return id;
+			}
+		};
+
+#endif // XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+
+
+#if XLANG_ENABLE_ASSERTS
+
+		/// Remembers which type each message type id was first used by, in debug builds.
+		/// Generated ids are 32-bit hashes, and explicit ids are chosen by hand, so two types
+		/// can end up with the same id. Messages of one would then be dispatched to handlers of
+		/// the other and reinterpreted as the wrong type, so clashes are caught here instead.
+		class MessageTypeIdRegistry
+		{
+		public:
+
+			/// Maximum number of types remembered. Types used after the table is full aren't checked.
+			static const u32 MAX_TYPES = 4096;
+
+			/// Records that the given id is used by the given type.
+			/// \param id The id of the type.
+			/// \param type An address unique to the type.
+			/// \return False if the id is already used by a different type.
+			static bool Register(const u32 id, const void *const type);
+
+		private:
+
+			static Mutex smMutex;							///< Protects the table.
+			static u32 smIds[MAX_TYPES];					///< Ids of the remembered types, hashed by id.
+			static const void *smTypes[MAX_TYPES];			///< Addresses identifying the types, or null for free entries.
+		};
+
+		/// Checks that the id of a message type isn't shared with any other type.
+		/// Each type is checked once, the first time a message or handler of that type is created.
+		/// \tparam ValueType The message type.
+		template <class ValueType>
+		struct MessageTypeIdCheck
+		{
+			/// Asserts if the id of the message type is already used by a different type.
+			XLANG_FORCEINLINE static void Check()
+			{
+				if (Atomic::Load(&smChecked) == 0)
+				{
+					const bool unique(MessageTypeIdRegistry::Register(MessageTypeId<ValueType>::Value(), const_cast<const u32 *>(&smChecked)));
+					XLANG_ASSERT_MSG(unique, "Message type id clashes with the id of another message type");
+
+					Atomic::Store(&smChecked, 1);
+				}
+			}
+
+			static volatile u32 smChecked;		///< Set once the type is checked. Its address identifies the type.
+		};
+
+		template <class ValueType>
+		volatile u32 MessageTypeIdCheck<ValueType>::smChecked = 0;
+
+#else
+
+		/// Checks that the id of a message type isn't shared with any other type, in debug builds only.
+		template <class ValueType>
+		struct MessageTypeIdCheck
+		{
+			XLANG_FORCEINLINE static void Check()
+			{
+			}
+		};
+
+#endif // XLANG_ENABLE_ASSERTS
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_MESSAGES_MESSAGETYPEID_H
@@ -8,6 +8,7 @@
 #include "clang/private/c_BasicTypes.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/PagedPool/c_FreeList.h"
+#include "clang/private/Threading/c_Atomic.h"
 
 #include "clang/c_AllocatorManager.h"
 #include "clang/c_IAllocator.h"
@@ -36,7 +37,7 @@ namespace clang
 			/// Returns true if the page has been allocated by a successful call to Initialize.
 			XLANG_FORCEINLINE bool IsInitialized() const
 			{
-				return (mData != 0);
+				return (Atomic::Load(&mData) != 0);
 			}
 
 			/// Initializes the page, allocating its data buffer and marking all entries as free.
@@ -45,35 +46,47 @@ namespace clang
 			{
 				// Allocate the page data buffer.
 				IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
-				mData = reinterpret_cast<Entry *>(allocator->Allocate(ENTRIES_PER_PAGE * sizeof(Entry)));
+				Entry *const data(reinterpret_cast<Entry *>(allocator->Allocate(ENTRIES_PER_PAGE * sizeof(Entry))));
 
-				if (mData == 0)
+				if (data == 0)
 				{
 					return false;
 				}
 
 				// Add all the entries in the page to the free list initially.
 				// We add them at the front of the list in reverse order so the list starts at the low end.
-				Entry *entry(mData + ENTRIES_PER_PAGE);
-				while (--entry >= mData)
+				Entry *entry(data + ENTRIES_PER_PAGE);
+				while (--entry >= data)
 				{
 					// Add the free entry to the freelist.
 					freeList.Add(entry);
 				}
 
+				// Publish the buffer only once it's set up, since it can be read without locking.
+				Atomic::Store(&mData, data);
 				return true;
 			}
 
 			/// Releases the page, de-allocating its data buffer and clearing its free list.
 			inline void Release(FreeList &freeList)
 			{
-				XLANG_ASSERT(mData);
-
 				IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
-				allocator->Free(mData);
-				mData = 0;
+				allocator->Free(Retire(freeList));
+			}
+
+			/// Retires the page, unpublishing its data buffer and clearing its free list.
+			/// The buffer isn't freed, since threads reading the page without locking may still be
+			/// accessing it. The caller frees it later, once those threads are known to be done.
+			/// \return The retired data buffer.
+			inline void *Retire(FreeList &freeList)
+			{
+				Entry *const data(mData);
+				XLANG_ASSERT(data);
 
+				Atomic::Store(&mData, static_cast<Entry *>(0));
 				freeList.Clear();
+
+				return data;
 			}
 
 			/// Allocates a free entry and sets its index, returning true on success.
@@ -106,12 +119,20 @@ namespace clang
 			}
 
 			/// Gets a pointer to the entry at the given index.
+			/// Returns null if the page isn't initialized.
+			/// \note This can be called without locking, concurrently with the page being initialized or retired.
 			XLANG_FORCEINLINE void *GetEntry(const u32 index) const
 			{
-				XLANG_ASSERT(mData);
 				XLANG_ASSERT(index < ENTRIES_PER_PAGE);
 
-				return reinterpret_cast<void *>(mData + index);
+				// Read the buffer pointer once, since the page can be retired at any time.
+				Entry *const data(Atomic::Load(&mData));
+				if (data == 0)
+				{
+					return 0;
+				}
+
+				return reinterpret_cast<void *>(data + index);
 			}
 
 			/// Gets the index of the entry addressed by the given pointer.
@@ -136,7 +157,7 @@ namespace clang
 
 		private:
 
-			Entry *mData;           ///< A page is really just a pointer to an allocated buffer of entries.
+			Entry *volatile mData;  ///< A page is really just a pointer to an allocated buffer of entries.
 		};
 
 
@@ -9,6 +9,8 @@
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/PagedPool/c_FreeList.h"
 #include "clang/private/PagedPool/c_Page.h"
+#include "clang/private/PagedPool/c_PageMask.h"
+#include "clang/private/Threading/c_Atomic.h"
 
 #include "clang/c_AllocatorManager.h"
 #include "clang/c_IAllocator.h"
@@ -20,14 +22,48 @@ namespace clang
 	namespace detail
 	{
 		/// A growable pool in which objects can be allocated.
-		template <class Entry, u32 MAX_ENTRIES>
+		/// Entries are allocated in pages, which are allocated as needed. The page table is split
+		/// into segments, each holding a fixed number of pages, which are also allocated as needed,
+		/// so the memory used grows with the number of entries rather than the maximum. An entry is
+		/// found from its index with a lookup in the segment table and one in the segment.
+		/// The pool tracks which pages have free entries, so allocation and freeing take constant
+		/// time however many pages there are. Pages that become unused are kept as spares, up to a
+		/// limit, so that allocating and freeing around a page boundary doesn't repeatedly allocate
+		/// and free the page. Beyond that limit, and once the pool is entirely empty, unused pages
+		/// are released.
+		template <class Entry>
 		class PagedPool
 		{
 		public:
 
-			/// Default Constructor.
-			inline PagedPool() : mEntryCount(0), mMaxPageIndex(0)
+			/// Default maximum number of unused pages kept for reuse.
+			static const u32 DEFAULT_MAX_SPARE_PAGES = 4;
+
+			/// Limit on the maximum number of entries, since indices are 31-bit.
+			static const u32 MAX_ENTRIES_LIMIT = 0x80000000;
+
+			/// Constructor. Nothing is allocated until the first entry is allocated.
+			/// \param maxEntries Maximum number of entries that can be allocated at once.
+			inline explicit PagedPool(const u32 maxEntries)
+				: mSegmentTable(0)
+				, mMaxEntries(0)
+				, mEntryCount(0)
+				, mMaxPageIndex(0)
+				, mCurrentPage(0)
+				, mNumPages(0)
+				, mNumSparePages(0)
+				, mMaxSparePages(DEFAULT_MAX_SPARE_PAGES)
+				, mPreferLowIndices(false)
 			{
+				void *retiredPages(0);
+				Reserve(maxEntries, retiredPages);
+				XLANG_ASSERT(retiredPages == 0);
+			}
+
+			inline ~PagedPool()
+			{
+				// We expect the pool to be empty and hence released.
+				XLANG_ASSERT(mSegmentTable == 0);
 			}
 
 			/// Returns the number of allocated entries.
@@ -36,84 +72,224 @@ namespace clang
 				return mEntryCount;
 			}
 
-			/// Allocates an entity in the pool and returns its unique index.
-			XLANG_FORCEINLINE bool Allocate(u32 &index)
+			/// Returns the maximum number of entries that can be allocated at once.
+			XLANG_FORCEINLINE u32 GetMaxEntries() const
 			{
-				u32 pageIndex(0);
-				u32 entryIndex(0);
+				return mMaxEntries;
+			}
+
+			/// Returns the number of pages currently allocated, including spare pages.
+			XLANG_FORCEINLINE u32 GetNumPages() const
+			{
+				return mNumPages;
+			}
+
+			/// Returns the number of unused pages currently kept for reuse.
+			XLANG_FORCEINLINE u32 GetNumSparePages() const
+			{
+				return mNumSparePages;
+			}
+
+			/// Sets the maximum number of unused pages kept for reuse.
+			/// Spare pages already kept beyond the new limit are released as entries are freed.
+			XLANG_FORCEINLINE void SetMaxSparePages(const u32 maxSparePages)
+			{
+				mMaxSparePages = maxSparePages;
+			}
+
+			/// Sets whether entries are allocated at the lowest free index, to keep the used indices dense.
+			/// Otherwise entries are allocated from the page last allocated from, while it has free entries.
+			XLANG_FORCEINLINE void SetPreferLowIndices(const bool preferLowIndices)
+			{
+				mPreferLowIndices = preferLowIndices;
+			}
+
+			/// Raises the maximum number of entries that can be allocated at once to at least the given number.
+			/// The maximum is never lowered. If entries are allocated then the segment table may be replaced
+			/// by a larger one, in which case the old table is retired rather than freed, and returned in the
+			/// list retiredPages, for the caller to free with \ref FreeRetiredPages.
+			/// \return False if the maximum couldn't be raised, for lack of memory.
+			inline bool Reserve(const u32 maxEntries, void *&retiredPages)
+			{
+				retiredPages = 0;
+
+				XLANG_ASSERT_MSG(maxEntries <= MAX_ENTRIES_LIMIT, "Maximum number of entries is too large");
+				const u32 newMaxEntries(maxEntries < MAX_ENTRIES_LIMIT ? maxEntries : MAX_ENTRIES_LIMIT);
 
-				if (mEntryCount < MAX_ENTRIES)
+				if (newMaxEntries <= mMaxEntries)
 				{
-					// Check each initialized page in turn for a free entry.
-					while (pageIndex < MAX_PAGES)
+					return true;
+				}
+
+				// If nothing is allocated then the table is sized when it's created.
+				if (mSegmentTable)
+				{
+					const u32 numPages(NumPages(newMaxEntries));
+					if (!mNonFullPages.Resize(numPages, false) ||
+						!mSparePages.Resize(numPages, false) ||
+						!mUninitializedPages.Resize(numPages, true))
 					{
-						FreeList &freeList(mFreeLists[pageIndex]);
-						PageType &page(mPageTable[pageIndex]);
+						return false;
+					}
 
-						if (!page.IsInitialized())
+					// Replace the table with a larger one, if there are more segments.
+					// The old table may still be being read by threads looking up entries, so it's retired.
+					const u32 numSegments(NumSegments(numPages));
+					if (numSegments > mSegmentTable->mNumSegments)
+					{
+						SegmentTable *const table(CreateSegmentTable(numSegments));
+						if (table == 0)
 						{
-							break;
+							return false;
 						}
 
-						if (page.Allocate(freeList, entryIndex))
+						for (u32 segmentIndex = 0; segmentIndex < mSegmentTable->mNumSegments; ++segmentIndex)
 						{
-							index = Index(pageIndex, entryIndex);
-							++mEntryCount;
-
-							// Update the maximum page index.
-							if (pageIndex > mMaxPageIndex)
-							{
-								mMaxPageIndex = pageIndex;
-							}
-
-							return true;
+							table->mSegments[segmentIndex] = mSegmentTable->mSegments[segmentIndex];
 						}
 
-						++pageIndex;
+						SegmentTable *const oldTable(mSegmentTable);
+						Atomic::Store(&mSegmentTable, table);
+
+						oldTable->mNext = retiredPages;
+						retiredPages = oldTable;
 					}
+				}
 
-					// All allocated pages are full. Initialize the first uninitialized page.
-					if (pageIndex < MAX_PAGES)
-					{
-						FreeList &freeList(mFreeLists[pageIndex]);
-						PageType &page(mPageTable[pageIndex]);
+				mMaxEntries = newMaxEntries;
+				return true;
+			}
+
+			/// Allocates an entity in the pool and returns its unique index.
+			XLANG_FORCEINLINE bool Allocate(u32 &index)
+			{
+				if (mEntryCount >= mMaxEntries)
+				{
+					return false;
+				}
+
+				// The segment table and page masks are created along with the first entry.
+				if (mSegmentTable == 0 && !Create())
+				{
+					return false;
+				}
 
-						if (page.Initialize(freeList))
+				// Usually the page last allocated from still has free entries.
+				u32 pageIndex(mCurrentPage);
+				if (mPreferLowIndices || !mNonFullPages.Test(pageIndex))
+				{
+					pageIndex = mNonFullPages.FindFirst();
+					if (pageIndex == PageMask::NONE)
+					{
+						// All initialized pages are full. Initialize the first uninitialized page.
+						pageIndex = mUninitializedPages.FindFirst();
+						if (pageIndex == PageMask::NONE || !InitializePage(pageIndex))
 						{
-							if (page.Allocate(freeList, entryIndex))
+							// Release the table if it was only just created.
+							if (mEntryCount == 0)
 							{
-								index = Index(pageIndex, entryIndex);
-								++mEntryCount;
-								return true;
+								Destroy();
 							}
+
+							return false;
 						}
 					}
+
+					mCurrentPage = pageIndex;
 				}
 
-				return false;
+				Segment *const segment(mSegmentTable->mSegments[SegmentIndex(pageIndex)]);
+				FreeList &freeList(segment->mFreeLists[SegmentPageIndex(pageIndex)]);
+				PageType &page(segment->mPages[SegmentPageIndex(pageIndex)]);
+
+				// A spare page is no longer unused once an entry is allocated from it.
+				if (freeList.Count() == ENTRIES_PER_PAGE)
+				{
+					mSparePages.Clear(pageIndex);
+					--mNumSparePages;
+				}
+
+				u32 entryIndex(0);
+				if (!page.Allocate(freeList, entryIndex))
+				{
+					XLANG_FAIL_MSG("Page tracked as non-full has no free entries");
+					return false;
+				}
+
+				if (freeList.Count() == 0)
+				{
+					mNonFullPages.Clear(pageIndex);
+				}
+
+				index = Index(pageIndex, entryIndex);
+				++mEntryCount;
+
+				return true;
 			}
 
 			/// Frees the entry at the given index and returns its memory to the pool.
 			XLANG_FORCEINLINE bool Free(const u32 index)
 			{
+				void *retiredPages(0);
+				if (Free(index, retiredPages))
+				{
+					// Nobody reads the pool without locking, so the pages can be freed right away.
+					FreeRetiredPages(retiredPages);
+					return true;
+				}
+
+				return false;
+			}
+
+			/// Frees the entry at the given index and returns its memory to the pool.
+			/// Pages released as a result are retired rather than freed, and returned as a list in
+			/// retiredPages, for the caller to free with \ref FreeRetiredPages when no threads can be
+			/// reading them. The list is null if no pages were released. Segments of the page table,
+			/// and the segment table itself, are released along with their last pages.
+			XLANG_FORCEINLINE bool Free(const u32 index, void *&retiredPages)
+			{
+				retiredPages = 0;
+
 				const u32 pageIndex(PageIndex(index));
 				const u32 entryIndex(EntryIndex(index));
 
-				XLANG_ASSERT(pageIndex < MAX_PAGES);
+				XLANG_ASSERT(mSegmentTable);
+				XLANG_ASSERT(pageIndex < mUninitializedPages.Size());
 
 				// Since we're being asked to free the memory the page should exist!
-				FreeList &freeList(mFreeLists[pageIndex]);
-				PageType &page(mPageTable[pageIndex]);
+				Segment *const segment(mSegmentTable->mSegments[SegmentIndex(pageIndex)]);
+				XLANG_ASSERT(segment);
+
+				FreeList &freeList(segment->mFreeLists[SegmentPageIndex(pageIndex)]);
+				PageType &page(segment->mPages[SegmentPageIndex(pageIndex)]);
 
 				XLANG_ASSERT(page.IsInitialized());
 				if (page.Free(freeList, entryIndex))
 				{
 					--mEntryCount;
+					mNonFullPages.Set(pageIndex);
 
-					// If the page has become unused then deallocate it.
+					// If the page has become unused then keep it as a spare, within the limit.
 					if (freeList.Count() == ENTRIES_PER_PAGE)
 					{
-						page.Release(freeList);
+						mSparePages.Set(pageIndex);
+						++mNumSparePages;
+
+						if (mEntryCount == 0)
+						{
+							// The pool is empty, so release all the pages, and the table.
+							while (!mSparePages.Empty())
+							{
+								RetirePage(mSparePages.FindFirst(), retiredPages);
+							}
+
+							Destroy(retiredPages);
+						}
+						else if (mNumSparePages > mMaxSparePages)
+						{
+							// Release the highest spare page if keeping the indices dense.
+							RetirePage(mPreferLowIndices ? mSparePages.FindLast() : pageIndex, retiredPages);
+						}
 					}
 
 					return true;
@@ -122,35 +298,68 @@ namespace clang
 				return false;
 			}
 
+			/// Frees a list of pages, segments and tables retired by \ref Free or \ref Reserve.
+			inline static void FreeRetiredPages(void *retiredPages)
+			{
+				IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+				while (retiredPages)
+				{
+					void *const next(*reinterpret_cast<void **>(retiredPages));
+					allocator->Free(retiredPages);
+					retiredPages = next;
+				}
+			}
+
 			/// Gets a pointer to the entry at the given index.
+			/// \note This can be called without locking, concurrently with entries being allocated and freed.
+			/// Retired pages must then only be freed once no such calls can still be accessing them.
 			XLANG_FORCEINLINE void *GetEntry(const u32 index) const
 			{
 				const u32 pageIndex(PageIndex(index));
 				const u32 entryIndex(EntryIndex(index));
+				const u32 segmentIndex(SegmentIndex(pageIndex));
 
-				XLANG_ASSERT(pageIndex < MAX_PAGES);
+				// If the address is stale then the table, segment or page may not even exist any more,
+				// in which case the entry is null.
+				const SegmentTable *const table(Atomic::Load(&mSegmentTable));
+				if (table == 0 || segmentIndex >= table->mNumSegments)
+				{
+					return 0;
+				}
 
-				// If the address is stale then the page may not even exist any more.
-				const PageType &page(mPageTable[pageIndex]);
-				if (page.IsInitialized())
+				const Segment *const segment(Atomic::Load(&table->mSegments[segmentIndex]));
+				if (segment == 0)
 				{
-					return page.GetEntry(entryIndex);
+					return 0;
 				}
 
-				return 0;
+				const PageType &page(segment->mPages[SegmentPageIndex(pageIndex)]);
+				return page.GetEntry(entryIndex);
 			}
 
 			/// Gets the index of the entry addressed by the given pointer.
-			/// Returns MAX_ENTRIES if the entry is not found.
+			/// Returns MAX_ENTRIES_LIMIT if the entry is not found.
 			XLANG_FORCEINLINE u32 GetIndex(void *const entry) const
 			{
 				XLANG_ASSERT(entry);
 
+				if (mSegmentTable == 0)
+				{
+					return MAX_ENTRIES_LIMIT;
+				}
+
 				// Search all pages that have ever been allocated for one which contains the entry.
 				u32 pageIndex(0);
 				while (pageIndex <= mMaxPageIndex)
 				{
-					const PageType &page(mPageTable[pageIndex]);
+					const Segment *const segment(mSegmentTable->mSegments[SegmentIndex(pageIndex)]);
+					if (segment == 0)
+					{
+						pageIndex += PAGES_PER_SEGMENT;
+						continue;
+					}
+
+					const PageType &page(segment->mPages[SegmentPageIndex(pageIndex)]);
 					if (page.IsInitialized())
 					{
 						const u32 entryIndex(page.GetIndex(entry));
@@ -163,19 +372,44 @@ namespace clang
 					++pageIndex;
 				}
 
-				return MAX_ENTRIES;
+				return MAX_ENTRIES_LIMIT;
 			}
 
 		private:
 
 			static const u32 ENTRIES_PER_PAGE = 64;
-			static const u32 MAX_PAGES = (MAX_ENTRIES + ENTRIES_PER_PAGE - 1) / ENTRIES_PER_PAGE;
 			static const u32 ENTRY_INDEX_MASK = ENTRIES_PER_PAGE - 1;
 			static const u32 PAGE_INDEX_MASK = ~ENTRY_INDEX_MASK;
 			static const u32 PAGE_INDEX_SHIFT = 6;
 
+			static const u32 PAGES_PER_SEGMENT = 256;
+			static const u32 SEGMENT_PAGE_INDEX_MASK = PAGES_PER_SEGMENT - 1;
+			static const u32 SEGMENT_INDEX_SHIFT = 8;
+
 			typedef Page<Entry, ENTRIES_PER_PAGE> PageType;
 
+			/// A segment of the page table.
+			/// The link is first so that retired segments can be listed without touching the pages.
+			struct Segment
+			{
+				inline Segment() : mNext(0), mNumPages(0)
+				{
+				}
+
+				void *mNext;                                ///< Next in a list of retired memory.
+				u32 mNumPages;                              ///< Number of initialized pages in the segment.
+				PageType mPages[PAGES_PER_SEGMENT];         ///< Pages, each of which is basically a pointer to a buffer.
+				FreeList mFreeLists[PAGES_PER_SEGMENT];     ///< Each page has its own dedicated list of free entries.
+			};
+
+			/// Table of pointers to the segments of the page table, allocated with room for all the segments.
+			struct SegmentTable
+			{
+				void *mNext;                                ///< Next in a list of retired memory.
+				u32 mNumSegments;                           ///< Number of segment pointers in the table.
+				Segment *volatile mSegments[1];             ///< Segment pointers, null for unallocated segments.
+			};
+
 			XLANG_FORCEINLINE static u32 PageIndex(const u32 index)
 			{
 				return ((index & PAGE_INDEX_MASK) >> PAGE_INDEX_SHIFT);
@@ -191,13 +425,202 @@ namespace clang
 				return ((pageIndex << PAGE_INDEX_SHIFT) | entryIndex);
 			}
 
+			XLANG_FORCEINLINE static u32 SegmentIndex(const u32 pageIndex)
+			{
+				return (pageIndex >> SEGMENT_INDEX_SHIFT);
+			}
+
+			XLANG_FORCEINLINE static u32 SegmentPageIndex(const u32 pageIndex)
+			{
+				return (pageIndex & SEGMENT_PAGE_INDEX_MASK);
+			}
+
+			XLANG_FORCEINLINE static u32 NumPages(const u32 numEntries)
+			{
+				return (numEntries + ENTRIES_PER_PAGE - 1) / ENTRIES_PER_PAGE;
+			}
+
+			XLANG_FORCEINLINE static u32 NumSegments(const u32 numPages)
+			{
+				return (numPages + PAGES_PER_SEGMENT - 1) / PAGES_PER_SEGMENT;
+			}
+
 			PagedPool(const PagedPool &other);
 			PagedPool &operator=(const PagedPool &other);
 
-			PageType mPageTable[MAX_PAGES];     ///< Table of allocated pages, each of which is basically a pointer to a buffer.
-			FreeList mFreeLists[MAX_PAGES];     ///< Each page has its own dedicated list of free entries, so we can favour low-index pages.
+			/// Allocates a segment table with the given number of null segment pointers.
+			inline static SegmentTable *CreateSegmentTable(const u32 numSegments)
+			{
+				IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+				const u32 size(sizeof(SegmentTable) + (numSegments - 1) * sizeof(Segment *));
+
+				SegmentTable *const table(reinterpret_cast<SegmentTable *>(allocator->Allocate(size)));
+				if (table)
+				{
+					table->mNext = 0;
+					table->mNumSegments = numSegments;
+
+					for (u32 segmentIndex = 0; segmentIndex < numSegments; ++segmentIndex)
+					{
+						table->mSegments[segmentIndex] = 0;
+					}
+				}
+
+				return table;
+			}
+
+			/// Creates the segment table and page masks, sized for the maximum number of entries.
+			inline bool Create()
+			{
+				const u32 numPages(NumPages(mMaxEntries));
+				if (!mNonFullPages.Resize(numPages, false) ||
+					!mSparePages.Resize(numPages, false) ||
+					!mUninitializedPages.Resize(numPages, true))
+				{
+					ReleaseMasks();
+					return false;
+				}
+
+				SegmentTable *const table(CreateSegmentTable(NumSegments(numPages)));
+				if (table == 0)
+				{
+					ReleaseMasks();
+					return false;
+				}
+
+				// Publish the table only once it's set up, since it can be read without locking.
+				Atomic::Store(&mSegmentTable, table);
+				mCurrentPage = 0;
+				mMaxPageIndex = 0;
+
+				return true;
+			}
+
+			/// Retires the segment table and releases the page masks, once all the pages are released.
+			inline void Destroy(void *&retiredPages)
+			{
+				XLANG_ASSERT(mNumPages == 0);
+
+				SegmentTable *const table(mSegmentTable);
+				Atomic::Store(&mSegmentTable, static_cast<SegmentTable *>(0));
+
+				table->mNext = retiredPages;
+				retiredPages = table;
+
+				ReleaseMasks();
+			}
+
+			/// Destroys the segment table, freeing it right away, since nothing was ever allocated in it.
+			inline void Destroy()
+			{
+				void *retiredPages(0);
+				Destroy(retiredPages);
+				FreeRetiredPages(retiredPages);
+			}
+
+			inline void ReleaseMasks()
+			{
+				mNonFullPages.Release();
+				mSparePages.Release();
+				mUninitializedPages.Release();
+			}
+
+			/// Initializes an uninitialized page, which starts out as an unused spare.
+			/// The segment holding the page is allocated if it isn't already.
+			inline bool InitializePage(const u32 pageIndex)
+			{
+				Segment *volatile &segmentPointer(mSegmentTable->mSegments[SegmentIndex(pageIndex)]);
+				Segment *segment(segmentPointer);
+
+				if (segment == 0)
+				{
+					IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+					void *const memory(allocator->Allocate(sizeof(Segment)));
+
+					if (memory == 0)
+					{
+						return false;
+					}
+
+					// Publish the segment only once it's constructed, since it can be read without locking.
+					segment = new (memory) Segment();
+					Atomic::Store(&segmentPointer, segment);
+				}
+
+				if (!segment->mPages[SegmentPageIndex(pageIndex)].Initialize(segment->mFreeLists[SegmentPageIndex(pageIndex)]))
+				{
+					// Release the segment if it was only just allocated.
+					if (segment->mNumPages == 0)
+					{
+						Atomic::Store(&segmentPointer, static_cast<Segment *>(0));
+						segment->~Segment();
+						AllocatorManager::Instance().GetAllocator()->Free(segment);
+					}
+
+					return false;
+				}
+
+				++segment->mNumPages;
+
+				mUninitializedPages.Clear(pageIndex);
+				mNonFullPages.Set(pageIndex);
+				mSparePages.Set(pageIndex);
+
+				++mNumPages;
+				++mNumSparePages;
+
+				// Update the maximum page index.
+				if (pageIndex > mMaxPageIndex)
+				{
+					mMaxPageIndex = pageIndex;
+				}
+
+				return true;
+			}
+
+			/// Retires an unused page, adding its buffer to the given list of retired pages.
+			/// If it was the last initialized page in its segment then the segment is retired too.
+			inline void RetirePage(const u32 pageIndex, void *&retiredPages)
+			{
+				XLANG_ASSERT(mSparePages.Test(pageIndex));
+
+				Segment *volatile &segmentPointer(mSegmentTable->mSegments[SegmentIndex(pageIndex)]);
+				Segment *const segment(segmentPointer);
+
+				// The buffer is unused, so its first word can link it into the list.
+				void *const data(segment->mPages[SegmentPageIndex(pageIndex)].Retire(segment->mFreeLists[SegmentPageIndex(pageIndex)]));
+				*reinterpret_cast<void **>(data) = retiredPages;
+				retiredPages = data;
+
+				if (--segment->mNumPages == 0)
+				{
+					Atomic::Store(&segmentPointer, static_cast<Segment *>(0));
+
+					segment->~Segment();
+					segment->mNext = retiredPages;
+					retiredPages = segment;
+				}
+
+				mSparePages.Clear(pageIndex);
+				mNonFullPages.Clear(pageIndex);
+				mUninitializedPages.Set(pageIndex);
+
+				--mNumPages;
+				--mNumSparePages;
+			}
+
+			SegmentTable *volatile mSegmentTable;   ///< Table of page table segments, allocated along with the first entry.
+			PageMask mNonFullPages;                 ///< Initialized pages with at least one free entry.
+			PageMask mSparePages;                   ///< Initialized pages with no allocated entries.
+			PageMask mUninitializedPages;           ///< Pages not currently initialized.
+			u32 mMaxEntries;               ///< Maximum number of entries that can be allocated at once.
 			u32 mEntryCount;               ///< Number of allocated entries in the entire pool.
 			u32 mMaxPageIndex;             ///< Maximum index of any allocated page.
+			u32 mCurrentPage;              ///< Index of the page last allocated from.
+			u32 mNumPages;                 ///< Number of initialized pages.
+			u32 mNumSparePages;            ///< Number of initialized pages with no allocated entries.
+			u32 mMaxSparePages;            ///< Maximum number of spare pages kept for reuse.
+			bool mPreferLowIndices;        ///< Whether entries are allocated at the lowest free index.
 		};
 
 
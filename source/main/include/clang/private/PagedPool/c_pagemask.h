@@ -0,0 +1,310 @@
+#ifndef __XLANG_PRIVATE_PAGEDPOOL_PAGEMASK_H
+#define __XLANG_PRIVATE_PAGEDPOOL_PAGEMASK_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+
+#include "clang/c_AllocatorManager.h"
+#include "clang/c_IAllocator.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Helpers for finding set bits in the words of a \ref PageMask.
+		struct PageMaskBits
+		{
+			/// Returns the index of the lowest set bit of a non-zero value.
+			XLANG_FORCEINLINE static u32 FindLowestSetBit(const u32 value)
+			{
+				XLANG_ASSERT(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+				return static_cast<u32>(__builtin_ctz(value));
+#elif defined(_MSC_VER)
+				unsigned long index;
+				_BitScanForward(&index, value);
+				return static_cast<u32>(index);
+#else
+				u32 index(0);
+				while ((value & (1u << index)) == 0)
+				{
+					++index;
+				}
+
+				return index;
+#endif
+			}
+
+			/// Returns the index of the highest set bit of a non-zero value.
+			XLANG_FORCEINLINE static u32 FindHighestSetBit(const u32 value)
+			{
+				XLANG_ASSERT(value != 0);
+
+#if defined(__GNUC__) || defined(__clang__)
+				return 31 - static_cast<u32>(__builtin_clz(value));
+#elif defined(_MSC_VER)
+				unsigned long index;
+				_BitScanReverse(&index, value);
+				return static_cast<u32>(index);
+#else
+				u32 index(31);
+				while ((value & (1u << index)) == 0)
+				{
+					--index;
+				}
+
+				return index;
+#endif
+			}
+		};
+
+
+		/// A set of page indices, as a hierarchy of bit masks.
+		/// Each level has one bit per word of the level below, set if that word has any bits set,
+		/// so the lowest or highest index in the set is found with one bit scan per level.
+		/// There are only a few levels, even for a very large number of pages.
+		/// The masks are allocated when the set is sized, so it can be sized at runtime.
+		class PageMask
+		{
+		public:
+
+			/// Returned by \ref FindFirst and \ref FindLast when the set is empty.
+			static const u32 NONE = 0xFFFFFFFF;
+
+			/// Default constructor. The set is initially empty, and can't hold any indices until it's sized.
+			inline PageMask() : mWords(0), mNumBits(0), mNumLevels(0)
+			{
+			}
+
+			inline ~PageMask()
+			{
+				// We expect the set to have been released.
+				XLANG_ASSERT(mWords == 0);
+			}
+
+			/// Returns the number of indices the set can hold.
+			XLANG_FORCEINLINE u32 Size() const
+			{
+				return mNumBits;
+			}
+
+			/// Resizes the set to hold indices up to the given number, keeping the indices already in it.
+			/// Indices added by the resize are optionally added to the set.
+			/// \return False if the masks couldn't be allocated, in which case the set is unchanged.
+			inline bool Resize(const u32 numBits, const bool fill)
+			{
+				XLANG_ASSERT(numBits > 0 && numBits >= mNumBits);
+
+				// Each level has a word for every 32 words of the level below, up to a single word.
+				u32 levelOffsets[MAX_LEVELS];
+				u32 numLevels(0);
+				u32 numWords(0);
+				u32 levelWords((numBits + 31) / 32);
+
+				while (true)
+				{
+					XLANG_ASSERT(numLevels < MAX_LEVELS);
+					levelOffsets[numLevels++] = numWords;
+					numWords += levelWords;
+
+					if (levelWords == 1)
+					{
+						break;
+					}
+
+					levelWords = (levelWords + 31) / 32;
+				}
+
+				// Allocate whole 64-bit words, since allocators may not support smaller blocks.
+				IAllocator *const allocator(AllocatorManager::Instance().GetAllocator());
+				u32 *const words(reinterpret_cast<u32 *>(allocator->Allocate(((numWords + 1) & ~1u) * sizeof(u32))));
+				if (words == 0)
+				{
+					return false;
+				}
+
+				// Copy the bottom level, adding the new indices, then rebuild the levels above.
+				for (u32 index = 0; index < numWords; ++index)
+				{
+					words[index] = 0;
+				}
+
+				const u32 oldWords((mNumBits + 31) / 32);
+				for (u32 index = 0; index < oldWords; ++index)
+				{
+					words[index] = mWords[index];
+				}
+
+				if (fill)
+				{
+					for (u32 bit = mNumBits; bit < numBits; ++bit)
+					{
+						words[bit >> 5] |= (1u << (bit & 31));
+					}
+				}
+
+				for (u32 level = 1; level < numLevels; ++level)
+				{
+					const u32 belowWords(levelOffsets[level] - levelOffsets[level - 1]);
+					for (u32 index = 0; index < belowWords; ++index)
+					{
+						if (words[levelOffsets[level - 1] + index] != 0)
+						{
+							words[levelOffsets[level] + (index >> 5)] |= (1u << (index & 31));
+						}
+					}
+				}
+
+				Release();
+
+				mWords = words;
+				mNumBits = numBits;
+				mNumLevels = numLevels;
+
+				for (u32 level = 0; level < numLevels; ++level)
+				{
+					mLevelOffsets[level] = levelOffsets[level];
+				}
+
+				return true;
+			}
+
+			/// Frees the masks, leaving the set empty and unable to hold any indices.
+			inline void Release()
+			{
+				if (mWords)
+				{
+					AllocatorManager::Instance().GetAllocator()->Free(mWords);
+				}
+
+				mWords = 0;
+				mNumBits = 0;
+				mNumLevels = 0;
+			}
+
+			/// Returns true if the set is empty.
+			XLANG_FORCEINLINE bool Empty() const
+			{
+				return (mNumLevels == 0 || mWords[mLevelOffsets[mNumLevels - 1]] == 0);
+			}
+
+			/// Returns true if the given index is in the set.
+			XLANG_FORCEINLINE bool Test(const u32 index) const
+			{
+				XLANG_ASSERT(index < mNumBits);
+				return (mWords[index >> 5] & (1u << (index & 31))) != 0;
+			}
+
+			/// Adds the given index to the set.
+			XLANG_FORCEINLINE void Set(const u32 index)
+			{
+				XLANG_ASSERT(index < mNumBits);
+
+				// Set the bit in each level until reaching a word that already had bits set.
+				u32 bit(index);
+				for (u32 level = 0; level < mNumLevels; ++level)
+				{
+					u32 &word(mWords[mLevelOffsets[level] + (bit >> 5)]);
+					const u32 previous(word);
+
+					word |= (1u << (bit & 31));
+					if (previous != 0)
+					{
+						break;
+					}
+
+					bit >>= 5;
+				}
+			}
+
+			/// Removes the given index from the set.
+			XLANG_FORCEINLINE void Clear(const u32 index)
+			{
+				XLANG_ASSERT(index < mNumBits);
+
+				// Clear the bit in each level until reaching a word that still has bits set.
+				u32 bit(index);
+				for (u32 level = 0; level < mNumLevels; ++level)
+				{
+					u32 &word(mWords[mLevelOffsets[level] + (bit >> 5)]);
+
+					word &= ~(1u << (bit & 31));
+					if (word != 0)
+					{
+						break;
+					}
+
+					bit >>= 5;
+				}
+			}
+
+			/// Returns the lowest index in the set, or NONE if it's empty.
+			XLANG_FORCEINLINE u32 FindFirst() const
+			{
+				if (Empty())
+				{
+					return NONE;
+				}
+
+				// Descend from the top level, following the lowest set bit of each word.
+				u32 index(0);
+				u32 level(mNumLevels);
+
+				while (level-- > 0)
+				{
+					index = (index << 5) + PageMaskBits::FindLowestSetBit(mWords[mLevelOffsets[level] + index]);
+				}
+
+				return index;
+			}
+
+			/// Returns the highest index in the set, or NONE if it's empty.
+			XLANG_FORCEINLINE u32 FindLast() const
+			{
+				if (Empty())
+				{
+					return NONE;
+				}
+
+				// Descend from the top level, following the highest set bit of each word.
+				u32 index(0);
+				u32 level(mNumLevels);
+
+				while (level-- > 0)
+				{
+					index = (index << 5) + PageMaskBits::FindHighestSetBit(mWords[mLevelOffsets[level] + index]);
+				}
+
+				return index;
+			}
+
+		private:
+
+			/// Maximum number of levels, enough for any 32-bit index.
+			static const u32 MAX_LEVELS = 7;
+
+			PageMask(const PageMask &other);
+			PageMask &operator=(const PageMask &other);
+
+			u32 *mWords;                        ///< Words of all the levels, starting with the bottom level.
+			u32 mNumBits;                       ///< Number of indices the set can hold.
+			u32 mNumLevels;                     ///< Number of levels, the top of which is a single word.
+			u32 mLevelOffsets[MAX_LEVELS];      ///< Offset of the first word of each level.
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_PAGEDPOOL_PAGEMASK_H
@@ -11,12 +11,15 @@
 #include "clang/private/Core/c_ActorDestroyer.h"
 #include "clang/private/Debug/c_Assert.h"
 #include "clang/private/Directory/c_Directory.h"
+#include "clang/private/MessageCache/c_MessageCache.h"
 #include "clang/private/Messages/c_IMessage.h"
 #include "clang/private/Messages/c_MessageCreator.h"
+#include "clang/private/Threading/c_Atomic.h"
 #include "clang/private/Threading/c_Lock.h"
 #include "clang/private/Threading/c_Thread.h"
 #include "clang/private/Threading/c_Monitor.h"
 #include "clang/private/ThreadPool/c_ThreadCollection.h"
+#include "clang/private/ThreadPool/c_WorkStealingQueue.h"
 
 #include "clang/c_Align.h"
 #include "clang/c_AllocatorManager.h"
@@ -28,10 +31,31 @@ namespace clang
 	namespace detail
 	{
 		/// A pool of worker threads.
+		/// Each worker thread owns a work-stealing queue of actors awaiting processing.
+		/// Actors scheduled by a worker thread, typically because one actor sent another a
+		/// message, are pushed onto that worker's own queue. Actors scheduled by other threads
+		/// go onto a shared injection queue. Workers that run out of work take actors from
+		/// the injection queue and then steal from the queues of other workers, starting at a
+		/// randomly chosen victim. Workers that find no work spin briefly, polling the queues, before
+		/// going to sleep, and threads that schedule actors don't wake sleeping workers while some
+		/// worker is spinning, since the spinning worker picks the actor up instead.
 		class ThreadPool
 		{
 		public:
 
+			/// Event counters maintained by the pool.
+			/// \note New counters only need adding here, and are updated with IncrementCounter.
+			enum Counter
+			{
+				COUNTER_MESSAGES_PROCESSED = 0,						///< Number of messages processed by referenced actors.
+				COUNTER_MESSAGE_BATCHES,							///< Number of batches of messages processed by referenced actors.
+				COUNTER_THREADS_PULSED,								///< Number of times a sleeping worker thread was signaled to wake.
+				COUNTER_THREADS_WOKEN,								///< Number of times a sleeping worker thread woke up.
+				COUNTER_ACTORS_STOLEN,								///< Number of actors taken from the queues of other workers.
+				COUNTER_SPINS_SUCCEEDED,							///< Number of times a spinning worker found work without sleeping.
+				MAX_COUNTERS
+			};
+
 			/// Worker thread entry point function.
 			/// Only global (static) functions can be used as thread entry points. Therefore this static method
 			/// exists to wrap the non-static class method that is the real entry point.
@@ -44,6 +68,9 @@ namespace clang
 			/// Constructor.
 			ThreadPool();
 
+			/// Destructor.
+			~ThreadPool();
+
 			/// Starts the pool, starting the given number of worker threads.
 			void			Start(u32 count, u32 target_count);
 
@@ -71,35 +98,111 @@ namespace clang
 			/// \note This includes any threads which were created but later terminated.
 			inline u32		GetPeakThreads() const;
 
-			/// Resets internal counters that track reported events for thread pool management.
-			inline void		ResetCounters() const;
+			/// Sets the maximum number of messages an actor processes each time it's scheduled.
+			/// \note Values of zero are treated as one.
+			inline void		SetMessageQuantum(const u32 count);
+
+			/// Returns the maximum number of messages an actor processes each time it's scheduled.
+			inline u32		GetMessageQuantum() const;
 
-			/// Returns the number of messages processed within this pool.
-			/// The count is incremented automatically and can be reset using ResetCounters.
-			inline u32		GetNumMessagesProcessed() const;
+			/// Sets the maximum number of times an idle worker thread polls for work before sleeping.
+			/// \note Zero disables spinning, so idle worker threads sleep straight away.
+			inline void		SetIdleSpinCount(const u32 count);
 
-			/// Returns the number of thread pulse events made in response to arriving messages.
-			/// The count is incremented automatically and can be reset using ResetCounters.
-			inline u32		GetNumThreadsPulsed() const;
+			/// Returns the maximum number of times an idle worker thread polls for work before sleeping.
+			inline u32		GetIdleSpinCount() const;
 
-			/// Returns the number of threads woken by pulse events in response to arriving messages.
-			/// The count is incremented automatically and can be reset using ResetCounters.
-			inline u32		GetNumThreadsWoken() const;
+			/// Resets internal counters that track reported events for thread pool management.
+			/// \note Counters are reset by remembering their current values, so resetting doesn't
+			/// interfere with the threads updating them.
+			inline void		ResetCounters() const;
 
-			/// Gets a reference to the core message processing mutex.
+			/// Returns the value of the given event counter since it was last reset.
+			/// The value is the sum of the per-worker counts, read without locking, so events
+			/// that happen during the call may or may not be included.
+			inline u64		GetCounterValue(const Counter counter) const;
+
+			/// Gets a reference to the mutex that protects the reference state of actors.
 			inline Mutex	&GetMutex() const;
 
-			/// Pushes an actor that has received a message onto the work queue for processing,
-			/// and wakes up a worker thread to process it if one is available.
+			/// Pushes an actor that has received a message onto a work queue for processing,
+			/// and wakes up a worker thread to process it if one is sleeping.
+			/// \note When called from one of the pool's own worker threads, the actor is pushed
+			/// onto that worker's queue; otherwise it's pushed onto the shared injection queue.
 			inline void		Push(ActorCore *const actor);
 
-			/// Pushes an actor that has received a message onto the work queue for processing,
+			/// Pushes an actor that has received a message onto a work queue for processing,
 			/// without waking up a worker thread. Instead the actor is processed by a running thread.
-			inline void		TailPush(ActorCore *const actor);
+			/// \return True if the actor was pushed, or false if it was already scheduled.
+			inline bool		TailPush(ActorCore *const actor);
+
+			/// Wakes up to the given number of sleeping worker threads, to process actors
+			/// that have been pushed without waking a worker thread.
+			inline void		Wake(const u32 count);
 
 		private:
 
 			typedef IntrusiveQueue<ActorCore> WorkQueue;
+			typedef WorkStealingQueue<ActorCore> LocalWorkQueue;
+
+			/// A set of 64-bit event counts, padded to occupy whole cache lines.
+			struct CounterSet
+			{
+				XLANG_FORCEINLINE CounterSet()
+				{
+					for (u32 index = 0; index < MAX_COUNTERS; ++index)
+					{
+						mValues[index] = 0;
+					}
+				}
+
+				volatile u64	mValues[MAX_COUNTERS];					///< Event counts, indexed by counter.
+				u8				mPadding[XLANG_CACHELINE_SIZE - (MAX_COUNTERS * sizeof(u64)) % XLANG_CACHELINE_SIZE];	///< Keeps other data off the last cache line.
+			};
+
+			/// Scheduling state owned by a single worker thread.
+			/// Workers are allocated on demand and recycled when threads are stopped and
+			/// restarted, but never freed while the pool is running, so that other workers can
+			/// safely try to steal from them at any time.
+			struct Worker
+			{
+				XLANG_FORCEINLINE Worker(ThreadPool *const threadPool, const u32 index)
+					: mQueue()
+					, mThreadPool(threadPool)
+					, mIndex(index)
+					, mRandom(index + 1)
+					, mTicks(0)
+					, mSpinCount(MIN_SPIN_COUNT)
+					, mActive(false)
+					, mCounters()
+					, mMessageCache()
+				{
+				}
+
+				LocalWorkQueue	mQueue;									///< Actors scheduled by this worker.
+				ThreadPool		*mThreadPool;							///< The pool that owns the worker.
+				u32				mIndex;									///< Index of the worker within the pool.
+				u32				mRandom;								///< State of the random generator used to pick steal victims.
+				u32				mTicks;									///< Counts work queue polls, for fairness with the injection queue.
+				u32				mSpinCount;								///< Current adaptive number of polls made before sleeping.
+				bool			mActive;								///< True while a thread is running the worker, protected by the manager lock.
+				u8				mPadding[XLANG_CACHELINE_SIZE];			///< Keeps thieves' reads of the queue off the counters.
+				CounterSet		mCounters;								///< Event counts, written only by the thread running the worker.
+				MessageCache::ThreadCache mMessageCache;				///< Message blocks cached by the thread running the worker.
+
+				XCORE_CLASS_PLACEMENT_NEW_DELETE
+			};
+
+			/// The local queue is polled first, except that the injection queue is polled
+			/// first once in every INJECTION_INTERVAL polls so injected actors can't be starved.
+			static const u32 INJECTION_INTERVAL = 32;
+
+			/// Idle workers always poll at least this many times before sleeping, unless spinning is
+			/// disabled, so that a worker whose spins have stopped finding work can adapt back up.
+			static const u32 MIN_SPIN_COUNT = 16;
+
+			/// The worker run by the calling thread, or null if it isn't a worker thread.
+			static XLANG_THREAD_LOCAL Worker *smCurrentWorker;
 
 			/// Clamps a given thread count to a legal range.
 			inline static u32 ClampThreadCount(const u32 count);
@@ -108,23 +211,73 @@ namespace clang
 			ThreadPool &operator=(const ThreadPool &other);
 
 			/// Worker thread function.
-			void			WorkerThreadProc();
+			void			WorkerThreadProc(Worker *const worker);
 
 			/// Manager thread function.
 			void			ManagerThreadProc();
 
-			/// Processes an actor core entry retrieved from the work queue.
-			inline void		ProcessActorCore(Lock &lock, ActorCore *const actorCore);
+			/// Returns an inactive worker for a new thread to run, allocating one if necessary.
+			/// \note Must be called with the manager lock held.
+			Worker			*AcquireWorker();
+
+			/// Returns the calling thread's worker, if it's a worker thread of this pool.
+			inline Worker	*GetCurrentWorker() const;
+
+			/// Pushes an actor onto the given worker's queue, or onto the injection queue if it's full.
+			inline void		PushLocal(Worker *const worker, ActorCore *const actorCore);
+
+			/// Pushes an actor onto the shared injection queue.
+			inline void		Inject(ActorCore *const actorCore);
+
+			/// Pops an actor from the shared injection queue, if any.
+			inline ActorCore *PopInjected();
+
+			/// Finds an actor for the given worker to process, or returns null if there is none.
+			inline ActorCore *FindWork(Worker *const worker);
+
+			/// Tries to steal an actor from the queue of another worker.
+			inline ActorCore *Steal(Worker *const worker);
+
+			/// Returns true if any work queue appears non-empty.
+			inline bool		HasWork() const;
+
+			/// Polls the work queues for a while before the given worker goes to sleep.
+			/// Returns true if work appeared, in which case the worker shouldn't sleep.
+			inline bool		Spin(Worker *const worker);
+
+			/// Wakes a sleeping worker thread, if there is one, to process newly queued work.
+			/// \param worker The calling thread's worker, or null if it isn't a worker thread.
+			inline void		WakeWorker(Worker *const worker);
+
+			/// Returns the total of an event counter over all threads, ignoring resets.
+			inline u64		GetCounterTotal(const Counter counter) const;
+
+			/// Adds to an event counter on behalf of the calling thread.
+			/// Worker threads update their own counters without atomic read-modify-write
+			/// operations, while other threads atomically update a set of shared counters.
+			/// \param worker The calling thread's worker, or null if it isn't a worker thread.
+			inline void		IncrementCounter(Worker *const worker, const Counter counter, const u32 value = 1) const;
+
+			/// Processes an actor core entry retrieved from a work queue.
+			inline void		ProcessActorCore(Worker *const worker, ActorCore *const actorCore);
 
 			// Accessed in the main loop.
 			u32				mNumThreads;							///< Counts the number of threads running.
 			u32				mTargetThreads;							///< The number of threads currently desired.
-			WorkQueue		mWorkQueue;								///< Threadsafe queue of actors waiting to be processed.
-			mutable Monitor	mWorkQueueMonitor;						///< Synchronizes access to the work queue.
+			mutable Mutex	mMutex;									///< Protects the reference state of actors.
+			mutable Mutex	mInjectionMutex;						///< Protects the injection queue.
+			WorkQueue		mInjectionQueue;						///< Actors scheduled by threads other than workers.
+			volatile u32	mNumInjected;							///< Number of actors in the injection queue, readable without the lock.
+			mutable Monitor	mWorkerMonitor;							///< Idle worker threads sleep on this.
+			volatile u32	mNumSleeping;							///< Number of worker threads sleeping or about to sleep, and not yet pulsed.
+			volatile u32	mNumSpinning;							///< Number of worker threads spinning while polling for work.
+			volatile u32	mIdleSpinCount;							///< Maximum number of polls idle workers make before sleeping.
+			volatile u32	mNumWorkers;							///< Number of allocated workers, which may be stolen from.
+			Worker			*mWorkers[XLANG_MAX_THREADS_PER_FRAMEWORK];	///< Allocated workers, indexed by worker index.
 			mutable Monitor	mManagerMonitor;						///< Locking event that wakes the manager thread.
-			mutable u32		mNumMessagesProcessed;					///< Counter used to count processed messages.
-			mutable u32		mNumThreadsPulsed;						///< Counts the number of times we signaled a worker thread to wake.
-			mutable u32		mNumThreadsWoken;						///< Counter used to count woken threads.
+			volatile u32	mMessageQuantum;						///< Maximum number of messages processed per actor activation.
+			mutable CounterSet mSharedCounters;						///< Event counts of threads other than workers, updated atomically.
+			mutable CounterSet mCounterBase;						///< Counter totals at the time of the last reset.
 
 			// Accessed infrequently.
 			ThreadCollection mWorkerThreads;						///< Owned collection of worker threads.
@@ -184,52 +337,81 @@ namespace clang
 		}
 
 
-		XLANG_FORCEINLINE void ThreadPool::ResetCounters() const
+		XLANG_FORCEINLINE void ThreadPool::SetMessageQuantum(const u32 count)
 		{
-			Lock lock(mWorkQueueMonitor.GetMutex());
+			Atomic::Store(&mMessageQuantum, count > 0 ? count : 1);
+		}
+
 
-			mNumMessagesProcessed = 0;
-			mNumThreadsPulsed = 0;
-			mNumThreadsWoken = 0;
+		XLANG_FORCEINLINE u32 ThreadPool::GetMessageQuantum() const
+		{
+			return Atomic::Load(&mMessageQuantum);
 		}
 
 
-		XLANG_FORCEINLINE u32 ThreadPool::GetNumMessagesProcessed() const
+		XLANG_FORCEINLINE void ThreadPool::SetIdleSpinCount(const u32 count)
 		{
-			u32 count(0);
+			Atomic::Store(&mIdleSpinCount, count);
+		}
+
 
+		XLANG_FORCEINLINE u32 ThreadPool::GetIdleSpinCount() const
+		{
+			return Atomic::Load(&mIdleSpinCount);
+		}
+
+
+		XLANG_FORCEINLINE void ThreadPool::ResetCounters() const
+		{
+			// The worker threads own their counters, so rather than zeroing them we remember
+			// the current totals and subtract them from the values read later.
+			for (u32 index = 0; index < MAX_COUNTERS; ++index)
 			{
-				Lock lock(mWorkQueueMonitor.GetMutex());
-				count = mNumMessagesProcessed;
+				const Counter counter(static_cast<Counter>(index));
+				Atomic::Store(&mCounterBase.mValues[counter], GetCounterTotal(counter));
 			}
+		}
 
-			return count;
+
+		XLANG_FORCEINLINE u64 ThreadPool::GetCounterValue(const Counter counter) const
+		{
+			XLANG_ASSERT(counter < MAX_COUNTERS);
+
+			// A concurrent reset may store a base read after our total.
+			const u64 total(GetCounterTotal(counter));
+			const u64 base(Atomic::Load(&mCounterBase.mValues[counter]));
+			return (total > base) ? total - base : 0;
 		}
 
 
-		XLANG_FORCEINLINE u32 ThreadPool::GetNumThreadsPulsed() const
+		XLANG_FORCEINLINE u64 ThreadPool::GetCounterTotal(const Counter counter) const
 		{
-			u32 count(0);
+			u64 total(Atomic::Load(&mSharedCounters.mValues[counter]));
 
+			// Workers are never freed while the pool exists, so we can read them without locking.
+			const u32 numWorkers(Atomic::Load(&mNumWorkers));
+			for (u32 index = 0; index < numWorkers; ++index)
 			{
-				Lock lock(mWorkQueueMonitor.GetMutex());
-				count = mNumThreadsPulsed;
+				total += Atomic::Load(&Atomic::Load(&mWorkers[index])->mCounters.mValues[counter]);
 			}
 
-			return count;
+			return total;
 		}
 
 
-		XLANG_FORCEINLINE u32 ThreadPool::GetNumThreadsWoken() const
+		XLANG_FORCEINLINE void ThreadPool::IncrementCounter(Worker *const worker, const Counter counter, const u32 value) const
 		{
-			u32 count(0);
-
+			if (worker)
 			{
-				Lock lock(mWorkQueueMonitor.GetMutex());
-				count = mNumThreadsWoken;
+				// Only the worker's own thread writes its counters, so a plain add is safe.
+				// The atomic load and store just stop readers seeing torn 64-bit values.
+				volatile u64 *const word(&worker->mCounters.mValues[counter]);
+				Atomic::Store(word, Atomic::Load(word) + value);
+			}
+			else
+			{
+				Atomic::Add(&mSharedCounters.mValues[counter], value);
 			}
-
-			return count;
 		}
 
 
@@ -251,117 +433,421 @@ namespace clang
 
 		XLANG_FORCEINLINE Mutex &ThreadPool::GetMutex() const
 		{
-			return mWorkQueueMonitor.GetMutex();
+			return mMutex;
 		}
 
 
 		XLANG_FORCEINLINE void ThreadPool::Push(ActorCore *const actorCore)
 		{
-			// Don't schedule ourselves if the actor is already scheduled or running.
-			// Actors which need further processing at the end of their current
-			// processing, are marked dirty, and will be rescheduled when executed.
-			if (actorCore->IsScheduled())
+			// Mark the actor as scheduled. If it's already scheduled or running then the
+			// worker processing it sees the notification and processes it again.
+			if (!actorCore->Schedule())
 			{
-				// Flag the actor as dirty so it will be re-scheduled after execution.
-				actorCore->Dirty();
 				return;
 			}
 
-			// Mark the actor as busy.
-			actorCore->Schedule();
-
-			// Push the actor onto the work queue and wake a worker thread.
-			mWorkQueue.Push(actorCore);
+			// Push the actor onto the calling worker's own queue, if we're running in a worker thread.
+			if (Worker *const worker = GetCurrentWorker())
+			{
+				PushLocal(worker, actorCore);
+			}
+			else
+			{
+				Inject(actorCore);
+			}
 
 			// Wake up a worker thread.
-			mWorkQueueMonitor.Pulse();
-			++mNumThreadsPulsed;
+			WakeWorker(GetCurrentWorker());
 		}
 
 
-		XLANG_FORCEINLINE void ThreadPool::TailPush(ActorCore *const actorCore)
+		XLANG_FORCEINLINE bool ThreadPool::TailPush(ActorCore *const actorCore)
 		{
-			// Don't schedule ourselves if the actor is already scheduled or running.
-			// Actors which need further processing at the end of their current
-			// processing, are marked dirty, and will be rescheduled when executed.
-			if (actorCore->IsScheduled())
+			// Mark the actor as scheduled. If it's already scheduled or running then the
+			// worker processing it sees the notification and processes it again.
+			if (!actorCore->Schedule())
+			{
+				return false;
+			}
+
+			// Push the actor onto a work queue without waking a worker thread.
+			if (Worker *const worker = GetCurrentWorker())
+			{
+				PushLocal(worker, actorCore);
+			}
+			else
+			{
+				Inject(actorCore);
+			}
+
+			return true;
+		}
+
+
+		XLANG_FORCEINLINE void ThreadPool::Wake(const u32 count)
+		{
+			Worker *const worker(GetCurrentWorker());
+
+			// As in WakeWorker, spinning workers are sure to see the pushed actors.
+			Atomic::Fence();
+			if (Atomic::Load(&mNumSpinning) != 0)
 			{
-				// Flag the actor as dirty so it will be re-scheduled after execution.
-				actorCore->Dirty();
 				return;
 			}
 
-			// Mark the actor as busy.
-			actorCore->Schedule();
+			// Pulse as many sleepers as there are actors to process, under a single lock.
+			if (Atomic::Load(&mNumSleeping) != 0)
+			{
+				u32 numPulses(0);
+
+				{
+					Lock lock(mWorkerMonitor.GetMutex());
+
+					// Sleepers already pulsed have been taken off the count, so aren't pulsed again.
+					const u32 numSleeping(Atomic::Load(&mNumSleeping));
+					numPulses = (count < numSleeping ? count : numSleeping);
 
-			// Push the actor onto the work queue without waking a worker thread.
-			mWorkQueue.Push(actorCore);
+					Atomic::Store(&mNumSleeping, numSleeping - numPulses);
+					for (u32 index = 0; index < numPulses; ++index)
+					{
+						mWorkerMonitor.Pulse();
+					}
+				}
+
+				if (numPulses != 0)
+				{
+					IncrementCounter(worker, COUNTER_THREADS_PULSED, numPulses);
+				}
+			}
 		}
 
 
-		XLANG_FORCEINLINE void ThreadPool::ProcessActorCore(Lock &lock, ActorCore *const actorCore)
+		XLANG_FORCEINLINE ThreadPool::Worker *ThreadPool::GetCurrentWorker() const
 		{
-			// Read an unprocessed message from the actor's message queue.
-			// If there are no queued messages the returned pointer is null.
-			IMessage *const message(actorCore->GetQueuedMessage());
+			// Worker threads of other frameworks have to use our injection queue.
+			Worker *const worker(smCurrentWorker);
+			if (worker && worker->mThreadPool == this)
+			{
+				return worker;
+			}
 
-			// We have to hold the lock while we check the referenced state, to make sure a
-			// dereferencing ActorRef that decremented the reference count has finished accessing
-			// it before we free it, in the case where the actor has become unreferenced.
-			const bool referenced(actorCore->IsReferenced());
+			return 0;
+		}
+
+
+		XLANG_FORCEINLINE void ThreadPool::PushLocal(Worker *const worker, ActorCore *const actorCore)
+		{
+			if (!worker->mQueue.Push(actorCore))
+			{
+				// Overflow into the injection queue, which is unbounded.
+				Inject(actorCore);
+			}
+		}
 
-			// Increment the message processing counter if we'll process a message.
-			// We do this while still holding the lock to ensure the counter can't be cleared
-			// just before we increment it. We exploit the fact that bools are 0 or 1 to avoid branches.
-			const u32 messageValid(message != 0);
-			const u32 actorReferenced(referenced);
-			mNumMessagesProcessed += (messageValid & actorReferenced);
 
-			lock.Unlock();
+		XLANG_FORCEINLINE void ThreadPool::Inject(ActorCore *const actorCore)
+		{
+			Lock lock(mInjectionMutex);
+			mInjectionQueue.Push(actorCore);
+			Atomic::Increment(&mNumInjected);
+		}
 
-			// An actor is still 'live' if it has unprocessed messages or is still referenced.
-			const bool live((message != 0) | referenced);
-			if (live)
+
+		XLANG_FORCEINLINE ActorCore *ThreadPool::PopInjected()
+		{
+			// Avoid taking the lock in the common case where the queue is empty.
+			if (Atomic::Load(&mNumInjected) == 0)
+			{
+				return 0;
+			}
+
+			Lock lock(mInjectionMutex);
+			ActorCore *const actorCore(mInjectionQueue.Pop());
+			if (actorCore)
+			{
+				Atomic::Decrement(&mNumInjected);
+			}
+
+			return actorCore;
+		}
+
+
+		XLANG_FORCEINLINE ActorCore *ThreadPool::FindWork(Worker *const worker)
+		{
+			ActorCore *actorCore(0);
+
+			// Occasionally look at the injection queue first, in case the local queue never empties.
+			if ((++worker->mTicks & (INJECTION_INTERVAL - 1)) == 0)
+			{
+				actorCore = PopInjected();
+			}
+
+			if (actorCore == 0)
+			{
+				actorCore = worker->mQueue.Pop();
+			}
+
+			if (actorCore == 0)
+			{
+				actorCore = PopInjected();
+			}
+
+			if (actorCore == 0)
+			{
+				actorCore = Steal(worker);
+				if (actorCore)
+				{
+					IncrementCounter(worker, COUNTER_ACTORS_STOLEN);
+				}
+			}
+
+			return actorCore;
+		}
+
+
+		XLANG_FORCEINLINE ActorCore *ThreadPool::Steal(Worker *const worker)
+		{
+			const u32 numWorkers(Atomic::Load(&mNumWorkers));
+			if (numWorkers < 2)
+			{
+				return 0;
+			}
+
+			// Start at a random victim so that thieves spread themselves over the workers.
+			u32 random(worker->mRandom);
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			worker->mRandom = random;
+
+			u32 index(random % numWorkers);
+			for (u32 count = 0; count < numWorkers; ++count)
 			{
-				// If the actor has a waiting message then process the message, even if the
-				// actor is no longer referenced. This ensures messages send to actors just
-				// before they become unreferenced are correctly processed.
-				if (message)
+				Worker *const victim(Atomic::Load(&mWorkers[index]));
+				if (victim != worker)
 				{
-					// Update the actor's message handlers and handle the message.
-					actorCore->ValidateHandlers();
-					actorCore->ProcessMessage(message);
-
-					// Destroy the message now it's been read.
-					// The directory lock is used to protect the global free list.
-					Lock directoryLock(Directory::GetMutex());
-					MessageCreator::Destroy(message);
+					if (ActorCore *const actorCore = victim->mQueue.Pop())
+					{
+						return actorCore;
+					}
+				}
+
+				if (++index == numWorkers)
+				{
+					index = 0;
+				}
+			}
+
+			return 0;
+		}
+
+
+		XLANG_FORCEINLINE bool ThreadPool::HasWork() const
+		{
+			if (Atomic::Load(&mNumInjected) != 0)
+			{
+				return true;
+			}
+
+			const u32 numWorkers(Atomic::Load(&mNumWorkers));
+			for (u32 index = 0; index < numWorkers; ++index)
+			{
+				if (!Atomic::Load(&mWorkers[index])->mQueue.Empty())
+				{
+					return true;
 				}
 			}
+
+			return false;
+		}
+
+
+		XLANG_FORCEINLINE bool ThreadPool::Spin(Worker *const worker)
+		{
+			const u32 maxSpinCount(Atomic::Load(&mIdleSpinCount));
+			if (maxSpinCount == 0)
+			{
+				return false;
+			}
+
+			u32 spinCount(worker->mSpinCount);
+			if (spinCount > maxSpinCount)
+			{
+				spinCount = maxSpinCount;
+			}
+
+			// Announce that we're spinning, so that threads scheduling work don't wake sleepers.
+			Atomic::Increment(&mNumSpinning);
+
+			bool found(false);
+			for (u32 count = 0; count < spinCount; ++count)
+			{
+				// Stop spinning if we're told to stop the thread, so it isn't delayed.
+				if (mNumThreads > mTargetThreads)
+				{
+					break;
+				}
+
+				Atomic::Pause();
+
+				if (HasWork())
+				{
+					found = true;
+					break;
+				}
+			}
+
+			// Look for work once more after we stop announcing that we're spinning.
+			// A thread that saw us spinning, and so didn't wake anyone, pushed its work
+			// before that, so we're sure to see it here.
+			Atomic::Decrement(&mNumSpinning);
+			if (!found)
+			{
+				found = HasWork();
+			}
+
+			// Spin for longer next time if spinning paid off, and for less time if it didn't.
+			if (found)
+			{
+				IncrementCounter(worker, COUNTER_SPINS_SUCCEEDED);
+				spinCount = (spinCount < maxSpinCount / 2) ? spinCount * 2 : maxSpinCount;
+			}
 			else
 			{
+				spinCount = (spinCount / 2 > MIN_SPIN_COUNT) ? spinCount / 2 : MIN_SPIN_COUNT;
+			}
+
+			worker->mSpinCount = spinCount;
+			return found;
+		}
+
+
+		XLANG_FORCEINLINE void ThreadPool::WakeWorker(Worker *const worker)
+		{
+			// The fence orders our push before the reads of the spinner and sleeper counts.
+			// A spinning worker looks for work again when it stops spinning, so if one is
+			// spinning it's sure to see our work and there's no need to wake anyone.
+			Atomic::Fence();
+			if (Atomic::Load(&mNumSpinning) != 0)
+			{
+				return;
+			}
+
+			// A worker going to sleep increments the count before looking for work one
+			// last time, so either it sees our work or we see it, and pulse it.
+			// The count only includes sleepers that haven't been pulsed yet, so a sleeper
+			// that has been pulsed but is still waking isn't pulsed again by later sends.
+			if (Atomic::Load(&mNumSleeping) != 0)
+			{
+				bool pulsed(false);
+
+				{
+					Lock lock(mWorkerMonitor.GetMutex());
+
+					// Another thread may have pulsed the last sleeper since we looked.
+					if (Atomic::Load(&mNumSleeping) != 0)
+					{
+						Atomic::Decrement(&mNumSleeping);
+						mWorkerMonitor.Pulse();
+						pulsed = true;
+					}
+				}
+
+				if (pulsed)
+				{
+					IncrementCounter(worker, COUNTER_THREADS_PULSED);
+				}
+			}
+		}
+
+
+		XLANG_FORCEINLINE void ThreadPool::ProcessActorCore(Worker *const worker, ActorCore *const actorCore)
+		{
+			// Consume any notifications before reading the queue, so that any message pushed
+			// after we've looked is followed by a notification that we see when we unschedule.
+			actorCore->BeginProcessing();
+
+			// Read an unprocessed message from the actor's message queue.
+			// If there are no queued messages the returned pointer is null.
+			// We're the only thread processing the actor so we can read its queue without locking.
+			IMessage *const message(actorCore->GetQueuedMessage());
+			const bool referenced(actorCore->IsReferenced());
+
+			// An actor is still 'live' if it has unprocessed messages or is still referenced.
+			const bool live((message != 0) | referenced);
+			if (!live)
+			{
+				// Make sure a dereferencing ActorRef that decremented the reference count
+				// has finished accessing the actor before we free it.
+				{
+					Lock lock(mMutex);
+				}
+
 				// Garbage collect the unreferenced actor.
 				// This also frees any messages still in its queue.
+				// The actor stays marked as scheduled so it can't be pushed onto a work queue again.
 				ActorDestroyer::DestroyActor(actorCore);
+				return;
 			}
 
-			lock.Relock();
-
-			if (live)
+			// If the actor has waiting messages then process them, even if the actor is no
+			// longer referenced. This ensures messages send to actors just before they become
+			// unreferenced are correctly processed.
+			if (message)
 			{
-				// Re-add the actor to the work queue if it still needs more processing,
-				// including if it's unreferenced and we haven't destroyed it yet.
-				if (actorCore->IsDirty() | actorCore->HasQueuedMessage() | !referenced)
+				// Like messages, batches are only counted for referenced actors.
+				IncrementCounter(worker, COUNTER_MESSAGE_BATCHES, static_cast<u32>(referenced));
+
+				// Update the actor's message handlers once for the whole batch.
+				actorCore->ValidateHandlers();
+
+				// Process up to a quantum of messages before moving on to other actors,
+				// so the scheduling costs are shared by all the messages in the batch.
+				const u32 quantum(Atomic::Load(&mMessageQuantum));
+				IMessage *nextMessage(message);
+				u32 count(0);
+
+				while (nextMessage)
 				{
-					actorCore->CleanAndSchedule();
-					mWorkQueue.Push(actorCore);
-					return;
+					// Increment the message processing counter. We exploit the fact that bools are 0 or 1 to avoid a branch.
+					IncrementCounter(worker, COUNTER_MESSAGES_PROCESSED, static_cast<u32>(referenced));
+					actorCore->ProcessMessage(nextMessage);
+
+					// Destroy the message now it's been read, unless a handler forwarded it, in which
+					// case its new recipient destroys it instead.
+					// The block goes back to this worker's own message cache, without locking.
+					if (actorCore->IsMessageForwarded())
+					{
+						actorCore->ForwardMessage(nextMessage);
+					}
+					else
+					{
+						MessageCreator::Destroy(nextMessage);
+					}
+
+					// End the batch early if the handler changed the actor's handlers, so that
+					// the next message is handled by the new handlers after they're validated.
+					if (++count == quantum || actorCore->AreHandlersDirty())
+					{
+						break;
+					}
+
+					nextMessage = actorCore->GetQueuedMessage();
 				}
-				else
+			}
+
+			// Re-add the actor to our own work queue if it still needs more processing,
+			// including if it has messages left over from the batch, if it's unreferenced
+			// and we haven't destroyed it yet, or if it was notified while we were processing it.
+			if (!actorCore->HasQueuedMessage() && actorCore->IsReferenced())
+			{
+				if (actorCore->Unschedule())
 				{
-					actorCore->CleanAndUnschedule();
+					return;
 				}
 			}
+
+			PushLocal(worker, actorCore);
 		}
 
 
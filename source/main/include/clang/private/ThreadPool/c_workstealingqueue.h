@@ -0,0 +1,145 @@
+#ifndef __XLANG_PRIVATE_THREADPOOL_WORKSTEALINGQUEUE_H
+#define __XLANG_PRIVATE_THREADPOOL_WORKSTEALINGQUEUE_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE 
+#pragma once 
+#endif
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/c_Atomic.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Bounded lock-free work queue owned by a single worker thread, from which other
+		/// worker threads can steal.
+		/// Based on the circular deque of Chase and Lev. Only the owning thread may Push, and
+		/// does so without any atomic read-modify-write. Items are removed from the front by
+		/// Pop, which any thread (the owner included) may call, and which claims an item
+		/// with a single compare-and-swap on the front index.
+		/// \note The owner pops from the front rather than the back, so that actors are
+		/// processed in the order they were scheduled. This keeps an actor that repeatedly
+		/// reschedules itself from starving the other actors queued behind it.
+		/// \tparam ItemType The type of item queued, which is stored by pointer.
+		template <class ItemType>
+		class WorkStealingQueue
+		{
+		public:
+
+			/// Maximum number of items held at once. Must be a power of two.
+			static const u32 CAPACITY = 256;
+
+			/// Constructor.
+			inline WorkStealingQueue();
+
+			/// Returns true if the queue appeared empty at the time of the call.
+			/// \note The result is only a snapshot if other threads are accessing the queue.
+			inline bool Empty() const;
+
+			/// Pushes an item onto the back of the queue.
+			/// \note Only the owning thread may call this method.
+			/// \return False, if the queue is full, in which case the item isn't queued.
+			inline bool Push(ItemType *const item);
+
+			/// Removes and returns the item at the front of the queue, or null if the queue is empty.
+			/// Can be called by any thread.
+			inline ItemType *Pop();
+
+		private:
+
+			WorkStealingQueue(const WorkStealingQueue &other);
+			WorkStealingQueue &operator=(const WorkStealingQueue &other);
+
+			volatile u32		mFront;												///< Index of the front item, advanced by Pop.
+			u8					mFrontPadding[XLANG_CACHELINE_SIZE - sizeof(u32)];	///< Keeps thieves' writes off the owner's cache line.
+			volatile u32		mBack;												///< Index one past the back item, written only by the owner.
+			u8					mBackPadding[XLANG_CACHELINE_SIZE - sizeof(u32)];	///< Keeps the owner's writes off the items.
+			ItemType *volatile	mItems[CAPACITY];									///< Circular buffer of queued items.
+		};
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE WorkStealingQueue<ItemType>::WorkStealingQueue()
+			: mFront(0)
+			, mBack(0)
+		{
+			for (u32 index = 0; index < CAPACITY; ++index)
+			{
+				mItems[index] = 0;
+			}
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE bool WorkStealingQueue<ItemType>::Empty() const
+		{
+			const u32 front(Atomic::Load(&mFront));
+			const u32 back(Atomic::Load(&mBack));
+
+			// Indices wrap around, so compare their signed difference.
+			return (static_cast<s32>(back - front) <= 0);
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE bool WorkStealingQueue<ItemType>::Push(ItemType *const item)
+		{
+			XLANG_ASSERT(item);
+
+			// The back index is only written by this thread so can't change underneath us.
+			// The front index may be advanced by other threads at any time, but only towards
+			// the back, so a stale value just makes the queue look fuller than it is.
+			const u32 back(mBack);
+			const u32 front(Atomic::Load(&mFront));
+
+			if (back - front >= CAPACITY)
+			{
+				return false;
+			}
+
+			// Write the item before publishing the new back index, so that a thread which
+			// sees the new index is guaranteed to see the item too.
+			Atomic::Store(&mItems[back & (CAPACITY - 1)], item);
+			Atomic::Store(&mBack, back + 1);
+
+			return true;
+		}
+
+
+		template <class ItemType>
+		XLANG_FORCEINLINE ItemType *WorkStealingQueue<ItemType>::Pop()
+		{
+			while (true)
+			{
+				const u32 front(Atomic::Load(&mFront));
+				const u32 back(Atomic::Load(&mBack));
+
+				if (static_cast<s32>(back - front) <= 0)
+				{
+					return 0;
+				}
+
+				// Read the item before claiming it. Once the front index moves past it the
+				// owner is free to overwrite the slot with a new item.
+				ItemType *const item(Atomic::Load(&mItems[front & (CAPACITY - 1)]));
+
+				// Claim the item by advancing the front index. If another thread got there
+				// first then the item is theirs, and we retry with the new front item.
+				if (Atomic::CompareExchange(&mFront, front, front + 1))
+				{
+					return item;
+				}
+			}
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADPOOL_WORKSTEALINGQUEUE_H
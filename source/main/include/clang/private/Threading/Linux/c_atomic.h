@@ -0,0 +1,140 @@
+#ifndef __XLANG_PRIVATE_THREADING_LINUX_ATOMIC_H
+#define __XLANG_PRIVATE_THREADING_LINUX_ATOMIC_H
+
+#include "clang/private/c_BasicTypes.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Atomic operations on naturally aligned words, implemented with the gcc/clang __atomic builtins.
+		/// Loads have acquire semantics, stores have release semantics, and read-modify-write
+		/// operations are sequentially consistent.
+		class Atomic
+		{
+		public:
+
+			/// Atomically reads a value, with acquire semantics.
+			XLANG_FORCEINLINE static u32 Load(const volatile u32 *const word)
+			{
+				return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+			}
+
+			/// Atomically writes a value, with release semantics.
+			XLANG_FORCEINLINE static void Store(volatile u32 *const word, const u32 value)
+			{
+				__atomic_store_n(word, value, __ATOMIC_RELEASE);
+			}
+
+			/// Atomically replaces a value, returning the previous value.
+			XLANG_FORCEINLINE static u32 Exchange(volatile u32 *const word, const u32 value)
+			{
+				return __atomic_exchange_n(word, value, __ATOMIC_SEQ_CST);
+			}
+
+			/// Replaces the value with the desired value if it holds the expected value.
+			/// \return True, if the value was replaced.
+			XLANG_FORCEINLINE static bool CompareExchange(volatile u32 *const word, const u32 expected, const u32 desired)
+			{
+				u32 value(expected);
+				return __atomic_compare_exchange_n(word, &value, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+			}
+
+			/// Atomically adds to a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Add(volatile u32 *const word, const u32 value)
+			{
+				return __atomic_add_fetch(word, value, __ATOMIC_SEQ_CST);
+			}
+
+			/// Atomically increments a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Increment(volatile u32 *const word)
+			{
+				return __atomic_add_fetch(word, 1, __ATOMIC_SEQ_CST);
+			}
+
+			/// Atomically decrements a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Decrement(volatile u32 *const word)
+			{
+				return __atomic_sub_fetch(word, 1, __ATOMIC_SEQ_CST);
+			}
+
+			/// Atomically reads a 64-bit value, with acquire semantics.
+			XLANG_FORCEINLINE static u64 Load(const volatile u64 *const word)
+			{
+				return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+			}
+
+			/// Atomically writes a 64-bit value, with release semantics.
+			XLANG_FORCEINLINE static void Store(volatile u64 *const word, const u64 value)
+			{
+				__atomic_store_n(word, value, __ATOMIC_RELEASE);
+			}
+
+			/// Atomically adds to a 64-bit value, returning the new value.
+			XLANG_FORCEINLINE static u64 Add(volatile u64 *const word, const u64 value)
+			{
+				return __atomic_add_fetch(word, value, __ATOMIC_SEQ_CST);
+			}
+
+			/// Atomically reads a pointer, with acquire semantics.
+			template <class ItemType>
+			XLANG_FORCEINLINE static ItemType *Load(ItemType *const volatile *const word)
+			{
+				return __atomic_load_n(word, __ATOMIC_ACQUIRE);
+			}
+
+			/// Atomically writes a pointer, with release semantics.
+			template <class ItemType>
+			XLANG_FORCEINLINE static void Store(ItemType *volatile *const word, ItemType *const value)
+			{
+				__atomic_store_n(word, value, __ATOMIC_RELEASE);
+			}
+
+			/// Atomically replaces a pointer, returning the previous pointer.
+			template <class ItemType>
+			XLANG_FORCEINLINE static ItemType *Exchange(ItemType *volatile *const word, ItemType *const value)
+			{
+				return __atomic_exchange_n(word, value, __ATOMIC_SEQ_CST);
+			}
+
+			/// Replaces the pointer with the desired pointer if it holds the expected pointer.
+			/// \return True, if the pointer was replaced.
+			template <class ItemType>
+			XLANG_FORCEINLINE static bool CompareExchange(ItemType *volatile *const word, ItemType *const expected, ItemType *const desired)
+			{
+				ItemType *value(expected);
+				return __atomic_compare_exchange_n(word, &value, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+			}
+
+			/// Full memory barrier. No loads or stores are reordered across it.
+			XLANG_FORCEINLINE static void Fence()
+			{
+				__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			}
+
+			/// Hints to the processor that the calling thread is spinning in a wait loop.
+			XLANG_FORCEINLINE static void Pause()
+			{
+#if defined(__i386__) || defined(__x86_64__)
+				__builtin_ia32_pause();
+#elif defined(__aarch64__)
+				__asm__ __volatile__("yield");
+#endif
+			}
+
+		private:
+
+			Atomic();
+			Atomic(const Atomic &other);
+			Atomic &operator=(const Atomic &other);
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_LINUX_ATOMIC_H
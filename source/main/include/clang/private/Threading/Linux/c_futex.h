@@ -0,0 +1,63 @@
+#ifndef __XLANG_PRIVATE_THREADING_LINUX_FUTEX_H
+#define __XLANG_PRIVATE_THREADING_LINUX_FUTEX_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "clang/private/c_BasicTypes.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Thin wrapper around the Linux futex system call.
+		/// A futex is a 32-bit word in user memory on which threads can sleep in the kernel,
+		/// and be woken by other threads. The kernel only ever looks at the word when a thread
+		/// goes to sleep, so the uncontended paths of the primitives built on it never leave user space.
+		class Futex
+		{
+		public:
+
+			/// Puts the calling thread to sleep, as long as the word still holds the expected value.
+			/// Returns immediately if the value has already changed. May also return spuriously.
+			XLANG_FORCEINLINE static void Wait(volatile u32 *const word, const u32 expected)
+			{
+				syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+			}
+
+			/// Wakes at most the given number of threads sleeping on the word.
+			XLANG_FORCEINLINE static void Wake(volatile u32 *const word, const u32 count)
+			{
+				syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+			}
+
+			/// Returns the kernel id of the calling thread, cached per thread.
+			/// Thread ids are never zero, so zero can be used to mean 'no thread'.
+			XLANG_FORCEINLINE static u32 CurrentThreadId()
+			{
+				static __thread u32 sThreadId = 0;
+				if (sThreadId == 0)
+				{
+					sThreadId = static_cast<u32>(syscall(SYS_gettid));
+				}
+
+				return sThreadId;
+			}
+
+		private:
+
+			Futex();
+			Futex(const Futex &other);
+			Futex &operator=(const Futex &other);
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_LINUX_FUTEX_H
@@ -0,0 +1,144 @@
+#ifndef __XLANG_PRIVATE_THREADING_LINUX_MONITOR_H
+#define __XLANG_PRIVATE_THREADING_LINUX_MONITOR_H
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/Linux/c_Futex.h"
+#include "clang/private/Threading/Linux/c_Lock.h"
+#include "clang/private/Threading/Linux/c_Mutex.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Implements a monitor/condition object using a Linux futex.
+		/// The monitor essentially ties a futex word to a mutex, allowing a
+		/// thread to Wait until it is Pulsed when the mutex becomes available.
+		/// Each pulse hands out a wake token, counted under the mutex, and advances a sequence
+		/// number used as the futex word so that a waiting thread can't sleep through it.
+		/// A thread returns from Wait only once it has taken a token, so a single pulse never
+		/// releases more than one waiter, however the futex wakes fall.
+		class Monitor
+		{
+		public:
+
+			/// Default constructor
+			inline Monitor();
+
+			/// Destructor
+			/// \note If the monitor is destroyed while threads are still waiting on it, the result is undefined.
+			inline ~Monitor();
+
+			/// Returns a reference to the Mutex owned by the monitor.
+			XLANG_FORCEINLINE Mutex &GetMutex()
+			{
+				return mMutex;
+			}
+
+			/// Waits for the monitor to be pulsed via Pulse or PulseAll.
+			/// The calling thread should hold a lock on the mutex.
+			/// The calling thread is blocked until another thread wakes it.
+			/// The lock owned by the caller is released, and regained when the thread is woken.
+			/// \note As with any condition variable, callers should re-check their wait condition on return.
+			inline void Wait(Lock &lock);
+
+			/// Pulses the monitor, waking a single waiting thread.
+			/// \note
+			/// The calling thread should own a lock on the mutex. When the calling thread
+			/// releases the lock, a woken thread aquires the lock and proceeds.
+			inline void Pulse();
+
+			/// Pulses the monitor, waking all waiting threads.
+			/// \note
+			/// The calling thread should own the lock on the mutex. When the calling thread
+			/// releases the lock, a woken thread aquires the lock and proceeds.
+			inline void PulseAll();
+
+		private:
+
+			Monitor(const Monitor &other);
+			Monitor &operator=(const Monitor &other);
+
+			Mutex mMutex;					///< A futex-based mutex used to guarantee exclusive access.
+			volatile u32 mSequence;			///< Futex word advanced by each pulse.
+			u32 mNumWaiting;				///< Number of threads in Wait not yet pulsed, protected by the mutex.
+			u32 mNumTokens;					///< Number of pulses not yet taken by a waiting thread, protected by the mutex.
+		};
+
+
+		XLANG_FORCEINLINE Monitor::Monitor()
+			: mMutex()
+			, mSequence(0)
+			, mNumWaiting(0)
+			, mNumTokens(0)
+		{
+		}
+
+
+		XLANG_FORCEINLINE Monitor::~Monitor()
+		{
+			XLANG_ASSERT(mNumWaiting == 0 && mNumTokens == 0);
+		}
+
+
+		XLANG_FORCEINLINE void Monitor::Wait(Lock &lock)
+		{
+			++mNumWaiting;
+
+			// Sleep until a pulse leaves a token for us. The sequence number is sampled
+			// while we still hold the lock, and pulses are issued under the same lock, so
+			// any pulse made after we release it changes the futex word and stops us from
+			// sleeping through it. A futex wake that finds no token left, because another
+			// waiter took it, just sends us back to sleep.
+			while (true)
+			{
+				const u32 sequence(__atomic_load_n(&mSequence, __ATOMIC_RELAXED));
+
+				lock.Unlock();
+				Futex::Wait(&mSequence, sequence);
+				lock.Relock();
+
+				if (mNumTokens)
+				{
+					--mNumTokens;
+					return;
+				}
+			}
+		}
+
+
+		XLANG_FORCEINLINE void Monitor::Pulse()
+		{
+			// Skip the system call entirely if every waiting thread has already been pulsed.
+			if (mNumWaiting)
+			{
+				--mNumWaiting;
+				++mNumTokens;
+
+				__atomic_add_fetch(&mSequence, 1, __ATOMIC_RELAXED);
+				Futex::Wake(&mSequence, 1);
+			}
+		}
+
+
+		XLANG_FORCEINLINE void Monitor::PulseAll()
+		{
+			if (mNumWaiting)
+			{
+				mNumTokens += mNumWaiting;
+				mNumWaiting = 0;
+
+				__atomic_add_fetch(&mSequence, 1, __ATOMIC_RELAXED);
+				Futex::Wake(&mSequence, 0x7FFFFFFF);
+			}
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_LINUX_MONITOR_H
@@ -0,0 +1,132 @@
+#ifndef __XLANG_PRIVATE_THREADING_LINUX_MUTEX_H
+#define __XLANG_PRIVATE_THREADING_LINUX_MUTEX_H
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Debug/c_Assert.h"
+#include "clang/private/Threading/Linux/c_Futex.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// A simple critical section object implemented with a Linux futex.
+		/// The futex word has three states: unlocked, locked, and locked with (possible) waiters.
+		/// Only the last state requires a system call on unlock, so uncontended locking and
+		/// unlocking are a single atomic instruction each.
+		/// \note Like the Win32 critical section it replaces, the mutex is recursive: the owning
+		/// thread may lock it again, and must unlock it the same number of times.
+		class Mutex
+		{
+		public:
+
+			/// Default constructor.
+			XLANG_FORCEINLINE Mutex() 
+				: mState(UNLOCKED)
+				, mOwner(0)
+				, mRecursion(0)
+			{
+			}
+
+			/// Destructor.
+			XLANG_FORCEINLINE ~Mutex()
+			{
+			}
+
+			/// Locks the mutex, guaranteeing exclusive access to a protected resource associated with it.
+			/// \note This is a blocking call and should be used with care to avoid deadlocks.
+			XLANG_FORCEINLINE void Lock()
+			{
+				const u32 self(Futex::CurrentThreadId());
+
+				// Only the owner can have stored its own id, so a relaxed read is enough here.
+				if (__atomic_load_n(&mOwner, __ATOMIC_RELAXED) == self)
+				{
+					++mRecursion;
+					return;
+				}
+
+				u32 state(UNLOCKED);
+				if (!__atomic_compare_exchange_n(&mState, &state, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+				{
+					LockContended();
+				}
+
+				__atomic_store_n(&mOwner, self, __ATOMIC_RELAXED);
+				mRecursion = 1;
+			}
+
+			/// Unlocks the mutex, releasing exclusive access to a protected resource associated with it.
+			XLANG_FORCEINLINE void Unlock()
+			{
+				XLANG_ASSERT(mOwner == Futex::CurrentThreadId());
+				if (--mRecursion != 0)
+				{
+					return;
+				}
+
+				__atomic_store_n(&mOwner, 0, __ATOMIC_RELAXED);
+
+				// Only wake a sleeping thread if the mutex was marked as contended.
+				if (__atomic_exchange_n(&mState, UNLOCKED, __ATOMIC_RELEASE) == CONTENDED)
+				{
+					Futex::Wake(&mState, 1);
+				}
+			}
+
+		private:
+
+			enum
+			{
+				UNLOCKED = 0,				///< Nobody holds the mutex.
+				LOCKED = 1,					///< Held, with no threads sleeping on it.
+				CONTENDED = 2				///< Held, and threads may be sleeping on it.
+			};
+
+			/// Number of times a contending thread polls the mutex before going to sleep.
+			/// Critical sections in clang are short, so the holder is often about to release it.
+			static const u32 SPIN_COUNT = 100;
+
+			Mutex(const Mutex &other);
+			Mutex &operator=(const Mutex &other);
+
+			/// Slow path of Lock, taken when the mutex was already held.
+			inline void LockContended()
+			{
+				// Spin briefly in the hope that the holder releases the mutex soon.
+				for (u32 spin = 0; spin < SPIN_COUNT; ++spin)
+				{
+					u32 state(UNLOCKED);
+					if (__atomic_load_n(&mState, __ATOMIC_RELAXED) == UNLOCKED &&
+						__atomic_compare_exchange_n(&mState, &state, LOCKED, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+					{
+						return;
+					}
+
+#if defined(__i386__) || defined(__x86_64__)
+					__builtin_ia32_pause();
+#endif
+				}
+
+				// Mark the mutex as contended, and sleep until it's released.
+				// Since we can't know whether other threads are still sleeping when we acquire it
+				// this way, we conservatively leave it marked as contended.
+				while (__atomic_exchange_n(&mState, CONTENDED, __ATOMIC_ACQUIRE) != UNLOCKED)
+				{
+					Futex::Wait(&mState, CONTENDED);
+				}
+			}
+
+			volatile u32 mState;			///< Futex word holding the lock state.
+			volatile u32 mOwner;			///< Id of the owning thread, or zero when unlocked.
+			u32 mRecursion;					///< Number of times the owning thread has locked the mutex.
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_LINUX_MUTEX_H
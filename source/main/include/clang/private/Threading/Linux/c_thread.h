@@ -0,0 +1,131 @@
+#ifndef __XLANG_PRIVATE_THREADING_LINUX_THREAD_H
+#define __XLANG_PRIVATE_THREADING_LINUX_THREAD_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE 
+#pragma once 
+#endif
+#include "cbase/c_allocator.h"
+
+#include <pthread.h>
+
+#include "clang/c_Defines.h"
+#include "clang/private/Debug/c_Assert.h"
+
+namespace clang
+{
+	namespace detail
+	{
+		/// A system thread, implemented using POSIX threads.
+		class Thread
+		{
+		public:
+
+			/// Defines a function that can serve as a thread entry point.
+			/// \note Entry point functions must be static -- implying that they can't be class
+			/// member functions.
+			typedef void (*EntryPoint)(void *const context);
+
+			/// Default constructor
+			XLANG_FORCEINLINE Thread() 
+				: mThread()
+				, mRunning(false)
+			{
+			}
+
+			/// Destructor
+			XLANG_FORCEINLINE ~Thread()
+			{
+				XLANG_ASSERT(mRunning == false);
+			}
+
+			/// Starts the thread, executing the given entry point function.
+			/// \param entryPoint The entry point function that the thread should execute.
+			/// \param context Pointer to a context object providing the environment in which the thread runs.
+			/// \return True, if the thread was started successfully.
+			inline bool Start(EntryPoint entryPoint, void *const context);
+
+			/// Waits for the thread to finish and return.
+			/// The semantics are that Start and Join can be called repeatedly in pairs.
+			inline void Join();
+
+			/// Returns true if the thread is currently running.
+			/// The thread is running if Start was called more recently than Join.
+			inline bool Running() const;
+
+			XCORE_CLASS_PLACEMENT_NEW_DELETE
+		private:
+			/// Struct that holds a pointer to a thread entry point function and some context data.
+			struct ThreadData
+			{
+				EntryPoint	mEntryPoint;
+				void		*mContext;
+			};
+
+			/// Thread entry point adapter function.
+			/// Wraps a call to a standard clang-style thread entry point in a pthreads-style
+			/// static thread entry point function signature.
+			/// \param pData A pointer to a ThreadData structure containing an entry point
+			/// function and a context pointer.
+			/// \return Unused dummy return value.
+			inline static void *ThreadStartProc(void *pData);
+
+			Thread(const Thread &other);
+			Thread &operator=(const Thread &other);
+
+			pthread_t	mThread;		///< Handle of the internal POSIX thread.
+			bool		mRunning;		///< pthread_t has no null value, so we track validity separately.
+			ThreadData	mThreadData;	///< Wrapper around the data passed to the thread on start.
+		};
+
+
+		XLANG_FORCEINLINE bool Thread::Start(EntryPoint entryPoint, void *const context)
+		{
+			XLANG_ASSERT(mRunning == false);
+
+			// Create a data structure to wrap the data we need to pass to the entry function.
+			mThreadData.mEntryPoint = entryPoint;
+			mThreadData.mContext = context;
+
+			mRunning = (pthread_create(
+				&mThread,                               // returns the thread handle
+				0,                                      // default attributes, joinable
+				ThreadStartProc,                        // thread entry point function
+				reinterpret_cast<void *>(&mThreadData)) // pass the real entrypoint and context
+				== 0);
+
+			return mRunning;
+		}
+
+
+		XLANG_FORCEINLINE void Thread::Join()
+		{
+			XLANG_ASSERT(mRunning);
+
+			// Wait for the thread to terminate and release its resources,
+			// so it can be safely recreated next time.
+			pthread_join(mThread, 0);
+			mRunning = false;
+		}
+
+
+		XLANG_FORCEINLINE bool Thread::Running() const
+		{
+			return mRunning;
+		}
+
+
+		inline void *Thread::ThreadStartProc(void *pData)
+		{
+			// Call the real entry point function, passing the provided context.
+			ThreadData *threadData = reinterpret_cast<ThreadData *>(pData);
+			threadData->mEntryPoint(threadData->mContext);
+
+			return 0;
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_LINUX_THREAD_H
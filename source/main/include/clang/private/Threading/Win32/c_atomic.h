@@ -0,0 +1,175 @@
+#ifndef __XLANG_PRIVATE_THREADING_WIN32_ATOMIC_H
+#define __XLANG_PRIVATE_THREADING_WIN32_ATOMIC_H
+
+#ifdef _MSC_VER
+#pragma warning(push,0)
+#endif //_MSC_VER
+
+#include <windows.h>
+#include <intrin.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif //_MSC_VER
+
+#include "clang/private/c_BasicTypes.h"
+
+#include "clang/c_Defines.h"
+
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Atomic operations on naturally aligned words, implemented with the Win32 Interlocked functions.
+		/// Loads have acquire semantics, stores have release semantics, and read-modify-write
+		/// operations are sequentially consistent.
+		/// \note Plain loads and stores are relied on to be acquire and release on x86 and x64,
+		/// so only compiler reordering needs to be prevented for them.
+		class Atomic
+		{
+		public:
+
+			/// Atomically reads a value, with acquire semantics.
+			XLANG_FORCEINLINE static u32 Load(const volatile u32 *const word)
+			{
+				const u32 value(*word);
+				_ReadWriteBarrier();
+				return value;
+			}
+
+			/// Atomically writes a value, with release semantics.
+			XLANG_FORCEINLINE static void Store(volatile u32 *const word, const u32 value)
+			{
+				_ReadWriteBarrier();
+				*word = value;
+			}
+
+			/// Atomically replaces a value, returning the previous value.
+			XLANG_FORCEINLINE static u32 Exchange(volatile u32 *const word, const u32 value)
+			{
+				return static_cast<u32>(InterlockedExchange(reinterpret_cast<volatile LONG *>(word), static_cast<LONG>(value)));
+			}
+
+			/// Replaces the value with the desired value if it holds the expected value.
+			/// \return True, if the value was replaced.
+			XLANG_FORCEINLINE static bool CompareExchange(volatile u32 *const word, const u32 expected, const u32 desired)
+			{
+				return (static_cast<u32>(InterlockedCompareExchange(
+					reinterpret_cast<volatile LONG *>(word),
+					static_cast<LONG>(desired),
+					static_cast<LONG>(expected))) == expected);
+			}
+
+			/// Atomically adds to a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Add(volatile u32 *const word, const u32 value)
+			{
+				return static_cast<u32>(InterlockedExchangeAdd(reinterpret_cast<volatile LONG *>(word), static_cast<LONG>(value))) + value;
+			}
+
+			/// Atomically increments a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Increment(volatile u32 *const word)
+			{
+				return static_cast<u32>(InterlockedIncrement(reinterpret_cast<volatile LONG *>(word)));
+			}
+
+			/// Atomically decrements a value, returning the new value.
+			XLANG_FORCEINLINE static u32 Decrement(volatile u32 *const word)
+			{
+				return static_cast<u32>(InterlockedDecrement(reinterpret_cast<volatile LONG *>(word)));
+			}
+
+			/// Atomically reads a 64-bit value, with acquire semantics.
+			/// \note Plain 64-bit loads aren't atomic in 32-bit builds, so those use an interlocked operation.
+			XLANG_FORCEINLINE static u64 Load(const volatile u64 *const word)
+			{
+#if defined(_WIN64)
+				const u64 value(*word);
+				_ReadWriteBarrier();
+				return value;
+#else
+				return static_cast<u64>(InterlockedCompareExchange64(
+					reinterpret_cast<volatile LONGLONG *>(const_cast<volatile u64 *>(word)), 0, 0));
+#endif // defined(_WIN64)
+			}
+
+			/// Atomically writes a 64-bit value, with release semantics.
+			/// \note Plain 64-bit stores aren't atomic in 32-bit builds, so those use an interlocked operation.
+			XLANG_FORCEINLINE static void Store(volatile u64 *const word, const u64 value)
+			{
+#if defined(_WIN64)
+				_ReadWriteBarrier();
+				*word = value;
+#else
+				InterlockedExchange64(reinterpret_cast<volatile LONGLONG *>(word), static_cast<LONGLONG>(value));
+#endif // defined(_WIN64)
+			}
+
+			/// Atomically adds to a 64-bit value, returning the new value.
+			XLANG_FORCEINLINE static u64 Add(volatile u64 *const word, const u64 value)
+			{
+				return static_cast<u64>(InterlockedExchangeAdd64(reinterpret_cast<volatile LONGLONG *>(word), static_cast<LONGLONG>(value))) + value;
+			}
+
+			/// Atomically reads a pointer, with acquire semantics.
+			template <class ItemType>
+			XLANG_FORCEINLINE static ItemType *Load(ItemType *const volatile *const word)
+			{
+				ItemType *const value(*word);
+				_ReadWriteBarrier();
+				return value;
+			}
+
+			/// Atomically writes a pointer, with release semantics.
+			template <class ItemType>
+			XLANG_FORCEINLINE static void Store(ItemType *volatile *const word, ItemType *const value)
+			{
+				_ReadWriteBarrier();
+				*word = value;
+			}
+
+			/// Atomically replaces a pointer, returning the previous pointer.
+			template <class ItemType>
+			XLANG_FORCEINLINE static ItemType *Exchange(ItemType *volatile *const word, ItemType *const value)
+			{
+				return static_cast<ItemType *>(InterlockedExchangePointer(
+					reinterpret_cast<PVOID volatile *>(word),
+					value));
+			}
+
+			/// Replaces the pointer with the desired pointer if it holds the expected pointer.
+			/// \return True, if the pointer was replaced.
+			template <class ItemType>
+			XLANG_FORCEINLINE static bool CompareExchange(ItemType *volatile *const word, ItemType *const expected, ItemType *const desired)
+			{
+				return (InterlockedCompareExchangePointer(
+					reinterpret_cast<PVOID volatile *>(word),
+					desired,
+					expected) == expected);
+			}
+
+			/// Full memory barrier. No loads or stores are reordered across it.
+			XLANG_FORCEINLINE static void Fence()
+			{
+				MemoryBarrier();
+			}
+
+			/// Hints to the processor that the calling thread is spinning in a wait loop.
+			XLANG_FORCEINLINE static void Pause()
+			{
+				YieldProcessor();
+			}
+
+		private:
+
+			Atomic();
+			Atomic(const Atomic &other);
+			Atomic &operator=(const Atomic &other);
+		};
+
+
+	} // namespace detail
+} // namespace clang
+
+
+#endif // __XLANG_PRIVATE_THREADING_WIN32_ATOMIC_H
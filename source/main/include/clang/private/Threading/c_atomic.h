@@ -0,0 +1,15 @@
+#ifndef __XLANG_PRIVATE_THREADING_ATOMIC_H
+#define __XLANG_PRIVATE_THREADING_ATOMIC_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE 
+#pragma once 
+#endif
+
+#include "clang/c_Defines.h"
+#if XLANG_USE_LINUX_THREADS
+#include "clang/private/Threading/Linux/c_Atomic.h"
+#else
+#include "clang/private/Threading/Win32/c_Atomic.h"
+#endif // XLANG_USE_LINUX_THREADS
+
+#endif // __XLANG_PRIVATE_THREADING_ATOMIC_H
@@ -6,7 +6,11 @@
 #endif
 
 #include "clang/c_Defines.h"
+#if XLANG_USE_LINUX_THREADS
+#include "clang/private/Threading/Linux/c_Lock.h"
+#else
 #include "clang/private/Threading/Win32/c_Lock.h"
+#endif // XLANG_USE_LINUX_THREADS
 
 #endif // __XLANG_PRIVATE_THREADING_LOCK_H
 
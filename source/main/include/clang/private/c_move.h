@@ -0,0 +1,52 @@
+#ifndef __XLANG_PRIVATE_MOVE_H
+#define __XLANG_PRIVATE_MOVE_H
+#include "ccore/c_target.h"
+#ifdef USE_PRAGMA_ONCE
+#pragma once
+#endif
+
+#include "clang/c_Defines.h"
+
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+namespace clang
+{
+	namespace detail
+	{
+		/// Strips any reference from a type.
+		template <class ValueType> struct RemoveReference						{ typedef ValueType Type; };
+		template <class ValueType> struct RemoveReference<ValueType &>			{ typedef ValueType Type; };
+		template <class ValueType> struct RemoveReference<ValueType &&>			{ typedef ValueType Type; };
+
+		/// Defines ResultType only for the value types that a forwarding reference deduces from
+		/// non-const rvalues, so rvalue overloads of methods taking a const reference are only
+		/// chosen for values that can be moved from.
+		template <class ValueType, class ResultType> struct EnableIfMovable					{ typedef ResultType Type; };
+		template <class ValueType, class ResultType> struct EnableIfMovable<ValueType &, ResultType>	{ };
+		template <class ValueType, class ResultType> struct EnableIfMovable<const ValueType, ResultType>	{ };
+
+		/// Casts a value to an rvalue reference, so that it's moved rather than copied.
+		/// Equivalent to std::move, which we avoid to keep the library free of the standard library.
+		template <class ValueType>
+		XLANG_FORCEINLINE typename RemoveReference<ValueType>::Type &&Move(ValueType &&value)
+		{
+			return static_cast<typename RemoveReference<ValueType>::Type &&>(value);
+		}
+
+		/// Passes on a forwarding reference as the kind of reference it was passed as.
+		/// Equivalent to std::forward.
+		template <class ValueType>
+		XLANG_FORCEINLINE ValueType &&Forward(typename RemoveReference<ValueType>::Type &value)
+		{
+			return static_cast<ValueType &&>(value);
+		}
+
+
+	} // namespace detail
+} // namespace clang
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+#endif // __XLANG_PRIVATE_MOVE_H
@@ -0,0 +1,204 @@
+// Copyright (C) by Ashton Mason. See LICENSE.txt for licensing information.
+
+
+//
+// This sample is a benchmark that compares the LocklessForwardAllocator with the
+// DefaultAllocator, under increasing numbers of threads. Each thread allocates and
+// frees blocks of the sizes typical of messages and actor cores, between 32 and 1024
+// bytes. In the local test each thread frees its own blocks. In the cross-thread test
+// each thread hands its blocks to a neighbour, which frees them, as happens when a
+// message sent by one worker thread is handled by another.
+//
+
+
+#include <stdio.h>
+#include <chrono>
+
+#include "clang/c_defaultallocator.h"
+#include "clang/c_iallocator.h"
+#include "clang/c_llfw_allocator.h"
+
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Thread.h"
+
+
+static const int MAX_THREADS = 32;
+static const int BLOCKS_PER_BATCH = 64;
+static const int NUM_BATCHES = 2000;
+static const int SLOTS_PER_THREAD = 64;
+
+static const clang::IAllocator::SizeType ARENA_SIZE = 256 * 1024 * 1024;
+
+
+// Shared state of the threads taking part in a test.
+struct Test
+{
+    clang::IAllocator *mAllocator;
+    int mNumThreads;
+    volatile clang::u32 mStarted;
+
+    // Blocks handed from each thread to its neighbour, in the cross-thread test.
+    void *volatile mSlots[MAX_THREADS * SLOTS_PER_THREAD];
+};
+
+
+// Context of a single thread taking part in a test.
+struct ThreadContext
+{
+    Test *mTest;
+    int mIndex;
+};
+
+
+// Returns the size of the nth block allocated in a batch, cycling through the size range.
+inline static clang::IAllocator::SizeType BlockSize(const int index)
+{
+    return static_cast<clang::IAllocator::SizeType>(32 + ((index * 37) % 32) * 32);
+}
+
+
+inline static void WaitForStart(Test *const test)
+{
+    while (clang::detail::Atomic::Load(&test->mStarted) == 0)
+    {
+        clang::detail::Atomic::Pause();
+    }
+}
+
+
+// Allocates a batch of blocks, then frees them all, from the same thread.
+static void LocalEntryPoint(void *const context)
+{
+    ThreadContext *const threadContext(reinterpret_cast<ThreadContext *>(context));
+    Test *const test(threadContext->mTest);
+    clang::IAllocator *const allocator(test->mAllocator);
+
+    void *blocks[BLOCKS_PER_BATCH];
+
+    WaitForStart(test);
+
+    for (int batch = 0; batch < NUM_BATCHES; ++batch)
+    {
+        for (int index = 0; index < BLOCKS_PER_BATCH; ++index)
+        {
+            blocks[index] = allocator->Allocate(BlockSize(index));
+        }
+
+        for (int index = 0; index < BLOCKS_PER_BATCH; ++index)
+        {
+            allocator->Free(blocks[index]);
+        }
+    }
+}
+
+
+// Allocates blocks and swaps them into the slots of the neighbouring thread,
+// freeing the blocks previously put there by that thread's other neighbour.
+static void CrossThreadEntryPoint(void *const context)
+{
+    ThreadContext *const threadContext(reinterpret_cast<ThreadContext *>(context));
+    Test *const test(threadContext->mTest);
+    clang::IAllocator *const allocator(test->mAllocator);
+
+    const int neighbour((threadContext->mIndex + 1) % test->mNumThreads);
+    void *volatile *const slots(test->mSlots + neighbour * SLOTS_PER_THREAD);
+
+    WaitForStart(test);
+
+    for (int batch = 0; batch < NUM_BATCHES; ++batch)
+    {
+        for (int index = 0; index < BLOCKS_PER_BATCH; ++index)
+        {
+            void *const block(allocator->Allocate(BlockSize(index)));
+            void *const previous(clang::detail::Atomic::Exchange(slots + index % SLOTS_PER_THREAD, block));
+
+            if (previous)
+            {
+                allocator->Free(previous);
+            }
+        }
+    }
+}
+
+
+static double Measure(
+    clang::IAllocator *const allocator,
+    const int numThreads,
+    clang::detail::Thread::EntryPoint entryPoint)
+{
+    static Test test;
+    ThreadContext contexts[MAX_THREADS];
+    clang::detail::Thread threads[MAX_THREADS];
+
+    test.mAllocator = allocator;
+    test.mNumThreads = numThreads;
+    test.mStarted = 0;
+
+    for (int index = 0; index < MAX_THREADS * SLOTS_PER_THREAD; ++index)
+    {
+        test.mSlots[index] = 0;
+    }
+
+    for (int index = 0; index < numThreads; ++index)
+    {
+        contexts[index].mTest = &test;
+        contexts[index].mIndex = index;
+        threads[index].Start(entryPoint, &contexts[index]);
+    }
+
+    // Release all the threads at once, and time them until the last finishes.
+    const std::chrono::steady_clock::time_point start(std::chrono::steady_clock::now());
+    clang::detail::Atomic::Store(&test.mStarted, 1);
+
+    for (int index = 0; index < numThreads; ++index)
+    {
+        threads[index].Join();
+    }
+
+    const std::chrono::steady_clock::time_point end(std::chrono::steady_clock::now());
+
+    // Free any blocks left in the slots.
+    for (int index = 0; index < MAX_THREADS * SLOTS_PER_THREAD; ++index)
+    {
+        if (test.mSlots[index])
+        {
+            allocator->Free(test.mSlots[index]);
+        }
+    }
+
+    const double seconds(std::chrono::duration<double>(end - start).count());
+    const double numOperations(static_cast<double>(numThreads) * NUM_BATCHES * BLOCKS_PER_BATCH);
+
+    // Time per allocation and matching free, as seen by each thread.
+    return seconds * 1.0e9 * numThreads / numOperations;
+}
+
+
+static void MeasureAll(const char *const name, clang::detail::Thread::EntryPoint entryPoint)
+{
+    clang::DefaultAllocator defaultAllocator;
+    clang::DefaultAllocator backingAllocator;
+    clang::LocklessForwardAllocator locklessAllocator(&backingAllocator, ARENA_SIZE);
+
+    printf("%s:\n", name);
+    printf("threads    DefaultAllocator    LocklessForwardAllocator\n");
+
+    for (int numThreads = 1; numThreads <= MAX_THREADS; numThreads *= 2)
+    {
+        const double defaultTime(Measure(&defaultAllocator, numThreads, entryPoint));
+        const double locklessTime(Measure(&locklessAllocator, numThreads, entryPoint));
+
+        printf("%7d    %11.1f ns/op    %19.1f ns/op\n", numThreads, defaultTime, locklessTime);
+    }
+
+    printf("\n");
+}
+
+
+int main()
+{
+    MeasureAll("Local allocation and free", LocalEntryPoint);
+    MeasureAll("Cross-thread free", CrossThreadEntryPoint);
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Copyright (C) by Ashton Mason. See LICENSE.txt for licensing information.
+
+
+//
+// This sample is a benchmark that measures how the cost of dispatching a message to
+// its handler depends on the number of handlers registered by the receiving actor.
+// Actors with increasing numbers of handlers, each for a different message type, are
+// sent a large number of messages of the type whose handler is found last. Since the
+// handlers are kept in a dispatch index sorted by message type, the cost per message
+// should grow only very slowly with the number of handlers.
+//
+
+
+#include <stdio.h>
+#include <time.h>
+
+#include "clang/c_actor.h"
+#include "clang/c_actorref.h"
+#include "clang/c_framework.h"
+#include "clang/c_receiver.h"
+
+
+static const int MESSAGES_PER_BATCH = 10000;
+static const int NUM_BATCHES = 100;
+
+
+// A family of distinct message types, each handled by its own handler.
+template <int INDEX>
+struct IndexedMessage
+{
+    int mValue;
+};
+
+
+// Registers handlers for the message types with indices up to and including INDEX.
+template <class ActorType, int INDEX>
+struct HandlerRegistrar
+{
+    inline static void Register(ActorType *const actor)
+    {
+        HandlerRegistrar<ActorType, INDEX - 1>::Register(actor);
+        actor->template RegisterIndexedHandler<INDEX>();
+    }
+};
+
+template <class ActorType>
+struct HandlerRegistrar<ActorType, -1>
+{
+    inline static void Register(ActorType *const /*actor*/)
+    {
+    }
+};
+
+
+// An actor with a handler for each of a number of different message types.
+// It replies to the sender after each batch of messages it receives.
+template <int NUM_HANDLERS>
+class Dispatcher : public clang::Actor
+{
+public:
+
+    inline Dispatcher() : mCount(0)
+    {
+        HandlerRegistrar<Dispatcher, NUM_HANDLERS - 1>::Register(this);
+    }
+
+    template <int INDEX>
+    inline void RegisterIndexedHandler()
+    {
+        RegisterHandler(this, &Dispatcher::template Handle<INDEX>);
+    }
+
+private:
+
+    template <int INDEX>
+    inline void Handle(const IndexedMessage<INDEX> &/*message*/, const clang::Address from)
+    {
+        if (++mCount == MESSAGES_PER_BATCH)
+        {
+            mCount = 0;
+            Send(INDEX, from);
+        }
+    }
+
+    int mCount;
+};
+
+
+template <int NUM_HANDLERS>
+static void Measure(clang::Framework &framework)
+{
+    clang::Receiver receiver;
+    clang::ActorRef actor(framework.CreateActor< Dispatcher<NUM_HANDLERS> >());
+
+    // Always send messages of the last type registered.
+    IndexedMessage<NUM_HANDLERS - 1> message;
+    message.mValue = 0;
+
+    const clock_t start(clock());
+
+    for (int batch = 0; batch < NUM_BATCHES; ++batch)
+    {
+        for (int count = 0; count < MESSAGES_PER_BATCH; ++count)
+        {
+            framework.Send(message, receiver.GetAddress(), actor.GetAddress());
+        }
+
+        receiver.Wait();
+    }
+
+    const clock_t end(clock());
+
+    const double seconds(static_cast<double>(end - start) / CLOCKS_PER_SEC);
+    const double numMessages(static_cast<double>(NUM_BATCHES) * MESSAGES_PER_BATCH);
+
+    printf("%2d handlers: %7.1f ns per message\n", NUM_HANDLERS, seconds * 1.0e9 / numMessages);
+}
+
+
+int main()
+{
+    // Use a single worker thread so the measurement isn't dominated by thread synchronization.
+    clang::Framework framework(1);
+
+    Measure<1>(framework);
+    Measure<2>(framework);
+    Measure<4>(framework);
+    Measure<8>(framework);
+    Measure<16>(framework);
+    Measure<32>(framework);
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#define TESTS_TESTSUITES_ACTORGROUPTESTSUITE
+#ifdef TESTS_TESTSUITES_ACTORGROUPTESTSUITE
+
+#include "clang/c_ActorGroup.h"
+#include "clang/c_Address.h"
+#include "clang/c_Receiver.h"
+
+#include "cunittest/cunittest.h"
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_ACTORGROUPTESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		UNITTEST_TEST(TestConstruct)
+		{
+			clang::ActorGroup group;
+			CHECK_TRUE(group.GetSize() == 0);    // Group not empty
+		}
+
+		UNITTEST_TEST(TestAdd)
+		{
+			clang::Receiver receiver;
+			clang::ActorGroup group;
+			const clang::Address address(receiver.GetAddress());
+
+			CHECK_TRUE(group.Add(address));    // Address not added
+			CHECK_TRUE(group.GetSize() == 1);    // Size incorrect
+			CHECK_TRUE(group.Contains(address));    // Added address not found
+			CHECK_TRUE(group.GetAddress(0) == address);    // Address incorrect
+		}
+
+		UNITTEST_TEST(TestAddDuplicate)
+		{
+			clang::Receiver receiver;
+			clang::ActorGroup group;
+			const clang::Address address(receiver.GetAddress());
+
+			CHECK_TRUE(group.Add(address));    // Address not added
+			CHECK_TRUE(!group.Add(address));    // Duplicate address added
+			CHECK_TRUE(group.GetSize() == 1);    // Size incorrect
+		}
+
+		UNITTEST_TEST(TestAddMany)
+		{
+			// More addresses than the group initially has room for.
+			clang::Receiver receivers[40];
+			clang::ActorGroup group;
+
+			for (clang::u32 index = 0; index < 40; ++index)
+			{
+				CHECK_TRUE(group.Add(receivers[index].GetAddress()));    // Address not added
+			}
+
+			CHECK_TRUE(group.GetSize() == 40);    // Size incorrect
+			for (clang::u32 index = 0; index < 40; ++index)
+			{
+				CHECK_TRUE(group.Contains(receivers[index].GetAddress()));    // Added address not found
+			}
+		}
+
+		UNITTEST_TEST(TestRemove)
+		{
+			clang::Receiver receivers[3];
+			clang::ActorGroup group;
+			const clang::Address first(receivers[0].GetAddress());
+			const clang::Address second(receivers[1].GetAddress());
+			const clang::Address third(receivers[2].GetAddress());
+
+			group.Add(first);
+			group.Add(second);
+			group.Add(third);
+
+			CHECK_TRUE(group.Remove(first));    // Address not removed
+			CHECK_TRUE(!group.Remove(first));    // Removed address removed again
+			CHECK_TRUE(group.GetSize() == 2);    // Size incorrect
+			CHECK_TRUE(!group.Contains(first));    // Removed address found
+			CHECK_TRUE(group.Contains(second));    // Remaining address not found
+			CHECK_TRUE(group.Contains(third));    // Remaining address not found
+		}
+
+		UNITTEST_TEST(TestClear)
+		{
+			clang::Receiver receiver;
+			clang::ActorGroup group;
+			const clang::Address address(receiver.GetAddress());
+
+			group.Add(address);
+			group.Clear();
+
+			CHECK_TRUE(group.GetSize() == 0);    // Group not empty
+			CHECK_TRUE(!group.Contains(address));    // Cleared address found
+			CHECK_TRUE(group.Add(address));    // Address not added after clear
+		}
+	}
+}
+UNITTEST_SUITE_END
+
+
+#endif	// TESTS_TESTSUITES_ACTORGROUPTESTSUITE
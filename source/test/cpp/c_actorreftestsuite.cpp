@@ -4,6 +4,7 @@
 #include "clang\private\Directory\x_Directory.h"
 #include "clang\private\Directory\x_ActorDirectory.h"
 #include "clang\private\Threading\x_Lock.h"
+#include "clang\private\Threading\x_Thread.h"
 
 #include "clang\x_ActorRef.h"
 #include "clang\x_Framework.h"
@@ -15,6 +16,18 @@ inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
 inline void	operator delete(void* mem, void* )							{ }
 
 
+static void CopyActorRefEntryPoint(void *const context)
+{
+	const clang::ActorRef &actor(*reinterpret_cast<const clang::ActorRef *>(context));
+	for (clang::u32 count = 0; count < 10000; ++count)
+	{
+		clang::ActorRef copy(actor);
+		clang::ActorRef assigned;
+		assigned = copy;
+	}
+}
+
+
 UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_ACTORREFTESTSUITE)
 {
     UNITTEST_FIXTURE(main)
@@ -83,6 +96,62 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_ACTORREFTESTSUITE)
 			}
 		}
 
+		UNITTEST_TEST(TestSelfAssignment)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<SimpleActor>());
+
+			// Self-assignment mustn't make the actor unreferenced, even briefly.
+			actor = actor;
+
+			clang::u32 numEntities(1);
+			for (clang::u32 count = 0; count < 1000 && numEntities == 1; ++count)
+			{
+				clang::detail::Lock lock(clang::detail::Directory::GetMutex());
+				numEntities = clang::detail::ActorDirectory::Instance().Count();
+			}
+
+			CHECK_TRUE(numEntities == 1);   // Actor destroyed by self-assignment
+		}
+
+		UNITTEST_TEST(TestConcurrentCopies)
+		{
+			clang::Framework framework;
+
+			{
+				clang::ActorRef actor(framework.CreateActor<SimpleActor>());
+
+				// Copy and destroy references to the actor in several threads at once.
+				clang::detail::Thread threads[4];
+				for (clang::u32 index = 0; index < 4; ++index)
+				{
+					threads[index].Start(CopyActorRefEntryPoint, &actor);
+				}
+
+				for (clang::u32 index = 0; index < 4; ++index)
+				{
+					threads[index].Join();
+				}
+
+				clang::u32 numEntities(0);
+
+				{
+					clang::detail::Lock lock(clang::detail::Directory::GetMutex());
+					numEntities = clang::detail::ActorDirectory::Instance().Count();
+				}
+
+				CHECK_TRUE(numEntities == 1);   // Actor destroyed while still referenced
+			}
+
+			// Wait for the actor to be destroyed once the last reference is gone.
+			clang::u32 numEntities(1);
+			while (numEntities != 0)
+			{
+				clang::detail::Lock lock(clang::detail::Directory::GetMutex());
+				numEntities = clang::detail::ActorDirectory::Instance().Count();
+			}
+		}
+
 		UNITTEST_TEST(TestScope)
 		{
 			clang::Framework framework;
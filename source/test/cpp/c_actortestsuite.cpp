@@ -2,7 +2,9 @@
 #ifdef TESTS_TESTSUITES_ACTORTESTSUITE
 
 #include "clang\private\x_BasicTypes.h"
+#include "clang\private\Threading\x_Atomic.h"
 #include "clang\private\Threading\x_Mutex.h"
+#include "clang\private\Threading\x_Thread.h"
 
 #include "clang\x_Register.h"
 #include "clang\x_Framework.h"
@@ -110,6 +112,209 @@ private:
 	}
 };
 
+class MultiTypeActor : public clang::Actor
+{
+public:
+
+	inline MultiTypeActor()
+	{
+		// Registered out of type order, so the handlers have to be sorted for dispatch.
+		RegisterHandler(this, &MultiTypeActor::HandleShort);
+		RegisterHandler(this, &MultiTypeActor::HandleInt);
+		RegisterHandler(this, &MultiTypeActor::HandleChar);
+		RegisterHandler(this, &MultiTypeActor::HandleDouble);
+		RegisterHandler(this, &MultiTypeActor::HandleFloat);
+	}
+
+private:
+
+	inline void HandleInt(const int &/*message*/, const clang::Address from)
+	{
+		Send(clang::u32(1), from);
+	}
+
+	inline void HandleFloat(const float &/*message*/, const clang::Address from)
+	{
+		Send(clang::u32(2), from);
+	}
+
+	inline void HandleDouble(const double &/*message*/, const clang::Address from)
+	{
+		Send(clang::u32(4), from);
+	}
+
+	inline void HandleShort(const short &/*message*/, const clang::Address from)
+	{
+		Send(clang::u32(8), from);
+	}
+
+	inline void HandleChar(const char &/*message*/, const clang::Address from)
+	{
+		// Removes a handler from the middle of the registered list.
+		DeregisterHandler(this, &MultiTypeActor::HandleFloat);
+		Send(clang::u32(16), from);
+	}
+};
+
+
+class ManyHandlerActor : public clang::Actor
+{
+public:
+
+	enum { NUM_HANDLERS = 40 };
+
+	inline ManyHandlerActor() : mCount(0)
+	{
+		// More handlers than used to fit in the fixed-size handler arrays.
+		for (clang::u32 index = 0; index < NUM_HANDLERS; ++index)
+		{
+			RegisterHandler(this, &ManyHandlerActor::Count);
+		}
+
+		RegisterHandler(this, &ManyHandlerActor::Report);
+	}
+
+private:
+
+	inline void Count(const int &/*message*/, const clang::Address /*from*/)
+	{
+		++mCount;
+	}
+
+	inline void Report(const char &/*message*/, const clang::Address from)
+	{
+		Send(mCount, from);
+	}
+
+	clang::u32 mCount;
+};
+
+
+// Forwards each message it's sent to another address, recording where the message value was.
+class Forwarder : public clang::Actor
+{
+public:
+
+	struct Parameters
+	{
+		clang::Address mAddress;
+	};
+
+	inline Forwarder(const Parameters &params) : mAddress(params.mAddress)
+	{
+		RegisterHandler(this, &Forwarder::Handler);
+
+		// There's no message to forward outside of a handler.
+		smForwardedInConstructor = Forward(mAddress);
+	}
+
+	static const void *volatile smValue;
+	static volatile bool smForwardedInConstructor;
+
+private:
+
+	inline void Handler(const clang::u32 &message, const clang::Address /*from*/)
+	{
+		smValue = &message;
+		Forward(mAddress);
+	}
+
+	clang::Address mAddress;
+};
+
+const void *volatile Forwarder::smValue = 0;
+volatile bool Forwarder::smForwardedInConstructor = true;
+
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+// Value that owns a buffer and counts how often it's allocated and copied, by any thread.
+struct CountedValue
+{
+	inline explicit CountedValue(const clang::u32 size) : mSize(size), mData(Allocate(size))
+	{
+	}
+
+	inline CountedValue(const CountedValue &other) : mSize(other.mSize), mData(Allocate(other.mSize))
+	{
+		clang::detail::Atomic::Increment(&smCopies);
+	}
+
+	inline CountedValue(CountedValue &&other) : mSize(other.mSize), mData(other.mData)
+	{
+		other.mSize = 0;
+		other.mData = 0;
+	}
+
+	inline ~CountedValue()
+	{
+		if (mData)
+		{
+			clang::AllocatorManager::Instance().GetAllocator()->Free(mData);
+		}
+	}
+
+	inline static void *Allocate(const clang::u32 size)
+	{
+		clang::detail::Atomic::Increment(&smAllocations);
+		return clang::AllocatorManager::Instance().GetAllocator()->Allocate(size * sizeof(clang::u64));
+	}
+
+	clang::u32 mSize;
+	void *mData;
+
+	static volatile clang::u32 smAllocations;
+	static volatile clang::u32 smCopies;
+
+private:
+
+	CountedValue &operator=(const CountedValue &other);
+};
+
+volatile clang::u32 CountedValue::smAllocations = 0;
+volatile clang::u32 CountedValue::smCopies = 0;
+
+// Replies to each value it's sent with two new values of the same size, one moved and one emplaced.
+class CountedValueReplier : public clang::Actor
+{
+public:
+
+	inline CountedValueReplier()
+	{
+		RegisterHandler(this, &CountedValueReplier::Handler);
+	}
+
+private:
+
+	inline void Handler(const CountedValue &message, const clang::Address from)
+	{
+		Send(CountedValue(message.mSize), from);
+		Emplace<CountedValue>(from, message.mSize);
+	}
+};
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+
+// Context of a thread that creates actors and records their addresses.
+struct CreatorContext
+{
+	enum { NUM_ACTORS = 200 };
+
+	clang::Framework	*mFramework;
+	clang::Address		mAddresses[NUM_ACTORS];
+};
+
+static void CreatorEntryPoint(void *const context)
+{
+	CreatorContext *const creatorContext(reinterpret_cast<CreatorContext *>(context));
+	for (clang::u32 index = 0; index < CreatorContext::NUM_ACTORS; ++index)
+	{
+		// The actors are released immediately so their indices are reused.
+		clang::ActorRef actor(creatorContext->mFramework->CreateActor<ActorHandlerConstructor>());
+		creatorContext->mAddresses[index] = actor.GetAddress();
+	}
+}
 
 UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_ACTORTESTSUITE)
 {
@@ -259,6 +464,343 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_ACTORTESTSUITE)
 
 			receiver.Wait();
 		}
+
+		class Summer
+		{
+		public:
+
+			inline Summer() : mSum(0)
+			{
+			}
+
+			inline void Catch(const clang::u32 &value, const clang::Address /*from*/)
+			{
+				mSum += value;
+			}
+
+			clang::u32 mSum;
+		};
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		class CountedValueCatcher
+		{
+		public:
+
+			inline CountedValueCatcher() : mSize(0)
+			{
+			}
+
+			inline void Catch(const CountedValue &value, const clang::Address /*from*/)
+			{
+				mSize += value.mSize;
+			}
+
+			clang::u32 mSize;
+		};
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+		class Forwardee
+		{
+		public:
+
+			inline Forwardee() : mValue(0), mMessage(0), mFrom(clang::Address::Null())
+			{
+			}
+
+			inline void Catch(const clang::u32 &value, const clang::Address from)
+			{
+				mValue = value;
+				mMessage = &value;
+				mFrom = from;
+			}
+
+			clang::u32 mValue;
+			const void *mMessage;
+			clang::Address mFrom;
+		};
+
+		class Dropper
+		{
+		public:
+
+			inline Dropper() : mCount(0)
+			{
+			}
+
+			inline void Handle(const clang::Address /*from*/)
+			{
+				++mCount;
+			}
+
+			clang::u32 mCount;
+		};
+
+		// Tests that messages of each type are dispatched to the handler for that type.
+		UNITTEST_TEST(TestDispatchByType)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<MultiTypeActor>());
+
+			Summer summer;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&summer, &Summer::Catch);
+
+			actor.Push(int(0), receiver.GetAddress());
+			actor.Push(float(0), receiver.GetAddress());
+			actor.Push(double(0), receiver.GetAddress());
+			actor.Push(short(0), receiver.GetAddress());
+
+			for (clang::u32 count = 0; count < 4; ++count)
+			{
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(summer.mSum == 1 + 2 + 4 + 8);    // Messages dispatched to the wrong handlers
+		}
+
+		// Tests that the remaining handlers are still dispatched after one is deregistered.
+		UNITTEST_TEST(TestDispatchAfterDeregister)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<MultiTypeActor>());
+
+			Summer summer;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&summer, &Summer::Catch);
+
+			actor.Push(char(0), receiver.GetAddress());
+			receiver.Wait();
+
+			actor.Push(int(0), receiver.GetAddress());
+			actor.Push(double(0), receiver.GetAddress());
+			actor.Push(short(0), receiver.GetAddress());
+
+			for (clang::u32 count = 0; count < 3; ++count)
+			{
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(summer.mSum == 16 + 1 + 4 + 8);    // Messages dispatched to the wrong handlers
+		}
+
+		UNITTEST_TEST(TestDeregisterInSharedHandlers)
+		{
+			clang::Framework framework;
+			clang::ActorRef actorOne(framework.CreateActor<MultiTypeActor>());
+			clang::ActorRef actorTwo(framework.CreateActor<MultiTypeActor>());
+
+			Dropper dropper;
+			framework.SetFallbackHandler(&dropper, &Dropper::Handle);
+
+			Summer summer;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&summer, &Summer::Catch);
+
+			// The first actor deregisters its float handler.
+			actorOne.Push(char(0), receiver.GetAddress());
+			receiver.Wait();
+
+			// Replies from the same actor arrive in order, so a float reply would arrive first.
+			actorOne.Push(float(0), receiver.GetAddress());
+			actorOne.Push(char(0), receiver.GetAddress());
+			receiver.Wait();
+
+			CHECK_TRUE(summer.mSum == 16 + 16);    // Deregistered handler was executed
+			CHECK_TRUE(dropper.mCount == 1);    // Unhandled message not passed to the fallback handler
+
+			// The second actor, of the same type, still has its float handler.
+			actorTwo.Push(float(0), receiver.GetAddress());
+			receiver.Wait();
+
+			CHECK_TRUE(summer.mSum == 16 + 16 + 2);    // Handler deregistered from another actor
+		}
+
+		UNITTEST_TEST(TestForwardMessage)
+		{
+			clang::Framework framework;
+
+			Forwardee forwardee;
+			clang::Receiver target;
+			target.RegisterHandler(&forwardee, &Forwardee::Catch);
+
+			Forwarder::Parameters params;
+			params.mAddress = target.GetAddress();
+			clang::ActorRef actor(framework.CreateActor<Forwarder>(params));
+
+			clang::Receiver sender;
+			actor.Push(clang::u32(7), sender.GetAddress());
+			target.Wait();
+
+			CHECK_TRUE(forwardee.mValue == 7);    // Forwarded value not received intact
+			CHECK_TRUE(forwardee.mFrom == sender.GetAddress());    // Forwarded message lost its sender
+			CHECK_TRUE(forwardee.mMessage == Forwarder::smValue);    // Forwarded message was copied
+			CHECK_TRUE(!Forwarder::smForwardedInConstructor);    // Forwarded without a message
+		}
+
+		UNITTEST_TEST(TestForwardManyMessages)
+		{
+			clang::Framework framework;
+
+			Forwardee forwardee;
+			clang::Receiver target;
+			target.RegisterHandler(&forwardee, &Forwardee::Catch);
+
+			// Each message is forwarded in turn, in the order it was sent.
+			Forwarder::Parameters params;
+			params.mAddress = target.GetAddress();
+			clang::ActorRef actor(framework.CreateActor<Forwarder>(params));
+
+			clang::Receiver sender;
+			for (clang::u32 count = 0; count < 100; ++count)
+			{
+				actor.Push(count, sender.GetAddress());
+			}
+
+			for (clang::u32 count = 0; count < 100; ++count)
+			{
+				target.Wait();
+			}
+
+			CHECK_TRUE(forwardee.mValue == 99);    // Forwarded messages out of order
+		}
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		UNITTEST_TEST(TestSendMovesValues)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<CountedValueReplier>());
+
+			CountedValueCatcher catcher;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&catcher, &CountedValueCatcher::Catch);
+
+			clang::detail::Atomic::Store(&CountedValue::smAllocations, 0u);
+			clang::detail::Atomic::Store(&CountedValue::smCopies, 0u);
+
+			// Temporaries and explicitly moved values are moved into their messages.
+			CountedValue value(2);
+			framework.Send(CountedValue(1), receiver.GetAddress(), actor.GetAddress());
+			actor.Push(clang::detail::Move(value), receiver.GetAddress());
+
+			// Four replies, each of which allocates its own buffer.
+			for (clang::u32 count = 0; count < 4; ++count)
+			{
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(catcher.mSize == 2 * 1 + 2 * 2);    // Values not received intact
+			CHECK_TRUE(clang::detail::Atomic::Load(&CountedValue::smCopies) == 0);    // Moved values were copied
+			CHECK_TRUE(clang::detail::Atomic::Load(&CountedValue::smAllocations) == 2 + 4);    // Moved values were reallocated
+		}
+
+		UNITTEST_TEST(TestEmplaceConstructsValues)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<CountedValueReplier>());
+
+			CountedValueCatcher catcher;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&catcher, &CountedValueCatcher::Catch);
+
+			clang::detail::Atomic::Store(&CountedValue::smAllocations, 0u);
+			clang::detail::Atomic::Store(&CountedValue::smCopies, 0u);
+
+			framework.Emplace<CountedValue>(receiver.GetAddress(), actor.GetAddress(), 3u);
+			actor.Emplace<CountedValue>(receiver.GetAddress(), 4u);
+
+			for (clang::u32 count = 0; count < 4; ++count)
+			{
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(catcher.mSize == 2 * 3 + 2 * 4);    // Values not received intact
+			CHECK_TRUE(clang::detail::Atomic::Load(&CountedValue::smCopies) == 0);    // Emplaced values were copied
+			CHECK_TRUE(clang::detail::Atomic::Load(&CountedValue::smAllocations) == 2 + 4);    // Emplaced values were reallocated
+		}
+
+		UNITTEST_TEST(TestSendCopiesLvalues)
+		{
+			clang::Framework framework;
+			clang::ActorRef actor(framework.CreateActor<CountedValueReplier>());
+
+			CountedValueCatcher catcher;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&catcher, &CountedValueCatcher::Catch);
+
+			clang::detail::Atomic::Store(&CountedValue::smCopies, 0u);
+
+			// Named values are still copied, so the sender keeps its own.
+			CountedValue value(5);
+			framework.Send(value, receiver.GetAddress(), actor.GetAddress());
+
+			receiver.Wait();
+			receiver.Wait();
+
+			CHECK_TRUE(value.mData != 0);    // Sent value was moved from
+			CHECK_TRUE(clang::detail::Atomic::Load(&CountedValue::smCopies) == 1);    // Sent value wasn't copied
+		}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
+		UNITTEST_TEST(TestRegisterManyHandlers)
+		{
+			clang::Framework framework;
+			clang::ActorRef actorOne(framework.CreateActor<ManyHandlerActor>());
+			clang::ActorRef actorTwo(framework.CreateActor<ManyHandlerActor>());
+
+			Summer summer;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&summer, &Summer::Catch);
+
+			actorOne.Push(int(0), receiver.GetAddress());
+			actorOne.Push(char(0), receiver.GetAddress());
+			actorTwo.Push(int(0), receiver.GetAddress());
+			actorTwo.Push(char(0), receiver.GetAddress());
+
+			receiver.Wait();
+			receiver.Wait();
+
+			CHECK_TRUE(summer.mSum == 2 * ManyHandlerActor::NUM_HANDLERS);    // Not all handlers were executed
+		}
+
+		// Tests that actors created concurrently by several threads get unique addresses.
+		UNITTEST_TEST(TestUniqueAddressesFromThreads)
+		{
+			const clang::u32 numThreads = 4;
+
+			clang::Framework framework;
+			static CreatorContext contexts[numThreads];
+			clang::detail::Thread threads[numThreads];
+
+			for (clang::u32 thread = 0; thread < numThreads; ++thread)
+			{
+				contexts[thread].mFramework = &framework;
+				threads[thread].Start(CreatorEntryPoint, &contexts[thread]);
+			}
+
+			for (clang::u32 thread = 0; thread < numThreads; ++thread)
+			{
+				threads[thread].Join();
+			}
+
+			const clang::u32 numAddresses = numThreads * CreatorContext::NUM_ACTORS;
+			bool unique(true);
+			for (clang::u32 first = 0; first < numAddresses; ++first)
+			{
+				const clang::Address &address(contexts[first / CreatorContext::NUM_ACTORS].mAddresses[first % CreatorContext::NUM_ACTORS]);
+				unique &= (address != clang::Address::Null());
+
+				for (clang::u32 second = first + 1; second < numAddresses; ++second)
+				{
+					unique &= (address != contexts[second / CreatorContext::NUM_ACTORS].mAddresses[second % CreatorContext::NUM_ACTORS]);
+				}
+			}
+
+			CHECK_TRUE(unique);    // Actors created by different threads have the same address
+		}
 	};
 
 }
@@ -1,8 +1,12 @@
 #define TESTS_TESTSUITES_FRAMEWORKTESTSUITE
 #ifdef TESTS_TESTSUITES_FRAMEWORKTESTSUITE
 
+#include "clang/c_AllocatorManager.h"
+#include "clang/c_DefaultAllocator.h"
 #include "clang\x_Framework.h"
 #include "clang\x_register.h"
+#include "clang\private\Threading\x_Atomic.h"
+#include "clang\private\Threading\x_Thread.h"
 
 #include "cunittest\cunittest.h"
 
@@ -14,6 +18,10 @@ class IntMessage
 {
 public:
 
+	inline IntMessage() : mValue(0)
+	{
+	}
+
 	inline explicit IntMessage(const clang::u32 value) : mValue(value)
 	{
 	}
@@ -38,6 +46,68 @@ private:
 	clang::u32 mValue;
 };
 
+// Message too large to be held in an actor's inline mailbox.
+class LargeIntMessage
+{
+public:
+
+	inline explicit LargeIntMessage(const clang::u32 value) : mValue(value)
+	{
+	}
+
+	clang::u32 mValue;
+	clang::u32 mPadding[15];
+};
+
+// Message that counts how many times it's copied.
+class CopyCountedMessage
+{
+public:
+
+	inline explicit CopyCountedMessage(const clang::u32 value) : mValue(value)
+	{
+	}
+
+	inline CopyCountedMessage(const CopyCountedMessage &other) : mValue(other.mValue)
+	{
+		clang::detail::Atomic::Increment(&smCopies);
+	}
+
+	clang::u32 mValue;
+
+	static volatile clang::u32 smCopies;
+
+private:
+
+	CopyCountedMessage &operator=(const CopyCountedMessage &other);
+};
+
+volatile clang::u32 CopyCountedMessage::smCopies = 0;
+
+// Flags used by GateActor to hold up a worker thread.
+static volatile bool sGateEntered = false;
+static volatile bool sGateOpen = false;
+
+// Context of a thread that sends messages to a set of actors, which may be destroyed meanwhile.
+struct SenderContext
+{
+	enum { MAX_TARGETS = 16 };
+
+	clang::Framework	*mFramework;
+	clang::Address		mTargets[MAX_TARGETS];
+	clang::u32			mNumMessages;
+};
+
+static void SenderEntryPoint(void *const context)
+{
+	SenderContext *const senderContext(reinterpret_cast<SenderContext *>(context));
+	for (clang::u32 count = 0; count < senderContext->mNumMessages; ++count)
+	{
+		const clang::Address &target(senderContext->mTargets[count % SenderContext::MAX_TARGETS]);
+		senderContext->mFramework->Send(IntMessage(count), clang::Address::Null(), target);
+	}
+}
+
 
 UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 {
@@ -80,6 +150,248 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 			}
 		};
 
+		class CountingActor : public clang::Actor
+		{
+		public:
+
+			struct Parameters
+			{
+				volatile clang::u32 *mCount;
+			};
+
+			inline explicit CountingActor(const Parameters &params) : mParams(params)
+			{
+				RegisterHandler(this, &CountingActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &/*value*/, const clang::Address /*from*/)
+			{
+				clang::detail::Atomic::Increment(mParams.mCount);
+			}
+
+			Parameters mParams;
+		};
+
+		class CountingFallbackHandler
+		{
+		public:
+
+			inline CountingFallbackHandler() : mCount(0)
+			{
+			}
+
+			inline void Handle(const clang::Address /*from*/)
+			{
+				clang::detail::Atomic::Increment(&mCount);
+			}
+
+			volatile clang::u32 mCount;
+		};
+
+		// Checks that the values received from each of a number of sources arrive in increasing order,
+		// where the source of a value is the value modulo the number of sources.
+		class SequenceChecker
+		{
+		public:
+
+			enum { MAX_SOURCES = 8 };
+
+			inline explicit SequenceChecker(const clang::u32 numSources) : mNumSources(numSources), mInOrder(true)
+			{
+				for (clang::u32 index = 0; index < MAX_SOURCES; ++index)
+				{
+					mNext[index] = index;
+				}
+			}
+
+			inline void Handle(const IntMessage &value, const clang::Address /*from*/)
+			{
+				const clang::u32 source(value.Value() % mNumSources);
+				if (value.Value() != mNext[source])
+				{
+					mInOrder = false;
+				}
+
+				mNext[source] = value.Value() + mNumSources;
+			}
+
+			clang::u32 mNumSources;
+			clang::u32 mNext[MAX_SOURCES];
+			bool mInOrder;
+		};
+
+		class FanOutActor : public clang::Actor
+		{
+		public:
+
+			enum { MAX_TARGETS = 8 };
+
+			struct Parameters
+			{
+				clang::Address mTargets[MAX_TARGETS];
+				clang::u32 mNumTargets;
+			};
+
+			inline explicit FanOutActor(const Parameters &params) : mParams(params)
+			{
+				RegisterHandler(this, &FanOutActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &value, const clang::Address /*from*/)
+			{
+				// Messages sent from within a handler schedule their targets on this worker's own queue.
+				for (clang::u32 index = 0; index < mParams.mNumTargets; ++index)
+				{
+					Send(value, mParams.mTargets[index]);
+				}
+			}
+
+			Parameters mParams;
+		};
+
+		class EchoActor : public clang::Actor
+		{
+		public:
+
+			struct Parameters
+			{
+				clang::Address mAddress;
+			};
+
+			inline explicit EchoActor(const Parameters &params) : mAddress(params.mAddress)
+			{
+				RegisterHandler(this, &EchoActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &value, const clang::Address /*from*/)
+			{
+				Send(value, mAddress);
+			}
+
+			clang::Address mAddress;
+		};
+
+		class InlineEchoActor : public clang::Actor
+		{
+		public:
+
+			struct Parameters
+			{
+				clang::Address mAddress;
+			};
+
+			inline explicit InlineEchoActor(const Parameters &params) : mAddress(params.mAddress)
+			{
+				EnableInlineMailbox();
+				RegisterHandler(this, &InlineEchoActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &value, const clang::Address /*from*/)
+			{
+				Send(value, mAddress);
+			}
+
+			clang::Address mAddress;
+		};
+
+		class InlineResponderActor : public clang::Actor
+		{
+		public:
+
+			inline InlineResponderActor()
+			{
+				EnableInlineMailbox();
+				RegisterHandler(this, &InlineResponderActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &value, const clang::Address from)
+			{
+				Send(value, from);
+			}
+		};
+
+		class MixedEchoActor : public clang::Actor
+		{
+		public:
+
+			struct Parameters
+			{
+				clang::Address mAddress;
+			};
+
+			inline explicit MixedEchoActor(const Parameters &params) : mAddress(params.mAddress)
+			{
+				EnableInlineMailbox();
+				RegisterHandler(this, &MixedEchoActor::SmallHandler);
+				RegisterHandler(this, &MixedEchoActor::LargeHandler);
+			}
+
+		private:
+
+			inline void SmallHandler(const IntMessage &value, const clang::Address /*from*/)
+			{
+				Send(value, mAddress);
+			}
+
+			inline void LargeHandler(const LargeIntMessage &value, const clang::Address /*from*/)
+			{
+				Send(IntMessage(value.mValue), mAddress);
+			}
+
+			clang::Address mAddress;
+		};
+
+		class GateActor : public clang::Actor
+		{
+		public:
+
+			inline GateActor()
+			{
+				RegisterHandler(this, &GateActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &value, const clang::Address from)
+			{
+				// Hold up the worker thread until the test opens the gate.
+				sGateEntered = true;
+				while (!sGateOpen)
+				{
+				}
+
+				Send(value, from);
+			}
+		};
+
+		class CopyCountedEchoActor : public clang::Actor
+		{
+		public:
+
+			inline CopyCountedEchoActor()
+			{
+				RegisterHandler(this, &CopyCountedEchoActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const CopyCountedMessage &value, const clang::Address from)
+			{
+				// Echo the value back as a plain integer, so the echo isn't counted as a copy.
+				Send(IntMessage(value.mValue), from);
+			}
+		};
+
 		class ThreadCountActor : public clang::Actor
 		{
 		public:
@@ -111,6 +423,44 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 			clang::Framework framework(2);
 		}
 
+		UNITTEST_TEST(TestParametersConstruction)
+		{
+			clang::Framework::Parameters params(2, 4);
+			params.mMaxActors = 100000;
+			params.mMaxReceivers = 1000;
+
+			clang::Framework framework(params);
+			clang::ActorRef actorRef(framework.CreateActor<SimpleActor>());
+
+			CHECK_TRUE(actorRef.GetAddress() != clang::Address::Null());    // Actor not created
+		}
+
+		UNITTEST_TEST(TestCreateMoreActorsThanDefaultMaximum)
+		{
+			const clang::u32 numActors = XLANG_MAX_ACTORS + 100;
+
+			clang::Framework::Parameters params(2, 4);
+			params.mMaxActors = numActors;
+
+			clang::Framework framework(params);
+
+			clang::IAllocator *const allocator(clang::AllocatorManager::Instance().GetAllocator());
+			clang::ActorRef *const actors(reinterpret_cast<clang::ActorRef *>(allocator->Allocate(numActors * sizeof(clang::ActorRef))));
+
+			for (clang::u32 index = 0; index < numActors; ++index)
+			{
+				new (actors + index) clang::ActorRef(framework.CreateActor<SimpleActor>());
+				CHECK_TRUE(actors[index].GetAddress() != clang::Address::Null());    // Actor not created within the raised maximum
+			}
+
+			for (clang::u32 index = 0; index < numActors; ++index)
+			{
+				actors[index].~ActorRef();
+			}
+
+			allocator->Free(actors);
+		}
+
 		UNITTEST_TEST(TestCreateActorNoParams)
 		{
 			clang::Framework framework;
@@ -287,6 +637,86 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 200);    // Processed message count incorrect");
 		}
 
+		UNITTEST_TEST(TestMessageQuantum)
+		{
+			clang::Framework framework(1);
+			CHECK_TRUE(framework.GetMessageQuantum() == XLANG_DEFAULT_MESSAGE_QUANTUM);    // Default message quantum incorrect
+
+			framework.SetMessageQuantum(0);
+			CHECK_TRUE(framework.GetMessageQuantum() == 1);    // Zero message quantum not clamped
+
+			framework.SetMessageQuantum(10);
+			CHECK_TRUE(framework.GetMessageQuantum() == 10);    // Message quantum not set
+		}
+
+		UNITTEST_TEST(TestIdleSpinCount)
+		{
+			clang::Framework framework(1);
+			CHECK_TRUE(framework.GetIdleSpinCount() == XLANG_DEFAULT_IDLE_SPIN_COUNT);    // Default idle spin count incorrect
+
+			framework.SetIdleSpinCount(100);
+			CHECK_TRUE(framework.GetIdleSpinCount() == 100);    // Idle spin count not set
+
+			framework.SetIdleSpinCount(0);
+			CHECK_TRUE(framework.GetIdleSpinCount() == 0);    // Idle spinning not disabled
+		}
+
+		UNITTEST_TEST(TestIdleSpinningDisabled)
+		{
+			clang::Framework framework(2);
+			clang::Receiver receiver;
+			framework.SetIdleSpinCount(0);
+
+			{
+				clang::ActorRef actor(framework.CreateActor<ResponderActor>());
+
+				// Without spinning every message has to be picked up by a woken or running thread.
+				for (int count = 0; count < 100; ++count)
+				{
+					framework.Send(IntMessage(count), receiver.GetAddress(), actor.GetAddress());
+					receiver.Wait();
+				}
+			}
+
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 100);    // Processed message count incorrect
+		}
+
+		UNITTEST_TEST(TestGetNumMessageBatches)
+		{
+			clang::Framework framework(1);
+			clang::Receiver receiver;
+			framework.SetMessageQuantum(10);
+
+			{
+				clang::ActorRef gateActor(framework.CreateActor<GateActor>());
+				clang::ActorRef responder(framework.CreateActor<ResponderActor>());
+
+				// Keep the only worker thread busy while messages are queued at the responder.
+				sGateEntered = false;
+				sGateOpen = false;
+				framework.Send(IntMessage(0), receiver.GetAddress(), gateActor.GetAddress());
+				while (!sGateEntered)
+				{
+				}
+
+				for (int count = 0; count < 100; ++count)
+				{
+					framework.Send(IntMessage(count), receiver.GetAddress(), responder.GetAddress());
+				}
+
+				// The responder processes its queued messages ten at a time.
+				sGateOpen = true;
+				for (int count = 0; count < 101; ++count)
+				{
+					receiver.Wait();
+				}
+			}
+
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 101);    // Processed message count incorrect
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGE_BATCHES) == 11);    // Message batch count incorrect
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_AVERAGE_BATCH_SIZE) == 9);    // Average batch size incorrect
+		}
+
 		UNITTEST_TEST(TestGetNumThreadPulses)
 		{
 			clang::Framework framework(2);
@@ -312,8 +742,10 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 
 			// We expect many of the messages to arrive while the actor is being processed.
 			// Such messages shouldn't cause the threadpool to be pulsed, so aren't counted.
-			// But it's non-deterministic, so we can't say much.
-			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_PULSED) <= 100);    // Processed message count incorrect");
+			// But it's non-deterministic, so we can't say much. If the worker finishes each
+			// message before the next arrives, every message pulses the pool, and the pool
+			// is pulsed once more to garbage collect the actor when it's unreferenced.
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_PULSED) <= 100 + 1);    // Processed message count incorrect");
 		}
 
 		UNITTEST_TEST(TestGetNumWokenThreadsSerial)
@@ -341,8 +773,10 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 
 			// We expect many of the messages to arrive while the actor is being processed.
 			// Such messages shouldn't cause the threadpool to be pulsed, so don't wake any threads.
-			// But it's non-deterministic, so we can't say much.
-			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= 100);    // Woken thread count incorrect");
+			// But it's non-deterministic, so we can't say much. At most every message wakes a
+			// thread, plus one more woken to garbage collect the actor when it's unreferenced.
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= 100 + 1);    // Woken thread count incorrect");
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= framework.GetCounterValue(clang::Framework::COUNTER_THREADS_PULSED));    // More threads woken than pulsed
 		}
 
 		UNITTEST_TEST(TestGetNumWokenThreadsParallel)
@@ -388,8 +822,10 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 			// Such messages should cause the threadpool to be pulsed, waking the other threads.
 			// Due to the non-deterministic nature it's possible that some threads go to sleep and are woken again.
 			// It's also possible that some or all of the threads never slept at all so never needed to be woken.
-			// Therefore it's not possible to test much here.
-			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= 500);    // Woken thread count incorrect");
+			// Therefore it's not possible to test much here, beyond one wake per message plus
+			// one per actor to garbage collect it when it's unreferenced.
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= 500 + 5);    // Woken thread count incorrect");
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= framework.GetCounterValue(clang::Framework::COUNTER_THREADS_PULSED));    // More threads woken than pulsed
 		}
 
 		UNITTEST_TEST(TestResetCounters)
@@ -426,6 +862,41 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 0);    // Message processing count not reset");
 			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_PULSED) == 0);    // Thread pulse count not reset");
 			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_THREADS_WOKEN) <= 2);    // Woken thread count not reset");
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGE_BATCHES) == 0);    // Message batch count not reset
+		}
+
+		UNITTEST_TEST(TestGetCounterValueWhileProcessing)
+		{
+			clang::Framework framework(2);
+			clang::Receiver receiver;
+			bool increasing(true);
+
+			{
+				clang::ActorRef actorOne(framework.CreateActor<ResponderActor>());
+				clang::ActorRef actorTwo(framework.CreateActor<ResponderActor>());
+
+				for (int count = 0; count < 1000; ++count)
+				{
+					IntMessage msg(count);
+					framework.Send(msg, receiver.GetAddress(), actorOne.GetAddress());
+					framework.Send(msg, receiver.GetAddress(), actorTwo.GetAddress());
+				}
+
+				// Read the counter while the worker threads are updating it.
+				clang::u64 previous(0);
+				for (int count = 0; count < 1000; ++count)
+				{
+					const clang::u64 value(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED));
+					increasing &= (value >= previous);
+					previous = value;
+
+					receiver.Wait();
+					receiver.Wait();
+				}
+			}
+
+			CHECK_TRUE(increasing);    // Processed message count decreased
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 2000);    // Processed message count incorrect
 		}
 
 		UNITTEST_TEST(TestThreadPoolThreadsafety)
@@ -456,6 +927,391 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_FRAMEWORKTESTSUITE)
 				receiver.Wait();
 			}
 		}
+
+		UNITTEST_TEST(TestFanOutFromWorker)
+		{
+			clang::Framework framework(4);
+			clang::Receiver receiver;
+
+			{
+				// Create a set of echo actors, and an actor that forwards each message it receives to all of them.
+				EchoActor::Parameters echoParams;
+				echoParams.mAddress = receiver.GetAddress();
+
+				FanOutActor::Parameters fanOutParams;
+				fanOutParams.mNumTargets = FanOutActor::MAX_TARGETS;
+
+				clang::ActorRef echoActors[FanOutActor::MAX_TARGETS];
+				for (clang::u32 index = 0; index < FanOutActor::MAX_TARGETS; ++index)
+				{
+					echoActors[index] = framework.CreateActor<EchoActor>(echoParams);
+					fanOutParams.mTargets[index] = echoActors[index].GetAddress();
+				}
+
+				clang::ActorRef fanOutActor(framework.CreateActor<FanOutActor>(fanOutParams));
+
+				// The echo actors are scheduled by a worker thread, so idle workers have to steal them.
+				for (clang::u32 count = 0; count < 100; ++count)
+				{
+					framework.Send(IntMessage(count), receiver.GetAddress(), fanOutActor.GetAddress());
+				}
+
+				for (clang::u32 count = 0; count < 100 * FanOutActor::MAX_TARGETS; ++count)
+				{
+					receiver.Wait();
+				}
+			}
+
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == 100 * (FanOutActor::MAX_TARGETS + 1));    // Processed message count incorrect
+		}
+
+		UNITTEST_TEST(TestBroadcast)
+		{
+			const clang::u32 numActors = 100;
+
+			clang::Framework framework(4);
+			clang::Receiver receiver;
+
+			{
+				clang::ActorRef actors[numActors];
+				clang::ActorGroup group;
+
+				for (clang::u32 index = 0; index < numActors; ++index)
+				{
+					actors[index] = framework.CreateActor<CopyCountedEchoActor>();
+					group.Add(actors[index].GetAddress());
+				}
+
+				// Receivers can be members of groups too.
+				CHECK_TRUE(group.Add(receiver.GetAddress()));    // Receiver not added
+
+				clang::detail::Atomic::Store(&CopyCountedMessage::smCopies, 0u);
+				framework.ResetCounters();
+
+				const CopyCountedMessage message(7);
+				CHECK_TRUE(framework.Broadcast(message, receiver.GetAddress(), group) == numActors + 1);    // Broadcast not delivered
+
+				for (clang::u32 count = 0; count < numActors + 1; ++count)
+				{
+					receiver.Wait();
+				}
+			}
+
+			CHECK_TRUE(clang::detail::Atomic::Load(&CopyCountedMessage::smCopies) == 1);    // Broadcast value copied per recipient
+			CHECK_TRUE(framework.GetCounterValue(clang::Framework::COUNTER_MESSAGES_PROCESSED) == numActors);    // Processed message count incorrect
+		}
+
+		UNITTEST_TEST(TestBroadcastToMissingAddress)
+		{
+			clang::Framework framework;
+			CountingFallbackHandler fallbackHandler;
+			framework.SetFallbackHandler(&fallbackHandler, &CountingFallbackHandler::Handle);
+
+			clang::Receiver receiver;
+			clang::ActorGroup group;
+
+			clang::ActorRef actor(framework.CreateActor<ResponderActor>());
+			group.Add(actor.GetAddress());
+
+			{
+				// The address of a receiver that no longer exists.
+				clang::Receiver missing;
+				group.Add(missing.GetAddress());
+			}
+
+			CHECK_TRUE(framework.Broadcast(IntMessage(3), receiver.GetAddress(), group) == 1);    // Broadcast delivered to missing address
+			CHECK_TRUE(clang::detail::Atomic::Load(&fallbackHandler.mCount) == 1);    // Undelivered message not passed to fallback handler
+
+			receiver.Wait();
+		}
+
+		UNITTEST_TEST(TestSendBatchToReceiver)
+		{
+			const clang::u32 numMessages = 200;
+
+			clang::Framework framework;
+			SequenceChecker checker(1);
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&checker, &SequenceChecker::Handle);
+
+			IntMessage values[numMessages];
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				values[index] = IntMessage(index);
+			}
+
+			CHECK_TRUE(framework.SendBatch(values, numMessages, receiver.GetAddress(), receiver.GetAddress()) == numMessages);    // Batch not delivered
+			receiver.Wait(numMessages);
+
+			CHECK_TRUE(checker.mInOrder);    // Batched messages arrived out of order
+		}
+
+		UNITTEST_TEST(TestSendBatchArrivalOrder)
+		{
+			const clang::u32 numMessages = 1000;
+
+			clang::Framework framework(4);
+			SequenceChecker checker(1);
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&checker, &SequenceChecker::Handle);
+
+			EchoActor::Parameters params;
+			params.mAddress = receiver.GetAddress();
+			clang::ActorRef actor(framework.CreateActor<EchoActor>(params));
+
+			IntMessage values[numMessages];
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				values[index] = IntMessage(index);
+			}
+
+			CHECK_TRUE(framework.SendBatch(values, numMessages, receiver.GetAddress(), actor.GetAddress()) == numMessages);    // Batch not delivered
+
+			clang::u32 received(0);
+			while (received < numMessages)
+			{
+				received += receiver.Wait(numMessages - received);
+			}
+
+			CHECK_TRUE(checker.mInOrder);    // Batched messages arrived out of order
+		}
+
+		UNITTEST_TEST(TestSendBatchToManyActors)
+		{
+			const clang::u32 numActors = SequenceChecker::MAX_SOURCES;
+			const clang::u32 numMessages = 1000;
+
+			clang::Framework framework(4);
+			SequenceChecker checker(numActors);
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&checker, &SequenceChecker::Handle);
+
+			EchoActor::Parameters params;
+			params.mAddress = receiver.GetAddress();
+
+			clang::ActorRef actors[numActors];
+			for (clang::u32 index = 0; index < numActors; ++index)
+			{
+				actors[index] = framework.CreateActor<EchoActor>(params);
+			}
+
+			IntMessage values[numMessages];
+			clang::Address targets[numMessages];
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				values[index] = IntMessage(index);
+				targets[index] = actors[index % numActors].GetAddress();
+			}
+
+			CHECK_TRUE(framework.SendBatch(values, numMessages, receiver.GetAddress(), targets) == numMessages);    // Batch not delivered
+
+			clang::u32 received(0);
+			while (received < numMessages)
+			{
+				received += receiver.Wait(numMessages - received);
+			}
+
+			CHECK_TRUE(checker.mInOrder);    // Messages sent to the same actor arrived out of order
+		}
+
+		UNITTEST_TEST(TestSendBatchToMissingAddress)
+		{
+			const clang::u32 numMessages = 100;
+
+			clang::Framework framework;
+			CountingFallbackHandler fallbackHandler;
+			framework.SetFallbackHandler(&fallbackHandler, &CountingFallbackHandler::Handle);
+
+			clang::Receiver receiver;
+			clang::Address missingAddress;
+
+			{
+				// The address of a receiver that no longer exists.
+				clang::Receiver missing;
+				missingAddress = missing.GetAddress();
+			}
+
+			IntMessage values[numMessages];
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				values[index] = IntMessage(index);
+			}
+
+			CHECK_TRUE(framework.SendBatch(values, numMessages, receiver.GetAddress(), missingAddress) == 0);    // Batch delivered to missing address
+			CHECK_TRUE(clang::detail::Atomic::Load(&fallbackHandler.mCount) == numMessages);    // Undelivered messages not passed to fallback handler
+		}
+
+		UNITTEST_TEST(TestSendInlineArrivalOrder)
+		{
+			const clang::u32 numMessages = 1000;
+
+			clang::Framework framework(4);
+			SequenceChecker checker(1);
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&checker, &SequenceChecker::Handle);
+
+			InlineEchoActor::Parameters params;
+			params.mAddress = receiver.GetAddress();
+			clang::ActorRef actor(framework.CreateActor<InlineEchoActor>(params));
+
+			// More small messages than the actor's inline mailbox holds, so some of them spill.
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				CHECK_TRUE(framework.Send(IntMessage(index), receiver.GetAddress(), actor.GetAddress()));    // Message not delivered
+			}
+
+			clang::u32 received(0);
+			while (received < numMessages)
+			{
+				received += receiver.Wait(numMessages - received);
+			}
+
+			CHECK_TRUE(checker.mInOrder);    // Inline messages arrived out of order
+		}
+
+		UNITTEST_TEST(TestSendMixedArrivalOrder)
+		{
+			const clang::u32 numMessages = 1000;
+
+			clang::Framework framework(4);
+			SequenceChecker checker(1);
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&checker, &SequenceChecker::Handle);
+
+			MixedEchoActor::Parameters params;
+			params.mAddress = receiver.GetAddress();
+			clang::ActorRef actor(framework.CreateActor<MixedEchoActor>(params));
+
+			// Small messages are held inline and large ones allocated, but they share a queue.
+			for (clang::u32 index = 0; index < numMessages; ++index)
+			{
+				if (index % 3 == 0)
+				{
+					CHECK_TRUE(framework.Send(LargeIntMessage(index), receiver.GetAddress(), actor.GetAddress()));    // Message not delivered
+				}
+				else
+				{
+					CHECK_TRUE(framework.Send(IntMessage(index), receiver.GetAddress(), actor.GetAddress()));    // Message not delivered
+				}
+			}
+
+			clang::u32 received(0);
+			while (received < numMessages)
+			{
+				received += receiver.Wait(numMessages - received);
+			}
+
+			CHECK_TRUE(checker.mInOrder);    // Small and large messages arrived out of order
+		}
+
+#if XLANG_ENABLE_DEFAULTALLOCATOR_CHECKS
+
+		// Sends a small message to each actor in turn, and waits for each reply before the next.
+		static void SendToEach(clang::Framework &framework, clang::Receiver &receiver, clang::ActorRef *const actors, const clang::u32 numActors)
+		{
+			for (clang::u32 index = 0; index < numActors; ++index)
+			{
+				framework.Send(IntMessage(index), receiver.GetAddress(), actors[index].GetAddress());
+				receiver.Wait();
+			}
+		}
+
+		UNITTEST_TEST(TestSmallMessagesCostNoMemoryPerActor)
+		{
+			const clang::u32 numActors = 128;
+
+			clang::DefaultAllocator *const allocator(dynamic_cast<clang::DefaultAllocator *>(clang::AllocatorManager::Instance().GetAllocator()));
+			if (allocator == 0)
+			{
+				return;
+			}
+
+			clang::Framework framework(2);
+			clang::Receiver receiver;
+
+			clang::ActorRef actors[numActors];
+			clang::ActorRef inlineActors[numActors];
+
+			// Warm up the message cache, so that only per-actor memory is measured below.
+			actors[0] = framework.CreateActor<ResponderActor>();
+			SendToEach(framework, receiver, actors, 1);
+
+			const clang::u32 bytesBeforeCreate(allocator->GetBytesAllocated());
+			for (clang::u32 index = 0; index < numActors; ++index)
+			{
+				actors[index] = framework.CreateActor<ResponderActor>();
+				inlineActors[index] = framework.CreateActor<InlineResponderActor>();
+			}
+
+			const clang::u32 bytesBeforeSend(allocator->GetBytesAllocated());
+			SendToEach(framework, receiver, actors, numActors);
+			const clang::u32 bytesAfterSend(allocator->GetBytesAllocated());
+			SendToEach(framework, receiver, inlineActors, numActors);
+			const clang::u32 bytesAfterInlineSend(allocator->GetBytesAllocated());
+
+			// Actors are cheap to create, and don't grow when sent small messages unless they enable the ring.
+			CHECK_TRUE(bytesBeforeSend - bytesBeforeCreate < 2 * numActors * 512);    // Actors too large
+			CHECK_TRUE(bytesAfterSend - bytesBeforeSend < numActors * 64);    // Small messages grew actors without inline mailboxes
+
+#if XLANG_INLINE_MAILBOX_SLOTS
+			CHECK_TRUE(bytesAfterInlineSend - bytesAfterSend >= numActors * XLANG_INLINE_MAILBOX_SLOTS * 64);    // Inline mailboxes not allocated
+#endif // XLANG_INLINE_MAILBOX_SLOTS
+		}
+
+#endif // XLANG_ENABLE_DEFAULTALLOCATOR_CHECKS
+
+		UNITTEST_TEST(TestSendToActorsWhileDestroyed)
+		{
+			const clang::u32 numRounds = 20;
+			const clang::u32 numSenders = 2;
+			const clang::u32 numMessages = 1000;
+
+			clang::Framework framework(4);
+			CountingFallbackHandler fallbackHandler;
+			framework.SetFallbackHandler(&fallbackHandler, &CountingFallbackHandler::Handle);
+
+			volatile clang::u32 handled(0);
+
+			for (clang::u32 round = 0; round < numRounds; ++round)
+			{
+				SenderContext contexts[numSenders];
+				clang::detail::Thread senders[numSenders];
+
+				{
+					CountingActor::Parameters params;
+					params.mCount = &handled;
+
+					clang::ActorRef actors[SenderContext::MAX_TARGETS];
+					for (clang::u32 index = 0; index < SenderContext::MAX_TARGETS; ++index)
+					{
+						actors[index] = framework.CreateActor<CountingActor>(params);
+					}
+
+					for (clang::u32 sender = 0; sender < numSenders; ++sender)
+					{
+						contexts[sender].mFramework = &framework;
+						contexts[sender].mNumMessages = numMessages;
+						for (clang::u32 index = 0; index < SenderContext::MAX_TARGETS; ++index)
+						{
+							contexts[sender].mTargets[index] = actors[index].GetAddress();
+						}
+
+						senders[sender].Start(SenderEntryPoint, &contexts[sender]);
+					}
+
+					// The actors are released here, so they're garbage collected while messages are still being sent to them.
+				}
+
+				for (clang::u32 sender = 0; sender < numSenders; ++sender)
+				{
+					senders[sender].Join();
+				}
+			}
+
+			// Messages that arrive while an actor is being destroyed are dropped, so we can't check an exact count.
+			const clang::u32 total(clang::detail::Atomic::Load(&handled) + clang::detail::Atomic::Load(&fallbackHandler.mCount));
+			CHECK_TRUE(total <= numRounds * numSenders * numMessages);    // Too many messages handled
+		}
 	};
 }
 UNITTEST_SUITE_END
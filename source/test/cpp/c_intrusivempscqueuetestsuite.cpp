@@ -0,0 +1,155 @@
+#define TESTS_TESTSUITES_INTRUSIVEMPSCQUEUETESTSUITE
+#ifdef TESTS_TESTSUITES_INTRUSIVEMPSCQUEUETESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Containers/c_IntrusiveMpscQueue.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Thread.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void		operator delete(void* mem, void* )							{ }
+
+
+struct MailboxItem
+{
+	inline MailboxItem() : mNext(0), mProducer(0), mSequence(0)
+	{
+	}
+
+	inline void SetNext(MailboxItem *const next)
+	{
+		clang::detail::Atomic::Store(&mNext, next);
+	}
+
+	inline MailboxItem *GetNext() const
+	{
+		return clang::detail::Atomic::Load(&mNext);
+	}
+
+	MailboxItem *volatile	mNext;
+	clang::u32				mProducer;
+	clang::u32				mSequence;
+};
+
+typedef clang::detail::IntrusiveMpscQueue<MailboxItem> ItemMailbox;
+
+struct ProducerContext
+{
+	inline ProducerContext() : mQueue(0), mItems(0), mNumItems(0)
+	{
+	}
+
+	ItemMailbox			*mQueue;
+	MailboxItem			*mItems;
+	clang::u32			mNumItems;
+};
+
+static void ProducerEntryPoint(void *const context)
+{
+	ProducerContext *const producerContext(reinterpret_cast<ProducerContext *>(context));
+	for (clang::u32 index = 0; index < producerContext->mNumItems; ++index)
+	{
+		producerContext->mQueue->Push(&producerContext->mItems[index]);
+	}
+}
+
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_INTRUSIVEMPSCQUEUETESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		UNITTEST_TEST(TestConstruct)
+		{
+			ItemMailbox queue;
+			CHECK_TRUE(queue.Empty());    // Queue not initially empty
+			CHECK_TRUE(queue.Pop() == 0);    // Pop from empty queue returned an item
+		}
+
+		UNITTEST_TEST(TestPushPopOrder)
+		{
+			ItemMailbox queue;
+			MailboxItem items[4];
+
+			queue.Push(&items[0]);
+			queue.Push(&items[1]);
+			CHECK_TRUE(!queue.Empty());    // Queue empty after push
+
+			CHECK_TRUE(queue.Pop() == &items[0]);    // Wrong item popped
+
+			// Items pushed while the consumer holds earlier items still come out after them.
+			queue.Push(&items[2]);
+			queue.Push(&items[3]);
+
+			CHECK_TRUE(queue.Pop() == &items[1]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == &items[2]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == &items[3]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == 0);    // Pop from empty queue returned an item
+			CHECK_TRUE(queue.Empty());    // Queue not empty after popping everything
+		}
+
+		UNITTEST_TEST(TestConcurrentPush)
+		{
+			const clang::u32 numProducers = 4;
+			const clang::u32 numItems = 50000;
+
+			static MailboxItem items[numProducers][numItems];
+			for (clang::u32 producer = 0; producer < numProducers; ++producer)
+			{
+				for (clang::u32 index = 0; index < numItems; ++index)
+				{
+					items[producer][index].mProducer = producer;
+					items[producer][index].mSequence = index;
+				}
+			}
+
+			ItemMailbox queue;
+			ProducerContext contexts[numProducers];
+			clang::detail::Thread producers[numProducers];
+
+			for (clang::u32 index = 0; index < numProducers; ++index)
+			{
+				contexts[index].mQueue = &queue;
+				contexts[index].mItems = items[index];
+				contexts[index].mNumItems = numItems;
+				producers[index].Start(ProducerEntryPoint, &contexts[index]);
+			}
+
+			// Consume concurrently with the producers, checking that the items of each
+			// producer arrive in the order in which that producer pushed them.
+			clang::u32 nextSequence[numProducers] = { 0 };
+			clang::u32 numPopped(0);
+			bool inOrder(true);
+
+			while (numPopped < numProducers * numItems)
+			{
+				if (MailboxItem *const item = queue.Pop())
+				{
+					inOrder &= (item->mSequence == nextSequence[item->mProducer]);
+					nextSequence[item->mProducer] = item->mSequence + 1;
+					++numPopped;
+				}
+			}
+
+			for (clang::u32 index = 0; index < numProducers; ++index)
+			{
+				producers[index].Join();
+			}
+
+			CHECK_TRUE(inOrder);    // Items of a producer popped out of order
+			CHECK_TRUE(queue.Empty());    // Queue not empty after all items were popped
+		}
+
+	};
+
+
+
+} // namespace UnitTests
+UNITTEST_SUITE_END
+
+#endif // TESTS_TESTSUITES_INTRUSIVEMPSCQUEUETESTSUITE
@@ -0,0 +1,320 @@
+#define TESTS_TESTSUITES_LLFWALLOCATORTESTSUITE
+#ifdef TESTS_TESTSUITES_LLFWALLOCATORTESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Thread.h"
+
+#include "clang/c_Align.h"
+#include "clang/c_DefaultAllocator.h"
+#include "clang/c_llfw_allocator.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void	operator delete(void* mem, void* )							{ }
+
+// Context of a thread that frees the blocks allocated by another thread.
+struct FreerContext
+{
+	enum { NUM_BLOCKS = 4096 };
+
+	clang::LocklessForwardAllocator	*mAllocator;
+	void							*volatile mBlocks[NUM_BLOCKS];
+};
+
+static void FreerEntryPoint(void *const context)
+{
+	FreerContext *const freerContext(reinterpret_cast<FreerContext *>(context));
+	for (clang::u32 index = 0; index < FreerContext::NUM_BLOCKS; ++index)
+	{
+		// Wait for the allocating thread to publish the block.
+		void *block(0);
+		while ((block = clang::detail::Atomic::Load(&freerContext->mBlocks[index])) == 0)
+		{
+			clang::detail::Atomic::Pause();
+		}
+
+		freerContext->mAllocator->Free(block);
+	}
+}
+
+// Context of a thread that repeatedly allocates and frees blocks of various sizes.
+struct ChurnContext
+{
+	enum { NUM_ROUNDS = 200, NUM_BLOCKS = 64 };
+
+	clang::LocklessForwardAllocator	*mAllocator;
+	clang::u32						mSeed;
+	bool							mIntact;
+};
+
+static void ChurnEntryPoint(void *const context)
+{
+	ChurnContext *const churnContext(reinterpret_cast<ChurnContext *>(context));
+	clang::u32 *blocks[ChurnContext::NUM_BLOCKS];
+
+	churnContext->mIntact = true;
+	for (clang::u32 round = 0; round < ChurnContext::NUM_ROUNDS; ++round)
+	{
+		for (clang::u32 index = 0; index < ChurnContext::NUM_BLOCKS; ++index)
+		{
+			const clang::u32 size(32 + ((index * 37 + churnContext->mSeed) % 31) * 32);
+			blocks[index] = reinterpret_cast<clang::u32 *>(churnContext->mAllocator->Allocate(size));
+			blocks[index][0] = churnContext->mSeed + index;
+		}
+
+		// Blocks shared with another thread would have been overwritten.
+		for (clang::u32 index = 0; index < ChurnContext::NUM_BLOCKS; ++index)
+		{
+			if (blocks[index][0] != churnContext->mSeed + index)
+			{
+				churnContext->mIntact = false;
+			}
+
+			churnContext->mAllocator->Free(blocks[index]);
+		}
+	}
+}
+
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_LLFWALLOCATORTESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		UNITTEST_TEST(TestConstruct)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 1024 * 1024);
+
+			CHECK_TRUE(allocator.GetNumSlabs() == 0);    // Slabs carved before any allocation
+		}
+
+		UNITTEST_TEST(TestAllocate)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 1024 * 1024);
+
+			void *const block(allocator.Allocate(40));
+
+			CHECK_TRUE(block != 0);    // Allocate returned null block pointer
+			CHECK_TRUE(allocator.IsSlabBlock(block));    // Small block not allocated from a slab
+			CHECK_TRUE(XLANG_ALIGNED(block, sizeof(void *)));    // Allocated block isn't aligned
+			CHECK_TRUE(allocator.GetNumSlabs() == 1);    // Slab not carved
+
+			allocator.Free(block);
+		}
+
+		UNITTEST_TEST(TestAllocateAligned)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 1024 * 1024);
+
+			void *blocks[8];
+			for (clang::u32 index = 0; index < 8; ++index)
+			{
+				blocks[index] = allocator.AllocateAligned(40, 64);
+				CHECK_TRUE(allocator.IsSlabBlock(blocks[index]));    // Aligned block not allocated from a slab
+				CHECK_TRUE(XLANG_ALIGNED(blocks[index], 64));    // Allocated block isn't aligned
+			}
+
+			for (clang::u32 index = 0; index < 8; ++index)
+			{
+				allocator.Free(blocks[index]);
+			}
+		}
+
+		UNITTEST_TEST(TestAllocateMultipleDifferentSizes)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 4 * 1024 * 1024);
+
+			clang::u8 *blocks[32];
+			for (clang::u32 index = 0; index < 32; ++index)
+			{
+				blocks[index] = reinterpret_cast<clang::u8 *>(allocator.Allocate((index + 1) * 32));
+				CHECK_TRUE(blocks[index] != 0);    // Allocate returned null block pointer
+			}
+
+			// Each size class has its own slab.
+			CHECK_TRUE(allocator.GetNumSlabs() == 32);    // Size classes share slabs
+
+			for (clang::u32 first = 0; first < 32; ++first)
+			{
+				for (clang::u32 second = first + 1; second < 32; ++second)
+				{
+					CHECK_TRUE(blocks[first] + (first + 1) * 32 <= blocks[second] || blocks[second] + (second + 1) * 32 <= blocks[first]);    // Allocate returned overlapping blocks
+				}
+			}
+
+			for (clang::u32 index = 0; index < 32; ++index)
+			{
+				allocator.Free(blocks[index]);
+			}
+		}
+
+		UNITTEST_TEST(TestFreedBlockReused)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 1024 * 1024);
+
+			// Fill a slab of the largest blocks, then free one of them.
+			const clang::u32 numBlocks(63);
+			void *blocks[numBlocks];
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = allocator.Allocate(1024);
+			}
+
+			CHECK_TRUE(allocator.GetNumSlabs() == 1);    // Slab holds fewer blocks than expected
+
+			void *const block(blocks[17]);
+			allocator.Free(block);
+
+			blocks[17] = allocator.Allocate(1024);
+			CHECK_TRUE(blocks[17] == block);    // Freed block not reused
+			CHECK_TRUE(allocator.GetNumSlabs() == 1);    // Slab carved instead of reusing freed block
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				allocator.Free(blocks[index]);
+			}
+		}
+
+		UNITTEST_TEST(TestAllocateManySlabs)
+		{
+			const clang::u32 numBlocks = 5000;
+
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 4 * 1024 * 1024);
+
+			// More blocks than fit in a single slab.
+			void **const blocks(reinterpret_cast<void **>(backingAllocator.Allocate(numBlocks * sizeof(void *))));
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = allocator.Allocate(32);
+				CHECK_TRUE(allocator.IsSlabBlock(blocks[index]));    // Block not allocated from a slab
+			}
+
+			CHECK_TRUE(allocator.GetNumSlabs() == 3);    // Wrong number of slabs carved
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				allocator.Free(blocks[index]);
+			}
+
+			// Freed blocks are reused, rather than new slabs carved.
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = allocator.Allocate(32);
+			}
+
+			CHECK_TRUE(allocator.GetNumSlabs() == 3);    // Slabs carved instead of reusing freed blocks
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				allocator.Free(blocks[index]);
+			}
+
+			backingAllocator.Free(blocks);
+		}
+
+		UNITTEST_TEST(TestLargeBlockFromBackingAllocator)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 1024 * 1024);
+
+			void *const block0(allocator.Allocate(4096));
+			void *const block1(allocator.AllocateAligned(32, 256));
+
+			CHECK_TRUE(block0 != 0);    // Allocate returned null block pointer
+			CHECK_TRUE(block1 != 0);    // Allocate returned null block pointer
+			CHECK_TRUE(!allocator.IsSlabBlock(block0));    // Large block allocated from a slab
+			CHECK_TRUE(!allocator.IsSlabBlock(block1));    // Overaligned block allocated from a slab
+			CHECK_TRUE(XLANG_ALIGNED(block1, 256));    // Allocated block isn't aligned
+
+			allocator.Free(block0);
+			allocator.Free(block1);
+		}
+
+		UNITTEST_TEST(TestArenaExhausted)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, clang::LocklessForwardAllocator::SLAB_SIZE);
+
+			void *const block0(allocator.Allocate(32));
+			void *const block1(allocator.Allocate(64));
+
+			// The arena only has room for one slab, so the second size class spills.
+			CHECK_TRUE(allocator.IsSlabBlock(block0));    // Block not allocated from a slab
+			CHECK_TRUE(!allocator.IsSlabBlock(block1));    // Block allocated from a slab beyond the arena
+			CHECK_TRUE(allocator.GetNumSlabs() == 1);    // Slab count exceeds the arena
+
+			allocator.Free(block0);
+			allocator.Free(block1);
+		}
+
+		UNITTEST_TEST(TestCrossThreadFree)
+		{
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 4 * 1024 * 1024);
+
+			FreerContext *const context(new (backingAllocator.Allocate(sizeof(FreerContext))) FreerContext);
+			context->mAllocator = &allocator;
+			for (clang::u32 index = 0; index < FreerContext::NUM_BLOCKS; ++index)
+			{
+				context->mBlocks[index] = 0;
+			}
+
+			clang::detail::Thread freer;
+			freer.Start(FreerEntryPoint, context);
+
+			for (clang::u32 index = 0; index < FreerContext::NUM_BLOCKS; ++index)
+			{
+				clang::detail::Atomic::Store(&context->mBlocks[index], allocator.Allocate(96));
+			}
+
+			freer.Join();
+
+			// Blocks freed by the other thread are reused, so the slabs aren't exhausted.
+			const clang::u32 numSlabs(allocator.GetNumSlabs());
+			void *const block(allocator.Allocate(96));
+			CHECK_TRUE(allocator.GetNumSlabs() == numSlabs);    // Blocks freed by another thread not reused
+
+			allocator.Free(block);
+			backingAllocator.Free(context);
+		}
+
+		UNITTEST_TEST(TestConcurrentAllocation)
+		{
+			const clang::u32 numThreads = 4;
+
+			clang::DefaultAllocator backingAllocator;
+			clang::LocklessForwardAllocator allocator(&backingAllocator, 16 * 1024 * 1024);
+
+			ChurnContext contexts[numThreads];
+			clang::detail::Thread threads[numThreads];
+
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				contexts[index].mAllocator = &allocator;
+				contexts[index].mSeed = index * 1000;
+				threads[index].Start(ChurnEntryPoint, &contexts[index]);
+			}
+
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				threads[index].Join();
+				CHECK_TRUE(contexts[index].mIntact);    // Block allocated to two threads at once
+			}
+		}
+	};
+}
+UNITTEST_SUITE_END
+
+
+#endif	// TESTS_TESTSUITES_LLFWALLOCATORTESTSUITE
@@ -149,6 +149,326 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_MESSAGECACHETESTSUITE)
 
 			clang::detail::MessageCache::Instance().Dereference();
 		}
+
+		UNITTEST_TEST(TestThreadCacheAllocateAfterFree)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			static clang::detail::MessageCache::ThreadCache threadCache;
+			freeList.RegisterThreadCache(&threadCache);
+
+			void *const mem0(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem0 != 0);    // Allocate failed");
+			freeList.Free(mem0, sizeof(Item));
+
+			void *const mem1(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem1 != 0);    // Allocate failed");
+			freeList.Free(mem1, sizeof(Item));
+
+			CHECK_TRUE(mem0 == mem1);    // Second allocate didn't reuse block cached by the thread");
+
+			freeList.DeregisterThreadCache();
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestThreadCacheDeregisterReturnsBlocks)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			static clang::detail::MessageCache::ThreadCache threadCache;
+			freeList.RegisterThreadCache(&threadCache);
+
+			void *const mem0(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem0 != 0);    // Allocate failed");
+			freeList.Free(mem0, sizeof(Item));
+
+			// Blocks cached by the thread are handed back to the shared depot.
+			freeList.DeregisterThreadCache();
+
+			void *const mem1(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem1 != 0);    // Allocate failed");
+			freeList.Free(mem1, sizeof(Item));
+
+			CHECK_TRUE(mem0 == mem1);    // Allocate didn't reuse block returned by the thread");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestAllocateBatchAfterFree)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			void *const mem0(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem0 != 0);    // Allocate failed");
+			freeList.Free(mem0, sizeof(Item));
+
+			// The first block comes from the cache and the rest from the allocator.
+			void *blocks[4];
+			CHECK_TRUE(freeList.AllocateBatch(sizeof(Item), XLANG_ALIGNOF(Item), blocks, 4) == 4);    // AllocateBatch failed");
+			CHECK_TRUE(blocks[0] == mem0);    // AllocateBatch didn't reuse free block");
+
+			for (clang::u32 index = 0; index < 4; ++index)
+			{
+				CHECK_TRUE(blocks[index] != 0);    // AllocateBatch returned null block");
+				freeList.Free(blocks[index], sizeof(Item));
+			}
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestSizeClasses)
+		{
+			typedef clang::detail::MessageCache MessageCache;
+
+			CHECK_TRUE(MessageCache::GetPoolBlockSize(0) == 8);    // Wrong smallest size class");
+			CHECK_TRUE(MessageCache::GetPoolBlockSize(MessageCache::MAX_POOLS - 1) == MessageCache::MAX_BLOCK_SIZE);    // Wrong largest size class");
+			CHECK_TRUE(MessageCache::MapBlockSizeToPool(MessageCache::MAX_BLOCK_SIZE + 1) >= MessageCache::MAX_POOLS);    // Oversized block mapped to a pool");
+
+			// Each size maps to the smallest size class big enough to hold it.
+			for (clang::u32 size = 1; size <= MessageCache::MAX_BLOCK_SIZE; ++size)
+			{
+				const clang::u32 poolIndex(MessageCache::MapBlockSizeToPool(size));
+				if (poolIndex >= MessageCache::MAX_POOLS || MessageCache::GetPoolBlockSize(poolIndex) < size || (poolIndex > 0 && MessageCache::GetPoolBlockSize(poolIndex - 1) >= size))
+				{
+					CHECK_TRUE(false);    // Size mapped to wrong size class");
+					break;
+				}
+			}
+
+			// Size classes are spaced geometrically, at most a quarter apart.
+			for (clang::u32 poolIndex = 8; poolIndex < MessageCache::MAX_POOLS; ++poolIndex)
+			{
+				CHECK_TRUE(MessageCache::GetPoolBlockSize(poolIndex) * 4 <= MessageCache::GetPoolBlockSize(poolIndex - 1) * 5);    // Size classes too far apart");
+			}
+		}
+
+		UNITTEST_TEST(TestAlignmentClasses)
+		{
+			typedef clang::detail::MessageCache MessageCache;
+
+			CHECK_TRUE(MessageCache::MapAlignmentToClass(4) == 0);    // Small alignment not mapped to first alignment class");
+			CHECK_TRUE(MessageCache::MapAlignmentToClass(MessageCache::MIN_ALIGNMENT) == 0);    // Wrong alignment class");
+			CHECK_TRUE(MessageCache::MapAlignmentToClass(MessageCache::MIN_ALIGNMENT * 2) == 1);    // Wrong alignment class");
+			CHECK_TRUE(MessageCache::MapAlignmentToClass(XLANG_CACHELINE_SIZE) == MessageCache::NUM_ALIGNMENT_CLASSES - 1);    // Wrong alignment class");
+			CHECK_TRUE(MessageCache::MapAlignmentToClass(XLANG_CACHELINE_SIZE * 2) >= MessageCache::NUM_ALIGNMENT_CLASSES);    // Overaligned block mapped to an alignment class");
+		}
+
+		UNITTEST_TEST(TestAllocateAfterFreeHigherAlignment)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			void *const mem0(freeList.Allocate(sizeof(Item), XLANG_CACHELINE_SIZE));
+			CHECK_TRUE(mem0 != 0);    // Allocate failed");
+			CHECK_TRUE(XLANG_ALIGNED(mem0, XLANG_CACHELINE_SIZE));    // Allocated block isn't aligned");
+			freeList.Free(mem0, sizeof(Item));
+
+			// Blocks cached for higher alignments satisfy lower ones.
+			void *const mem1(freeList.Allocate(sizeof(Item), XLANG_ALIGNOF(Item)));
+			CHECK_TRUE(mem1 != 0);    // Allocate failed");
+			freeList.Free(mem1, sizeof(Item));
+
+			CHECK_TRUE(mem0 == mem1);    // Allocate didn't reuse free block of higher alignment");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestAllocateMixedAlignments)
+		{
+			const clang::u32 numBlocks = 32;
+
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			// Cache blocks of the smallest alignment, some of which are more aligned by chance.
+			void *blocks[numBlocks];
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = freeList.Allocate(40, 8);
+			}
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				freeList.Free(blocks[index], 40);
+			}
+
+			// Every alignment is satisfied, from the cache or the allocator.
+			for (clang::u32 alignment = 8; alignment <= XLANG_CACHELINE_SIZE * 2; alignment *= 2)
+			{
+				for (clang::u32 index = 0; index < numBlocks; ++index)
+				{
+					blocks[index] = freeList.Allocate(40, alignment);
+					CHECK_TRUE(blocks[index] != 0);    // Allocate failed");
+					CHECK_TRUE(XLANG_ALIGNED(blocks[index], alignment));    // Allocated block isn't aligned");
+				}
+
+				for (clang::u32 index = 0; index < numBlocks; ++index)
+				{
+					freeList.Free(blocks[index], 40);
+				}
+			}
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestAllocateAfterFreeSameSizeClass)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			// Sizes in the same size class share blocks.
+			void *const mem0(freeList.Allocate(224, 8));
+			CHECK_TRUE(mem0 != 0);    // Allocate failed");
+			freeList.Free(mem0, 224);
+
+			void *const mem1(freeList.Allocate(200, 8));
+			CHECK_TRUE(mem1 != 0);    // Allocate failed");
+			freeList.Free(mem1, 200);
+
+			CHECK_TRUE(mem0 == mem1);    // Allocate didn't reuse free block of the same size class");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestStats)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			const clang::u32 poolIndex(clang::detail::MessageCache::MapBlockSizeToPool(48));
+
+			void *const mem0(freeList.Allocate(48, 8));
+			freeList.Free(mem0, 48);
+			void *const mem1(freeList.Allocate(48, 8));
+			freeList.Free(mem1, 48);
+
+			clang::detail::MessageCache::PoolStats stats;
+			freeList.GetPoolStats(poolIndex, stats);
+
+			CHECK_TRUE(stats.mBlockSize == 48);    // Wrong block size");
+			CHECK_TRUE(stats.mHits == 1);    // Wrong hit count");
+			CHECK_TRUE(stats.mMisses == 1);    // Wrong miss count");
+			CHECK_TRUE(stats.mOverflows == 0);    // Wrong overflow count");
+			CHECK_TRUE(stats.mNumBlocks == 1);    // Wrong number of cached blocks");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestDepotGrowsForBursts)
+		{
+			const clang::u32 numBlocks = 200;
+
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			const clang::u32 poolIndex(clang::detail::MessageCache::MapBlockSizeToPool(64));
+			void *blocks[numBlocks];
+
+			// The first burst is allocated from the allocator, and grows the depot as it's freed.
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = freeList.Allocate(64, 8);
+			}
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				freeList.Free(blocks[index], 64);
+			}
+
+			clang::detail::MessageCache::PoolStats stats;
+			freeList.GetPoolStats(poolIndex, stats);
+
+			CHECK_TRUE(stats.mMisses == numBlocks);    // Wrong miss count");
+			CHECK_TRUE(stats.mOverflows == 0);    // Depot didn't grow to hold burst");
+			CHECK_TRUE(stats.mNumBlocks == numBlocks);    // Depot didn't hold burst");
+
+			// The second burst is served entirely from the cache.
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = freeList.Allocate(64, 8);
+			}
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				freeList.Free(blocks[index], 64);
+			}
+
+			freeList.GetPoolStats(poolIndex, stats);
+
+			CHECK_TRUE(stats.mHits == numBlocks);    // Second burst not served from the cache");
+			CHECK_TRUE(stats.mMisses == numBlocks);    // Second burst allocated from the allocator");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestDepotMemoryCeiling)
+		{
+			typedef clang::detail::MessageCache MessageCache;
+
+			const clang::u32 blockSize = MessageCache::MAX_BLOCK_SIZE;
+			const clang::u32 numBlocks = MessageCache::MAX_DEPOT_BYTES / blockSize + 16;
+
+			MessageCache::Instance().Reference();
+			MessageCache &freeList(MessageCache::Instance());
+
+			const clang::u32 poolIndex(MessageCache::MapBlockSizeToPool(blockSize));
+			void *blocks[numBlocks];
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				blocks[index] = freeList.Allocate(blockSize, 8);
+			}
+
+			for (clang::u32 index = 0; index < numBlocks; ++index)
+			{
+				freeList.Free(blocks[index], blockSize);
+			}
+
+			MessageCache::PoolStats stats;
+			freeList.GetPoolStats(poolIndex, stats);
+
+			// A burst bigger than the ceiling overflows to the allocator.
+			CHECK_TRUE(stats.mOverflows > 0);    // Depot grew beyond memory ceiling");
+			CHECK_TRUE(stats.mNumBlocks + stats.mOverflows == numBlocks);    // Freed blocks lost");
+			CHECK_TRUE(stats.mMaxBlocks * blockSize <= MessageCache::MAX_DEPOT_BYTES);    // Depot grew beyond memory ceiling");
+
+			MessageCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestThreadCacheStats)
+		{
+			clang::detail::MessageCache::Instance().Reference();
+			clang::detail::MessageCache &freeList(clang::detail::MessageCache::Instance());
+
+			static clang::detail::MessageCache::ThreadCache threadCache;
+			freeList.RegisterThreadCache(&threadCache);
+
+			const clang::u32 poolIndex(clang::detail::MessageCache::MapBlockSizeToPool(48));
+
+			void *const mem0(freeList.Allocate(48, 8));
+			freeList.Free(mem0, 48);
+			void *const mem1(freeList.Allocate(48, 8));
+			freeList.Free(mem1, 48);
+
+			// Counts of registered thread caches are included.
+			clang::detail::MessageCache::PoolStats stats;
+			freeList.GetPoolStats(poolIndex, stats);
+
+			CHECK_TRUE(stats.mHits == 1);    // Wrong hit count");
+			CHECK_TRUE(stats.mMisses == 1);    // Wrong miss count");
+
+			// And kept once they're deregistered.
+			freeList.DeregisterThreadCache();
+			freeList.GetPoolStats(poolIndex, stats);
+
+			CHECK_TRUE(stats.mHits == 1);    // Hit count lost on deregistration");
+			CHECK_TRUE(stats.mMisses == 1);    // Miss count lost on deregistration");
+
+			clang::detail::MessageCache::Instance().Dereference();
+		}
 	};
 }
 UNITTEST_SUITE_END
@@ -1,7 +1,9 @@
 #define TESTS_TESTSUITES_MESSAGETESTSUITE
 #ifdef TESTS_TESTSUITES_MESSAGETESTSUITE
 
+#include "clang\private\Core\x_InlineMailbox.h"
 #include "clang\private\Messages\x_IMessage.h"
+#include "clang\private\Messages\x_InlineMessage.h"
 #include "clang\private\Messages\x_Message.h"
 
 #include "clang\x_Address.h"
@@ -34,6 +36,73 @@ struct NamedMessageValue
 	int b;
 };
 
+XLANG_REGISTER_MESSAGE_ID(NamedMessageValue, 0x1001);
+
+struct LargeMessageValue
+{
+	int values[16];
+};
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+// Value that owns a buffer and counts how often it's allocated, copied and moved.
+struct MovableMessageValue
+{
+	inline explicit MovableMessageValue(const clang::u32 size) : mSize(size), mData(Allocate(size))
+	{
+	}
+
+	inline MovableMessageValue(const MovableMessageValue &other) : mSize(other.mSize), mData(Allocate(other.mSize))
+	{
+		++smCopies;
+	}
+
+	inline MovableMessageValue(MovableMessageValue &&other) : mSize(other.mSize), mData(other.mData)
+	{
+		other.mSize = 0;
+		other.mData = 0;
+		++smMoves;
+	}
+
+	inline ~MovableMessageValue()
+	{
+		if (mData)
+		{
+			clang::AllocatorManager::Instance().GetAllocator()->Free(mData);
+		}
+	}
+
+	inline static void ResetCounts()
+	{
+		smAllocations = 0;
+		smCopies = 0;
+		smMoves = 0;
+	}
+
+	inline static void *Allocate(const clang::u32 size)
+	{
+		++smAllocations;
+		return clang::AllocatorManager::Instance().GetAllocator()->Allocate(size * sizeof(clang::u32));
+	}
+
+	clang::u32 mSize;
+	void *mData;
+
+	static clang::u32 smAllocations;
+	static clang::u32 smCopies;
+	static clang::u32 smMoves;
+
+private:
+
+	MovableMessageValue &operator=(const MovableMessageValue &other);
+};
+
+clang::u32 MovableMessageValue::smAllocations = 0;
+clang::u32 MovableMessageValue::smCopies = 0;
+clang::u32 MovableMessageValue::smMoves = 0;
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
+
 
 UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_MESSAGETESTSUITE)
 {
@@ -181,7 +250,7 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_MESSAGETESTSUITE)
 			allocator.Free(memory);
 		}
 
-		UNITTEST_TEST(TestTypeNameUnregistered)
+		UNITTEST_TEST(TestTypeIdUnregistered)
 		{
 			typedef clang::detail::Message<MessageValue> MessageType;
 
@@ -196,12 +265,13 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_MESSAGETESTSUITE)
 			MessageValue value;
 			clang::detail::IMessage *const message = MessageType::Initialize(memory, value, here);
 
-			CHECK_TRUE(message->TypeId() >= 0);    // Unregistered message type has non-zero type name");
+			CHECK_TRUE(message->TypeId() != 0);    // Unregistered message type has zero type id
+			CHECK_TRUE(message->TypeId() == clang::detail::MessageTypeId<MessageValue>::Value());    // Message type id incorrect
 
 			allocator.Free(memory);
 		}
 
-		UNITTEST_TEST(TestTypeNameRegistered)
+		UNITTEST_TEST(TestTypeIdRegistered)
 		{
 			typedef clang::detail::Message<NamedMessageValue> MessageType;
 
@@ -216,10 +286,225 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_MESSAGETESTSUITE)
 			NamedMessageValue value;
 			clang::detail::IMessage *const message = MessageType::Initialize(memory, value, here);
 
-			CHECK_TRUE(message->TypeId() >= 0);    // Registered message type has zero type name");
+			CHECK_TRUE(message->TypeId() == 0x1001);    // Registered message type doesn't have its explicit type id
+
+			allocator.Free(memory);
+		}
+
+		UNITTEST_TEST(TestHeaderSize)
+		{
+			// Next pointer, from address fields, type id and descriptor pointer.
+			CHECK_TRUE(sizeof(clang::detail::IMessage) <= 2 * sizeof(void *) + 16);    // Message header too large
+			CHECK_TRUE(sizeof(clang::detail::Message<MessageValue>) == sizeof(clang::detail::IMessage));    // Message larger than its header
+		}
+
+		UNITTEST_TEST(TestTrivialValueRelease)
+		{
+			typedef clang::detail::Message<MessageValue> MessageType;
+
+			clang::Address here;
+			clang::IAllocator &allocator(*clang::AllocatorManager::Instance().GetAllocator());
+			void *const memory = allocator.AllocateAligned(MessageType::GetSize(), MessageType::GetAlignment());
+
+			MessageValue value;
+			clang::detail::IMessage *const message = MessageType::Initialize(memory, value, here);
+
+			CHECK_TRUE(message->GetDescriptor().mRelease == 0);    // Trivially destructible value has a release function
+			CHECK_TRUE(message->GetMessageValueSize() == MessageType::GetValueSize());    // Message value size incorrect
+			CHECK_TRUE(message->GetMessageData() == memory);    // Message value not at the start of the block
+			CHECK_TRUE(message->Release());    // Message block can't be freed
+
+			allocator.Free(memory);
+		}
+
+		UNITTEST_TEST(TestInlineTraits)
+		{
+			CHECK_TRUE(clang::detail::InlineMessageTraits<MessageValue>::IS_INLINE == (XLANG_INLINE_MAILBOX_SLOTS != 0));    // Small value not held inline
+			CHECK_TRUE(clang::detail::InlineMessageTraits<clang::u32>::IS_INLINE == (XLANG_INLINE_MAILBOX_SLOTS != 0));    // Integer not held inline
+			CHECK_TRUE(!clang::detail::InlineMessageTraits<LargeMessageValue>::IS_INLINE);    // Large value held inline
+		}
+
+		UNITTEST_TEST(TestInlineMailboxSpill)
+		{
+			typedef clang::detail::InlineMessageTraits<MessageValue> TraitsType;
+			typedef clang::detail::Message<MessageValue> MessageType;
+
+			const clang::u32 numSlots(clang::detail::InlineMailbox::NUM_SLOTS);
+			clang::detail::IMessage *messages[clang::detail::InlineMailbox::NUM_SLOTS];
 
+			clang::Address here;
+			clang::detail::InlineMailbox mailbox;
+			MessageValue value;
+
+			// Mailboxes are disabled until their actor enables them.
+			CHECK_TRUE(mailbox.Allocate(&value, TraitsType::smDescriptor, clang::detail::MessageTypeId<MessageValue>::Value(), here) == 0);    // Message allocated in a disabled mailbox
+			mailbox.Enable();
+
+			for (clang::u32 index = 0; index < numSlots; ++index)
+			{
+				value.a = index;
+				messages[index] = mailbox.Allocate(&value, TraitsType::smDescriptor, clang::detail::MessageTypeId<MessageValue>::Value(), here);
+				CHECK_TRUE(messages[index] != 0);    // Mailbox full too soon
+			}
+
+			// The mailbox is full, so the next message has to be allocated elsewhere.
+			CHECK_TRUE(mailbox.Allocate(&value, TraitsType::smDescriptor, clang::detail::MessageTypeId<MessageValue>::Value(), here) == 0);    // Message allocated in a full mailbox
+
+			for (clang::u32 index = 0; index < numSlots; ++index)
+			{
+				CHECK_TRUE(clang::detail::InlineMessage::IsInline(messages[index]));    // Message not held inline
+				CHECK_TRUE(static_cast<MessageType *>(messages[index])->Value().a == (int)index);    // Message value incorrect
+			}
+
+			// Releasing the oldest message frees the next slot.
+			CHECK_TRUE(!messages[0]->Release());    // Slot freed to the message cache
+			messages[0] = mailbox.Allocate(&value, TraitsType::smDescriptor, clang::detail::MessageTypeId<MessageValue>::Value(), here);
+			CHECK_TRUE(messages[0] != 0);    // Released slot not reused
+
+			for (clang::u32 index = 0; index < numSlots; ++index)
+			{
+				messages[index]->Release();
+			}
+		}
+
+		UNITTEST_TEST(TestInlineMessageOutlivesMailbox)
+		{
+			typedef clang::detail::InlineMessageTraits<MessageValue> TraitsType;
+			typedef clang::detail::Message<MessageValue> MessageType;
+
+			clang::Address here;
+			clang::detail::IMessage *message(0);
+
+			{
+				clang::detail::InlineMailbox mailbox;
+				MessageValue value;
+				value.b = 5;
+				mailbox.Enable();
+
+				message = mailbox.Allocate(&value, TraitsType::smDescriptor, clang::detail::MessageTypeId<MessageValue>::Value(), here);
+				CHECK_TRUE(message != 0);    // Message not allocated
+
+				// Forwarded messages keep the slots alive when the mailbox is destroyed.
+				clang::detail::InlineMessage::Detach(message);
+			}
+
+			CHECK_TRUE(static_cast<MessageType *>(message)->Value().b == 5);    // Message value incorrect
+			CHECK_TRUE(!message->Release());    // Slot freed to the message cache
+		}
+
+		UNITTEST_TEST(TestTypeIdsUnique)
+		{
+			const clang::u32 valueId(clang::detail::MessageTypeId<MessageValue>::Value());
+			const clang::u32 namedValueId(clang::detail::MessageTypeId<NamedMessageValue>::Value());
+			const clang::u32 intId(clang::detail::MessageTypeId<int>::Value());
+
+			CHECK_TRUE(valueId != namedValueId);    // Message types have the same type id
+			CHECK_TRUE(valueId != intId);    // Message types have the same type id
+			CHECK_TRUE(namedValueId != intId);    // Message types have the same type id
+		}
+
+#if XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+
+		UNITTEST_TEST(TestTypeIdsConstant)
+		{
+			// Generated ids are compile-time constants.
+			constexpr clang::u32 valueId(clang::detail::MessageTypeId<MessageValue>::VALUE);
+			constexpr clang::u32 intId(clang::detail::MessageTypeId<int>::VALUE);
+			constexpr clang::u32 nameHash(clang::detail::HashTypeName("MessageValue"));
+
+			CHECK_TRUE(valueId == clang::detail::MessageTypeId<MessageValue>::Value());    // Constant type id differs from run-time type id
+			CHECK_TRUE(valueId != intId);    // Message types have the same type id
+			CHECK_TRUE(nameHash == clang::detail::HashTypeName("MessageValue"));    // Type name hash not deterministic
+			CHECK_TRUE(nameHash != clang::detail::HashTypeName("MessageValue2"));    // Different type names have the same hash
+		}
+
+#endif // XLANG_ENABLE_CONSTEXPR_TYPE_IDS
+
+#if XLANG_ENABLE_ASSERTS
+
+		UNITTEST_TEST(TestTypeIdClashDetected)
+		{
+			// Ids a real message type is unlikely to have.
+			const clang::u32 id(0x7E57C1A5);
+			static char typeOne;
+			static char typeTwo;
+
+			CHECK_TRUE(clang::detail::MessageTypeIdRegistry::Register(id, &typeOne));    // First use of an id rejected
+			CHECK_TRUE(clang::detail::MessageTypeIdRegistry::Register(id, &typeOne));    // Same type rejected on second use
+			CHECK_TRUE(!clang::detail::MessageTypeIdRegistry::Register(id, &typeTwo));    // Different type with the same id not detected
+			CHECK_TRUE(clang::detail::MessageTypeIdRegistry::Register(id + 1, &typeTwo));    // Different id rejected
+		}
+
+#endif // XLANG_ENABLE_ASSERTS
+
+#if XLANG_ENABLE_MOVE_SEMANTICS
+
+		UNITTEST_TEST(TestInitializeCopiesValue)
+		{
+			typedef clang::detail::Message<MovableMessageValue> MessageType;
+
+			clang::Address here;
+			clang::IAllocator &allocator(*clang::AllocatorManager::Instance().GetAllocator());
+			void *const memory = allocator.AllocateAligned(MessageType::GetSize(), MessageType::GetAlignment());
+
+			MovableMessageValue::ResetCounts();
+			MovableMessageValue value(4);
+			MessageType *const message = MessageType::Initialize(memory, value, here);
+
+			CHECK_TRUE(MovableMessageValue::smCopies == 1);    // Value not copied
+			CHECK_TRUE(MovableMessageValue::smAllocations == 2);    // Copy didn't allocate its own buffer
+			CHECK_TRUE(message->Value().mData != value.mData);    // Copy shares the buffer
+
+			message->Release();
 			allocator.Free(memory);
 		}
+
+		UNITTEST_TEST(TestEmplaceMovesValue)
+		{
+			typedef clang::detail::Message<MovableMessageValue> MessageType;
+
+			clang::Address here;
+			clang::IAllocator &allocator(*clang::AllocatorManager::Instance().GetAllocator());
+			void *const memory = allocator.AllocateAligned(MessageType::GetSize(), MessageType::GetAlignment());
+
+			MovableMessageValue::ResetCounts();
+			MovableMessageValue value(4);
+			void *const data(value.mData);
+			MessageType *const message = MessageType::Emplace(memory, here, clang::detail::Move(value));
+
+			CHECK_TRUE(MovableMessageValue::smCopies == 0);    // Moved value was copied
+			CHECK_TRUE(MovableMessageValue::smMoves == 1);    // Value not moved
+			CHECK_TRUE(MovableMessageValue::smAllocations == 1);    // Moved value allocated a buffer
+			CHECK_TRUE(message->Value().mData == data);    // Buffer not moved into the message
+			CHECK_TRUE(value.mData == 0);    // Moved-from value still owns the buffer
+
+			message->Release();
+			allocator.Free(memory);
+		}
+
+		UNITTEST_TEST(TestEmplaceConstructsValue)
+		{
+			typedef clang::detail::Message<MovableMessageValue> MessageType;
+
+			clang::Address here;
+			clang::IAllocator &allocator(*clang::AllocatorManager::Instance().GetAllocator());
+			void *const memory = allocator.AllocateAligned(MessageType::GetSize(), MessageType::GetAlignment());
+
+			MovableMessageValue::ResetCounts();
+			MessageType *const message = MessageType::Emplace(memory, here, 6u);
+
+			CHECK_TRUE(MovableMessageValue::smCopies == 0);    // Emplaced value was copied
+			CHECK_TRUE(MovableMessageValue::smMoves == 0);    // Emplaced value was moved
+			CHECK_TRUE(MovableMessageValue::smAllocations == 1);    // Value allocated more than once
+			CHECK_TRUE(message->Value().mSize == 6);    // Value constructed from the wrong arguments
+			CHECK_TRUE(message->GetBlock() == &message->Value());    // Value not constructed in the block
+			CHECK_TRUE(message->From() == here);    // Message from address incorrect
+
+			message->Release();
+			allocator.Free(memory);
+		}
+
+#endif // XLANG_ENABLE_MOVE_SEMANTICS
 	};
 
 }
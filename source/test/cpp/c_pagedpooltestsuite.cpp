@@ -0,0 +1,454 @@
+#define TESTS_TESTSUITES_PAGEDPOOLTESTSUITE
+#ifdef TESTS_TESTSUITES_PAGEDPOOLTESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/PagedPool/c_PagedPool.h"
+#include "clang/private/PagedPool/c_PageMask.h"
+#include "clang/c_DefaultAllocator.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void	operator delete(void* mem, void* )							{ }
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_PAGEDPOOLTESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		struct Item
+		{
+			clang::u64 a;
+			clang::u64 b;
+		};
+
+		typedef clang::detail::PagedPool<Item> ItemPool;
+
+		static const clang::u32 ENTRIES_PER_PAGE = 64;
+
+		// Counts the pages in a list returned by PagedPool::Free.
+		static clang::u32 CountRetiredPages(void *retiredPages)
+		{
+			clang::u32 count(0);
+			while (retiredPages)
+			{
+				retiredPages = *reinterpret_cast<void **>(retiredPages);
+				++count;
+			}
+
+			return count;
+		}
+
+		UNITTEST_TEST(TestConstruct)
+		{
+			ItemPool pool(1024);
+
+			CHECK_TRUE(pool.Count() == 0);    // New pool isn't empty
+			CHECK_TRUE(pool.GetNumPages() == 0);    // New pool has pages
+		}
+
+		UNITTEST_TEST(TestAllocate)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 index(0);
+			CHECK_TRUE(pool.Allocate(index));    // Allocate failed
+			CHECK_TRUE(pool.GetEntry(index) != 0);    // Allocated entry not found
+			CHECK_TRUE(pool.Count() == 1);    // Count incorrect
+			CHECK_TRUE(pool.GetNumPages() == 1);    // Page count incorrect
+
+			CHECK_TRUE(pool.Free(index));    // Free failed
+			CHECK_TRUE(pool.Count() == 0);    // Count incorrect
+		}
+
+		UNITTEST_TEST(TestAllocateFillsPages)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 indices[3 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed
+				CHECK_TRUE(indices[count] < 3 * ENTRIES_PER_PAGE);    // Entry allocated beyond the pages needed
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 3);    // Page count incorrect
+
+			for (clang::u32 first = 0; first < 3 * ENTRIES_PER_PAGE; ++first)
+			{
+				for (clang::u32 second = first + 1; second < 3 * ENTRIES_PER_PAGE; ++second)
+				{
+					CHECK_TRUE(indices[first] != indices[second]);    // Index allocated twice
+				}
+			}
+
+			for (clang::u32 count = 0; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(pool.Free(indices[count]));    // Free failed
+			}
+		}
+
+		UNITTEST_TEST(TestAllocateFull)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 indices[1024];
+			for (clang::u32 count = 0; count < 1024; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed
+			}
+
+			clang::u32 index(0);
+			CHECK_TRUE(!pool.Allocate(index));    // Allocate succeeded in a full pool
+
+			// A freed entry can be allocated again.
+			CHECK_TRUE(pool.Free(indices[700]));    // Free failed
+			CHECK_TRUE(pool.Allocate(index));    // Allocate failed
+			CHECK_TRUE(index == indices[700]);    // Freed entry not reused
+
+			for (clang::u32 count = 0; count < 1024; ++count)
+			{
+				CHECK_TRUE(pool.Free(indices[count]));    // Free failed
+			}
+		}
+
+		UNITTEST_TEST(TestSparePagesKept)
+		{
+			ItemPool pool(1024);
+			pool.SetMaxSparePages(1);
+
+			clang::u32 indices[4 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 4 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Allocate(indices[count]);
+			}
+
+			// The first page to become unused is kept.
+			void *retiredPages(0);
+			for (clang::u32 count = 3 * ENTRIES_PER_PAGE; count < 4 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count], retiredPages);
+				CHECK_TRUE(retiredPages == 0);    // Page released within the spare page limit
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 4);    // Page count incorrect
+			CHECK_TRUE(pool.GetNumSparePages() == 1);    // Spare page count incorrect
+
+			// The second exceeds the limit, so is released.
+			for (clang::u32 count = 2 * ENTRIES_PER_PAGE; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count], retiredPages);
+				ItemPool::FreeRetiredPages(retiredPages);
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 3);    // Page not released beyond the spare page limit
+			CHECK_TRUE(pool.GetNumSparePages() == 1);    // Spare page count incorrect
+
+			for (clang::u32 count = 0; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+		}
+
+		UNITTEST_TEST(TestSparePageReused)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 indices[ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Allocate(indices[count]);
+			}
+
+			// Allocating and freeing across the page boundary keeps the second page.
+			clang::u32 index(0);
+			pool.Allocate(index);
+			void *const entry(pool.GetEntry(index));
+
+			for (clang::u32 count = 0; count < 10; ++count)
+			{
+				pool.Free(index);
+				CHECK_TRUE(pool.GetNumPages() == 2);    // Page released within the spare page limit
+
+				pool.Allocate(index);
+				CHECK_TRUE(pool.GetEntry(index) == entry);    // Spare page not reused
+			}
+
+			pool.Free(index);
+			for (clang::u32 count = 0; count < ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+		}
+
+		UNITTEST_TEST(TestAllPagesReleasedWhenEmpty)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 indices[4 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 4 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Allocate(indices[count]);
+			}
+
+			void *retiredPages(0);
+			for (clang::u32 count = 0; count < 4 * ENTRIES_PER_PAGE - 1; ++count)
+			{
+				pool.Free(indices[count], retiredPages);
+				CHECK_TRUE(retiredPages == 0);    // Page released within the spare page limit
+			}
+
+			// Freeing the last entry releases all the pages, spares included, with their segment and the segment table.
+			pool.Free(indices[4 * ENTRIES_PER_PAGE - 1], retiredPages);
+			CHECK_TRUE(CountRetiredPages(retiredPages) == 4 + 2);    // Pages not released when pool emptied
+			ItemPool::FreeRetiredPages(retiredPages);
+
+			CHECK_TRUE(pool.GetNumPages() == 0);    // Pages remain in empty pool
+			CHECK_TRUE(pool.GetNumSparePages() == 0);    // Spare pages remain in empty pool
+
+			clang::u32 index(0);
+			CHECK_TRUE(pool.Allocate(index));    // Allocate failed after pages released
+			CHECK_TRUE(index < ENTRIES_PER_PAGE);    // Entry not allocated in the first page
+			pool.Free(index);
+		}
+
+		UNITTEST_TEST(TestPreferLowIndices)
+		{
+			ItemPool pool(1024);
+
+			clang::u32 indices[2 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Allocate(indices[count]);
+			}
+
+			// By default the page last allocated from is used while it has room.
+			const clang::u32 lowIndex(indices[5]);
+			const clang::u32 highIndex(indices[ENTRIES_PER_PAGE + 5]);
+			pool.Free(lowIndex);
+			pool.Free(highIndex);
+
+			clang::u32 index(0);
+			pool.Allocate(index);
+			CHECK_TRUE(index == highIndex);    // Entry not allocated from the current page
+			pool.Free(index);
+
+			// Otherwise the lowest free index is used.
+			pool.SetPreferLowIndices(true);
+			pool.Allocate(index);
+			CHECK_TRUE(index == lowIndex);    // Entry not allocated at the lowest free index
+			pool.Allocate(index);
+			CHECK_TRUE(index == highIndex);    // Entry not allocated at the lowest free index
+
+			for (clang::u32 count = 0; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+		}
+
+		UNITTEST_TEST(TestPreferLowIndicesReleasesHighPages)
+		{
+			ItemPool pool(1024);
+			pool.SetMaxSparePages(1);
+			pool.SetPreferLowIndices(true);
+
+			clang::u32 indices[4 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 4 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Allocate(indices[count]);
+			}
+
+			// Empty the second page then the fourth. The higher spare page is released.
+			void *retiredPages(0);
+			for (clang::u32 count = ENTRIES_PER_PAGE; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+
+			for (clang::u32 count = 3 * ENTRIES_PER_PAGE; count < 4 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count], retiredPages);
+				ItemPool::FreeRetiredPages(retiredPages);
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 3);    // Page count incorrect
+			CHECK_TRUE(pool.GetEntry(indices[ENTRIES_PER_PAGE]) != 0);    // Lower spare page released
+			CHECK_TRUE(pool.GetEntry(indices[3 * ENTRIES_PER_PAGE]) == 0);    // Higher spare page kept
+
+			// Empty the third page. The second page is still the one kept.
+			for (clang::u32 count = 2 * ENTRIES_PER_PAGE; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+
+			CHECK_TRUE(pool.GetEntry(indices[ENTRIES_PER_PAGE]) != 0);    // Lower spare page released
+			CHECK_TRUE(pool.GetEntry(indices[2 * ENTRIES_PER_PAGE]) == 0);    // Higher spare page kept
+
+			for (clang::u32 count = 0; count < ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+		}
+
+		UNITTEST_TEST(TestReserve)
+		{
+			ItemPool pool(64);
+
+			clang::u32 indices[3 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed
+				reinterpret_cast<Item *>(pool.GetEntry(indices[count]))->a = count;
+			}
+
+			clang::u32 index(0);
+			CHECK_TRUE(!pool.Allocate(index));    // Allocate succeeded beyond the maximum
+
+			// Raising the maximum keeps the allocated entries.
+			void *retiredPages(0);
+			CHECK_TRUE(pool.Reserve(1000000, retiredPages));    // Reserve failed
+			ItemPool::FreeRetiredPages(retiredPages);
+			CHECK_TRUE(pool.GetMaxEntries() == 1000000);    // Maximum not raised
+
+			for (clang::u32 count = ENTRIES_PER_PAGE; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed after raising the maximum
+				reinterpret_cast<Item *>(pool.GetEntry(indices[count]))->a = count;
+			}
+
+			for (clang::u32 count = 0; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(reinterpret_cast<Item *>(pool.GetEntry(indices[count]))->a == count);    // Entry lost when maximum raised
+			}
+
+			// The maximum is never lowered.
+			CHECK_TRUE(pool.Reserve(64, retiredPages));    // Reserve failed
+			CHECK_TRUE(retiredPages == 0);    // Table replaced when maximum not raised
+			CHECK_TRUE(pool.GetMaxEntries() == 1000000);    // Maximum lowered
+
+			for (clang::u32 count = 0; count < 3 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+		}
+
+		UNITTEST_TEST(TestLargeMaximum)
+		{
+			ItemPool pool(50000000);
+
+			// Only the pages used are allocated, and entries beyond them aren't found.
+			clang::u32 indices[2 * ENTRIES_PER_PAGE];
+			for (clang::u32 count = 0; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 2);    // Page count incorrect
+			CHECK_TRUE(pool.GetEntry(40000000) == 0);    // Entry found in unallocated segment
+			CHECK_TRUE(pool.GetEntry(4 * ENTRIES_PER_PAGE) == 0);    // Entry found in uninitialized page
+
+			for (clang::u32 count = 0; count < 2 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+
+			CHECK_TRUE(pool.GetEntry(0) == 0);    // Entry found in released pool
+		}
+
+		UNITTEST_TEST(TestManySegments)
+		{
+			// More pages than fit in one segment of the page table.
+			const clang::u32 numEntries(300 * ENTRIES_PER_PAGE);
+
+			clang::DefaultAllocator allocator;
+			clang::u32 *const indices(reinterpret_cast<clang::u32 *>(allocator.Allocate(numEntries * sizeof(clang::u32))));
+
+			ItemPool pool(numEntries);
+			pool.SetMaxSparePages(0);
+
+			for (clang::u32 count = 0; count < numEntries; ++count)
+			{
+				CHECK_TRUE(pool.Allocate(indices[count]));    // Allocate failed
+				reinterpret_cast<Item *>(pool.GetEntry(indices[count]))->a = count;
+			}
+
+			CHECK_TRUE(pool.GetNumPages() == 300);    // Page count incorrect
+
+			for (clang::u32 count = 0; count < numEntries; ++count)
+			{
+				CHECK_TRUE(reinterpret_cast<Item *>(pool.GetEntry(indices[count]))->a == count);    // Entry overwritten
+			}
+
+			// Emptying the pages of the second segment releases it.
+			void *retiredPages(0);
+			for (clang::u32 count = 256 * ENTRIES_PER_PAGE; count < numEntries; ++count)
+			{
+				pool.Free(indices[count], retiredPages);
+				ItemPool::FreeRetiredPages(retiredPages);
+			}
+
+			CHECK_TRUE(pool.GetEntry(indices[256 * ENTRIES_PER_PAGE]) == 0);    // Entry found in released segment
+
+			for (clang::u32 count = 0; count < 256 * ENTRIES_PER_PAGE; ++count)
+			{
+				pool.Free(indices[count]);
+			}
+
+			allocator.Free(indices);
+		}
+
+		UNITTEST_TEST(TestPageMask)
+		{
+			clang::detail::PageMask mask;
+			CHECK_TRUE(mask.Resize(40000, false));    // Resize failed
+
+			CHECK_TRUE(mask.Empty());    // New mask isn't empty
+			CHECK_TRUE(mask.FindFirst() == clang::detail::PageMask::NONE);    // Empty mask has a first index
+			CHECK_TRUE(mask.FindLast() == clang::detail::PageMask::NONE);    // Empty mask has a last index
+
+			mask.Set(31000);
+			mask.Set(1025);
+			mask.Set(39999);
+
+			CHECK_TRUE(mask.Test(1025));    // Set index not in mask
+			CHECK_TRUE(!mask.Test(1024));    // Unset index in mask
+			CHECK_TRUE(mask.FindFirst() == 1025);    // First index incorrect
+			CHECK_TRUE(mask.FindLast() == 39999);    // Last index incorrect
+
+			mask.Clear(1025);
+			mask.Clear(39999);
+			CHECK_TRUE(mask.FindFirst() == 31000);    // First index incorrect
+			CHECK_TRUE(mask.FindLast() == 31000);    // Last index incorrect
+
+			mask.Clear(31000);
+			CHECK_TRUE(mask.Empty());    // Cleared mask isn't empty
+
+			mask.Release();
+		}
+
+		UNITTEST_TEST(TestPageMaskResize)
+		{
+			clang::detail::PageMask mask;
+			CHECK_TRUE(mask.Resize(10, false));    // Resize failed
+
+			mask.Set(3);
+
+			// Resizing keeps the indices in the set, and optionally adds the new ones.
+			CHECK_TRUE(mask.Resize(5000000, true));    // Resize failed
+			CHECK_TRUE(mask.Size() == 5000000);    // Size incorrect
+			CHECK_TRUE(mask.FindFirst() == 3);    // Index lost by resize
+			CHECK_TRUE(!mask.Test(4));    // Old index added by resize
+			CHECK_TRUE(mask.Test(10));    // New index not added by resize
+			CHECK_TRUE(mask.FindLast() == 4999999);    // New index not added by resize
+
+			mask.Release();
+			CHECK_TRUE(mask.Empty());    // Released mask isn't empty
+		}
+	}
+}
+UNITTEST_SUITE_END
+
+#endif // TESTS_TESTSUITES_PAGEDPOOLTESTSUITE
@@ -44,7 +44,7 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_POOLTESTSUITE)
 			Item item0;
 			pool.Add(&item0);
 
-			CHECK_TRUE(pool.FetchAligned(XLANG_ALIGNOF(Item)) == &item0);
+			CHECK_TRUE(!pool.Empty());	// Pool shouldn't be empty after add
 		}
 
 		UNITTEST_TEST(TestFetchWhileEmpty)
@@ -73,44 +73,6 @@ UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_POOLTESTSUITE)
 			CHECK_TRUE(pool.Fetch() == &item0);		// Fetch failed
 			CHECK_TRUE(pool.Fetch() == 0);	// Pool should be empty after fetch
 		}
-
-		UNITTEST_TEST(TestFetchSizeWhileEmpty)
-		{
-			clang::detail::Pool pool;
-			CHECK_TRUE(pool.FetchAligned(XLANG_ALIGNOF(Item)) == 0); // Fetch should fail when empty
-		}
-
-		UNITTEST_TEST(TestFetchCorrectAlignment)
-		{
-			clang::detail::Pool pool;
-
-			Item item0;
-			pool.Add(&item0);
-
-			CHECK_TRUE(pool.FetchAligned(XLANG_ALIGNOF(Item)) == &item0); // Fetch failed
-			CHECK_TRUE(pool.Fetch() == 0);	// Pool should be empty after fetch
-		}
-
-		UNITTEST_TEST(TestFetchWrongAlignment)
-		{
-			clang::detail::Pool pool;
-
-			Item item0;
-			pool.Add(&item0);
-
-			// The address may happen to be aligned.
-			const clang::u32 increasedAlignment(XLANG_ALIGNOF(Item) * 2);
-			if (XLANG_ALIGNED(&item0, increasedAlignment))
-			{
-				CHECK_TRUE(pool.FetchAligned(increasedAlignment) == &item0); // Fetch failed
-				CHECK_TRUE(pool.Fetch() == 0);	// Fetch shouldn't return anything
-			}
-			else
-			{
-				CHECK_TRUE(pool.FetchAligned(increasedAlignment) == 0); // Fetch should fail
-				CHECK_TRUE(pool.Fetch() == &item0); // Fetch should return original item
-			}
-		}
 	}
 }
 UNITTEST_SUITE_END
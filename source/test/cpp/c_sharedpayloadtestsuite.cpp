@@ -0,0 +1,225 @@
+#define TESTS_TESTSUITES_SHAREDPAYLOADTESTSUITE
+#ifdef TESTS_TESTSUITES_SHAREDPAYLOADTESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/MessageCache/c_PayloadCache.h"
+
+#include "clang/c_Framework.h"
+#include "clang/c_Receiver.h"
+#include "clang/c_SharedPayload.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void	operator delete(void* mem, void* )							{ }
+
+// Counts how many instances are alive.
+struct Tracked
+{
+	inline Tracked() : mValue(0)
+	{
+		++smInstances;
+	}
+
+	inline Tracked(const Tracked &other) : mValue(other.mValue)
+	{
+		++smInstances;
+	}
+
+	inline ~Tracked()
+	{
+		--smInstances;
+	}
+
+	clang::u32 mValue;
+
+	static clang::u32 smInstances;
+};
+
+clang::u32 Tracked::smInstances = 0;
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_SHAREDPAYLOADTESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		// A large payload, such as a frame of telemetry data.
+		struct Frame
+		{
+			clang::u32 mData[4096];
+		};
+
+		class FrameCatcher
+		{
+		public:
+
+			inline FrameCatcher() : mCount(0)
+			{
+			}
+
+			inline void Catch(const clang::SharedPayload<Frame> &frame, const clang::Address /*from*/)
+			{
+				mFrames[mCount++] = frame;
+			}
+
+			clang::SharedPayload<Frame> mFrames[4];
+			clang::u32 mCount;
+		};
+
+		UNITTEST_TEST(TestNull)
+		{
+			clang::SharedPayload<clang::u32> payload;
+
+			CHECK_TRUE(payload.IsNull());    // Default handle not null
+			CHECK_TRUE(payload.GetReferenceCount() == 0);    // Null handle referenced
+		}
+
+		UNITTEST_TEST(TestCopyShares)
+		{
+			clang::SharedPayload<clang::u32> payload(clang::u32(5));
+			CHECK_TRUE(!payload.IsNull());    // Payload not allocated
+			CHECK_TRUE(payload.Value() == 5);    // Payload not initialized
+
+			{
+				clang::SharedPayload<clang::u32> copy(payload);
+				CHECK_TRUE(&copy.Value() == &payload.Value());    // Payload copied
+				CHECK_TRUE(payload.GetReferenceCount() == 2);    // Copy not referenced
+			}
+
+			CHECK_TRUE(payload.GetReferenceCount() == 1);    // Copy not released
+		}
+
+		UNITTEST_TEST(TestAssign)
+		{
+			clang::SharedPayload<clang::u32> first(clang::u32(1));
+			clang::SharedPayload<clang::u32> second(clang::u32(2));
+
+			second = first;
+			CHECK_TRUE(second.Value() == 1);    // Payload not assigned
+			CHECK_TRUE(first.GetReferenceCount() == 2);    // Assigned payload not referenced
+
+			second = second;
+			CHECK_TRUE(second.GetReferenceCount() == 2);    // Self-assignment changed count
+
+			second = clang::SharedPayload<clang::u32>();
+			CHECK_TRUE(second.IsNull());    // Null not assigned
+			CHECK_TRUE(first.GetReferenceCount() == 1);    // Reassigned payload not released
+		}
+
+		UNITTEST_TEST(TestDestroyedOnLastRelease)
+		{
+			Tracked::smInstances = 0;
+
+			{
+				clang::SharedPayload<Tracked> payload(clang::SharedPayload<Tracked>::Create());
+				payload.EditValue().mValue = 3;
+
+				clang::SharedPayload<Tracked> copy(payload);
+				CHECK_TRUE(Tracked::smInstances == 1);    // Payload value copied
+				CHECK_TRUE(copy->mValue == 3);    // Edit not shared
+			}
+
+			CHECK_TRUE(Tracked::smInstances == 0);    // Payload value not destroyed
+		}
+
+		UNITTEST_TEST(TestBlockSizes)
+		{
+			CHECK_TRUE(clang::detail::PayloadCache::GetBlockSize(1) == 64);    // Smallest size class
+			CHECK_TRUE(clang::detail::PayloadCache::GetBlockSize(65) == 128);    // Rounded to power of two
+			CHECK_TRUE(clang::detail::PayloadCache::GetBlockSize(65536) == 65536);    // Exact size class
+			CHECK_TRUE(clang::detail::PayloadCache::GetBlockSize(262145) == 262152);    // Uncached size
+		}
+
+		UNITTEST_TEST(TestBlocksReused)
+		{
+			clang::detail::PayloadCache::Instance().Reference();
+
+			const void *block(0);
+
+			{
+				clang::SharedPayload<Frame> payload(clang::SharedPayload<Frame>::Create());
+				block = &payload.Value();
+			}
+
+			{
+				// The freed block is reused for a payload of the same size class.
+				clang::SharedPayload<Frame> payload(clang::SharedPayload<Frame>::Create());
+				CHECK_TRUE(&payload.Value() == block);    // Block not cached
+			}
+
+			clang::detail::PayloadCache::Instance().Dereference();
+		}
+
+		UNITTEST_TEST(TestBlocksAligned)
+		{
+			clang::detail::PayloadCache &cache(clang::detail::PayloadCache::Instance());
+			cache.Reference();
+
+			const clang::u32 blockSize(clang::detail::PayloadCache::GetBlockSize(200));
+
+			// Cache blocks of the same size class with whatever alignments they happen to have.
+			void *blocks[4];
+			for (clang::u32 index = 0; index < 4; ++index)
+			{
+				blocks[index] = cache.Allocate(blockSize, 8);
+			}
+
+			for (clang::u32 index = 0; index < 4; ++index)
+			{
+				cache.Free(blocks[index], blockSize);
+			}
+
+			// Fetched blocks satisfy the requested alignment, whether cached or not.
+			void *const aligned(cache.Allocate(blockSize, XLANG_CACHELINE_SIZE));
+			CHECK_TRUE((reinterpret_cast<uintptr_t>(aligned) & (XLANG_CACHELINE_SIZE - 1)) == 0);    // Block not cache line aligned
+
+			void *const overAligned(cache.Allocate(blockSize, 4 * XLANG_CACHELINE_SIZE));
+			CHECK_TRUE((reinterpret_cast<uintptr_t>(overAligned) & (4 * XLANG_CACHELINE_SIZE - 1)) == 0);    // Block not aligned beyond the cache line
+
+			cache.Free(aligned, blockSize);
+			cache.Free(overAligned, blockSize);
+
+			// Blocks of a lower alignment are found among the cached ones.
+			void *const block(cache.Allocate(blockSize, 8));
+			CHECK_TRUE(block == blocks[0] || block == blocks[1] || block == blocks[2] || block == blocks[3] || block == aligned || block == overAligned);    // Block not cached
+			cache.Free(block, blockSize);
+
+			cache.Dereference();
+		}
+
+		UNITTEST_TEST(TestSendSharesPayload)
+		{
+			clang::Framework framework;
+
+			FrameCatcher catcher;
+			clang::Receiver receiver;
+			receiver.RegisterHandler(&catcher, &FrameCatcher::Catch);
+
+			clang::SharedPayload<Frame> frame(clang::SharedPayload<Frame>::Create());
+			frame.EditValue().mData[0] = 7;
+
+			// Each recipient gets a handle to the same payload, rather than a copy of it.
+			for (clang::u32 count = 0; count < 4; ++count)
+			{
+				framework.Send(frame, receiver.GetAddress(), receiver.GetAddress());
+			}
+
+			for (clang::u32 count = 0; count < 4; ++count)
+			{
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(catcher.mCount == 4);    // Payloads not received
+			CHECK_TRUE(&catcher.mFrames[3].Value() == &frame.Value());    // Payload copied
+			CHECK_TRUE(catcher.mFrames[3]->mData[0] == 7);    // Payload not intact
+			CHECK_TRUE(frame.GetReferenceCount() == 5);    // Message handles not released
+		}
+	}
+}
+UNITTEST_SUITE_END
+
+
+#endif	// TESTS_TESTSUITES_SHAREDPAYLOADTESTSUITE
@@ -0,0 +1,335 @@
+#define TESTS_TESTSUITES_THREADINGTESTSUITE
+#ifdef TESTS_TESTSUITES_THREADINGTESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Lock.h"
+#include "clang/private/Threading/c_Monitor.h"
+#include "clang/private/Threading/c_Mutex.h"
+#include "clang/private/Threading/c_Thread.h"
+#include "clang/c_Framework.h"
+#include "clang/c_Receiver.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void		operator delete(void* mem, void* )							{ }
+
+
+struct SharedCounter
+{
+	inline SharedCounter() : mValue(0), mIterations(0)
+	{
+	}
+
+	clang::detail::Mutex	mMutex;
+	clang::u32			mValue;
+	clang::u32			mIterations;
+};
+
+static void CounterEntryPoint(void *const context)
+{
+	SharedCounter *const counter(reinterpret_cast<SharedCounter *>(context));
+	for (clang::u32 index = 0; index < counter->mIterations; ++index)
+	{
+		clang::detail::Lock lock(counter->mMutex);
+
+		// Non-atomic read-modify-write, only correct under mutual exclusion.
+		const clang::u32 value(counter->mValue);
+		counter->mValue = value + 1;
+	}
+}
+
+
+struct MonitorContext
+{
+	inline MonitorContext() : mNumWaiting(0), mNumReleased(0), mNumWoken(0)
+	{
+	}
+
+	clang::detail::Monitor	mMonitor;
+	clang::u32			mNumWaiting;	///< Threads that have reached the wait.
+	clang::u32			mNumReleased;	///< Number of wakeups granted by the test.
+	clang::u32			mNumWoken;		///< Threads that have consumed a wakeup.
+};
+
+static void MonitorEntryPoint(void *const context)
+{
+	MonitorContext *const monitorContext(reinterpret_cast<MonitorContext *>(context));
+	clang::detail::Lock lock(monitorContext->mMonitor.GetMutex());
+
+	++monitorContext->mNumWaiting;
+	monitorContext->mMonitor.PulseAll();
+
+	// Wait in a loop to guard against spurious wakeups.
+	while (monitorContext->mNumWoken == monitorContext->mNumReleased)
+	{
+		monitorContext->mMonitor.Wait(lock);
+	}
+
+	++monitorContext->mNumWoken;
+	monitorContext->mMonitor.PulseAll();
+}
+
+static void WaitUntil(MonitorContext &context, clang::detail::Lock &lock, const clang::u32 *const value, const clang::u32 target)
+{
+	while (*value < target)
+	{
+		context.mMonitor.Wait(lock);
+	}
+}
+
+
+struct PulseContext
+{
+	inline PulseContext() : mNumWaiting(0), mNumPulsed(0), mNumReturned(0), mOverWoken(false), mStop(false)
+	{
+	}
+
+	clang::detail::Monitor	mMonitor;
+	clang::u32			mNumWaiting;	///< Threads in Wait that haven't been pulsed.
+	clang::u32			mNumPulsed;		///< Number of waiters pulsed by the test.
+	clang::u32			mNumReturned;	///< Raw returns from Monitor::Wait.
+	bool				mOverWoken;		///< Set if Wait ever returned more often than it was pulsed.
+	bool				mStop;			///< Tells the waiters to exit on their next return.
+};
+
+static void PulseEntryPoint(void *const context)
+{
+	PulseContext *const pulseContext(reinterpret_cast<PulseContext *>(context));
+	clang::detail::Lock lock(pulseContext->mMonitor.GetMutex());
+
+	// Wait repeatedly, without a predicate, so that every return is counted.
+	// Re-entering the wait straight after each return races with the next pulse.
+	while (true)
+	{
+		++pulseContext->mNumWaiting;
+		pulseContext->mMonitor.Wait(lock);
+
+		if (++pulseContext->mNumReturned > pulseContext->mNumPulsed)
+		{
+			pulseContext->mOverWoken = true;
+		}
+
+		if (pulseContext->mStop)
+		{
+			break;
+		}
+	}
+}
+
+
+class IntMessage
+{
+public:
+
+	inline explicit IntMessage(const clang::u32 value) : mValue(value)
+	{
+	}
+
+	clang::u32 mValue;
+};
+
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_THREADINGTESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		class PingActor : public clang::Actor
+		{
+		public:
+
+			inline PingActor()
+			{
+				RegisterHandler(this, &PingActor::Handler);
+			}
+
+		private:
+
+			inline void Handler(const IntMessage &message, const clang::Address from)
+			{
+				Send(message, from);
+			}
+		};
+
+		UNITTEST_TEST(TestMutexLockUnlock)
+		{
+			clang::detail::Mutex mutex;
+			mutex.Lock();
+			mutex.Unlock();
+			mutex.Lock();
+			mutex.Unlock();
+		}
+
+		UNITTEST_TEST(TestMutexExclusion)
+		{
+			const clang::u32 numThreads = 8;
+			const clang::u32 numIterations = 20000;
+
+			SharedCounter counter;
+			counter.mIterations = numIterations;
+
+			clang::detail::Thread threads[numThreads];
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				CHECK_TRUE(threads[index].Start(CounterEntryPoint, &counter));    // Failed to start thread
+			}
+
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				threads[index].Join();
+				CHECK_TRUE(threads[index].Running() == false);    // Thread still running after join
+			}
+
+			CHECK_TRUE(counter.mValue == numThreads * numIterations);    // Lost updates under contention
+		}
+
+		UNITTEST_TEST(TestMutexHandoff)
+		{
+			SharedCounter counter;
+			counter.mIterations = 1;
+
+			// Hold the mutex so the thread is forced onto the contended path.
+			counter.mMutex.Lock();
+
+			clang::detail::Thread thread;
+			CHECK_TRUE(thread.Start(CounterEntryPoint, &counter));    // Failed to start thread
+
+			counter.mValue = 100;
+			counter.mMutex.Unlock();
+
+			thread.Join();
+			CHECK_TRUE(counter.mValue == 101);    // Blocked thread didn't acquire the released mutex
+		}
+
+		UNITTEST_TEST(TestThreadRestart)
+		{
+			SharedCounter counter;
+			counter.mIterations = 1;
+
+			clang::detail::Thread thread;
+			for (clang::u32 index = 0; index < 4; ++index)
+			{
+				CHECK_TRUE(thread.Start(CounterEntryPoint, &counter));    // Failed to start thread
+				CHECK_TRUE(thread.Running());    // Thread not running after start
+				thread.Join();
+			}
+
+			CHECK_TRUE(counter.mValue == 4);    // Thread function wasn't run
+		}
+
+		UNITTEST_TEST(TestMonitorPulseWakesOne)
+		{
+			const clang::u32 numThreads = 4;
+			const clang::u32 numPulses = 20000;
+
+			PulseContext context;
+			clang::detail::Thread threads[numThreads];
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				CHECK_TRUE(threads[index].Start(PulseEntryPoint, &context));    // Failed to start thread
+			}
+
+			// Pulse under a fresh lock each time, so that woken threads can re-enter the wait
+			// while the next pulse is made.
+			clang::u32 numPulsed(0);
+			while (numPulsed < numPulses)
+			{
+				clang::detail::Lock lock(context.mMonitor.GetMutex());
+
+				// Threads only release the lock inside Wait, so each counted waiter is in Wait,
+				// though it may not have reached the futex yet.
+				if (context.mNumWaiting)
+				{
+					--context.mNumWaiting;
+					++context.mNumPulsed;
+					context.mMonitor.Pulse();
+					++numPulsed;
+				}
+			}
+
+			{
+				clang::detail::Lock lock(context.mMonitor.GetMutex());
+
+				// Wait for every pulsed waiter to return, then release them all.
+				while (context.mNumReturned < context.mNumPulsed || context.mNumWaiting < numThreads)
+				{
+					lock.Unlock();
+					clang::detail::Atomic::Pause();
+					lock.Relock();
+				}
+
+				context.mStop = true;
+				context.mNumPulsed += context.mNumWaiting;
+				context.mNumWaiting = 0;
+				context.mMonitor.PulseAll();
+			}
+
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				threads[index].Join();
+			}
+
+			CHECK_TRUE(context.mOverWoken == false);    // Pulse released more than one waiter
+			CHECK_TRUE(context.mNumReturned == numPulses + numThreads);    // Not every pulse released a waiter
+		}
+
+		UNITTEST_TEST(TestMonitorPulseAllWakesAll)
+		{
+			const clang::u32 numThreads = 4;
+
+			MonitorContext context;
+			clang::detail::Thread threads[numThreads];
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				threads[index].Start(MonitorEntryPoint, &context);
+			}
+
+			{
+				clang::detail::Lock lock(context.mMonitor.GetMutex());
+				WaitUntil(context, lock, &context.mNumWaiting, numThreads);
+
+				context.mNumReleased = numThreads;
+				context.mMonitor.PulseAll();
+
+				WaitUntil(context, lock, &context.mNumWoken, numThreads);
+			}
+
+			for (clang::u32 index = 0; index < numThreads; ++index)
+			{
+				threads[index].Join();
+			}
+
+			CHECK_TRUE(context.mNumWoken == numThreads);    // PulseAll didn't wake all waiters
+		}
+
+		UNITTEST_TEST(TestFrameworkPingPong)
+		{
+			const clang::u32 numRoundTrips = 1000;
+
+			clang::Framework framework(2);
+			clang::Receiver receiver;
+			clang::ActorRef actor(framework.CreateActor<PingActor>());
+
+			// Each round trip crosses the worker threads and the receiver's monitor.
+			for (clang::u32 index = 0; index < numRoundTrips; ++index)
+			{
+				framework.Send(IntMessage(index), receiver.GetAddress(), actor.GetAddress());
+				receiver.Wait();
+			}
+
+			CHECK_TRUE(receiver.Count() == 0);    // Unconsumed replies
+		}
+
+	};
+
+
+
+} // namespace UnitTests
+UNITTEST_SUITE_END
+
+#endif // TESTS_TESTSUITES_THREADINGTESTSUITE
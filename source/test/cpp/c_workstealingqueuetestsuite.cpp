@@ -0,0 +1,207 @@
+#define TESTS_TESTSUITES_WORKSTEALINGQUEUETESTSUITE
+#ifdef TESTS_TESTSUITES_WORKSTEALINGQUEUETESTSUITE
+
+#include "clang/private/c_BasicTypes.h"
+#include "clang/private/Threading/c_Atomic.h"
+#include "clang/private/Threading/c_Thread.h"
+#include "clang/private/ThreadPool/c_WorkStealingQueue.h"
+
+#include "cunittest/cunittest.h"
+
+// Placement new/delete
+inline void*	operator new(ncore::xsize_t num_bytes, void* mem)			{ return mem; }
+inline void		operator delete(void* mem, void* )							{ }
+
+
+struct QueueItem
+{
+	inline QueueItem() : mValue(0), mNumPopped(0)
+	{
+	}
+
+	clang::u32			mValue;
+	volatile clang::u32	mNumPopped;		///< Counts how many times the item was popped.
+};
+
+typedef clang::detail::WorkStealingQueue<QueueItem> ItemQueue;
+
+struct StealContext
+{
+	inline StealContext() : mQueue(0), mDone(0), mNumStolen(0)
+	{
+	}
+
+	ItemQueue			*mQueue;
+	volatile clang::u32	mDone;			///< Set by the owner when it has pushed every item.
+	clang::u32			mNumStolen;		///< Written only by the thief that owns this context.
+};
+
+static void ThiefEntryPoint(void *const context)
+{
+	StealContext *const stealContext(reinterpret_cast<StealContext *>(context));
+	while (true)
+	{
+		// Read the done flag before popping, so a failed pop after it was set means the queue is drained.
+		const bool done(clang::detail::Atomic::Load(&stealContext->mDone) != 0);
+		if (QueueItem *const item = stealContext->mQueue->Pop())
+		{
+			clang::detail::Atomic::Increment(&item->mNumPopped);
+			++stealContext->mNumStolen;
+		}
+		else if (done)
+		{
+			break;
+		}
+	}
+}
+
+
+UNITTEST_SUITE_BEGIN(TESTS_TESTSUITES_WORKSTEALINGQUEUETESTSUITE)
+{
+    UNITTEST_FIXTURE(main)
+    {
+        UNITTEST_FIXTURE_SETUP() {}
+        UNITTEST_FIXTURE_TEARDOWN() {}
+
+		UNITTEST_TEST(TestConstruct)
+		{
+			ItemQueue queue;
+			CHECK_TRUE(queue.Empty());    // Queue not initially empty
+			CHECK_TRUE(queue.Pop() == 0);    // Pop from empty queue returned an item
+		}
+
+		UNITTEST_TEST(TestPushPopOrder)
+		{
+			ItemQueue queue;
+			QueueItem items[3];
+
+			CHECK_TRUE(queue.Push(&items[0]));    // Push failed
+			CHECK_TRUE(queue.Push(&items[1]));    // Push failed
+			CHECK_TRUE(queue.Push(&items[2]));    // Push failed
+			CHECK_TRUE(!queue.Empty());    // Queue empty after push
+
+			// Items come out in the order they were pushed.
+			CHECK_TRUE(queue.Pop() == &items[0]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == &items[1]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == &items[2]);    // Wrong item popped
+			CHECK_TRUE(queue.Pop() == 0);    // Pop from empty queue returned an item
+			CHECK_TRUE(queue.Empty());    // Queue not empty after popping everything
+		}
+
+		UNITTEST_TEST(TestPushFull)
+		{
+			ItemQueue queue;
+			QueueItem item;
+
+			for (clang::u32 index = 0; index < ItemQueue::CAPACITY; ++index)
+			{
+				CHECK_TRUE(queue.Push(&item));    // Push failed before queue was full
+			}
+
+			CHECK_TRUE(queue.Push(&item) == false);    // Push succeeded on full queue
+
+			// Popping one item makes room for one more.
+			CHECK_TRUE(queue.Pop() == &item);    // Wrong item popped
+			CHECK_TRUE(queue.Push(&item));    // Push failed after making room
+			CHECK_TRUE(queue.Push(&item) == false);    // Push succeeded on full queue
+		}
+
+		UNITTEST_TEST(TestWrapAround)
+		{
+			ItemQueue queue;
+			QueueItem items[7];
+
+			// Cycle items through the queue many times its capacity, so the indices wrap the buffer.
+			for (clang::u32 round = 0; round < ItemQueue::CAPACITY * 4; ++round)
+			{
+				for (clang::u32 index = 0; index < 7; ++index)
+				{
+					CHECK_TRUE(queue.Push(&items[index]));    // Push failed
+				}
+
+				for (clang::u32 index = 0; index < 7; ++index)
+				{
+					CHECK_TRUE(queue.Pop() == &items[index]);    // Wrong item popped
+				}
+			}
+
+			CHECK_TRUE(queue.Empty());    // Queue not empty after popping everything
+		}
+
+		UNITTEST_TEST(TestConcurrentSteal)
+		{
+			const clang::u32 numThieves = 4;
+			const clang::u32 numItems = 100000;
+
+			static QueueItem items[numItems];
+			for (clang::u32 index = 0; index < numItems; ++index)
+			{
+				items[index].mValue = index;
+				items[index].mNumPopped = 0;
+			}
+
+			ItemQueue queue;
+			StealContext contexts[numThieves];
+			clang::detail::Thread thieves[numThieves];
+
+			for (clang::u32 index = 0; index < numThieves; ++index)
+			{
+				contexts[index].mQueue = &queue;
+				thieves[index].Start(ThiefEntryPoint, &contexts[index]);
+			}
+
+			// The owner pushes every item, popping some itself along the way as a worker would.
+			clang::u32 numOwnerPopped(0);
+			for (clang::u32 index = 0; index < numItems; ++index)
+			{
+				while (!queue.Push(&items[index]))
+				{
+					if (QueueItem *const item = queue.Pop())
+					{
+						clang::detail::Atomic::Increment(&item->mNumPopped);
+						++numOwnerPopped;
+					}
+				}
+
+				if ((index & 7) == 0)
+				{
+					if (QueueItem *const item = queue.Pop())
+					{
+						clang::detail::Atomic::Increment(&item->mNumPopped);
+						++numOwnerPopped;
+					}
+				}
+			}
+
+			for (clang::u32 index = 0; index < numThieves; ++index)
+			{
+				clang::detail::Atomic::Store(&contexts[index].mDone, 1);
+			}
+
+			clang::u32 numPopped(numOwnerPopped);
+			for (clang::u32 index = 0; index < numThieves; ++index)
+			{
+				thieves[index].Join();
+				numPopped += contexts[index].mNumStolen;
+			}
+
+			// Every item was popped exactly once, whether by the owner or a thief.
+			CHECK_TRUE(numPopped == numItems);    // Items lost or duplicated
+			bool allPoppedOnce(true);
+			for (clang::u32 index = 0; index < numItems; ++index)
+			{
+				allPoppedOnce &= (items[index].mNumPopped == 1);
+			}
+
+			CHECK_TRUE(allPoppedOnce);    // An item was popped more or less than once
+			CHECK_TRUE(queue.Empty());    // Queue not empty after all items were popped
+		}
+
+	};
+
+
+
+} // namespace UnitTests
+UNITTEST_SUITE_END
+
+#endif // TESTS_TESTSUITES_WORKSTEALINGQUEUETESTSUITE
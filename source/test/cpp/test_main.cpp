@@ -7,14 +7,21 @@
 
 UNITTEST_SUITE_LIST(cUnitTest);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_POOLTESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_PAGEDPOOLTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_LISTTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_DEFAULTALLOCATORTESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_LLFWALLOCATORTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_ACTORTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_ACTORREFTESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_ACTORGROUPTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_THREADCOLLECTIONTESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_THREADINGTESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_WORKSTEALINGQUEUETESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_INTRUSIVEMPSCQUEUETESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_RECEIVERTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_MESSAGETESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_MESSAGECACHETESTSUITE);
+UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_SHAREDPAYLOADTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_FRAMEWORKTESTSUITE);
 UNITTEST_SUITE_DECLARE(cUnitTest, TESTS_TESTSUITES_FEATURETESTSUITE);
 